@@ -24,6 +24,7 @@
 #endif
 
 #include "gstfakeadec.h"
+#include "gstfakedec.h"
 #include "gstfdcaps.h"
 
 static GstStaticPadTemplate gst_fakeadec_sink_pad_template =
@@ -51,6 +52,8 @@ static GstStateChangeReturn gst_fakeadec_change_state (GstElement * element,
 
 static GstFlowReturn gst_fakeadec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_fakeadec_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 
 #define gst_fakeadec_parent_class parent_class
 G_DEFINE_TYPE (GstFakeAdec, gst_fakeadec, GST_TYPE_ELEMENT);
@@ -132,6 +135,8 @@ gst_fakeadec_init (GstFakeAdec * fakeadec)
       "sink");
   gst_pad_set_chain_function (fakeadec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_fakeadec_chain));
+  gst_pad_set_chain_list_function (fakeadec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_fakeadec_chain_list));
   gst_pad_set_event_function (fakeadec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_fakeadec_sink_event));
   gst_element_add_pad (GST_ELEMENT (fakeadec), fakeadec->sinkpad);
@@ -198,6 +203,20 @@ gst_fakeadec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
 }
 
+static GstFlowReturn
+gst_fakeadec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFakeAdec *fakeadec;
+
+  fakeadec = GST_FAKEADEC (parent);
+
+  GST_LOG_OBJECT (fakeadec, "buffer list with %u buffers",
+      gst_buffer_list_length (list));
+
+  return gst_fake_dec_push_list (fakeadec->srcpad, list);
+}
+
 static GstStateChangeReturn
 gst_fakeadec_change_state (GstElement * element, GstStateChange transition)
 {
@@ -0,0 +1,50 @@
+/* GStreamer Lightweight Playback Plugins
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *	Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *	         Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstfakedec.h"
+
+static gboolean
+copy_buffer_to_list (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  GstBufferList *outlist = (GstBufferList *) user_data;
+
+  gst_buffer_list_add (outlist, gst_buffer_copy (*buffer));
+
+  return TRUE;
+}
+
+/* pushes a copy of every buffer of @list on @srcpad as one list, the
+ * shared chain_list of fakevdec and fakeadec; takes ownership of @list */
+GstFlowReturn
+gst_fake_dec_push_list (GstPad * srcpad, GstBufferList * list)
+{
+  GstBufferList *outlist;
+
+  outlist = gst_buffer_list_new_sized (gst_buffer_list_length (list));
+  gst_buffer_list_foreach (list, copy_buffer_to_list, outlist);
+  gst_buffer_list_unref (list);
+
+  return gst_pad_push_list (srcpad, outlist);
+}
@@ -0,0 +1,33 @@
+/* GStreamer Lightweight Playback Plugins
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *	Author : Wonchul Lee <wonchul86.lee@lge.com>
+ *	         Jeongseok Kim <jeongseok.kim@lge.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_FAKEDEC_H__
+#define __GST_FAKEDEC_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL GstFlowReturn gst_fake_dec_push_list (GstPad * srcpad,
+    GstBufferList * list);
+
+G_END_DECLS
+#endif /* __GST_FAKEDEC_H__ */
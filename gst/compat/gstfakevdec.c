@@ -24,6 +24,7 @@
 #endif
 
 #include "gstfakevdec.h"
+#include "gstfakedec.h"
 #include "gstfdcaps.h"
 
 static GstStaticPadTemplate gst_fakevdec_sink_pad_template =
@@ -53,6 +54,8 @@ static gboolean gst_fakevdec_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstFlowReturn gst_fakevdec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_fakevdec_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 
 #define gst_fakevdec_parent_class parent_class
 G_DEFINE_TYPE (GstFakeVdec, gst_fakevdec, GST_TYPE_ELEMENT);
@@ -173,6 +176,8 @@ gst_fakevdec_init (GstFakeVdec * fakevdec)
       GST_DEBUG_FUNCPTR (gst_fakevdec_sink_event));
   gst_pad_set_chain_function (fakevdec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_fakevdec_chain));
+  gst_pad_set_chain_list_function (fakevdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_fakevdec_chain_list));
   //gst_pad_set_query_function (fakevdec->sinkpad,
   //              GST_DEBUG_FUNCPTR (gst_fakevdec_query));
   gst_element_add_pad (GST_ELEMENT (fakevdec), fakevdec->sinkpad);
@@ -237,6 +242,20 @@ gst_fakevdec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
 }
 
+static GstFlowReturn
+gst_fakevdec_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFakeVdec *fakevdec;
+
+  fakevdec = GST_FAKEVDEC (parent);
+
+  GST_LOG_OBJECT (fakevdec, "buffer list with %u buffers",
+      gst_buffer_list_length (list));
+
+  return gst_fake_dec_push_list (fakevdec->srcpad, list);
+}
+
 static GstStateChangeReturn
 gst_fakevdec_change_state (GstElement * element, GstStateChange transition)
 {
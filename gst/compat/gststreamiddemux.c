@@ -40,13 +40,37 @@
 GST_DEBUG_CATEGORY_STATIC (streamid_demux_debug);
 #define GST_CAT_DEFAULT streamid_demux_debug
 
+#define DEFAULT_ASYNC_PUSH FALSE
+#define DEFAULT_MAX_SIZE_BUFFERS 32
+#define DEFAULT_RECYCLE_PADS FALSE
+#define DEFAULT_IDLE_TIMEOUT 0
+
 enum
 {
   PROP_0,
   PROP_ACTIVE_PAD,
+  PROP_ASYNC_PUSH,
+  PROP_MAX_SIZE_BUFFERS,
+  PROP_RECYCLE_PADS,
+  PROP_IDLE_TIMEOUT,
   PROP_LAST
 };
 
+enum
+{
+  SIGNAL_PAD_RECYCLED,
+  LAST_SIGNAL
+};
+
+static guint gst_streamid_demux_signals[LAST_SIGNAL] = { 0 };
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_CURRENT_LEVEL_BUFFERS,
+  PROP_PAD_CURRENT_LEVEL_BYTES
+};
+
 static GstStaticPadTemplate gst_streamid_demux_sink_factory =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -66,11 +90,18 @@ GST_DEBUG_CATEGORY_INIT (streamid_demux_debug, \
 G_DEFINE_TYPE_WITH_CODE (GstStreamidDemux, gst_streamid_demux,
     GST_TYPE_ELEMENT, _do_init);
 
+G_DEFINE_TYPE (GstStreamidDemuxPad, gst_streamid_demux_pad, GST_TYPE_PAD);
+
 static void gst_streamid_demux_dispose (GObject * object);
+static void gst_streamid_demux_finalize (GObject * object);
+static void gst_streamid_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
 static void gst_streamid_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static GstFlowReturn gst_streamid_demux_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_streamid_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_streamid_demux_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstStateChangeReturn gst_streamid_demux_change_state (GstElement *
@@ -83,20 +114,171 @@ static void gst_streamid_demux_reset (GstStreamidDemux * demux);
 static void gst_streamid_demux_release_srcpad (const GValue * item,
     GstStreamidDemux * demux);
 
+static void
+gst_streamid_demux_pad_finalize (GObject * object)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (object);
+
+  if (dpad->queue) {
+    gst_data_queue_flush (dpad->queue);
+    g_object_unref (dpad->queue);
+    dpad->queue = NULL;
+  }
+  g_free (dpad->prev_stream_id);
+  gst_event_replace (&dpad->pending_stream_start, NULL);
+
+  G_OBJECT_CLASS (gst_streamid_demux_pad_parent_class)->finalize (object);
+}
+
+static void
+gst_streamid_demux_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (object);
+  GstDataQueueSize level = { 0, };
+
+  if (dpad->queue)
+    gst_data_queue_get_level (dpad->queue, &level);
+
+  switch (prop_id) {
+    case PROP_PAD_CURRENT_LEVEL_BUFFERS:
+      g_value_set_uint (value, level.visible);
+      break;
+    case PROP_PAD_CURRENT_LEVEL_BYTES:
+      g_value_set_uint (value, level.bytes);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_streamid_demux_pad_class_init (GstStreamidDemuxPadClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->get_property = gst_streamid_demux_pad_get_property;
+  gobject_class->finalize = gst_streamid_demux_pad_finalize;
+
+  /**
+   * GstStreamidDemuxPad:current-level-buffers:
+   *
+   * The number of buffers waiting in the queue of this srcpad. Always 0 when
+   * #GstStreamidDemux:async-push is disabled.
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_PAD_CURRENT_LEVEL_BUFFERS, g_param_spec_uint ("current-level-buffers",
+          "Current level (buffers)", "Current number of buffers in the queue",
+          0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemuxPad:current-level-bytes:
+   *
+   * The amount of data waiting in the queue of this srcpad.
+   */
+  g_object_class_install_property (gobject_class,
+      PROP_PAD_CURRENT_LEVEL_BYTES, g_param_spec_uint ("current-level-bytes",
+          "Current level (bytes)", "Current amount of data in the queue",
+          0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_streamid_demux_pad_init (GstStreamidDemuxPad * dpad)
+{
+  dpad->queue = NULL;
+  dpad->srcresult = GST_FLOW_FLUSHING;
+  dpad->eos = FALSE;
+  dpad->inactive_since = 0;
+  dpad->prev_stream_id = NULL;
+  dpad->pending_stream_start = NULL;
+}
+
 static void
 gst_streamid_demux_class_init (GstStreamidDemuxClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GstElementClass *gstelement_class = GST_ELEMENT_CLASS (klass);
 
+  gobject_class->set_property = gst_streamid_demux_set_property;
   gobject_class->get_property = gst_streamid_demux_get_property;
   gobject_class->dispose = gst_streamid_demux_dispose;
+  gobject_class->finalize = gst_streamid_demux_finalize;
 
   g_object_class_install_property (gobject_class, PROP_ACTIVE_PAD,
       g_param_spec_object ("active-pad", "Active pad",
           "The currently active src pad", GST_TYPE_PAD,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstStreamidDemux:async-push:
+   *
+   * Give every srcpad its own bounded queue and streaming task. The demuxer
+   * then only hands data over and returns, so a slow consumer on one stream
+   * does not stall the other streams until its queue is full.
+   * Only takes effect for srcpads created after it has been set.
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_PUSH,
+      g_param_spec_boolean ("async-push", "Async push",
+          "Push from a dedicated streaming thread per srcpad",
+          DEFAULT_ASYNC_PUSH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:max-size-buffers:
+   *
+   * Maximum number of buffers (or buffer lists) queued per srcpad in
+   * async-push mode. Upstream blocks when the queue of the active pad is
+   * full.
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_SIZE_BUFFERS,
+      g_param_spec_uint ("max-size-buffers", "Max. size (buffers)",
+          "Max. number of buffers queued per srcpad in async-push mode",
+          1, G_MAXUINT, DEFAULT_MAX_SIZE_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:recycle-pads:
+   *
+   * Instead of creating a new srcpad for an unseen stream-id, hand over the
+   * srcpad of a stream that has seen EOS or has been inactive for longer than
+   * #GstStreamidDemux:idle-timeout. Whatever is linked downstream is reused
+   * as long as it accepts the caps of the new stream, otherwise the stream
+   * gets a new srcpad after all.
+   */
+  g_object_class_install_property (gobject_class, PROP_RECYCLE_PADS,
+      g_param_spec_boolean ("recycle-pads", "Recycle pads",
+          "Reuse srcpads of finished or idle streams for new stream-ids",
+          DEFAULT_RECYCLE_PADS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux:idle-timeout:
+   *
+   * Time in nanoseconds a srcpad has to be inactive before it can be
+   * recycled. 0 means that only srcpads of streams that have seen EOS are
+   * recycled.
+   */
+  g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+      g_param_spec_uint64 ("idle-timeout", "Idle timeout",
+          "Inactive time before a srcpad can be recycled (0 = only after EOS)",
+          0, G_MAXUINT64, DEFAULT_IDLE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstStreamidDemux::pad-recycled:
+   * @demux: a #GstStreamidDemux
+   * @pad: the recycled srcpad
+   * @stream_id: the stream-id now carried by @pad
+   * @caps: the caps of the new stream
+   *
+   * Emitted from the streaming thread once downstream of a recycled srcpad
+   * has accepted the caps of its new stream.
+   */
+  gst_streamid_demux_signals[SIGNAL_PAD_RECYCLED] =
+      g_signal_new ("pad-recycled", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstStreamidDemuxClass, pad_recycled),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_NONE, 3, GST_TYPE_PAD,
+      G_TYPE_STRING, GST_TYPE_CAPS);
+
   gst_element_class_set_static_metadata (gstelement_class, "Streamid Demux",
       "Generic", "1-to-N output stream by stream-id",
       "HoonHee Lee <hoonhee.lee@lge.com>");
@@ -117,6 +299,8 @@ gst_streamid_demux_init (GstStreamidDemux * demux)
       "sink");
   gst_pad_set_chain_function (demux->sinkpad,
       GST_DEBUG_FUNCPTR (gst_streamid_demux_chain));
+  gst_pad_set_chain_list_function (demux->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_streamid_demux_chain_list));
   gst_pad_set_event_function (demux->sinkpad,
       GST_DEBUG_FUNCPTR (gst_streamid_demux_event));
 
@@ -126,6 +310,11 @@ gst_streamid_demux_init (GstStreamidDemux * demux)
   demux->active_srcpad = NULL;
   demux->nb_srcpads = 0;
 
+  demux->async_push = DEFAULT_ASYNC_PUSH;
+  demux->max_size_buffers = DEFAULT_MAX_SIZE_BUFFERS;
+  demux->recycle_pads = DEFAULT_RECYCLE_PADS;
+  demux->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+
   /* initialize hash table for srcpad */
   demux->stream_id_pairs =
       g_hash_table_new_full (g_str_hash, g_str_equal, (GDestroyNotify) g_free,
@@ -142,6 +331,49 @@ gst_streamid_demux_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_streamid_demux_finalize (GObject * object)
+{
+  GstStreamidDemux *demux = GST_STREAMID_DEMUX (object);
+
+  g_hash_table_unref (demux->stream_id_pairs);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_streamid_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstStreamidDemux *demux = GST_STREAMID_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_ASYNC_PUSH:
+      GST_OBJECT_LOCK (demux);
+      demux->async_push = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_MAX_SIZE_BUFFERS:
+      GST_OBJECT_LOCK (demux);
+      demux->max_size_buffers = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_RECYCLE_PADS:
+      GST_OBJECT_LOCK (demux);
+      demux->recycle_pads = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      GST_OBJECT_LOCK (demux);
+      demux->idle_timeout = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_streamid_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -151,7 +383,27 @@ gst_streamid_demux_get_property (GObject * object, guint prop_id,
   switch (prop_id) {
     case PROP_ACTIVE_PAD:
       GST_OBJECT_LOCK (demux);
-      g_value_set_object (value, demux->active_srcpad);
+      g_value_set_object (value, g_atomic_pointer_get (&demux->active_srcpad));
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_ASYNC_PUSH:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_boolean (value, demux->async_push);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_MAX_SIZE_BUFFERS:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint (value, demux->max_size_buffers);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_RECYCLE_PADS:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_boolean (value, demux->recycle_pads);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_uint64 (value, demux->idle_timeout);
       GST_OBJECT_UNLOCK (demux);
       break;
     default:
@@ -170,6 +422,333 @@ forward_sticky_events (GstPad * pad, GstEvent ** event, gpointer user_data)
   return TRUE;
 }
 
+static gboolean
+gst_streamid_demux_pad_check_full (GstDataQueue * queue, guint visible,
+    guint bytes, guint64 time, gpointer checkdata)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (checkdata);
+
+  return visible >= dpad->max_size_buffers;
+}
+
+static void
+gst_streamid_demux_item_destroy (GstDataQueueItem * item)
+{
+  if (item->object)
+    gst_mini_object_unref (item->object);
+  g_slice_free (GstDataQueueItem, item);
+}
+
+static gboolean
+add_buffer_size (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  *(guint *) user_data += gst_buffer_get_size (*buffer);
+
+  return TRUE;
+}
+
+/* Takes ownership of @obj. Blocks only when the queue of @dpad is full */
+static GstFlowReturn
+gst_streamid_demux_pad_enqueue (GstStreamidDemuxPad * dpad, GstMiniObject * obj)
+{
+  GstDataQueueItem *item;
+  GstFlowReturn res;
+
+  res = g_atomic_int_get (&dpad->srcresult);
+  if (res != GST_FLOW_OK && !GST_IS_EVENT (obj))
+    goto out_flow;
+
+  item = g_slice_new0 (GstDataQueueItem);
+  item->object = obj;
+  item->destroy = (GDestroyNotify) gst_streamid_demux_item_destroy;
+
+  if (GST_IS_BUFFER (obj)) {
+    item->size = gst_buffer_get_size (GST_BUFFER_CAST (obj));
+    item->duration = GST_BUFFER_DURATION (obj);
+    item->visible = TRUE;
+  } else if (GST_IS_BUFFER_LIST (obj)) {
+    gst_buffer_list_foreach (GST_BUFFER_LIST_CAST (obj), add_buffer_size,
+        &item->size);
+    item->visible = TRUE;
+  }
+
+  if (!gst_data_queue_push (dpad->queue, item)) {
+    item->destroy (item);
+    return GST_FLOW_FLUSHING;
+  }
+
+  return GST_FLOW_OK;
+
+out_flow:
+  {
+    GST_LOG_OBJECT (dpad, "dropping, pad task stopped with %s",
+        gst_flow_get_name (res));
+    gst_mini_object_unref (obj);
+    return res;
+  }
+}
+
+static void
+gst_streamid_demux_pad_loop (GstPad * pad)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (pad);
+  GstDataQueueItem *item = NULL;
+  GstMiniObject *obj;
+  GstFlowReturn res = GST_FLOW_OK;
+
+  if (!gst_data_queue_pop (dpad->queue, &item))
+    goto flushing;
+
+  obj = item->object;
+  item->object = NULL;
+  item->destroy (item);
+
+  if (GST_IS_BUFFER (obj)) {
+    res = gst_pad_push (pad, GST_BUFFER_CAST (obj));
+  } else if (GST_IS_BUFFER_LIST (obj)) {
+    res = gst_pad_push_list (pad, GST_BUFFER_LIST_CAST (obj));
+  } else if (GST_IS_EVENT (obj)) {
+    /* keep running after EOS, the pad may get recycled for a new stream */
+    gst_pad_push_event (pad, GST_EVENT_CAST (obj));
+  }
+
+  if (res != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+flushing:
+  {
+    GST_LOG_OBJECT (pad, "pausing task, flushing");
+    gst_pad_pause_task (pad);
+    return;
+  }
+pause:
+  {
+    /* the next chain call on this pad returns the flow upstream, where the
+     * error is handled as it would be without async-push */
+    GST_LOG_OBJECT (pad, "pausing task, reason %s", gst_flow_get_name (res));
+    g_atomic_int_set (&dpad->srcresult, res);
+    gst_data_queue_set_flushing (dpad->queue, TRUE);
+    gst_pad_pause_task (pad);
+    return;
+  }
+}
+
+static gboolean
+gst_streamid_demux_pad_activate_mode (GstPad * pad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (pad);
+  gboolean res = FALSE;
+
+  if (mode != GST_PAD_MODE_PUSH)
+    return FALSE;
+
+  if (active) {
+    g_atomic_int_set (&dpad->srcresult, GST_FLOW_OK);
+    gst_data_queue_set_flushing (dpad->queue, FALSE);
+    res = gst_pad_start_task (pad, (GstTaskFunction) gst_streamid_demux_pad_loop,
+        pad, NULL);
+  } else {
+    g_atomic_int_set (&dpad->srcresult, GST_FLOW_FLUSHING);
+    gst_data_queue_set_flushing (dpad->queue, TRUE);
+    gst_data_queue_flush (dpad->queue);
+    res = gst_pad_stop_task (pad);
+  }
+
+  return res;
+}
+
+/* Hand @obj over to @srcpad. Buffers, buffer lists and serialized events
+ * go through the pad queue in async-push mode, otherwise they are pushed
+ * right away from the calling thread */
+static GstFlowReturn
+gst_streamid_demux_push (GstPad * srcpad, GstMiniObject * obj)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (srcpad);
+
+  if (dpad->queue)
+    return gst_streamid_demux_pad_enqueue (dpad, obj);
+
+  if (GST_IS_BUFFER (obj))
+    return gst_pad_push (srcpad, GST_BUFFER_CAST (obj));
+  else
+    return gst_pad_push_list (srcpad, GST_BUFFER_LIST_CAST (obj));
+}
+
+static gboolean
+gst_streamid_demux_push_event (GstPad * srcpad, GstEvent * event)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (srcpad);
+
+  if (dpad->queue && GST_EVENT_IS_SERIALIZED (event))
+    return gst_streamid_demux_pad_enqueue (dpad,
+        GST_MINI_OBJECT_CAST (event)) == GST_FLOW_OK;
+
+  return gst_pad_push_event (srcpad, event);
+}
+
+static GList *
+gst_streamid_demux_get_srcpads (GstStreamidDemux * demux)
+{
+  GList *srcpads;
+
+  GST_OBJECT_LOCK (demux);
+  srcpads = g_hash_table_get_values (demux->stream_id_pairs);
+  g_list_foreach (srcpads, (GFunc) gst_object_ref, NULL);
+  GST_OBJECT_UNLOCK (demux);
+
+  return srcpads;
+}
+
+/* FLUSH_START, FLUSH_STOP and EOS go to every srcpad. The queues and tasks
+ * of the srcpads created in async-push mode have to follow them */
+static gboolean
+gst_streamid_demux_forward_event (GstStreamidDemux * demux, GstEvent * event)
+{
+  GList *srcpads, *walk;
+  gboolean res = TRUE;
+
+  srcpads = gst_streamid_demux_get_srcpads (demux);
+
+  for (walk = srcpads; walk; walk = g_list_next (walk)) {
+    GstPad *srcpad = GST_PAD_CAST (walk->data);
+    GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (srcpad);
+
+    /* created before async-push was enabled */
+    if (!dpad->queue) {
+      res &= gst_pad_push_event (srcpad, gst_event_ref (event));
+      continue;
+    }
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_FLUSH_START:
+        res &= gst_pad_push_event (srcpad, gst_event_ref (event));
+        g_atomic_int_set (&dpad->srcresult, GST_FLOW_FLUSHING);
+        gst_data_queue_set_flushing (dpad->queue, TRUE);
+        gst_pad_pause_task (srcpad);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        gst_data_queue_flush (dpad->queue);
+        res &= gst_pad_push_event (srcpad, gst_event_ref (event));
+        g_atomic_int_set (&dpad->srcresult, GST_FLOW_OK);
+        gst_data_queue_set_flushing (dpad->queue, FALSE);
+        gst_pad_start_task (srcpad,
+            (GstTaskFunction) gst_streamid_demux_pad_loop, srcpad, NULL);
+        break;
+      default:
+        res &= gst_streamid_demux_push_event (srcpad, gst_event_ref (event));
+        break;
+    }
+  }
+
+  g_list_free_full (srcpads, gst_object_unref);
+  gst_event_unref (event);
+
+  return res;
+}
+
+/* Called from the streaming thread of the sinkpad */
+static void
+gst_streamid_demux_set_active_srcpad (GstStreamidDemux * demux, GstPad * srcpad)
+{
+  GstPad *old = g_atomic_pointer_get (&demux->active_srcpad);
+
+  GST_OBJECT_LOCK (demux);
+  if (old)
+    GST_STREAMID_DEMUX_PAD (old)->inactive_since = g_get_monotonic_time ();
+  GST_STREAMID_DEMUX_PAD (srcpad)->inactive_since = 0;
+  GST_OBJECT_UNLOCK (demux);
+
+  g_atomic_pointer_set (&demux->active_srcpad, srcpad);
+}
+
+static void
+gst_streamid_demux_set_eos (GstStreamidDemux * demux, gboolean eos)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_iter_init (&iter, demux->stream_id_pairs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    GST_STREAMID_DEMUX_PAD (value)->eos = eos;
+  GST_OBJECT_UNLOCK (demux);
+}
+
+/* Call with the object lock */
+static gboolean
+gst_streamid_demux_pad_is_reclaimable (GstStreamidDemux * demux,
+    GstStreamidDemuxPad * dpad, gint64 now)
+{
+  if (dpad->eos)
+    return TRUE;
+
+  /* the active pad is never idle */
+  if (dpad->inactive_since == 0 || demux->idle_timeout == 0)
+    return FALSE;
+
+  return (now - dpad->inactive_since) * GST_USECOND >= demux->idle_timeout;
+}
+
+/* Hand the srcpad that has been finished or idle for the longest time over
+ * to @stream_id. The caps of the new stream are checked against downstream
+ * when they arrive, see gst_streamid_demux_check_recycled_caps() */
+static GstPad *
+gst_streamid_demux_srcpad_recycle (GstStreamidDemux * demux,
+    const gchar * stream_id)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GstStreamidDemuxPad *dpad = NULL;
+  gchar *old_stream_id = NULL;
+  gint64 now = g_get_monotonic_time ();
+
+  GST_OBJECT_LOCK (demux);
+  g_hash_table_iter_init (&iter, demux->stream_id_pairs);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    GstStreamidDemuxPad *candidate = GST_STREAMID_DEMUX_PAD (value);
+
+    if (!gst_streamid_demux_pad_is_reclaimable (demux, candidate, now))
+      continue;
+
+    if (!dpad || candidate->inactive_since < dpad->inactive_since) {
+      dpad = candidate;
+      old_stream_id = key;
+    }
+  }
+
+  if (dpad) {
+    /* the reference held by the table moves over to the new stream-id */
+    g_hash_table_steal (demux->stream_id_pairs, old_stream_id);
+    g_hash_table_insert (demux->stream_id_pairs, g_strdup (stream_id), dpad);
+
+    g_free (dpad->prev_stream_id);
+    dpad->prev_stream_id = old_stream_id;
+    dpad->eos = FALSE;
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  if (!dpad)
+    return NULL;
+
+  GST_INFO_OBJECT (dpad, "recycled for stream-id %s, was %s", stream_id,
+      dpad->prev_stream_id);
+
+  /* restart the pad task if downstream stopped it */
+  if (dpad->queue && g_atomic_int_get (&dpad->srcresult) != GST_FLOW_OK) {
+    gst_data_queue_set_flushing (dpad->queue, TRUE);
+    gst_pad_pause_task (GST_PAD_CAST (dpad));
+    g_atomic_int_set (&dpad->srcresult, GST_FLOW_OK);
+    gst_data_queue_set_flushing (dpad->queue, FALSE);
+    gst_pad_start_task (GST_PAD_CAST (dpad),
+        (GstTaskFunction) gst_streamid_demux_pad_loop, dpad, NULL);
+  }
+
+  return GST_PAD_CAST (dpad);
+}
+
 static void
 gst_streamid_demux_srcpad_create (GstStreamidDemux * demux, GstPad * pad,
     const gchar * stream_id)
@@ -181,17 +760,30 @@ gst_streamid_demux_srcpad_create (GstStreamidDemux * demux, GstPad * pad,
   padname = g_strdup_printf ("src_%u", demux->nb_srcpads++);
   pad_tmpl = gst_static_pad_template_get (&gst_streamid_demux_src_factory);
 
-  srcpad = gst_pad_new_from_template (pad_tmpl, padname);
+  srcpad = g_object_new (GST_TYPE_STREAMID_DEMUX_PAD, "name", padname,
+      "direction", GST_PAD_SRC, "template", pad_tmpl, NULL);
   gst_object_unref (pad_tmpl);
   g_free (padname);
 
   GST_OBJECT_LOCK (demux);
-
-  demux->active_srcpad = srcpad;
+  if (demux->async_push) {
+    GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (srcpad);
+
+    dpad->max_size_buffers = demux->max_size_buffers;
+    dpad->queue =
+        gst_data_queue_new (gst_streamid_demux_pad_check_full, NULL, NULL,
+        dpad);
+    gst_pad_set_activatemode_function (srcpad,
+        GST_DEBUG_FUNCPTR (gst_streamid_demux_pad_activate_mode));
+  }
   g_hash_table_insert (demux->stream_id_pairs, g_strdup (stream_id),
       gst_object_ref (srcpad));
   GST_OBJECT_UNLOCK (demux);
 
+  /* the table holds the reference from now on, so publishing the pointer is
+   * enough for the streaming thread */
+  gst_streamid_demux_set_active_srcpad (demux, srcpad);
+
   gst_pad_set_active (srcpad, TRUE);
 
   /* Forward sticky events to the new srcpad */
@@ -209,23 +801,51 @@ gst_streamid_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   demux = GST_STREAMID_DEMUX (parent);
 
-  GST_LOG_OBJECT (demux, "pushing buffer to %" GST_PTR_FORMAT,
-      demux->active_srcpad);
+  /* No lock and no ref here. The pad can't go away while we're streaming,
+   * because it's only released in gst_streamid_demux_reset() */
+  srcpad = g_atomic_pointer_get (&demux->active_srcpad);
 
-  GST_OBJECT_LOCK (demux);
-  if (demux->active_srcpad) {
-    srcpad = gst_object_ref (demux->active_srcpad);
-    GST_OBJECT_UNLOCK (demux);
-    res = gst_pad_push (srcpad, buf);
-    gst_object_unref (srcpad);
+  GST_LOG_OBJECT (demux, "pushing buffer to %" GST_PTR_FORMAT, srcpad);
+
+  if (srcpad) {
+    res = gst_streamid_demux_push (srcpad, GST_MINI_OBJECT_CAST (buf));
   } else {
-    GST_OBJECT_UNLOCK (demux);
+    GST_WARNING_OBJECT (demux, "no active srcpad, dropping buffer");
+    gst_buffer_unref (buf);
   }
 
   GST_LOG_OBJECT (demux, "handled buffer %s", gst_flow_get_name (res));
   return res;
 }
 
+/* All buffers of a list belong to the same stream, so the whole list goes
+ * to the active pad in one push */
+static GstFlowReturn
+gst_streamid_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFlowReturn res = GST_FLOW_OK;
+  GstStreamidDemux *demux = NULL;
+  GstPad *srcpad = NULL;
+
+  demux = GST_STREAMID_DEMUX (parent);
+
+  srcpad = g_atomic_pointer_get (&demux->active_srcpad);
+
+  GST_LOG_OBJECT (demux, "pushing list of %u buffers to %" GST_PTR_FORMAT,
+      gst_buffer_list_length (list), srcpad);
+
+  if (srcpad) {
+    res = gst_streamid_demux_push (srcpad, GST_MINI_OBJECT_CAST (list));
+  } else {
+    GST_WARNING_OBJECT (demux, "no active srcpad, dropping buffer list");
+    gst_buffer_list_unref (list);
+  }
+
+  GST_LOG_OBJECT (demux, "handled buffer list %s", gst_flow_get_name (res));
+  return res;
+}
+
 static GstPad *
 gst_streamid_demux_get_srcpad_by_stream_id (GstStreamidDemux * demux,
     const gchar * stream_id)
@@ -248,6 +868,82 @@ done:
   return srcpad;
 }
 
+/* Keep the STREAM_START of a recycled srcpad back until downstream accepted
+ * the caps of the new stream. Takes @event when returning TRUE */
+static gboolean
+gst_streamid_demux_hold_stream_start (GstStreamidDemux * demux,
+    GstPad * srcpad, GstEvent * event)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (srcpad);
+  GstEvent *old = NULL;
+  gboolean held;
+
+  GST_OBJECT_LOCK (demux);
+  held = (dpad->prev_stream_id != NULL);
+  if (held) {
+    old = dpad->pending_stream_start;
+    dpad->pending_stream_start = event;
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  if (old)
+    gst_event_unref (old);
+
+  return held;
+}
+
+/* First caps on a recycled srcpad. If downstream can't take them, the pad
+ * goes back to its previous stream-id without having seen the new stream,
+ * and the stream gets a new srcpad */
+static void
+gst_streamid_demux_check_recycled_caps (GstStreamidDemux * demux,
+    GstPad * sinkpad, GstPad * srcpad, GstEvent * event)
+{
+  GstStreamidDemuxPad *dpad = GST_STREAMID_DEMUX_PAD (srcpad);
+  GstCaps *caps = NULL;
+  gchar *stream_id = NULL;
+  gchar *prev_stream_id = NULL;
+  GstEvent *stream_start = NULL;
+  gpointer key = NULL;
+
+  gst_event_parse_caps (event, &caps);
+  stream_id = gst_pad_get_stream_id (sinkpad);
+
+  GST_OBJECT_LOCK (demux);
+  prev_stream_id = dpad->prev_stream_id;
+  dpad->prev_stream_id = NULL;
+  stream_start = dpad->pending_stream_start;
+  dpad->pending_stream_start = NULL;
+  GST_OBJECT_UNLOCK (demux);
+
+  if (gst_pad_peer_query_accept_caps (srcpad, caps)) {
+    GST_DEBUG_OBJECT (srcpad, "downstream accepted %" GST_PTR_FORMAT, caps);
+    if (stream_start)
+      gst_streamid_demux_push_event (srcpad, stream_start);
+    g_signal_emit (demux, gst_streamid_demux_signals[SIGNAL_PAD_RECYCLED], 0,
+        srcpad, stream_id, caps);
+    g_free (prev_stream_id);
+  } else {
+    GST_INFO_OBJECT (srcpad, "downstream refused %" GST_PTR_FORMAT
+        ", creating a new srcpad for %s", caps, stream_id);
+    if (stream_start)
+      gst_event_unref (stream_start);
+
+    GST_OBJECT_LOCK (demux);
+    if (g_hash_table_lookup_extended (demux->stream_id_pairs, stream_id, &key,
+            NULL)) {
+      g_hash_table_steal (demux->stream_id_pairs, stream_id);
+      g_free (key);
+    }
+    g_hash_table_insert (demux->stream_id_pairs, prev_stream_id, srcpad);
+    GST_OBJECT_UNLOCK (demux);
+
+    gst_streamid_demux_srcpad_create (demux, sinkpad, stream_id);
+  }
+
+  g_free (stream_id);
+}
+
 static gboolean
 gst_streamid_demux_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -268,28 +964,38 @@ gst_streamid_demux_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
     active_srcpad =
         gst_streamid_demux_get_srcpad_by_stream_id (demux, stream_id);
+    if (!active_srcpad && g_atomic_int_get (&demux->recycle_pads))
+      active_srcpad = gst_streamid_demux_srcpad_recycle (demux, stream_id);
+
     if (!active_srcpad) {
       gst_streamid_demux_srcpad_create (demux, pad, stream_id);
-    } else if (demux->active_srcpad != active_srcpad) {
-      GST_OBJECT_LOCK (demux);
-      demux->active_srcpad = active_srcpad;
-      GST_OBJECT_UNLOCK (demux);
+    } else if (g_atomic_pointer_get (&demux->active_srcpad) != active_srcpad) {
+      gst_streamid_demux_set_active_srcpad (demux, active_srcpad);
 
       g_object_notify (G_OBJECT (demux), "active-pad");
     }
+
+    if (active_srcpad
+        && gst_streamid_demux_hold_stream_start (demux, active_srcpad, event))
+      return TRUE;
+  } else if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+    active_srcpad = g_atomic_pointer_get (&demux->active_srcpad);
+    if (active_srcpad && GST_STREAMID_DEMUX_PAD (active_srcpad)->prev_stream_id)
+      gst_streamid_demux_check_recycled_caps (demux, pad, active_srcpad, event);
+  } else if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    gst_streamid_demux_set_eos (demux, TRUE);
+  } else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    gst_streamid_demux_set_eos (demux, FALSE);
   }
 
   if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_START
       || GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP
       || GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
-    res = gst_pad_event_default (pad, parent, event);
-  } else if (demux->active_srcpad) {
-    GstPad *srcpad = NULL;
-    GST_OBJECT_LOCK (demux);
-    srcpad = gst_object_ref (demux->active_srcpad);
-    GST_OBJECT_UNLOCK (demux);
-    res = gst_pad_push_event (srcpad, event);
-    gst_object_unref (srcpad);
+    /* decided per srcpad, async-push may have changed since some of them
+     * were created */
+    res = gst_streamid_demux_forward_event (demux, event);
+  } else if ((active_srcpad = g_atomic_pointer_get (&demux->active_srcpad))) {
+    res = gst_streamid_demux_push_event (active_srcpad, event);
   } else {
     gst_event_unref (event);
   }
@@ -325,17 +1031,13 @@ gst_streamid_demux_reset (GstStreamidDemux * demux)
   GstIterator *it = NULL;
   GstIteratorResult itret = GST_ITERATOR_OK;
 
+  /* Streaming is stopped by now, so nobody can be holding the published
+   * pointer any more. This is where the deferred release happens. */
   GST_OBJECT_LOCK (demux);
-  if (demux->active_srcpad != NULL)
-    demux->active_srcpad = NULL;
-
+  g_atomic_pointer_set (&demux->active_srcpad, NULL);
+  g_hash_table_remove_all (demux->stream_id_pairs);
   GST_OBJECT_UNLOCK (demux);
 
-  if (demux->stream_id_pairs != NULL) {
-    g_hash_table_unref (demux->stream_id_pairs);
-    demux->stream_id_pairs = NULL;
-  }
-
   it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (demux));
   while (itret == GST_ITERATOR_OK || itret == GST_ITERATOR_RESYNC) {
     itret =
@@ -27,6 +27,7 @@
 #define __GST_STREAMID_DEMUX_H__
 
 #include <gst/gst.h>
+#include <gst/base/gstdataqueue.h>
 
 G_BEGIN_DECLS
 #define GST_TYPE_STREAMID_DEMUX \
@@ -39,8 +40,16 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_STREAMID_DEMUX))
 #define GST_IS_STREAMID_DEMUX_CLASS(klass) \
   (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_STREAMID_DEMUX))
+#define GST_TYPE_STREAMID_DEMUX_PAD \
+  (gst_streamid_demux_pad_get_type())
+#define GST_STREAMID_DEMUX_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_STREAMID_DEMUX_PAD, GstStreamidDemuxPad))
+#define GST_IS_STREAMID_DEMUX_PAD(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_STREAMID_DEMUX_PAD))
 typedef struct _GstStreamidDemux GstStreamidDemux;
 typedef struct _GstStreamidDemuxClass GstStreamidDemuxClass;
+typedef struct _GstStreamidDemuxPad GstStreamidDemuxPad;
+typedef struct _GstStreamidDemuxPadClass GstStreamidDemuxPadClass;
 
 struct _GstStreamidDemux
 {
@@ -49,18 +58,55 @@ struct _GstStreamidDemux
   GstPad *sinkpad;
 
   guint nb_srcpads;
+
+  /* published with g_atomic_pointer_set(), read lock-free from the streaming
+   * thread. The reference is owned by stream_id_pairs and only dropped in
+   * reset, after streaming has stopped */
   GstPad *active_srcpad;
 
   /* This table contains srcpad and stream-id */
   GHashTable *stream_id_pairs;
+
+  /* push from a streaming thread per srcpad */
+  gboolean async_push;
+  guint max_size_buffers;
+
+  /* hand srcpads of finished or idle streams over to new stream-ids */
+  gboolean recycle_pads;
+  GstClockTime idle_timeout;
 };
 
 struct _GstStreamidDemuxClass
 {
   GstElementClass parent_class;
+
+  void (*pad_recycled) (GstStreamidDemux * demux, GstPad * pad,
+      const gchar * stream_id, GstCaps * caps);
+};
+
+struct _GstStreamidDemuxPad
+{
+  GstPad pad;
+
+  /* only used in async-push mode, the pad task pops from it */
+  GstDataQueue *queue;
+  guint max_size_buffers;
+  GstFlowReturn srcresult;
+
+  /* recycling state, protected by the object lock of the demuxer */
+  gboolean eos;
+  gint64 inactive_since;        /* monotonic time, 0 while active */
+  gchar *prev_stream_id;        /* set until the new caps are accepted */
+  GstEvent *pending_stream_start;       /* held back until then */
+};
+
+struct _GstStreamidDemuxPadClass
+{
+  GstPadClass parent_class;
 };
 
 G_GNUC_INTERNAL GType gst_streamid_demux_get_type (void);
+G_GNUC_INTERNAL GType gst_streamid_demux_pad_get_type (void);
 
 G_END_DECLS
 #endif /* __GST_STREAMID_DEMUX_H__ */
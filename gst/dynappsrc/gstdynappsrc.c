@@ -38,6 +38,9 @@
  * should be created before changing state READY to PAUSED. Therefore application
  * need to create appsrc element as soon as receiving source-setup signal.
  * Then appsrc can be configured by setting the element to PAUSED state.
+ * An appsrc created in PAUSED or PLAYING gets its srcpad right away, for a
+ * track that shows up mid-stream, and remove-appsrc takes a stream away
+ * again without restarting the others.
  *
  * When playback has finished (an EOS message has been received on the bus)
  * or an error has occured (an ERROR message has been received on the bus) or
@@ -82,6 +85,59 @@
  * ]|
  * This will create appsrc elements when called source notify handler.
  * </refsect2>
+ * <refsect2>
+ * <title>Direct push</title>
+ * <para>
+ * Applications linking the plugin can feed a stream by its index, the order
+ * of new-appsrc, with gst_dyn_appsrc_push_buffer(),
+ * gst_dyn_appsrc_push_buffer_list() and gst_dyn_appsrc_push_wrapped()
+ * instead of emitting push-buffer, which marshals every buffer through a
+ * GValue. gst_dyn_appsrc_push_wrapped() wraps memory owned by the
+ * application, an mmap or memfd region for instance, without allocating or
+ * copying and calls back when the pipeline released it.
+ * </para>
+ * |[
+ * gst_dyn_appsrc_push_wrapped (GST_DYN_APPSRC (dynappsrc), 0, data, length,
+ *     offset, CHUNK_SIZE, GST_CLOCK_TIME_NONE, g_mapped_file_ref (file),
+ *     (GDestroyNotify) g_mapped_file_unref);
+ * ]|
+ * <para>
+ * Producers that fill their own buffers can get a pool of pre-allocated
+ * buffers of a fixed size per stream with the get-buffer-pool action signal
+ * or gst_dyn_appsrc_get_buffer_pool(). Buffers acquired from it and pushed
+ * go back to the pool once the pipeline released them, so feeding does not
+ * allocate, and acquiring blocks while all buffers are in flight, which
+ * bounds the memory of the stream.
+ * </para>
+ * |[
+ * pool = gst_dyn_appsrc_get_buffer_pool (dynappsrc, 0, 64 * 1024, 16);
+ * gst_buffer_pool_acquire_buffer (pool, &buffer, NULL);
+ * gst_buffer_set_size (buffer, 64 * 1024);
+ * ... fill buffer, gst_buffer_set_size() to the filled length ...
+ * gst_dyn_appsrc_push_buffer (dynappsrc, 0, buffer);
+ * ]|
+ * </refsect2>
+ * <refsect2>
+ * <title>Shared memory</title>
+ * <para>
+ * A producer in another process, a demuxer or a DRM service for instance,
+ * can feed dynappsrc through a ring in shared memory instead of copying
+ * every packet to the application. It creates the ring in a memfd with the
+ * layout of gstdynshm.h, one lane per stream, and sends the descriptor, and
+ * optionally two eventfds, to the application, which plays
+ * <literal>dynappsrc://shm?fd=N&amp;notify=N&amp;release=N</literal> with the
+ * descriptor numbers it received. The producer writes to the notify eventfd
+ * when it filled a slot, dynappsrc writes to the release eventfd when a slot
+ * is free again. Without notify the lanes are polled.
+ * </para>
+ * <para>
+ * Going to PAUSED maps the ring and creates an appsrc for every lane, after
+ * the appsrc elements of the application if any, with the caps the producer
+ * left in the lane. Slots are pushed in place, wrapped as read-only memory,
+ * and given back to the producer when the pipeline freed the buffer. The
+ * descriptors stay owned by the application.
+ * </para>
+ * </refsect2>
  */
 
 #ifdef HAVE_CONFIG_H
@@ -92,7 +148,13 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <gst/app/gstappsrc.h>
+
 #include "gstdynappsrc.h"
+#include "gstdynbudget.h"
+#include "gstdyninterleave.h"
+#include "gstdynlive.h"
+#include "gstdynshm.h"
 
 GST_DEBUG_CATEGORY_STATIC (dyn_appsrc_debug);
 #define GST_CAT_DEFAULT dyn_appsrc_debug
@@ -100,21 +162,34 @@ GST_DEBUG_CATEGORY_STATIC (dyn_appsrc_debug);
 #define parent_class gst_dyn_appsrc_parent_class
 
 #define DEFAULT_PROP_URI NULL
+#define DEFAULT_PROP_MAX_BYTES 0
+#define DEFAULT_PROP_INTERLEAVE_WINDOW 0
+#define DEFAULT_PROP_LIVE FALSE
+#define DEFAULT_PROP_LATENCY (200 * GST_MSECOND)
 
 enum
 {
   PROP_0,
   PROP_URI,
   PROP_N_SRC,
+  PROP_MAX_BYTES,
+  PROP_BUDGET_STATS,
+  PROP_INTERLEAVE_WINDOW,
+  PROP_LIVE,
+  PROP_LATENCY,
+  PROP_LIVE_STATS,
   PROP_LAST
 };
 
 enum
 {
   SIGNAL_NEW_APPSRC,
+  SIGNAL_SEEK_DATA,
 
   /* actions */
   SIGNAL_END_OF_STREAM,
+  SIGNAL_GET_BUFFER_POOL,
+  SIGNAL_REMOVE_APPSRC,
   LAST_SIGNAL
 };
 
@@ -173,14 +248,113 @@ gst_dyn_appsrc_class_init (GstDynAppSrcClass * klass)
           "Total number of source streams", 0, G_MAXINT, 0,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDynAppSrc:max-bytes
+   *
+   * Bytes all appsrc elements may queue together, 0 leaves the max-bytes of
+   * each appsrc alone. The budget is split between the streams by the rate
+   * at which downstream consumes them, by setting their max-bytes, so that
+   * need-data and enough-data throttle each producer within its share.
+   * Read when going to PAUSED.
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BYTES,
+      g_param_spec_uint64 ("max-bytes", "Max bytes",
+          "Bytes queued in all appsrc elements together (0 = no budget)",
+          0, G_MAXUINT64, DEFAULT_PROP_MAX_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:budget-stats
+   *
+   * A structure named "budget-stats" with the "max-bytes", total "level"
+   * and "n-streams" of the budget, and for every stream N "level-N",
+   * "max-bytes-N" and the consumption "rate-N" in bytes per second. The
+   * level only counts buffers pushed with push-buffer or the direct push
+   * functions. %NULL while there is no budget.
+   */
+  g_object_class_install_property (gobject_class, PROP_BUDGET_STATS,
+      g_param_spec_boxed ("budget-stats", "Budget statistics",
+          "Fill level and share of the byte budget per stream",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:interleave-window
+   *
+   * Maximum running time, in nanoseconds, a stream may be ahead of the
+   * slowest one. A stream further ahead is held at the srcpad of its appsrc,
+   * so its queue fills up and the application gets enough-data for it
+   * until the others caught up. Streams are only held in PLAYING, so that
+   * the sinks can preroll. Only streams in TIME format count, sparse
+   * streams and streams that ended don't hold others back. 0 disables.
+   *
+   * Whether interleaving is on is decided at the READY to PAUSED
+   * transition: a window set while it was 0 takes effect the next time the
+   * element goes to PAUSED. A non-zero window can be changed at any time.
+   */
+  g_object_class_install_property (gobject_class, PROP_INTERLEAVE_WINDOW,
+      g_param_spec_uint64 ("interleave-window", "Interleave window",
+          "Running time a stream may be ahead of the others (0 = disabled)",
+          0, G_MAXUINT64, DEFAULT_PROP_INTERLEAVE_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:live
+   *
+   * The streams come from a live sender, broadcast packets for instance,
+   * with timestamps of the sender clock. The appsrc elements become live
+   * and the buffers are timestamped again on the pipeline clock, following
+   * the skew between the clocks estimated from the time the buffers are
+   * pushed at, so queues neither grow nor run dry as the clocks drift
+   * apart. All streams must be timestamped by the same sender clock. Read
+   * when going to PAUSED.
+   *
+   * The push time is taken in the push-buffer signal and the
+   * gst_dyn_appsrc_push_*() functions. Buffers pushed with
+   * gst_app_src_push_buffer() are taken as pushed when they leave their
+   * appsrc, which is later when it queues.
+   */
+  g_object_class_install_property (gobject_class, PROP_LIVE,
+      g_param_spec_boolean ("live", "Live",
+          "Recover the clock of a live sender", DEFAULT_PROP_LIVE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:latency
+   *
+   * Latency, in nanoseconds, the live streams are played with. It has to
+   * cover the network jitter and how far ahead of each other the streams
+   * are sent. Buffers later than that are late at the sinks, and when a
+   * run of them is, the timestamps are mapped again from the last one.
+   */
+  g_object_class_install_property (gobject_class, PROP_LATENCY,
+      g_param_spec_uint64 ("latency", "Latency",
+          "Latency of the live streams, in nanoseconds", 0, G_MAXINT64,
+          DEFAULT_PROP_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDynAppSrc:live-stats
+   *
+   * A structure named "live-stats" with the "latency" bound, the "skew" in
+   * nanoseconds the sender clock is behind the pipeline clock since the
+   * mapping started, the "drift" in parts per million it grows by, the largest
+   * delay of a buffer in the last window over the least delayed one
+   * "jitter", the number of buffers that were "late" and of times the
+   * mapping started over, "resyncs". %NULL if dynappsrc never was live.
+   */
+  g_object_class_install_property (gobject_class, PROP_LIVE_STATS,
+      g_param_spec_boxed ("live-stats", "Live statistics",
+          "Skew and latency achieved on the live streams",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstDynAppSrc::new-appsrc
    * @dynappsrc: a #GstDynAppSrc
    * @name : name of appsrc element
    *
    * Action signal to create a appsrc element.
-   * This signal should be emitted before changing state READY to PAUSED.
-   * The application emit this signal as soon as receiving source-setup signal from pipeline.
+   * The streams known from the start should be created before changing state
+   * READY to PAUSED, as soon as receiving source-setup signal from pipeline.
+   * Streams created later are added to the running bin with a new srcpad.
    *
    * Returns: a GstElement of appsrc element or NULL when element creation failed.
    */
@@ -190,6 +364,30 @@ gst_dyn_appsrc_class_init (GstDynAppSrcClass * klass)
       G_STRUCT_OFFSET (GstDynAppSrcClass, new_appsrc), NULL, NULL,
       g_cclosure_marshal_generic, GST_TYPE_ELEMENT, 1, G_TYPE_STRING);
 
+  /**
+   * GstDynAppSrc::seek-data
+   * @dynappsrc: a #GstDynAppSrc
+   * @format: the format of @position
+   * @position: the position all streams should continue from
+   *
+   * Emitted once per seek, from the seek-data of the first appsrc, once its
+   * queue was flushed. The application repositions all its streams,
+   * typically in one pass over the container, and returns %TRUE. The
+   * seek-data signal of the appsrc elements is answered by dynappsrc, so
+   * they need stream-type seekable or random-access and no handler of their
+   * own. The other appsrc elements flush right after, so the data of the
+   * new position should only be pushed from need-data.
+   *
+   * Without a handler every appsrc emits its own seek-data as before.
+   *
+   * Returns: %TRUE if the streams were repositioned.
+   */
+  gst_dyn_appsrc_signals[SIGNAL_SEEK_DATA] =
+      g_signal_new ("seek-data", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (GstDynAppSrcClass, seek_data),
+      NULL, NULL, g_cclosure_marshal_generic, G_TYPE_BOOLEAN, 2,
+      GST_TYPE_FORMAT, G_TYPE_UINT64);
+
   /**
     * GstDynAppSrc::end-of-stream:
     * @dynappsrc: the dynappsrc
@@ -202,8 +400,45 @@ gst_dyn_appsrc_class_init (GstDynAppSrcClass * klass)
           end_of_stream), NULL, NULL, g_cclosure_marshal_generic,
       GST_TYPE_FLOW_RETURN, 0, G_TYPE_NONE);
 
+  /**
+    * GstDynAppSrc::get-buffer-pool:
+    * @dynappsrc: the dynappsrc
+    * @index: the stream, in the order the appsrc elements were created
+    * @size: size of the buffers
+    * @max_buffers: number of buffers, 0 for no limit
+    *
+    * Get the pool of stream @index, creating it on the first call. The pool
+    * is active and lives until dynappsrc goes back to READY.
+    *
+    * Returns: (transfer full): a #GstBufferPool or NULL when there is no
+    * stream @index or its pool was created with another configuration.
+    */
+  gst_dyn_appsrc_signals[SIGNAL_GET_BUFFER_POOL] =
+      g_signal_new ("get-buffer-pool", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstDynAppSrcClass,
+          get_buffer_pool), NULL, NULL, g_cclosure_marshal_generic,
+      GST_TYPE_BUFFER_POOL, 3, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT);
+
+  /**
+    * GstDynAppSrc::remove-appsrc:
+    * @dynappsrc: the dynappsrc
+    * @appsrc: an appsrc returned by new-appsrc
+    *
+    * Remove the stream of @appsrc, in any state. When running, the srcpad of
+    * the stream gets EOS and is removed.
+    *
+    * Returns: %TRUE if @appsrc was a stream of @dynappsrc.
+    */
+  gst_dyn_appsrc_signals[SIGNAL_REMOVE_APPSRC] =
+      g_signal_new ("remove-appsrc", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION, G_STRUCT_OFFSET (GstDynAppSrcClass,
+          remove_appsrc), NULL, NULL, g_cclosure_marshal_generic,
+      G_TYPE_BOOLEAN, 1, GST_TYPE_ELEMENT);
+
   klass->new_appsrc = gst_dyn_appsrc_new_appsrc;
+  klass->remove_appsrc = gst_dyn_appsrc_remove_appsrc;
   klass->end_of_stream = gst_dyn_appsrc_end_of_stream;
+  klass->get_buffer_pool = gst_dyn_appsrc_get_buffer_pool;
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_dyn_appsrc_change_state);
@@ -223,6 +458,25 @@ gst_dyn_appsrc_init (GstDynAppSrc * bin)
   bin->uri = g_strdup (DEFAULT_PROP_URI);
   bin->appsrc_list = NULL;
   bin->n_source = 0;
+  bin->running = FALSE;
+  bin->max_bytes = DEFAULT_PROP_MAX_BYTES;
+  bin->budget = NULL;
+  bin->interleave_window = DEFAULT_PROP_INTERLEAVE_WINDOW;
+  bin->interleave = NULL;
+  bin->live = DEFAULT_PROP_LIVE;
+  bin->latency = DEFAULT_PROP_LATENCY;
+  bin->recovery = NULL;
+  bin->shm = NULL;
+  bin->shm_base = 0;
+
+  g_mutex_init (&bin->seek_lock);
+  bin->seek_seqnum = 0;
+  bin->seek_res = FALSE;
+  bin->batch_seeking = FALSE;
+  bin->batch_pending = FALSE;
+  bin->batch_res = FALSE;
+  bin->batch_format = GST_FORMAT_UNDEFINED;
+  bin->batch_position = 0;
 
   GST_OBJECT_FLAG_SET (bin, GST_ELEMENT_FLAG_SOURCE);
 }
@@ -244,6 +498,36 @@ gst_dyn_appsrc_set_property (GObject * object, guint prop_id,
       iface->set_uri (handler, g_value_get_string (value), NULL);
     }
       break;
+    case PROP_MAX_BYTES:
+      GST_OBJECT_LOCK (bin);
+      bin->max_bytes = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_INTERLEAVE_WINDOW:
+      GST_OBJECT_LOCK (bin);
+      bin->interleave_window = g_value_get_uint64 (value);
+      if (bin->interleave)
+        gst_dyn_interleave_set_window (bin->interleave,
+            bin->interleave_window);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_LIVE:
+      GST_OBJECT_LOCK (bin);
+      bin->live = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_LATENCY:
+    {
+      GstClockTime latency = g_value_get_uint64 (value);
+
+      GST_OBJECT_LOCK (bin);
+      bin->latency = latency;
+      GST_OBJECT_UNLOCK (bin);
+      /* it posts a latency message */
+      if (bin->recovery)
+        gst_dyn_live_set_latency (bin->recovery, latency);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -258,7 +542,9 @@ gst_dyn_appsrc_get_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_URI:
+      GST_OBJECT_LOCK (bin);
       g_value_set_string (value, bin->uri);
+      GST_OBJECT_UNLOCK (bin);
       break;
     case PROP_N_SRC:
     {
@@ -267,6 +553,38 @@ gst_dyn_appsrc_get_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (bin);
       break;
     }
+    case PROP_MAX_BYTES:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->max_bytes);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_INTERLEAVE_WINDOW:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->interleave_window);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_LIVE:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_boolean (value, bin->live);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_LATENCY:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint64 (value, bin->latency);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_LIVE_STATS:
+      if (bin->recovery)
+        g_value_take_boxed (value, gst_dyn_live_get_stats (bin->recovery));
+      else
+        g_value_set_boxed (value, NULL);
+      break;
+    case PROP_BUDGET_STATS:
+      if (bin->budget)
+        g_value_take_boxed (value, gst_dyn_budget_get_stats (bin->budget));
+      else
+        g_value_set_boxed (value, NULL);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -280,6 +598,15 @@ gst_dyn_appsrc_finalize (GObject * self)
 
   g_free (bin->uri);
 
+  if (bin->budget)
+    gst_dyn_budget_free (bin->budget);
+  if (bin->interleave)
+    gst_dyn_interleave_free (bin->interleave);
+  if (bin->recovery)
+    gst_dyn_live_free (bin->recovery);
+
+  g_mutex_clear (&bin->seek_lock);
+
   G_OBJECT_CLASS (parent_class)->finalize (self);
 }
 
@@ -299,6 +626,114 @@ gst_dyn_appsrc_handle_src_query (GstPad * pad, GstObject * parent,
   return res;
 }
 
+/* called with the seek lock, from dispatch_seek or the seek-data of the
+ * first appsrc */
+static gboolean
+emit_batch_seek_data (GstDynAppSrc * bin)
+{
+  gboolean handled = FALSE;
+
+  GST_OBJECT_LOCK (bin);
+  bin->batch_pending = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+
+  GST_DEBUG_OBJECT (bin, "seek-data to %" G_GUINT64_FORMAT " in %s",
+      bin->batch_position, gst_format_get_name (bin->batch_format));
+  g_signal_emit (bin, gst_dyn_appsrc_signals[SIGNAL_SEEK_DATA], 0,
+      bin->batch_format, bin->batch_position, &handled);
+  if (!handled)
+    GST_WARNING_OBJECT (bin, "application failed to seek");
+
+  GST_OBJECT_LOCK (bin);
+  bin->batch_res = handled;
+  GST_OBJECT_UNLOCK (bin);
+
+  return handled;
+}
+
+/* the application repositions all streams from seek-data of dynappsrc, when
+ * the first appsrc has flushed */
+static gboolean
+appsrc_seek_data_cb (GstElement * appsrc, guint64 offset, GstDynAppSrc * bin)
+{
+  gboolean res, pending;
+
+  GST_OBJECT_LOCK (bin);
+  pending = bin->batch_seeking && bin->batch_pending;
+  res = bin->batch_seeking && bin->batch_res;
+  GST_OBJECT_UNLOCK (bin);
+
+  if (pending)
+    res = emit_batch_seek_data (bin);
+
+  return res;
+}
+
+/* sends the seek to every appsrc, with the seek lock */
+static gboolean
+dispatch_seek (GstDynAppSrc * bin, GstEvent * event)
+{
+  GstIterator *it;
+  GValue data = { 0, };
+  GstPad *target;
+  gboolean res = TRUE;
+  gboolean batch;
+  gdouble rate;
+  GstFormat format;
+  GstSeekFlags flags;
+  GstSeekType start_type, stop_type;
+  gint64 start, stop;
+
+  gst_event_parse_seek (event, &rate, &format, &flags, &start_type, &start,
+      &stop_type, &stop);
+
+  /* one seek-data for all streams if the application wants it, emitted
+   * from the seek-data of the first appsrc */
+  batch = g_signal_has_handler_pending (bin,
+      gst_dyn_appsrc_signals[SIGNAL_SEEK_DATA], 0, FALSE);
+  if (batch) {
+    GST_OBJECT_LOCK (bin);
+    bin->batch_seeking = TRUE;
+    bin->batch_pending = TRUE;
+    bin->batch_res = FALSE;
+    bin->batch_format = format;
+    bin->batch_position = start;
+    GST_OBJECT_UNLOCK (bin);
+  }
+
+  it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (bin));
+  while (gst_iterator_next (it, &data) == GST_ITERATOR_OK) {
+    GstPad *srcpad = g_value_get_object (&data);
+    target = gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (srcpad));
+    if (target) {
+      res &= gst_pad_send_event (target, gst_event_ref (event));
+      gst_object_unref (target);
+    }
+    g_value_reset (&data);
+  }
+  g_value_unset (&data);
+  gst_iterator_free (it);
+
+  if (batch) {
+    gboolean pending;
+
+    GST_OBJECT_LOCK (bin);
+    pending = bin->batch_pending;
+    GST_OBJECT_UNLOCK (bin);
+
+    /* no appsrc asked, the application still has to know */
+    if (pending)
+      emit_batch_seek_data (bin);
+
+    GST_OBJECT_LOCK (bin);
+    res &= bin->batch_res;
+    bin->batch_seeking = FALSE;
+    GST_OBJECT_UNLOCK (bin);
+  }
+
+  return res;
+}
+
 static gboolean
 gst_dyn_appsrc_handle_src_event (GstPad * pad, GstObject * parent,
     GstEvent * event)
@@ -306,24 +741,26 @@ gst_dyn_appsrc_handle_src_event (GstPad * pad, GstObject * parent,
   gboolean res = TRUE;
   GstPad *target;
   GstDynAppSrc *bin = GST_DYN_APPSRC (parent);
-  GstIterator *it;
-  GValue data = { 0, };
 
   /*
    * dynappsrc handle a seek event that it send to all of linked appsrce elements.
+   * The same seek arrives from every stream downstream, only the first one is
+   * dispatched.
    */
   if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
-    it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (bin));
-    while (gst_iterator_next (it, &data) == GST_ITERATOR_OK) {
-      GstPad *srcpad = g_value_get_object (&data);
-      target = gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (srcpad));
-      res = gst_pad_send_event (target, gst_event_ref (event));
-      gst_object_unref (target);
-      g_value_reset (&data);
+    guint32 seqnum = gst_event_get_seqnum (event);
+
+    g_mutex_lock (&bin->seek_lock);
+    if (bin->seek_seqnum && seqnum == bin->seek_seqnum) {
+      GST_DEBUG_OBJECT (pad, "seek %u already dispatched", seqnum);
+      res = bin->seek_res;
+    } else {
+      res = dispatch_seek (bin, event);
+      bin->seek_seqnum = seqnum;
+      bin->seek_res = res;
     }
+    g_mutex_unlock (&bin->seek_lock);
     gst_event_unref (event);
-    g_value_unset (&data);
-    gst_iterator_free (it);
   } else if ((target = gst_ghost_pad_get_target (GST_GHOST_PAD_CAST (pad)))) {
     res = gst_pad_send_event (target, event);
     gst_object_unref (target);
@@ -333,41 +770,128 @@ gst_dyn_appsrc_handle_src_event (GstPad * pad, GstObject * parent,
   return res;
 }
 
-static gboolean
-setup_source (GstDynAppSrc * bin)
+/* adds the appsrc of @appsrc_group to the bin and exposes its srcpad */
+static void
+add_source (GstDynAppSrc * bin, GstAppSourceGroup * appsrc_group, guint index)
 {
-  GList *item;
   GstPadTemplate *pad_tmpl;
+  GstPad *srcpad;
   gchar *padname;
-  gboolean ret = FALSE;
 
   pad_tmpl = gst_static_pad_template_get (&src_template);
 
-  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
-    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
-    GstPad *srcpad = NULL;
+  gst_bin_add (GST_BIN_CAST (bin), appsrc_group->appsrc);
+
+  srcpad = gst_element_get_static_pad (appsrc_group->appsrc, "src");
+  padname = g_strdup_printf ("src_%u", index);
+  appsrc_group->srcpad =
+      gst_ghost_pad_new_from_template (padname, srcpad, pad_tmpl);
+  gst_pad_set_event_function (appsrc_group->srcpad,
+      gst_dyn_appsrc_handle_src_event);
+  gst_pad_set_query_function (appsrc_group->srcpad,
+      gst_dyn_appsrc_handle_src_query);
+
+  /* first, so that the other probes see the buffers retimestamped */
+  if (bin->recovery)
+    gst_dyn_live_add_stream (bin->recovery, appsrc_group->appsrc);
+  if (bin->budget)
+    gst_dyn_budget_add_stream (bin->budget, appsrc_group->appsrc, index);
+  if (bin->interleave)
+    gst_dyn_interleave_add_stream (bin->interleave, appsrc_group->appsrc);
+
+  gst_pad_set_active (appsrc_group->srcpad, TRUE);
+  gst_element_add_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (pad_tmpl);
+  g_free (padname);
+}
+
+/* undoes add_source() and drops the appsrc and pool of @appsrc_group, @eos
+ * ends the stream downstream when it goes away while running */
+static void
+release_source (GstDynAppSrc * bin, GstAppSourceGroup * appsrc_group,
+    gboolean eos)
+{
+  GstPad *peer;
+
+  if (appsrc_group->srcpad) {
+    GST_DEBUG_OBJECT (bin, "removing appsrc element and ghostpad");
+
+    /* its streaming thread may be held back, let it go before stopping */
+    if (bin->interleave)
+      gst_dyn_interleave_remove_stream (bin->interleave, appsrc_group->appsrc);
+
+    gst_element_set_state (appsrc_group->appsrc, GST_STATE_NULL);
+
+    if (bin->budget)
+      gst_dyn_budget_remove_stream (bin->budget, appsrc_group->appsrc);
+    if (bin->recovery)
+      gst_dyn_live_remove_stream (bin->recovery, appsrc_group->appsrc);
+
+    /* the stream is gone for good, don't leave downstream waiting for it */
+    if (eos && (peer = gst_pad_get_peer (appsrc_group->srcpad))) {
+      gst_pad_send_event (peer, gst_event_new_eos ());
+      gst_object_unref (peer);
+    }
+
+    gst_ghost_pad_set_target (GST_GHOST_PAD_CAST (appsrc_group->srcpad), NULL);
+    gst_pad_set_active (appsrc_group->srcpad, FALSE);
+    gst_element_remove_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
+    appsrc_group->srcpad = NULL;
+
+    gst_bin_remove (GST_BIN_CAST (bin), appsrc_group->appsrc);
+  }
+  gst_object_unref (appsrc_group->appsrc);
+  appsrc_group->appsrc = NULL;
+
+  /* wakes up producers blocked in acquire, buffers still in flight are
+   * freed when released */
+  if (appsrc_group->pool) {
+    gst_buffer_pool_set_active (appsrc_group->pool, FALSE);
+    gst_object_unref (appsrc_group->pool);
+    appsrc_group->pool = NULL;
+  }
+}
 
-    gst_bin_add (GST_BIN_CAST (bin), appsrc_group->appsrc);
+static gboolean
+setup_source (GstDynAppSrc * bin)
+{
+  GList *appsrc_list, *item;
+  guint index;
+  gboolean ret = FALSE;
 
-    srcpad = gst_element_get_static_pad (appsrc_group->appsrc, "src");
-    padname =
-        g_strdup_printf ("src_%u", g_list_position (bin->appsrc_list, item));
-    appsrc_group->srcpad =
-        gst_ghost_pad_new_from_template (padname, srcpad, pad_tmpl);
-    gst_pad_set_event_function (appsrc_group->srcpad,
-        gst_dyn_appsrc_handle_src_event);
-    gst_pad_set_query_function (appsrc_group->srcpad,
-        gst_dyn_appsrc_handle_src_query);
+  /* appsrcs created from now on are added by new-appsrc */
+  GST_OBJECT_LOCK (bin);
+  appsrc_list = g_list_copy (bin->appsrc_list);
+  bin->running = TRUE;
+  /* kept until finalize, the push functions use it without the lock */
+  if (bin->max_bytes && !bin->budget)
+    bin->budget = gst_dyn_budget_new (GST_ELEMENT_CAST (bin), bin->max_bytes);
+  else if (bin->budget)
+    gst_dyn_budget_set_max_bytes (bin->budget, bin->max_bytes);
+  if (bin->interleave_window && !bin->interleave)
+    bin->interleave = gst_dyn_interleave_new (GST_ELEMENT_CAST (bin),
+        bin->interleave_window);
+  else if (bin->interleave)
+    gst_dyn_interleave_set_flushing (bin->interleave, FALSE);
+  if (bin->live && !bin->recovery)
+    bin->recovery = gst_dyn_live_new (GST_ELEMENT_CAST (bin));
+  if (bin->recovery)
+    gst_dyn_live_reset (bin->recovery, bin->live, bin->latency);
+  GST_OBJECT_UNLOCK (bin);
 
-    gst_pad_set_active (appsrc_group->srcpad, TRUE);
-    gst_element_add_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
+  for (item = appsrc_list, index = 0; item; item = g_list_next (item), index++) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
 
-    gst_object_unref (srcpad);
-    g_free (padname);
+    /* removed before it was ever added */
+    if (!appsrc_group->appsrc)
+      continue;
 
+    add_source (bin, appsrc_group, index);
     ret = TRUE;
   }
-  gst_object_unref (pad_tmpl);
+  g_list_free (appsrc_list);
 
   if (ret) {
     GST_DEBUG_OBJECT (bin, "all appsrc elements are added");
@@ -377,49 +901,95 @@ setup_source (GstDynAppSrc * bin)
   return ret;
 }
 
+/* Undoes setup_shm(): releases the lane streams, if still there, and the
+ * ring */
 static void
-remove_source (GstDynAppSrc * bin)
+remove_shm (GstDynAppSrc * bin)
 {
-  GList *item;
+  GList *lanes, *item;
 
-  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
-    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
+  if (!bin->shm)
+    return;
 
-    GST_DEBUG_OBJECT (bin, "removing appsrc element and ghostpad");
+  GST_OBJECT_LOCK (bin);
+  lanes = g_list_nth (bin->appsrc_list, bin->shm_base);
+  if (lanes && lanes->prev) {
+    lanes->prev->next = NULL;
+    lanes->prev = NULL;
+  } else if (lanes) {
+    bin->appsrc_list = NULL;
+  }
+  bin->n_source -= MIN (bin->n_source, g_list_length (lanes));
+  GST_OBJECT_UNLOCK (bin);
 
-    gst_ghost_pad_set_target (GST_GHOST_PAD_CAST (appsrc_group->srcpad), NULL);
-    gst_element_remove_pad (GST_ELEMENT_CAST (bin), appsrc_group->srcpad);
-    appsrc_group->srcpad = NULL;
+  for (item = lanes; item; item = g_list_next (item)) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
 
-    gst_element_set_state (appsrc_group->appsrc, GST_STATE_NULL);
-    gst_bin_remove (GST_BIN_CAST (bin), appsrc_group->appsrc);
-    gst_object_unref (appsrc_group->appsrc);
-    appsrc_group->appsrc = NULL;
+    if (appsrc_group->appsrc)
+      release_source (bin, appsrc_group, FALSE);
   }
+  g_list_free_full (lanes, g_free);
 
-  g_list_free_full (bin->appsrc_list, g_free);
-  bin->appsrc_list = NULL;
+  /* buffers still in the pipeline keep the mapping */
+  gst_dyn_shm_ring_stop (bin->shm);
+  gst_dyn_shm_ring_unref (bin->shm);
+  bin->shm = NULL;
+}
 
+static void
+remove_source (GstDynAppSrc * bin)
+{
+  GList *appsrc_list, *item;
+
+  /* the direct push functions look streams up from the application threads */
+  GST_OBJECT_LOCK (bin);
+  appsrc_list = bin->appsrc_list;
+  bin->appsrc_list = NULL;
   bin->n_source = 0;
+  bin->running = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+
+  g_mutex_lock (&bin->seek_lock);
+  bin->seek_seqnum = 0;
+  g_mutex_unlock (&bin->seek_lock);
+
+  for (item = appsrc_list; item; item = g_list_next (item)) {
+    GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
+
+    if (appsrc_group->appsrc)
+      release_source (bin, appsrc_group, FALSE);
+  }
+
+  g_list_free_full (appsrc_list, g_free);
+
+  remove_shm (bin);
 }
 
 static GstElement *
 gst_dyn_appsrc_new_appsrc (GstDynAppSrc * bin, const gchar * name)
 {
   GstAppSourceGroup *appsrc_group;
+  gboolean running;
+  guint index;
 
-  GST_OBJECT_LOCK (bin);
-
-  if (GST_STATE (bin) >= GST_STATE_PAUSED) {
-    GST_WARNING_OBJECT (bin,
-        "deny to create appsrc when state is in PAUSED or PLAYING state");
-    GST_OBJECT_UNLOCK (bin);
-    return NULL;
-  }
   appsrc_group = g_malloc0 (sizeof (GstAppSourceGroup));
   appsrc_group->appsrc = gst_element_factory_make ("appsrc", name);
+  if (!appsrc_group->appsrc) {
+    GST_WARNING_OBJECT (bin, "failed to create appsrc element");
+    g_free (appsrc_group);
+    return NULL;
+  }
+
+  GST_OBJECT_LOCK (bin);
+  /* removed streams keep their slot so that indexes stay valid */
+  index = g_list_length (bin->appsrc_list);
   bin->appsrc_list = g_list_append (bin->appsrc_list, appsrc_group);
   bin->n_source++;
+  running = bin->running;
+
+  /* connected before the application can, see seek-data of dynappsrc */
+  g_signal_connect (appsrc_group->appsrc, "seek-data",
+      G_CALLBACK (appsrc_seek_data_cb), bin);
 
   GST_INFO_OBJECT (bin, "appsrc %p is appended to a list",
       appsrc_group->appsrc);
@@ -427,9 +997,71 @@ gst_dyn_appsrc_new_appsrc (GstDynAppSrc * bin, const gchar * name)
 
   GST_OBJECT_UNLOCK (bin);
 
+  /* a track showing up mid-stream gets its own pad right away, the appsrc
+   * starts its stream with a stream-start of its own like the others */
+  if (running) {
+    GST_INFO_OBJECT (bin, "adding stream %u while running", index);
+    add_source (bin, appsrc_group, index);
+    gst_element_sync_state_with_parent (appsrc_group->appsrc);
+  }
+
   return appsrc_group->appsrc;
 }
 
+/**
+ * gst_dyn_appsrc_remove_appsrc:
+ * @dynappsrc: a #GstDynAppSrc
+ * @appsrc: an appsrc returned by new-appsrc
+ *
+ * Removes the stream of @appsrc. When dynappsrc is running its srcpad gets
+ * EOS and is removed. The indexes of the other streams don't change.
+ *
+ * Returns: %TRUE if @appsrc was a stream of @dynappsrc.
+ */
+gboolean
+gst_dyn_appsrc_remove_appsrc (GstDynAppSrc * bin, GstElement * appsrc)
+{
+  GstAppSourceGroup *appsrc_group = NULL;
+  GstAppSourceGroup *removed;
+  gboolean running;
+  GList *item;
+
+  g_return_val_if_fail (GST_IS_DYN_APPSRC (bin), FALSE);
+  g_return_val_if_fail (GST_IS_ELEMENT (appsrc), FALSE);
+
+  GST_OBJECT_LOCK (bin);
+  for (item = bin->appsrc_list; item; item = g_list_next (item)) {
+    appsrc_group = (GstAppSourceGroup *) item->data;
+    if (appsrc_group->appsrc == appsrc)
+      break;
+  }
+  if (!item)
+    goto not_found;
+
+  /* leave an empty slot behind and release the stream outside of the lock */
+  removed = g_memdup (appsrc_group, sizeof (GstAppSourceGroup));
+  appsrc_group->appsrc = NULL;
+  appsrc_group->srcpad = NULL;
+  appsrc_group->pool = NULL;
+  bin->n_source--;
+  running = bin->running;
+  GST_OBJECT_UNLOCK (bin);
+
+  GST_INFO_OBJECT (bin, "removing %" GST_PTR_FORMAT, appsrc);
+
+  release_source (bin, removed, running);
+  g_free (removed);
+
+  return TRUE;
+
+not_found:
+  {
+    GST_OBJECT_UNLOCK (bin);
+    GST_WARNING_OBJECT (bin, "%" GST_PTR_FORMAT " is not a stream", appsrc);
+    return FALSE;
+  }
+}
+
 /**
  * gst_dyn_appsrc_end_of_stream:
  * @dynappsrc: a #GstDynAppSrc
@@ -444,22 +1076,354 @@ GstFlowReturn
 gst_dyn_appsrc_end_of_stream (GstDynAppSrc * bin)
 {
   GstFlowReturn ret = GST_FLOW_OK;
-  GList *item;
+  GList *appsrcs = NULL, *item;
 
+  /* remove-appsrc may drop a group meanwhile, the signal is emitted on refs
+   * taken under the lock */
+  GST_OBJECT_LOCK (bin);
   for (item = bin->appsrc_list; item; item = g_list_next (item)) {
     GstAppSourceGroup *appsrc_group = (GstAppSourceGroup *) item->data;
 
+    if (appsrc_group->appsrc)
+      appsrcs = g_list_prepend (appsrcs, gst_object_ref (appsrc_group->appsrc));
+  }
+  GST_OBJECT_UNLOCK (bin);
+  appsrcs = g_list_reverse (appsrcs);
+
+  for (item = appsrcs; item; item = g_list_next (item)) {
+    GstElement *appsrc = GST_ELEMENT_CAST (item->data);
+
     GST_DEBUG_OBJECT (bin, "indicate to appsrc element for EOS");
-    g_signal_emit_by_name (appsrc_group->appsrc, "end-of-stream", &ret);
-    GST_DEBUG_OBJECT (bin, "%s[ret:%s]",
-        GST_ELEMENT_NAME (appsrc_group->appsrc), gst_flow_get_name (ret));
+    g_signal_emit_by_name (appsrc, "end-of-stream", &ret);
+    GST_DEBUG_OBJECT (bin, "%s[ret:%s]", GST_ELEMENT_NAME (appsrc),
+        gst_flow_get_name (ret));
     if (ret != GST_FLOW_OK)
       break;
   }
+  g_list_free_full (appsrcs, gst_object_unref);
+
+  return ret;
+}
+
+/* returns a ref to the appsrc of stream @index or NULL */
+static GstElement *
+get_appsrc (GstDynAppSrc * bin, guint index)
+{
+  GstAppSourceGroup *appsrc_group;
+  GstElement *appsrc = NULL;
+
+  GST_OBJECT_LOCK (bin);
+  appsrc_group = g_list_nth_data (bin->appsrc_list, index);
+  if (appsrc_group && appsrc_group->appsrc)
+    appsrc = gst_object_ref (appsrc_group->appsrc);
+  GST_OBJECT_UNLOCK (bin);
+
+  return appsrc;
+}
+
+/**
+ * gst_dyn_appsrc_get_buffer_pool:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: the stream, in the order the appsrc elements were created
+ * @size: size of the buffers
+ * @max_buffers: number of buffers, allocated up front, 0 for no limit
+ *
+ * Get the pool of stream @index, creating and activating it on the first
+ * call. Buffers pushed from it return to it when the pipeline released them.
+ *
+ * Returns: (transfer full): the #GstBufferPool or NULL when there is no
+ * stream @index or its pool has another configuration.
+ */
+GstBufferPool *
+gst_dyn_appsrc_get_buffer_pool (GstDynAppSrc * bin, guint index, guint size,
+    guint max_buffers)
+{
+  GstAppSourceGroup *appsrc_group;
+  GstBufferPool *pool = NULL;
+  GstStructure *config;
+  guint cur_size, cur_max;
+
+  g_return_val_if_fail (GST_IS_DYN_APPSRC (bin), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  GST_OBJECT_LOCK (bin);
+  appsrc_group = g_list_nth_data (bin->appsrc_list, index);
+  if (!appsrc_group || !appsrc_group->appsrc)
+    goto no_stream;
+
+  if (appsrc_group->pool) {
+    config = gst_buffer_pool_get_config (appsrc_group->pool);
+    gst_buffer_pool_config_get_params (config, NULL, &cur_size, NULL,
+        &cur_max);
+    gst_structure_free (config);
+    if (cur_size != size || cur_max != max_buffers)
+      goto wrong_config;
+
+    pool = gst_object_ref (appsrc_group->pool);
+    GST_OBJECT_UNLOCK (bin);
+    return pool;
+  }
+
+  pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (pool);
+  /* min == max allocates everything on activation */
+  gst_buffer_pool_config_set_params (config, NULL, size, max_buffers,
+      max_buffers);
+  if (!gst_buffer_pool_set_config (pool, config)
+      || !gst_buffer_pool_set_active (pool, TRUE))
+    goto activate_failed;
+
+  appsrc_group->pool = gst_object_ref (pool);
+  GST_OBJECT_UNLOCK (bin);
+
+  GST_INFO_OBJECT (bin, "stream %u: pool of %u buffers of %u bytes", index,
+      max_buffers, size);
+
+  return pool;
+
+no_stream:
+  {
+    GST_OBJECT_UNLOCK (bin);
+    GST_WARNING_OBJECT (bin, "no stream %u", index);
+    return NULL;
+  }
+wrong_config:
+  {
+    GST_OBJECT_UNLOCK (bin);
+    GST_WARNING_OBJECT (bin, "stream %u already has a pool of %u buffers "
+        "of %u bytes", index, cur_max, cur_size);
+    return NULL;
+  }
+activate_failed:
+  {
+    GST_OBJECT_UNLOCK (bin);
+    GST_ERROR_OBJECT (bin, "failed to activate the pool of stream %u", index);
+    gst_object_unref (pool);
+    return NULL;
+  }
+}
+
+/**
+ * gst_dyn_appsrc_push_buffer:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: the stream, in the order the appsrc elements were created
+ * @buffer: (transfer full): a #GstBuffer to push
+ *
+ * Pushes @buffer to the appsrc of stream @index like its push-buffer action
+ * signal, without marshalling the call.
+ *
+ * Returns: the return value of gst_app_src_push_buffer(), or
+ * #GST_FLOW_NOT_LINKED when there is no stream @index.
+ */
+GstFlowReturn
+gst_dyn_appsrc_push_buffer (GstDynAppSrc * bin, guint index,
+    GstBuffer * buffer)
+{
+  GstElement *appsrc;
+  GstFlowReturn ret;
+
+  g_return_val_if_fail (GST_IS_DYN_APPSRC (bin), GST_FLOW_ERROR);
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
+
+  appsrc = get_appsrc (bin, index);
+  if (!appsrc)
+    goto no_stream;
+
+  if (bin->budget)
+    gst_dyn_budget_pushed (bin->budget, appsrc, gst_buffer_get_size (buffer));
+  if (bin->recovery)
+    gst_dyn_live_pushed (bin->recovery, appsrc, buffer);
+
+  ret = gst_app_src_push_buffer (GST_APP_SRC_CAST (appsrc), buffer);
+  gst_object_unref (appsrc);
+
+  return ret;
+
+no_stream:
+  {
+    GST_WARNING_OBJECT (bin, "no stream %u", index);
+    gst_buffer_unref (buffer);
+    return GST_FLOW_NOT_LINKED;
+  }
+}
+
+/**
+ * gst_dyn_appsrc_push_buffer_list:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: the stream, in the order the appsrc elements were created
+ * @list: (transfer full): a #GstBufferList to push
+ *
+ * Pushes all buffers of @list to the appsrc of stream @index, stopping at the
+ * first one that is not accepted.
+ *
+ * Returns: #GST_FLOW_OK when all buffers were queued.
+ */
+GstFlowReturn
+gst_dyn_appsrc_push_buffer_list (GstDynAppSrc * bin, guint index,
+    GstBufferList * list)
+{
+  GstElement *appsrc;
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  g_return_val_if_fail (GST_IS_DYN_APPSRC (bin), GST_FLOW_ERROR);
+  g_return_val_if_fail (GST_IS_BUFFER_LIST (list), GST_FLOW_ERROR);
+
+  appsrc = get_appsrc (bin, index);
+  if (!appsrc)
+    goto no_stream;
+
+  /* looked up once for the whole list */
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++) {
+    GstBuffer *buffer = gst_buffer_list_get (list, i);
+
+    if (bin->budget)
+      gst_dyn_budget_pushed (bin->budget, appsrc, gst_buffer_get_size (buffer));
+    if (bin->recovery)
+      gst_dyn_live_pushed (bin->recovery, appsrc, buffer);
+    ret = gst_app_src_push_buffer (GST_APP_SRC_CAST (appsrc),
+        gst_buffer_ref (buffer));
+  }
+
+  gst_object_unref (appsrc);
+  gst_buffer_list_unref (list);
+
+  return ret;
+
+no_stream:
+  {
+    GST_WARNING_OBJECT (bin, "no stream %u", index);
+    gst_buffer_list_unref (list);
+    return GST_FLOW_NOT_LINKED;
+  }
+}
+
+/**
+ * gst_dyn_appsrc_push_wrapped:
+ * @dynappsrc: a #GstDynAppSrc
+ * @index: the stream, in the order the appsrc elements were created
+ * @data: memory owned by the application, a mmap or memfd region for instance
+ * @maxsize: allocated size of @data
+ * @offset: offset of the chunk to push in @data
+ * @size: size of the chunk
+ * @pts: presentation timestamp of the chunk or #GST_CLOCK_TIME_NONE
+ * @user_data: data passed to @notify
+ * @notify: (allow-none): called with @user_data when the pipeline released
+ * the chunk
+ *
+ * Pushes a read-only chunk of @data to stream @index without allocating or
+ * copying it.
+ *
+ * Returns: see gst_dyn_appsrc_push_buffer(). @notify is called on failure too.
+ */
+GstFlowReturn
+gst_dyn_appsrc_push_wrapped (GstDynAppSrc * bin, guint index, gpointer data,
+    gsize maxsize, gsize offset, gsize size, GstClockTime pts,
+    gpointer user_data, GDestroyNotify notify)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, data,
+      maxsize, offset, size, user_data, notify);
+  GST_BUFFER_PTS (buffer) = pts;
+
+  return gst_dyn_appsrc_push_buffer (bin, index, buffer);
+}
+
+/* called from the reader thread of the ring */
+static GstFlowReturn
+shm_push_cb (guint lane, GstBuffer * buffer, GstDynAppSrc * bin)
+{
+  GstElement *appsrc;
+  GstFlowReturn ret;
+
+  if (buffer)
+    return gst_dyn_appsrc_push_buffer (bin, bin->shm_base + lane, buffer);
+
+  appsrc = get_appsrc (bin, bin->shm_base + lane);
+  if (!appsrc)
+    return GST_FLOW_NOT_LINKED;
+
+  ret = gst_app_src_end_of_stream (GST_APP_SRC_CAST (appsrc));
+  gst_object_unref (appsrc);
 
   return ret;
 }
 
+/* with a dynappsrc://shm URI, maps the ring and creates a stream per lane
+ * after those of the application */
+static gboolean
+setup_shm (GstDynAppSrc * bin)
+{
+  GError *err = NULL;
+  gint fd, notify_fd, release_fd;
+  guint lane, n_lanes;
+  gchar *uri;
+
+  GST_OBJECT_LOCK (bin);
+  uri = g_strdup (bin->uri);
+  GST_OBJECT_UNLOCK (bin);
+
+  if (!gst_dyn_shm_is_shm_uri (uri)) {
+    g_free (uri);
+    return TRUE;
+  }
+
+  if (!gst_dyn_shm_parse_uri (uri, &fd, &notify_fd, &release_fd, &err))
+    goto open_failed;
+  bin->shm = gst_dyn_shm_ring_open (GST_ELEMENT_CAST (bin), fd, notify_fd,
+      release_fd, &err);
+  if (!bin->shm)
+    goto open_failed;
+  g_free (uri);
+
+  GST_OBJECT_LOCK (bin);
+  bin->shm_base = g_list_length (bin->appsrc_list);
+  GST_OBJECT_UNLOCK (bin);
+
+  n_lanes = gst_dyn_shm_ring_get_n_lanes (bin->shm);
+  for (lane = 0; lane < n_lanes; lane++) {
+    GstElement *appsrc;
+    GstCaps *caps;
+    gchar *name;
+
+    name = g_strdup_printf ("lane%u", lane);
+    appsrc = gst_dyn_appsrc_new_appsrc (bin, name);
+    g_free (name);
+    if (!appsrc)
+      goto lane_failed;
+
+    /* held like the application holds its appsrcs, see remove_source() */
+    gst_object_ref (appsrc);
+
+    /* the ring bounds what is queued, the producer doesn't see enough-data */
+    caps = gst_dyn_shm_ring_get_caps (bin->shm, lane);
+    g_object_set (appsrc, "format", GST_FORMAT_TIME, "caps", caps,
+        "max-bytes", G_MAXUINT64, NULL);
+    if (caps)
+      gst_caps_unref (caps);
+  }
+
+  return TRUE;
+
+open_failed:
+  {
+    GST_ELEMENT_ERROR (bin, RESOURCE, OPEN_READ_WRITE, (NULL),
+        ("%s: %s", uri, err->message));
+    g_error_free (err);
+    g_free (uri);
+    return FALSE;
+  }
+lane_failed:
+  {
+    GST_ELEMENT_ERROR (bin, CORE, FAILED, (NULL),
+        ("failed to create the stream of lane %u", lane));
+    remove_shm (bin);
+    return FALSE;
+  }
+}
+
 static GstStateChangeReturn
 gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
 {
@@ -468,8 +1432,29 @@ gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
-      if (!setup_source (bin))
+      if (!setup_shm (bin))
+        return GST_STATE_CHANGE_FAILURE;
+      if (!setup_source (bin)) {
+        remove_shm (bin);
         return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      if (bin->interleave)
+        gst_dyn_interleave_set_playing (bin->interleave, TRUE);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      /* held streams would keep the sinks from prerolling again */
+      if (bin->interleave)
+        gst_dyn_interleave_set_playing (bin->interleave, FALSE);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* slots taken now would only be dropped by flushing appsrcs */
+      if (bin->shm)
+        gst_dyn_shm_ring_stop (bin->shm);
+      /* the appsrcs can't stop their tasks while they are held back */
+      if (bin->interleave)
+        gst_dyn_interleave_set_flushing (bin->interleave, TRUE);
       break;
     default:
       break;
@@ -482,6 +1467,9 @@ gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
       GST_DEBUG_OBJECT (bin, "ready to paused");
       if (ret == GST_STATE_CHANGE_FAILURE)
         goto setup_failed;
+      if (bin->shm && !gst_dyn_shm_ring_start (bin->shm,
+              (GstDynShmPushFunc) shm_push_cb, bin))
+        goto setup_failed;
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_DEBUG_OBJECT (bin, "paused to ready");
@@ -498,7 +1486,8 @@ gst_dyn_appsrc_change_state (GstElement * element, GstStateChange transition)
 
 setup_failed:
   {
-    /* clean up leftover groups */
+    /* the lanes and the ring, the application's streams stay its own */
+    remove_shm (bin);
     return GST_STATE_CHANGE_FAILURE;
   }
 }
@@ -529,6 +1518,19 @@ static gboolean
 gst_dyn_appsrc_uri_set_uri (GstURIHandler * handler, const gchar * uri,
     GError ** error)
 {
+  GstDynAppSrc *bin = GST_DYN_APPSRC (handler);
+  gint fd, notify_fd, release_fd;
+
+  /* the descriptors are only looked at when going to PAUSED */
+  if (gst_dyn_shm_is_shm_uri (uri)
+      && !gst_dyn_shm_parse_uri (uri, &fd, &notify_fd, &release_fd, error))
+    return FALSE;
+
+  GST_OBJECT_LOCK (bin);
+  g_free (bin->uri);
+  bin->uri = g_strdup (uri);
+  GST_OBJECT_UNLOCK (bin);
+
   return TRUE;
 }
 
@@ -50,6 +50,29 @@ struct _GstDynAppSrc
   GList *appsrc_list;
 
   gint n_source;
+  gboolean running;             /* srcpads are exposed, new streams too */
+
+  guint64 max_bytes;
+  struct _GstDynBudget *budget; /* shares max_bytes, NULL without */
+
+  GstClockTime interleave_window;
+  struct _GstDynInterleave *interleave; /* NULL without a window */
+
+  gboolean live;
+  GstClockTime latency;
+  struct _GstDynLive *recovery; /* clock recovery, NULL if never live */
+
+  struct _GstDynShmRing *shm;   /* fed from shared memory, or NULL */
+  guint shm_base;               /* index of the stream of the first lane */
+
+  GMutex seek_lock;             /* serializes seeks from all srcpads */
+  guint32 seek_seqnum;          /* of the last seek dispatched */
+  gboolean seek_res;
+  gboolean batch_seeking;       /* seek-data of the appsrcs is answered */
+  gboolean batch_pending;       /* our seek-data not emitted yet */
+  gboolean batch_res;           /* what the application answered */
+  GstFormat batch_format;
+  guint64 batch_position;
 };
 
 struct _GstDynAppSrcClass
@@ -58,20 +81,41 @@ struct _GstDynAppSrcClass
 
   /* create a appsrc element */
   GstElement *(*new_appsrc) (GstDynAppSrc * dynappsrc, const gchar * name);
+  gboolean (*remove_appsrc) (GstDynAppSrc * dynappsrc, GstElement * appsrc);
+
+  /* signals */
+  gboolean (*seek_data) (GstDynAppSrc * dynappsrc, GstFormat format,
+      guint64 position);
 
   /* actions */
     GstFlowReturn (*end_of_stream) (GstDynAppSrc * dynappsrc);
+  GstBufferPool *(*get_buffer_pool) (GstDynAppSrc * dynappsrc, guint index,
+      guint size, guint max_buffers);
 };
 
 struct _GstAppSourceGroup
 {
   GstElement *appsrc;
   GstPad *srcpad;
+  GstBufferPool *pool;          /* handed out to the producer, or NULL */
 };
 
 GType gst_dyn_appsrc_get_type (void);
 
 GstFlowReturn gst_dyn_appsrc_end_of_stream (GstDynAppSrc * dynappsrc);
+gboolean gst_dyn_appsrc_remove_appsrc (GstDynAppSrc * dynappsrc,
+    GstElement * appsrc);
+
+GstBufferPool *gst_dyn_appsrc_get_buffer_pool (GstDynAppSrc * dynappsrc,
+    guint index, guint size, guint max_buffers);
+
+GstFlowReturn gst_dyn_appsrc_push_buffer (GstDynAppSrc * dynappsrc,
+    guint index, GstBuffer * buffer);
+GstFlowReturn gst_dyn_appsrc_push_buffer_list (GstDynAppSrc * dynappsrc,
+    guint index, GstBufferList * list);
+GstFlowReturn gst_dyn_appsrc_push_wrapped (GstDynAppSrc * dynappsrc,
+    guint index, gpointer data, gsize maxsize, gsize offset, gsize size,
+    GstClockTime pts, gpointer user_data, GDestroyNotify notify);
 
 G_END_DECLS
 #endif /* __GST_DYN_APPSRC_H__ */
@@ -0,0 +1,317 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Shares one byte budget between the appsrc elements of dynappsrc.
+ *
+ * Every appsrc keeps throttling its producer with need-data and enough-data
+ * against its own max-bytes, the budget only moves those limits around: each
+ * stream gets a floor of a quarter of an even share, and the rest is split
+ * in proportion to the rate at which downstream takes data out of the
+ * stream. A stream consumed fast gets the room it needs and a slow one can't
+ * hold on to memory the others starve for, while the sum stays within the
+ * budget.
+ *
+ * The level of a stream is what was pushed into the appsrc, with the
+ * push-buffer signal or the direct push functions, minus what left its
+ * srcpad.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+
+#include "gstdynbudget.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dyn_budget_debug);
+#define GST_CAT_DEFAULT gst_dyn_budget_debug
+
+/* microseconds between two updates of the rates and limits */
+#define UPDATE_INTERVAL (100 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct
+{
+  GstDynBudget *budget;
+  guint index;
+
+  GstElement *appsrc;
+  GstPad *srcpad;
+  gulong probe_id;
+  gulong push_id;
+
+  guint64 in;                   /* bytes pushed into the appsrc */
+  guint64 out;                  /* bytes pushed out of its srcpad */
+  guint64 window;               /* bytes out since the last update */
+  gdouble rate;                 /* bytes per second taken by downstream */
+  guint64 limit;
+} BudgetStream;
+
+struct _GstDynBudget
+{
+  GMutex lock;
+  GstElement *owner;            /* not reffed */
+  guint64 max_bytes;
+
+  GList *streams;
+  gint64 last_update;
+};
+
+/* with the budget lock */
+static BudgetStream *
+find_stream (GstDynBudget * budget, GstElement * appsrc)
+{
+  GList *walk;
+
+  for (walk = budget->streams; walk; walk = walk->next) {
+    BudgetStream *stream = walk->data;
+    if (stream->appsrc == appsrc)
+      return stream;
+  }
+
+  return NULL;
+}
+
+/* with the budget lock, appsrc doesn't call back into us with its lock */
+static void
+update_limits (GstDynBudget * budget, gint64 now)
+{
+  GList *walk;
+  guint n_streams = g_list_length (budget->streams);
+  guint64 floor, spare;
+  gdouble total_rate = 0.0;
+  gint64 elapsed = now - budget->last_update;
+
+  if (n_streams == 0 || budget->max_bytes == 0)
+    return;
+
+  for (walk = budget->streams; walk; walk = walk->next) {
+    BudgetStream *stream = walk->data;
+
+    if (elapsed > 0) {
+      gdouble rate = stream->window * (gdouble) G_TIME_SPAN_SECOND / elapsed;
+      stream->rate = stream->rate > 0.0 ? (3 * stream->rate + rate) / 4 : rate;
+      stream->window = 0;
+    }
+    total_rate += stream->rate;
+  }
+  budget->last_update = now;
+
+  floor = budget->max_bytes / (4 * n_streams);
+  spare = budget->max_bytes - floor * n_streams;
+
+  for (walk = budget->streams; walk; walk = walk->next) {
+    BudgetStream *stream = walk->data;
+    guint64 limit;
+
+    if (total_rate > 0.0)
+      limit = floor + (guint64) (spare * (stream->rate / total_rate));
+    else
+      limit = floor + spare / n_streams;
+
+    if (limit != stream->limit) {
+      GST_LOG_OBJECT (stream->appsrc, "max-bytes %" G_GUINT64_FORMAT
+          " at %.0f bytes/s", limit, stream->rate);
+      stream->limit = limit;
+      g_object_set (stream->appsrc, "max-bytes", limit, NULL);
+    }
+  }
+}
+
+static GstPadProbeReturn
+srcpad_probe_cb (GstPad * pad, GstPadProbeInfo * info, BudgetStream * stream)
+{
+  GstDynBudget *budget = stream->budget;
+  gsize size = 0;
+  gint64 now;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    size = gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+    guint i, len = gst_buffer_list_length (list);
+
+    for (i = 0; i < len; i++)
+      size += gst_buffer_get_size (gst_buffer_list_get (list, i));
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    /* the appsrc dropped its queue */
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP) {
+      g_mutex_lock (&budget->lock);
+      stream->in = stream->out;
+      g_mutex_unlock (&budget->lock);
+    }
+    return GST_PAD_PROBE_OK;
+  } else {
+    return GST_PAD_PROBE_OK;
+  }
+
+  now = g_get_monotonic_time ();
+
+  g_mutex_lock (&budget->lock);
+  stream->out += size;
+  stream->window += size;
+  if (now - budget->last_update >= UPDATE_INTERVAL)
+    update_limits (budget, now);
+  g_mutex_unlock (&budget->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* runs before the push-buffer handler of appsrc */
+static GstFlowReturn
+push_buffer_cb (GstElement * appsrc, GstBuffer * buffer, BudgetStream * stream)
+{
+  gst_dyn_budget_pushed (stream->budget, appsrc, gst_buffer_get_size (buffer));
+
+  return GST_FLOW_OK;
+}
+
+GstDynBudget *
+gst_dyn_budget_new (GstElement * owner, guint64 max_bytes)
+{
+  GstDynBudget *budget;
+
+  GST_DEBUG_CATEGORY_INIT (gst_dyn_budget_debug, "dynappsrcbudget", 0,
+      "Byte budget of dynappsrc");
+
+  budget = g_slice_new0 (GstDynBudget);
+  g_mutex_init (&budget->lock);
+  budget->owner = owner;
+  budget->max_bytes = max_bytes;
+  budget->last_update = g_get_monotonic_time ();
+
+  GST_INFO_OBJECT (owner, "sharing %" G_GUINT64_FORMAT " bytes", max_bytes);
+
+  return budget;
+}
+
+static void
+stream_free (BudgetStream * stream)
+{
+  gst_pad_remove_probe (stream->srcpad, stream->probe_id);
+  g_signal_handler_disconnect (stream->appsrc, stream->push_id);
+  gst_object_unref (stream->srcpad);
+  gst_object_unref (stream->appsrc);
+  g_slice_free (BudgetStream, stream);
+}
+
+void
+gst_dyn_budget_free (GstDynBudget * budget)
+{
+  g_list_free_full (budget->streams, (GDestroyNotify) stream_free);
+  g_mutex_clear (&budget->lock);
+  g_slice_free (GstDynBudget, budget);
+}
+
+/* 0 stops moving the limits, the streams keep the ones they have */
+void
+gst_dyn_budget_set_max_bytes (GstDynBudget * budget, guint64 max_bytes)
+{
+  g_mutex_lock (&budget->lock);
+  budget->max_bytes = max_bytes;
+  g_mutex_unlock (&budget->lock);
+}
+
+void
+gst_dyn_budget_add_stream (GstDynBudget * budget, GstElement * appsrc,
+    guint index)
+{
+  BudgetStream *stream;
+
+  stream = g_slice_new0 (BudgetStream);
+  stream->budget = budget;
+  stream->index = index;
+  stream->appsrc = gst_object_ref (appsrc);
+  stream->srcpad = gst_element_get_static_pad (appsrc, "src");
+  stream->probe_id = gst_pad_add_probe (stream->srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, (GstPadProbeCallback) srcpad_probe_cb,
+      stream, NULL);
+  stream->push_id = g_signal_connect (appsrc, "push-buffer",
+      G_CALLBACK (push_buffer_cb), stream);
+
+  g_mutex_lock (&budget->lock);
+  budget->streams = g_list_append (budget->streams, stream);
+  update_limits (budget, g_get_monotonic_time ());
+  g_mutex_unlock (&budget->lock);
+}
+
+void
+gst_dyn_budget_remove_stream (GstDynBudget * budget, GstElement * appsrc)
+{
+  BudgetStream *stream;
+
+  g_mutex_lock (&budget->lock);
+  stream = find_stream (budget, appsrc);
+  if (stream) {
+    budget->streams = g_list_remove (budget->streams, stream);
+    /* the others get its share */
+    update_limits (budget, g_get_monotonic_time ());
+  }
+  g_mutex_unlock (&budget->lock);
+
+  if (stream)
+    stream_free (stream);
+}
+
+void
+gst_dyn_budget_pushed (GstDynBudget * budget, GstElement * appsrc, gsize size)
+{
+  BudgetStream *stream;
+
+  g_mutex_lock (&budget->lock);
+  if ((stream = find_stream (budget, appsrc)))
+    stream->in += size;
+  g_mutex_unlock (&budget->lock);
+}
+
+GstStructure *
+gst_dyn_budget_get_stats (GstDynBudget * budget)
+{
+  GstStructure *s;
+  GList *walk;
+  guint64 level = 0;
+  gchar name[32];
+
+  g_mutex_lock (&budget->lock);
+  s = gst_structure_new ("budget-stats",
+      "max-bytes", G_TYPE_UINT64, budget->max_bytes, NULL);
+
+  for (walk = budget->streams; walk; walk = walk->next) {
+    BudgetStream *stream = walk->data;
+    guint64 stream_level;
+
+    stream_level = stream->in > stream->out ? stream->in - stream->out : 0;
+    level += stream_level;
+
+    snprintf (name, sizeof (name), "level-%u", stream->index);
+    gst_structure_set (s, name, G_TYPE_UINT64, stream_level, NULL);
+    snprintf (name, sizeof (name), "max-bytes-%u", stream->index);
+    gst_structure_set (s, name, G_TYPE_UINT64, stream->limit, NULL);
+    snprintf (name, sizeof (name), "rate-%u", stream->index);
+    gst_structure_set (s, name, G_TYPE_UINT64, (guint64) stream->rate, NULL);
+  }
+  gst_structure_set (s, "n-streams", G_TYPE_UINT,
+      g_list_length (budget->streams), "level", G_TYPE_UINT64, level, NULL);
+  g_mutex_unlock (&budget->lock);
+
+  return s;
+}
@@ -0,0 +1,42 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DYN_BUDGET_H__
+#define __GST_DYN_BUDGET_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstDynBudget GstDynBudget;
+
+GstDynBudget *gst_dyn_budget_new (GstElement * owner, guint64 max_bytes);
+void gst_dyn_budget_free (GstDynBudget * budget);
+void gst_dyn_budget_set_max_bytes (GstDynBudget * budget, guint64 max_bytes);
+
+void gst_dyn_budget_add_stream (GstDynBudget * budget, GstElement * appsrc,
+    guint index);
+void gst_dyn_budget_remove_stream (GstDynBudget * budget, GstElement * appsrc);
+void gst_dyn_budget_pushed (GstDynBudget * budget, GstElement * appsrc,
+    gsize size);
+
+GstStructure *gst_dyn_budget_get_stats (GstDynBudget * budget);
+
+G_END_DECLS
+#endif /* __GST_DYN_BUDGET_H__ */
@@ -0,0 +1,350 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Keeps the appsrc elements of dynappsrc interleaved in running time.
+ *
+ * A buffer probe on every appsrc srcpad records the running time the stream
+ * pushed last and holds the streaming thread of a stream that is more than
+ * the window ahead of the slowest one. Its queue in the appsrc then fills
+ * up, so the application gets enough-data instead of need-data for it,
+ * while downstream queues don't fill up with data that waits for the other
+ * streams.
+ *
+ * Streams that didn't push a timed buffer yet, ended or are sparse
+ * (subtitles) don't hold anyone back. Flushes, EOS and the removal of a
+ * stream release the waiting threads.
+ *
+ * Threads are only held in PLAYING: while prerolling, the sink of the
+ * slowest stream may be waiting for the stream we would hold.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gstdyninterleave.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dyn_interleave_debug);
+#define GST_CAT_DEFAULT gst_dyn_interleave_debug
+
+typedef struct
+{
+  GstDynInterleave *interleave;
+
+  GstElement *appsrc;           /* not reffed, only compared */
+  GstPad *srcpad;
+  gulong probe_id;
+
+  GstSegment segment;
+  GstClockTime time;            /* running time of the last buffer */
+  gboolean sparse;
+  gboolean eos;
+  gboolean flushing;
+  gboolean removed;
+} InterleaveStream;
+
+struct _GstDynInterleave
+{
+  GMutex lock;
+  GCond cond;
+  GstElement *owner;            /* not reffed */
+  GstClockTime window;
+  gboolean flushing;
+  gboolean playing;
+
+  GList *streams;
+};
+
+/* with the lock */
+static gboolean
+is_ahead (GstDynInterleave * interleave, InterleaveStream * stream)
+{
+  GstClockTime slowest = GST_CLOCK_TIME_NONE;
+  GList *walk;
+
+  if (!interleave->window)
+    return FALSE;
+
+  for (walk = interleave->streams; walk; walk = walk->next) {
+    InterleaveStream *other = walk->data;
+
+    if (other == stream || other->eos || other->sparse
+        || !GST_CLOCK_TIME_IS_VALID (other->time))
+      continue;
+
+    if (!GST_CLOCK_TIME_IS_VALID (slowest) || other->time < slowest)
+      slowest = other->time;
+  }
+
+  return GST_CLOCK_TIME_IS_VALID (slowest)
+      && stream->time > slowest + interleave->window;
+}
+
+static gboolean
+is_sparse_caps (GstCaps * caps)
+{
+  const gchar *name;
+
+  if (!caps || gst_caps_get_size (caps) == 0)
+    return FALSE;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+  return g_str_has_prefix (name, "text/")
+      || g_str_has_prefix (name, "subpicture/")
+      || !strcmp (name, "application/x-ssa")
+      || !strcmp (name, "application/x-ass");
+}
+
+static void
+handle_event (InterleaveStream * stream, GstEvent * event)
+{
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    {
+      GstCaps *caps;
+
+      gst_event_parse_caps (event, &caps);
+      stream->sparse = is_sparse_caps (caps);
+      break;
+    }
+    case GST_EVENT_SEGMENT:
+      gst_event_copy_segment (event, &stream->segment);
+      break;
+    case GST_EVENT_STREAM_START:
+      stream->eos = FALSE;
+      stream->time = GST_CLOCK_TIME_NONE;
+      break;
+    case GST_EVENT_EOS:
+      stream->eos = TRUE;
+      break;
+    case GST_EVENT_FLUSH_START:
+      stream->flushing = TRUE;
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      stream->flushing = FALSE;
+      stream->eos = FALSE;
+      stream->time = GST_CLOCK_TIME_NONE;
+      gst_segment_init (&stream->segment, GST_FORMAT_UNDEFINED);
+      break;
+    default:
+      break;
+  }
+}
+
+static GstClockTime
+buffer_running_time (GstSegment * segment, GstBuffer * buf)
+{
+  GstClockTime ts = GST_BUFFER_PTS (buf);
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    ts = GST_BUFFER_DTS (buf);
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts) || segment->format != GST_FORMAT_TIME)
+    return GST_CLOCK_TIME_NONE;
+
+  return gst_segment_to_running_time (segment, GST_FORMAT_TIME, ts);
+}
+
+static GstPadProbeReturn
+srcpad_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    InterleaveStream * stream)
+{
+  GstDynInterleave *interleave = stream->interleave;
+  GstBuffer *buf = NULL;
+  GstClockTime rt;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & (GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+          GST_PAD_PROBE_TYPE_EVENT_FLUSH)) {
+    g_mutex_lock (&interleave->lock);
+    handle_event (stream, GST_PAD_PROBE_INFO_EVENT (info));
+    /* an ended or flushing stream may be the one others wait for */
+    g_cond_broadcast (&interleave->cond);
+    g_mutex_unlock (&interleave->lock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    buf = GST_PAD_PROBE_INFO_BUFFER (info);
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+    if (gst_buffer_list_length (list) > 0)
+      buf = gst_buffer_list_get (list, 0);
+  }
+  if (!buf)
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&interleave->lock);
+  rt = buffer_running_time (&stream->segment, buf);
+  if (!GST_CLOCK_TIME_IS_VALID (rt))
+    goto done;
+
+  stream->time = rt;
+  g_cond_broadcast (&interleave->cond);
+
+  if (interleave->playing && !stream->sparse
+      && is_ahead (interleave, stream)) {
+    GST_DEBUG_OBJECT (stream->appsrc, "ahead at %" GST_TIME_FORMAT
+        ", waiting for the other streams", GST_TIME_ARGS (rt));
+    while (interleave->playing && !interleave->flushing && !stream->flushing
+        && !stream->removed && is_ahead (interleave, stream))
+      g_cond_wait (&interleave->cond, &interleave->lock);
+    GST_DEBUG_OBJECT (stream->appsrc, "resuming");
+  }
+
+done:
+  g_mutex_unlock (&interleave->lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GstDynInterleave *
+gst_dyn_interleave_new (GstElement * owner, GstClockTime window)
+{
+  GstDynInterleave *interleave;
+
+  GST_DEBUG_CATEGORY_INIT (gst_dyn_interleave_debug, "dynappsrcinterleave", 0,
+      "Running-time interleave of dynappsrc");
+
+  interleave = g_slice_new0 (GstDynInterleave);
+  g_mutex_init (&interleave->lock);
+  g_cond_init (&interleave->cond);
+  interleave->owner = owner;
+  interleave->window = window;
+
+  GST_INFO_OBJECT (owner, "interleaving within %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (window));
+
+  return interleave;
+}
+
+void
+gst_dyn_interleave_free (GstDynInterleave * interleave)
+{
+  while (interleave->streams) {
+    InterleaveStream *stream = interleave->streams->data;
+    gst_dyn_interleave_remove_stream (interleave, stream->appsrc);
+  }
+
+  g_mutex_clear (&interleave->lock);
+  g_cond_clear (&interleave->cond);
+  g_slice_free (GstDynInterleave, interleave);
+}
+
+/* 0 lets every stream run freely */
+void
+gst_dyn_interleave_set_window (GstDynInterleave * interleave,
+    GstClockTime window)
+{
+  g_mutex_lock (&interleave->lock);
+  interleave->window = window;
+  g_cond_broadcast (&interleave->cond);
+  g_mutex_unlock (&interleave->lock);
+}
+
+/* releases the waiting threads before the appsrcs stop their tasks */
+void
+gst_dyn_interleave_set_flushing (GstDynInterleave * interleave,
+    gboolean flushing)
+{
+  g_mutex_lock (&interleave->lock);
+  interleave->flushing = flushing;
+  g_cond_broadcast (&interleave->cond);
+  g_mutex_unlock (&interleave->lock);
+}
+
+/* streams are only held back in PLAYING, going to PAUSED releases them so
+ * that the sinks can preroll */
+void
+gst_dyn_interleave_set_playing (GstDynInterleave * interleave,
+    gboolean playing)
+{
+  g_mutex_lock (&interleave->lock);
+  interleave->playing = playing;
+  g_cond_broadcast (&interleave->cond);
+  g_mutex_unlock (&interleave->lock);
+}
+
+static void
+stream_free (InterleaveStream * stream)
+{
+  g_slice_free (InterleaveStream, stream);
+}
+
+void
+gst_dyn_interleave_add_stream (GstDynInterleave * interleave,
+    GstElement * appsrc)
+{
+  InterleaveStream *stream;
+
+  stream = g_slice_new0 (InterleaveStream);
+  stream->interleave = interleave;
+  stream->appsrc = appsrc;
+  stream->srcpad = gst_element_get_static_pad (appsrc, "src");
+  stream->time = GST_CLOCK_TIME_NONE;
+  gst_segment_init (&stream->segment, GST_FORMAT_UNDEFINED);
+
+  g_mutex_lock (&interleave->lock);
+  interleave->streams = g_list_append (interleave->streams, stream);
+  g_mutex_unlock (&interleave->lock);
+
+  /* the stream is freed once the probe is removed and no longer running */
+  stream->probe_id = gst_pad_add_probe (stream->srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) srcpad_probe_cb, stream,
+      (GDestroyNotify) stream_free);
+}
+
+/* call before stopping the appsrc, wakes up its thread if it waits */
+void
+gst_dyn_interleave_remove_stream (GstDynInterleave * interleave,
+    GstElement * appsrc)
+{
+  InterleaveStream *stream = NULL;
+  GstPad *srcpad;
+  gulong probe_id;
+  GList *walk;
+
+  g_mutex_lock (&interleave->lock);
+  for (walk = interleave->streams; walk; walk = walk->next) {
+    if (((InterleaveStream *) walk->data)->appsrc == appsrc) {
+      stream = walk->data;
+      break;
+    }
+  }
+  if (!stream) {
+    g_mutex_unlock (&interleave->lock);
+    return;
+  }
+  interleave->streams = g_list_delete_link (interleave->streams, walk);
+  stream->removed = TRUE;
+  srcpad = stream->srcpad;
+  probe_id = stream->probe_id;
+  /* the others may have waited for it */
+  g_cond_broadcast (&interleave->cond);
+  g_mutex_unlock (&interleave->lock);
+
+  gst_pad_remove_probe (srcpad, probe_id);
+  gst_object_unref (srcpad);
+}
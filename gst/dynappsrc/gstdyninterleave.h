@@ -0,0 +1,45 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DYN_INTERLEAVE_H__
+#define __GST_DYN_INTERLEAVE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstDynInterleave GstDynInterleave;
+
+GstDynInterleave *gst_dyn_interleave_new (GstElement * owner,
+    GstClockTime window);
+void gst_dyn_interleave_free (GstDynInterleave * interleave);
+void gst_dyn_interleave_set_window (GstDynInterleave * interleave,
+    GstClockTime window);
+void gst_dyn_interleave_set_flushing (GstDynInterleave * interleave,
+    gboolean flushing);
+void gst_dyn_interleave_set_playing (GstDynInterleave * interleave,
+    gboolean playing);
+
+void gst_dyn_interleave_add_stream (GstDynInterleave * interleave,
+    GstElement * appsrc);
+void gst_dyn_interleave_remove_stream (GstDynInterleave * interleave,
+    GstElement * appsrc);
+
+G_END_DECLS
+#endif /* __GST_DYN_INTERLEAVE_H__ */
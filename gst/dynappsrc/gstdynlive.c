@@ -0,0 +1,551 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Recovers the clock of a live sender feeding the appsrc elements of
+ * dynappsrc and retimestamps the buffers on the pipeline clock.
+ *
+ * Every buffer is stamped with the running time at which the application
+ * pushed it. Against the timestamp the sender gave it, that makes a delay
+ * which is the network jitter plus a part growing or shrinking linearly
+ * with the skew between the sender clock and the pipeline clock. The
+ * smallest delay over a window of WINDOW of sender time is the skew part.
+ * From the second window on, the skew follows the line through the least
+ * delayed buffers of the windows. Its slope is the drift between the clocks,
+ * and both are corrected through a running average, so the timestamps don't
+ * jump and a constant drift is followed without lagging behind.
+ *
+ * The stamp is taken in the push-buffer signal and the push functions of
+ * dynappsrc. A buffer given straight to gst_app_src_push_buffer() goes
+ * around both and is taken as arriving when it leaves the appsrc, which is
+ * only the same while the appsrc doesn't queue.
+ *
+ * Buffers leave with the sender timestamp moved to the running time of the
+ * first one plus that skew, all streams being timestamped by the same
+ * sender clock. The appsrc elements are live and report the latency
+ * bound, so a buffer delayed by up to the bound more than the least delayed
+ * ones is still in time at the sinks. When too many in a row are not, or
+ * one shows up earlier than the bound allows, the sender or the pipeline
+ * jumped and the mapping starts over from that buffer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstdynlive.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dyn_live_debug);
+#define GST_CAT_DEFAULT gst_dyn_live_debug
+
+/* sender time over which the smallest delay is searched */
+#define WINDOW (2 * GST_SECOND)
+/* weight of the last window in the running averages of the skew line */
+#define SKEW_AVERAGE 16
+/* late buffers in a row that make the mapping start over */
+#define LATE_RESYNC 8
+
+/* the running time at which a buffer was pushed is kept on the buffer, so
+ * that it can't be matched with the arrival of another one */
+static GQuark arrival_quark;
+
+typedef struct
+{
+  GstDynLive *live;
+
+  GstElement *appsrc;
+  GstPad *srcpad;
+  gulong probe_id;
+  gulong push_id;
+
+  GstClockTime last_out;
+} LiveStream;
+
+struct _GstDynLive
+{
+  GMutex lock;
+  GstElement *owner;            /* not reffed */
+  gboolean enabled;
+  GstClockTime latency;
+
+  GList *streams;
+
+  /* the mapping */
+  GstClockTime base_send;       /* sender time of the first buffer */
+  GstClockTime base_recv;       /* and its running time */
+  gint64 skew;
+  guint late_run;               /* late buffers in a row */
+
+  /* the skew line, anchor_skew at anchor_send changing by drift per
+   * nanosecond of sender time */
+  GstClockTime anchor_send;
+  gint64 anchor_skew;
+  gdouble drift;
+  guint windows;                /* windows over */
+
+  /* the current window */
+  GstClockTime window_start;
+  gint64 window_min;
+  GstClockTime window_min_send; /* sender time of the least delayed buffer */
+  gint64 window_jitter;
+
+  /* stats */
+  GstClockTime jitter;          /* largest of the last window */
+  guint late;
+  guint resyncs;
+};
+
+/* with the lock */
+static LiveStream *
+find_stream (GstDynLive * live, GstElement * appsrc)
+{
+  GList *walk;
+
+  for (walk = live->streams; walk; walk = walk->next) {
+    LiveStream *stream = walk->data;
+    if (stream->appsrc == appsrc)
+      return stream;
+  }
+
+  return NULL;
+}
+
+/* with the lock */
+static void
+start_mapping (GstDynLive * live, GstClockTime send, GstClockTime recv)
+{
+  live->base_send = send;
+  live->base_recv = recv;
+  live->skew = 0;
+  live->anchor_send = send;
+  live->anchor_skew = 0;
+  live->drift = 0.0;
+  live->windows = 0;
+  live->window_start = send;
+  live->window_min = G_MAXINT64;
+  live->window_min_send = send;
+  live->window_jitter = 0;
+}
+
+/* with the lock */
+static gint64
+predict_skew (GstDynLive * live, GstClockTime send)
+{
+  return live->anchor_skew +
+      (gint64) (live->drift * ((gint64) send - (gint64) live->anchor_send));
+}
+
+/* with the lock, moves the skew line to the least delayed buffer of the
+ * window that is over */
+static void
+end_window (GstDynLive * live)
+{
+  gint64 span, predicted, error;
+
+  span = (gint64) live->window_min_send - (gint64) live->anchor_send;
+
+  if (live->windows == 0 || span <= 0) {
+    /* only a point so far */
+    live->anchor_skew = live->window_min;
+  } else if (live->windows == 1) {
+    live->drift = (gdouble) (live->window_min - live->anchor_skew) / span;
+    live->anchor_skew = live->window_min;
+  } else {
+    predicted = predict_skew (live, live->window_min_send);
+    error = live->window_min - predicted;
+    live->drift += (gdouble) error / span / SKEW_AVERAGE;
+    live->anchor_skew = predicted + error / SKEW_AVERAGE;
+  }
+  live->anchor_send = live->window_min_send;
+  live->windows++;
+}
+
+/* running time of the pipeline, NONE while it is not PLAYING */
+static GstClockTime
+get_running_time (GstDynLive * live)
+{
+  GstClock *clock;
+  GstClockTime now = GST_CLOCK_TIME_NONE;
+
+  if (GST_STATE (live->owner) != GST_STATE_PLAYING)
+    return now;
+
+  if ((clock = gst_element_get_clock (live->owner))) {
+    GstClockTime base_time = gst_element_get_base_time (live->owner);
+
+    now = gst_clock_get_time (clock);
+    now = now > base_time ? now - base_time : 0;
+    gst_object_unref (clock);
+  }
+
+  return now;
+}
+
+/* with the lock, updates the skew with a buffer sent at @send and received
+ * at @recv */
+static void
+update_skew (GstDynLive * live, GstClockTime send, GstClockTime recv)
+{
+  gint64 send_diff, delta, jitter;
+
+  if (!GST_CLOCK_TIME_IS_VALID (live->base_send))
+    goto resync;
+
+  /* the streams are not sent in exact order, the first buffer of one may
+   * be older than the first of another */
+  send_diff = (gint64) send - (gint64) live->base_send;
+  delta = ((gint64) recv - (gint64) live->base_recv) - send_diff;
+
+  if (delta < live->window_min) {
+    live->window_min = delta;
+    live->window_min_send = send;
+  }
+
+  if (send > live->window_start && send - live->window_start >= WINDOW) {
+    end_window (live);
+    live->jitter = live->window_jitter;
+    live->window_start = send;
+    live->window_min = G_MAXINT64;
+    live->window_jitter = 0;
+    GST_LOG_OBJECT (live->owner, "skew %" G_GINT64_FORMAT ", drift %lf, "
+        "jitter %" GST_TIME_FORMAT, live->anchor_skew, live->drift,
+        GST_TIME_ARGS (live->jitter));
+  }
+
+  if (live->windows == 0)
+    live->skew = live->window_min;
+  else
+    live->skew = predict_skew (live, send);
+
+  jitter = delta - live->skew;
+  if (jitter < -(gint64) live->latency)
+    goto resync;
+
+  if (jitter > (gint64) live->latency) {
+    live->late++;
+    if (++live->late_run >= LATE_RESYNC)
+      goto resync;
+  } else {
+    live->late_run = 0;
+  }
+  live->window_jitter = MAX (live->window_jitter, jitter);
+
+  return;
+
+resync:
+  {
+    if (GST_CLOCK_TIME_IS_VALID (live->base_send)) {
+      GST_INFO_OBJECT (live->owner, "mapping %" GST_TIME_FORMAT " to %"
+          GST_TIME_FORMAT " again", GST_TIME_ARGS (send), GST_TIME_ARGS (recv));
+      live->resyncs++;
+    }
+    start_mapping (live, send, recv);
+    live->late_run = 0;
+  }
+}
+
+/* with the lock */
+static GstClockTime
+map_time (GstDynLive * live, GstClockTime t)
+{
+  gint64 mapped;
+
+  if (!GST_CLOCK_TIME_IS_VALID (t))
+    return t;
+
+  mapped = (gint64) t - (gint64) live->base_send + (gint64) live->base_recv +
+      live->skew;
+
+  return mapped > 0 ? mapped : 0;
+}
+
+static void
+free_arrival (GstClockTime * arrival)
+{
+  g_slice_free (GstClockTime, arrival);
+}
+
+/* the arrival stamped on @buffer by gst_dyn_live_pushed(), taken off so
+ * that the buffer is stamped again if it is pushed again */
+static GstClockTime
+take_arrival (GstBuffer * buffer)
+{
+  GstClockTime *arrival, recv;
+
+  arrival = gst_mini_object_steal_qdata (GST_MINI_OBJECT_CAST (buffer),
+      arrival_quark);
+  if (!arrival)
+    return GST_CLOCK_TIME_NONE;
+
+  recv = *arrival;
+  free_arrival (arrival);
+
+  return recv;
+}
+
+static GstPadProbeReturn
+srcpad_probe_cb (GstPad * pad, GstPadProbeInfo * info, LiveStream * stream)
+{
+  GstDynLive *live = stream->live;
+  GstBuffer *buffer;
+  GstClockTime send, recv, now;
+  guint resyncs;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_FLUSH) {
+    /* the appsrc dropped its queue */
+    if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+        GST_EVENT_FLUSH_STOP) {
+      g_mutex_lock (&live->lock);
+      stream->last_out = GST_CLOCK_TIME_NONE;
+      g_mutex_unlock (&live->lock);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  /* the decoding order is the sending order */
+  send = GST_BUFFER_DTS_IS_VALID (buffer) ? GST_BUFFER_DTS (buffer) :
+      GST_BUFFER_PTS (buffer);
+
+  /* taken before the lock, it needs the one of the owner */
+  now = get_running_time (live);
+
+  /* pushed before PLAYING or straight to the appsrc, it arrived now as far
+   * as we know */
+  recv = take_arrival (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (recv))
+    recv = now;
+
+  g_mutex_lock (&live->lock);
+
+  if (!GST_CLOCK_TIME_IS_VALID (send) || !GST_CLOCK_TIME_IS_VALID (recv)
+      || !live->enabled) {
+    g_mutex_unlock (&live->lock);
+    return GST_PAD_PROBE_OK;
+  }
+
+  resyncs = live->resyncs;
+  update_skew (live, send, recv);
+
+  buffer = gst_buffer_make_writable (buffer);
+  GST_BUFFER_PTS (buffer) = map_time (live, GST_BUFFER_PTS (buffer));
+  GST_BUFFER_DTS (buffer) = map_time (live, GST_BUFFER_DTS (buffer));
+
+  /* the skew only moves a little, never let it go back in time */
+  send = GST_BUFFER_DTS_IS_VALID (buffer) ? GST_BUFFER_DTS (buffer) :
+      GST_BUFFER_PTS (buffer);
+  if (GST_CLOCK_TIME_IS_VALID (stream->last_out) && send < stream->last_out) {
+    GstClockTime diff = stream->last_out - send;
+
+    if (GST_BUFFER_DTS_IS_VALID (buffer))
+      GST_BUFFER_DTS (buffer) += diff;
+    if (GST_BUFFER_PTS_IS_VALID (buffer))
+      GST_BUFFER_PTS (buffer) += diff;
+    send = stream->last_out;
+  }
+  stream->last_out = send;
+
+  if (live->resyncs != resyncs)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  g_mutex_unlock (&live->lock);
+
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* runs before the push-buffer handler of appsrc */
+static GstFlowReturn
+push_buffer_cb (GstElement * appsrc, GstBuffer * buffer, LiveStream * stream)
+{
+  gst_dyn_live_pushed (stream->live, appsrc, buffer);
+
+  return GST_FLOW_OK;
+}
+
+GstDynLive *
+gst_dyn_live_new (GstElement * owner)
+{
+  GstDynLive *live;
+
+  GST_DEBUG_CATEGORY_INIT (gst_dyn_live_debug, "dynappsrclive", 0,
+      "Live clock recovery of dynappsrc");
+  arrival_quark = g_quark_from_static_string ("GstDynLiveArrival");
+
+  live = g_slice_new0 (GstDynLive);
+  g_mutex_init (&live->lock);
+  live->owner = owner;
+  live->base_send = GST_CLOCK_TIME_NONE;
+
+  return live;
+}
+
+static void
+stream_free (LiveStream * stream)
+{
+  gst_pad_remove_probe (stream->srcpad, stream->probe_id);
+  g_signal_handler_disconnect (stream->appsrc, stream->push_id);
+  gst_object_unref (stream->srcpad);
+  gst_object_unref (stream->appsrc);
+  g_slice_free (LiveStream, stream);
+}
+
+void
+gst_dyn_live_free (GstDynLive * live)
+{
+  g_list_free_full (live->streams, (GDestroyNotify) stream_free);
+  g_mutex_clear (&live->lock);
+  g_slice_free (GstDynLive, live);
+}
+
+/* a new session, the streams added from now on are live if @enabled */
+void
+gst_dyn_live_reset (GstDynLive * live, gboolean enabled, GstClockTime latency)
+{
+  g_mutex_lock (&live->lock);
+  live->enabled = enabled;
+  live->latency = latency;
+  live->base_send = GST_CLOCK_TIME_NONE;
+  live->skew = 0;
+  live->drift = 0.0;
+  live->late_run = 0;
+  live->jitter = 0;
+  live->late = 0;
+  live->resyncs = 0;
+  g_mutex_unlock (&live->lock);
+
+  if (enabled)
+    GST_INFO_OBJECT (live->owner, "live within %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (latency));
+}
+
+void
+gst_dyn_live_set_latency (GstDynLive * live, GstClockTime latency)
+{
+  GList *walk;
+  gboolean enabled;
+
+  g_mutex_lock (&live->lock);
+  live->latency = latency;
+  enabled = live->enabled;
+  for (walk = live->streams; walk; walk = walk->next) {
+    LiveStream *stream = walk->data;
+    g_object_set (stream->appsrc, "min-latency", (gint64) latency, NULL);
+  }
+  g_mutex_unlock (&live->lock);
+
+  /* the sinks take it from the next latency query */
+  if (enabled)
+    gst_element_post_message (live->owner,
+        gst_message_new_latency (GST_OBJECT_CAST (live->owner)));
+}
+
+void
+gst_dyn_live_add_stream (GstDynLive * live, GstElement * appsrc)
+{
+  LiveStream *stream;
+  GstClockTime latency;
+
+  g_mutex_lock (&live->lock);
+  latency = live->latency;
+  if (!live->enabled) {
+    g_mutex_unlock (&live->lock);
+    return;
+  }
+  g_mutex_unlock (&live->lock);
+
+  /* sinks wait for the latency bound on top of the buffer running time */
+  g_object_set (appsrc, "is-live", TRUE, "do-timestamp", FALSE,
+      "min-latency", (gint64) latency, NULL);
+
+  stream = g_slice_new0 (LiveStream);
+  stream->live = live;
+  stream->appsrc = gst_object_ref (appsrc);
+  stream->srcpad = gst_element_get_static_pad (appsrc, "src");
+  stream->last_out = GST_CLOCK_TIME_NONE;
+  stream->probe_id = gst_pad_add_probe (stream->srcpad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) srcpad_probe_cb, stream, NULL);
+  stream->push_id = g_signal_connect (appsrc, "push-buffer",
+      G_CALLBACK (push_buffer_cb), stream);
+
+  g_mutex_lock (&live->lock);
+  live->streams = g_list_append (live->streams, stream);
+  g_mutex_unlock (&live->lock);
+}
+
+void
+gst_dyn_live_remove_stream (GstDynLive * live, GstElement * appsrc)
+{
+  LiveStream *stream;
+
+  g_mutex_lock (&live->lock);
+  stream = find_stream (live, appsrc);
+  if (stream)
+    live->streams = g_list_remove (live->streams, stream);
+  g_mutex_unlock (&live->lock);
+
+  if (stream)
+    stream_free (stream);
+}
+
+/* stamps @buffer, which the application is pushing to @appsrc, with its
+ * arrival */
+void
+gst_dyn_live_pushed (GstDynLive * live, GstElement * appsrc,
+    GstBuffer * buffer)
+{
+  GstClockTime now, *arrival;
+  gboolean live_stream;
+
+  /* NONE before PLAYING */
+  now = get_running_time (live);
+  if (!GST_CLOCK_TIME_IS_VALID (now))
+    return;
+
+  g_mutex_lock (&live->lock);
+  live_stream = find_stream (live, appsrc) != NULL;
+  g_mutex_unlock (&live->lock);
+
+  if (!live_stream)
+    return;
+
+  arrival = g_slice_new (GstClockTime);
+  *arrival = now;
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (buffer), arrival_quark,
+      arrival, (GDestroyNotify) free_arrival);
+}
+
+GstStructure *
+gst_dyn_live_get_stats (GstDynLive * live)
+{
+  GstStructure *s;
+
+  g_mutex_lock (&live->lock);
+  s = gst_structure_new ("live-stats",
+      "latency", G_TYPE_UINT64, live->latency,
+      "skew", G_TYPE_INT64, live->skew,
+      "drift", G_TYPE_DOUBLE, live->drift * 1e6,
+      "jitter", G_TYPE_UINT64, live->jitter,
+      "late", G_TYPE_UINT, live->late,
+      "resyncs", G_TYPE_UINT, live->resyncs, NULL);
+  g_mutex_unlock (&live->lock);
+
+  return s;
+}
@@ -0,0 +1,43 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DYN_LIVE_H__
+#define __GST_DYN_LIVE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstDynLive GstDynLive;
+
+GstDynLive *gst_dyn_live_new (GstElement * owner);
+void gst_dyn_live_free (GstDynLive * live);
+void gst_dyn_live_reset (GstDynLive * live, gboolean enabled,
+    GstClockTime latency);
+void gst_dyn_live_set_latency (GstDynLive * live, GstClockTime latency);
+
+void gst_dyn_live_add_stream (GstDynLive * live, GstElement * appsrc);
+void gst_dyn_live_remove_stream (GstDynLive * live, GstElement * appsrc);
+void gst_dyn_live_pushed (GstDynLive * live, GstElement * appsrc,
+    GstBuffer * buffer);
+
+GstStructure *gst_dyn_live_get_stats (GstDynLive * live);
+
+G_END_DECLS
+#endif /* __GST_DYN_LIVE_H__ */
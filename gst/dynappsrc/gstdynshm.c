@@ -0,0 +1,517 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Feeds dynappsrc from a ring in memory shared with another process, see
+ * gstdynshm.h for its layout.
+ *
+ * The ring is mapped once, a reader thread waits on the notify eventfd of
+ * the producer and hands every FILLED slot to dynappsrc as a buffer wrapping
+ * the slot in place. The buffer holds a reference to the mapping, which
+ * outlives the ring when the pipeline keeps buffers after it stopped, and
+ * gives the slot back to the producer when it is freed. Without a notify
+ * eventfd the lanes are polled.
+ *
+ * Nothing the producer writes is trusted beyond the checks done when
+ * mapping: sizes of slots are clamped and the geometry is read once.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <glib-unix.h>
+
+#include "gstdynshm.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_dyn_shm_debug);
+#define GST_CAT_DEFAULT gst_dyn_shm_debug
+
+/* milliseconds between two looks at the lanes without a notify eventfd */
+#define POLL_INTERVAL 10
+
+typedef struct
+{
+  GstDynShmRing *ring;
+  guint index;                  /* of the slot in the ring */
+} SlotRef;
+
+struct _GstDynShmRing
+{
+  gint refcount;
+  GstElement *owner;            /* not reffed, only used while started */
+
+  gpointer base;
+  gsize size;
+  GstDynShmHeader *header;
+  GstDynShmSlot *slots;
+  guint8 *data;
+
+  /* geometry, read once when mapping */
+  guint n_lanes;
+  guint n_slots;
+  gsize slot_size;
+
+  gint notify_fd;               /* written by the producer, or -1 */
+  gint release_fd;              /* written when slots are freed, or -1 */
+  gint wakeup[2];               /* stops the reader */
+
+  SlotRef *refs;
+  gboolean eos[GST_DYN_SHM_MAX_LANES];
+
+  GThread *thread;
+  gint stopping;
+  GstDynShmPushFunc push;
+  gpointer user_data;
+};
+
+gboolean
+gst_dyn_shm_is_shm_uri (const gchar * uri)
+{
+  static const gchar prefix[] = "dynappsrc://shm";
+
+  if (!uri || !g_str_has_prefix (uri, prefix))
+    return FALSE;
+
+  return uri[sizeof (prefix) - 1] == '\0' || uri[sizeof (prefix) - 1] == '?';
+}
+
+static gboolean
+parse_fd (const gchar * value, gint * fd)
+{
+  gchar *end = NULL;
+  gint64 v;
+
+  v = g_ascii_strtoll (value, &end, 10);
+  if (!end || end == value || *end != '\0' || v < 0 || v > G_MAXINT)
+    return FALSE;
+
+  *fd = (gint) v;
+  return TRUE;
+}
+
+/* dynappsrc://shm?fd=N[&notify=N][&release=N], the descriptors are those of
+ * this process and stay owned by the application */
+gboolean
+gst_dyn_shm_parse_uri (const gchar * uri, gint * fd, gint * notify_fd,
+    gint * release_fd, GError ** error)
+{
+  const gchar *query;
+  gchar **params = NULL;
+  gint i;
+
+  *fd = *notify_fd = *release_fd = -1;
+
+  if (!gst_dyn_shm_is_shm_uri (uri))
+    goto bad_uri;
+
+  query = strchr (uri, '?');
+  if (!query)
+    goto no_fd;
+
+  params = g_strsplit (query + 1, "&", -1);
+  for (i = 0; params[i]; i++) {
+    gchar *value = strchr (params[i], '=');
+    gint *dest;
+
+    if (!value)
+      goto bad_uri;
+    *value++ = '\0';
+
+    if (!strcmp (params[i], "fd"))
+      dest = fd;
+    else if (!strcmp (params[i], "notify"))
+      dest = notify_fd;
+    else if (!strcmp (params[i], "release"))
+      dest = release_fd;
+    else
+      goto bad_uri;
+
+    if (!parse_fd (value, dest))
+      goto bad_uri;
+  }
+  g_strfreev (params);
+
+  if (*fd < 0)
+    goto no_fd;
+
+  return TRUE;
+
+bad_uri:
+  {
+    g_strfreev (params);
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "Invalid shared memory URI '%s'", uri);
+    return FALSE;
+  }
+no_fd:
+  {
+    g_set_error (error, GST_URI_ERROR, GST_URI_ERROR_BAD_URI,
+        "No ring descriptor in '%s'", uri);
+    return FALSE;
+  }
+}
+
+static gint
+dup_fd (gint fd)
+{
+  if (fd < 0)
+    return -1;
+
+  return fcntl (fd, F_DUPFD_CLOEXEC, 0);
+}
+
+GstDynShmRing *
+gst_dyn_shm_ring_open (GstElement * owner, gint fd, gint notify_fd,
+    gint release_fd, GError ** error)
+{
+  GstDynShmRing *ring;
+  GstDynShmHeader *header;
+  struct stat st;
+  gpointer base;
+  guint i, n_lanes, n_slots, slot_size;
+
+  GST_DEBUG_CATEGORY_INIT (gst_dyn_shm_debug, "dynappsrcshm", 0,
+      "Shared memory ring of dynappsrc");
+
+  if (fstat (fd, &st) < 0)
+    goto stat_failed;
+  if (st.st_size < (off_t) sizeof (GstDynShmHeader))
+    goto too_small;
+
+  base = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (base == MAP_FAILED)
+    goto map_failed;
+
+  header = base;
+  n_lanes = header->n_lanes;
+  n_slots = header->n_slots;
+  slot_size = header->slot_size;
+
+  if (header->magic != GST_DYN_SHM_MAGIC
+      || header->version != GST_DYN_SHM_VERSION)
+    goto bad_header;
+  if (n_lanes == 0 || n_lanes > GST_DYN_SHM_MAX_LANES || n_slots == 0
+      || n_slots > G_MAXINT / GST_DYN_SHM_MAX_LANES || slot_size == 0)
+    goto bad_header;
+  /* in 64 bits, the multiplications don't overflow with the limits above */
+  if ((guint64) GST_DYN_SHM_SIZE (n_lanes, n_slots, slot_size) >
+      (guint64) st.st_size)
+    goto bad_header;
+
+  ring = g_slice_new0 (GstDynShmRing);
+  ring->refcount = 1;
+  ring->owner = owner;
+  ring->base = base;
+  ring->size = st.st_size;
+  ring->header = header;
+  ring->slots = (GstDynShmSlot *) ((guint8 *) base + GST_DYN_SHM_SLOTS_OFFSET);
+  ring->data = (guint8 *) base + GST_DYN_SHM_DATA_OFFSET (n_lanes, n_slots);
+  ring->n_lanes = n_lanes;
+  ring->n_slots = n_slots;
+  ring->slot_size = slot_size;
+  ring->notify_fd = dup_fd (notify_fd);
+  ring->release_fd = dup_fd (release_fd);
+  ring->wakeup[0] = ring->wakeup[1] = -1;
+
+  ring->refs = g_new (SlotRef, n_lanes * n_slots);
+  for (i = 0; i < n_lanes * n_slots; i++) {
+    ring->refs[i].ring = ring;
+    ring->refs[i].index = i;
+  }
+
+  GST_INFO_OBJECT (owner, "mapped ring of %u lanes of %u slots of %u bytes",
+      n_lanes, n_slots, slot_size);
+
+  return ring;
+
+stat_failed:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ_WRITE,
+        "Can't stat ring descriptor %d: %s", fd, g_strerror (errno));
+    return NULL;
+  }
+too_small:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ_WRITE,
+        "Ring descriptor %d is too small", fd);
+    return NULL;
+  }
+map_failed:
+  {
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_OPEN_READ_WRITE,
+        "Can't map ring descriptor %d: %s", fd, g_strerror (errno));
+    return NULL;
+  }
+bad_header:
+  {
+    munmap (base, st.st_size);
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_SETTINGS,
+        "Ring descriptor %d has no valid ring header", fd);
+    return NULL;
+  }
+}
+
+static GstDynShmRing *
+ring_ref (GstDynShmRing * ring)
+{
+  g_atomic_int_inc (&ring->refcount);
+
+  return ring;
+}
+
+void
+gst_dyn_shm_ring_unref (GstDynShmRing * ring)
+{
+  if (!g_atomic_int_dec_and_test (&ring->refcount))
+    return;
+
+  g_assert (ring->thread == NULL);
+
+  munmap (ring->base, ring->size);
+  if (ring->notify_fd >= 0)
+    close (ring->notify_fd);
+  if (ring->release_fd >= 0)
+    close (ring->release_fd);
+  g_free (ring->refs);
+
+  g_slice_free (GstDynShmRing, ring);
+}
+
+guint
+gst_dyn_shm_ring_get_n_lanes (GstDynShmRing * ring)
+{
+  return ring->n_lanes;
+}
+
+/* NULL when the producer left the caps of @lane empty */
+GstCaps *
+gst_dyn_shm_ring_get_caps (GstDynShmRing * ring, guint lane)
+{
+  gchar *str;
+  GstCaps *caps = NULL;
+
+  g_return_val_if_fail (lane < ring->n_lanes, NULL);
+
+  str = g_strndup (ring->header->lanes[lane].caps, GST_DYN_SHM_CAPS_LEN);
+  if (*str)
+    caps = gst_caps_from_string (str);
+  g_free (str);
+
+  return caps;
+}
+
+static void
+signal_fd (gint fd)
+{
+  guint64 v = 1;
+
+  /* an eventfd adds it up, the reader only needs to wake up */
+  while (write (fd, &v, sizeof (v)) < 0 && errno == EINTR);
+}
+
+static void
+drain_fd (gint fd)
+{
+  guint8 buf[64];
+
+  while (read (fd, buf, sizeof (buf)) < 0 && errno == EINTR);
+}
+
+/* the pipeline dropped the buffer of the slot */
+static void
+slot_released (SlotRef * ref)
+{
+  GstDynShmRing *ring = ref->ring;
+
+  g_atomic_int_set (&ring->slots[ref->index].state, GST_DYN_SHM_SLOT_FREE);
+  if (ring->release_fd >= 0)
+    signal_fd (ring->release_fd);
+
+  gst_dyn_shm_ring_unref (ring);
+}
+
+static GstBuffer *
+wrap_slot (GstDynShmRing * ring, guint index)
+{
+  GstDynShmSlot *slot = &ring->slots[index];
+  GstBuffer *buffer;
+  gsize size;
+
+  size = MIN (slot->size, ring->slot_size);
+  if (size < slot->size)
+    GST_WARNING_OBJECT (ring->owner, "slot %u claims %u bytes, clamped",
+        index, slot->size);
+
+  g_atomic_int_set (&slot->state, GST_DYN_SHM_SLOT_IN_USE);
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      ring->data + (gsize) index * ring->slot_size, ring->slot_size, 0, size,
+      &ring->refs[index], (GDestroyNotify) slot_released);
+  ring_ref (ring);
+
+  GST_BUFFER_PTS (buffer) = slot->pts;
+  GST_BUFFER_DTS (buffer) = slot->dts;
+  GST_BUFFER_DURATION (buffer) = slot->duration;
+  if (slot->flags & GST_DYN_SHM_SLOT_DELTA_UNIT)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  if (slot->flags & GST_DYN_SHM_SLOT_DISCONT)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+  return buffer;
+}
+
+/* hands out the FILLED slots of every lane, in order */
+static void
+read_lanes (GstDynShmRing * ring)
+{
+  guint lane;
+
+  for (lane = 0; lane < ring->n_lanes; lane++) {
+    GstDynShmLane *l = &ring->header->lanes[lane];
+    gboolean eos;
+    guint tail;
+
+    if (ring->eos[lane])
+      continue;
+
+    /* before the slots, those filled before the flag are all seen */
+    eos = g_atomic_int_get (&l->flags) & GST_DYN_SHM_LANE_EOS;
+
+    tail = (guint) g_atomic_int_get (&l->tail);
+    while (!g_atomic_int_get (&ring->stopping)) {
+      guint index = lane * ring->n_slots + tail % ring->n_slots;
+      GstFlowReturn ret;
+
+      if (g_atomic_int_get (&ring->slots[index].state) !=
+          GST_DYN_SHM_SLOT_FILLED)
+        break;
+
+      ret = ring->push (lane, wrap_slot (ring, index), ring->user_data);
+      if (ret != GST_FLOW_OK)
+        GST_DEBUG_OBJECT (ring->owner, "lane %u: %s", lane,
+            gst_flow_get_name (ret));
+
+      g_atomic_int_set (&l->tail, (gint) ++tail);
+    }
+
+    if (eos && !g_atomic_int_get (&ring->stopping)) {
+      GST_DEBUG_OBJECT (ring->owner, "lane %u ended", lane);
+      ring->eos[lane] = TRUE;
+      ring->push (lane, NULL, ring->user_data);
+    }
+  }
+}
+
+static gpointer
+reader_thread (GstDynShmRing * ring)
+{
+  GPollFD fds[2];
+  guint n_fds = 1;
+  gint timeout = -1;
+
+  fds[0].fd = ring->wakeup[0];
+  fds[0].events = G_IO_IN;
+  if (ring->notify_fd >= 0) {
+    fds[1].fd = ring->notify_fd;
+    fds[1].events = G_IO_IN;
+    n_fds++;
+  } else {
+    timeout = POLL_INTERVAL;
+  }
+
+  while (!g_atomic_int_get (&ring->stopping)) {
+    read_lanes (ring);
+
+    fds[0].revents = fds[1].revents = 0;
+    if (g_poll (fds, n_fds, timeout) < 0 && errno != EINTR) {
+      GST_ERROR_OBJECT (ring->owner, "poll failed: %s", g_strerror (errno));
+      break;
+    }
+    /* cleared before looking, a slot filled meanwhile notifies again */
+    if (n_fds > 1 && (fds[1].revents & G_IO_IN))
+      drain_fd (ring->notify_fd);
+  }
+
+  return NULL;
+}
+
+/* starts handing the slots of the ring to @push, from a thread of its own */
+gboolean
+gst_dyn_shm_ring_start (GstDynShmRing * ring, GstDynShmPushFunc push,
+    gpointer user_data)
+{
+  GError *err = NULL;
+
+  g_return_val_if_fail (ring->thread == NULL, FALSE);
+
+  if (!g_unix_open_pipe (ring->wakeup, FD_CLOEXEC, &err))
+    goto pipe_failed;
+
+  ring->push = push;
+  ring->user_data = user_data;
+  g_atomic_int_set (&ring->stopping, FALSE);
+
+  ring->thread = g_thread_try_new ("dynappsrc-shm",
+      (GThreadFunc) reader_thread, ring, &err);
+  if (!ring->thread)
+    goto thread_failed;
+
+  return TRUE;
+
+pipe_failed:
+  {
+    GST_ERROR_OBJECT (ring->owner, "no wakeup pipe: %s", err->message);
+    g_error_free (err);
+    return FALSE;
+  }
+thread_failed:
+  {
+    GST_ERROR_OBJECT (ring->owner, "no reader thread: %s", err->message);
+    g_error_free (err);
+    close (ring->wakeup[0]);
+    close (ring->wakeup[1]);
+    ring->wakeup[0] = ring->wakeup[1] = -1;
+    return FALSE;
+  }
+}
+
+/* waits for the reader to finish, the slots it handed out stay in use until
+ * their buffers are freed */
+void
+gst_dyn_shm_ring_stop (GstDynShmRing * ring)
+{
+  if (!ring->thread)
+    return;
+
+  g_atomic_int_set (&ring->stopping, TRUE);
+  signal_fd (ring->wakeup[1]);
+  g_thread_join (ring->thread);
+  ring->thread = NULL;
+
+  close (ring->wakeup[0]);
+  close (ring->wakeup[1]);
+  ring->wakeup[0] = ring->wakeup[1] = -1;
+}
@@ -0,0 +1,126 @@
+/* GStreamer Dynamic App Source element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_DYN_SHM_H__
+#define __GST_DYN_SHM_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Layout of the ring shared with the producer process, in host byte order.
+ * The producer creates it in a memfd (or any file it can mmap shared) of at
+ * least GST_DYN_SHM_SIZE() bytes and passes the descriptor over:
+ *
+ *   0                        GstDynShmHeader
+ *   GST_DYN_SHM_SLOTS_OFFSET GstDynShmSlot[n_lanes * n_slots], lane by lane
+ *   GST_DYN_SHM_DATA_OFFSET  slot_size bytes per slot, in the same order
+ *
+ * Every lane is one stream. The producer fills the slots of a lane in turn:
+ * it waits for the state of the next one to be FREE, writes the data and
+ * the descriptor, sets the state to FILLED and writes to the notify eventfd.
+ * dynappsrc takes FILLED slots in order from the tail of the lane, wraps
+ * them into buffers without copying and sets them back to FREE, writing to
+ * the release eventfd, once the pipeline dropped the buffer. Slots can come
+ * back out of order. Setting GST_DYN_SHM_LANE_EOS in the flags of the lane
+ * ends the stream after its last FILLED slot.
+ *
+ * States and flags are accessed atomically, with a full barrier, by both
+ * sides. Everything else in the header is written once by the producer
+ * before it hands over the descriptor.
+ */
+
+#define GST_DYN_SHM_MAGIC 0x534e5944      /* "DYNS" */
+#define GST_DYN_SHM_VERSION 1
+#define GST_DYN_SHM_MAX_LANES 8
+#define GST_DYN_SHM_CAPS_LEN 248
+
+typedef enum
+{
+  GST_DYN_SHM_SLOT_FREE,        /* owned by the producer */
+  GST_DYN_SHM_SLOT_FILLED,      /* ready for dynappsrc */
+  GST_DYN_SHM_SLOT_IN_USE       /* in a buffer of the pipeline */
+} GstDynShmSlotState;
+
+#define GST_DYN_SHM_SLOT_DELTA_UNIT (1 << 0)
+#define GST_DYN_SHM_SLOT_DISCONT (1 << 1)
+
+#define GST_DYN_SHM_LANE_EOS (1 << 0)
+
+typedef struct
+{
+  volatile gint state;          /* GstDynShmSlotState */
+  guint32 size;                 /* bytes of data in the slot */
+  guint32 flags;                /* GST_DYN_SHM_SLOT_* */
+  guint32 reserved;
+  guint64 pts;                  /* G_MAXUINT64 when unknown */
+  guint64 dts;
+  guint64 duration;
+} GstDynShmSlot;
+
+typedef struct
+{
+  volatile gint flags;          /* GST_DYN_SHM_LANE_*, set by the producer */
+  volatile gint tail;           /* next slot dynappsrc takes, counting up */
+  gchar caps[GST_DYN_SHM_CAPS_LEN];     /* caps of the stream, may be empty */
+} GstDynShmLane;
+
+typedef struct
+{
+  guint32 magic;
+  guint32 version;
+  guint32 n_lanes;
+  guint32 n_slots;              /* per lane */
+  guint32 slot_size;
+  guint32 reserved[3];
+  GstDynShmLane lanes[GST_DYN_SHM_MAX_LANES];
+} GstDynShmHeader;
+
+#define GST_DYN_SHM_SLOTS_OFFSET (sizeof (GstDynShmHeader))
+#define GST_DYN_SHM_DATA_OFFSET(n_lanes,n_slots) \
+    ((GST_DYN_SHM_SLOTS_OFFSET + (gsize) (n_lanes) * (n_slots) * \
+        sizeof (GstDynShmSlot) + 4095) & ~((gsize) 4095))
+#define GST_DYN_SHM_SIZE(n_lanes,n_slots,slot_size) \
+    (GST_DYN_SHM_DATA_OFFSET (n_lanes, n_slots) + \
+        (gsize) (n_lanes) * (n_slots) * (slot_size))
+
+typedef struct _GstDynShmRing GstDynShmRing;
+
+/* @buffer is NULL at the end of @lane */
+typedef GstFlowReturn (*GstDynShmPushFunc) (guint lane, GstBuffer * buffer,
+    gpointer user_data);
+
+gboolean gst_dyn_shm_is_shm_uri (const gchar * uri);
+gboolean gst_dyn_shm_parse_uri (const gchar * uri, gint * fd,
+    gint * notify_fd, gint * release_fd, GError ** error);
+
+GstDynShmRing *gst_dyn_shm_ring_open (GstElement * owner, gint fd,
+    gint notify_fd, gint release_fd, GError ** error);
+void gst_dyn_shm_ring_unref (GstDynShmRing * ring);
+
+guint gst_dyn_shm_ring_get_n_lanes (GstDynShmRing * ring);
+GstCaps *gst_dyn_shm_ring_get_caps (GstDynShmRing * ring, guint lane);
+
+gboolean gst_dyn_shm_ring_start (GstDynShmRing * ring,
+    GstDynShmPushFunc push, gpointer user_data);
+void gst_dyn_shm_ring_stop (GstDynShmRing * ring);
+
+G_END_DECLS
+#endif /* __GST_DYN_SHM_H__ */
@@ -27,6 +27,7 @@
 #include <unistd.h>
 
 #include "gsthttpextbin.h"
+#include "gsthttpsegsrc.h"
 
 GST_DEBUG_CATEGORY_STATIC (http_ext_bin_debug);
 #define GST_CAT_DEFAULT http_ext_bin_debug
@@ -34,11 +35,23 @@ GST_DEBUG_CATEGORY_STATIC (http_ext_bin_debug);
 #define parent_class gst_http_ext_bin_parent_class
 
 #define DEFAULT_PROP_URI NULL
+#define DEFAULT_PROP_CONNECTIONS 1
+#define DEFAULT_PROP_SEGMENT_SIZE (1024 * 1024)
+
+/* the filter factory per application/<subtype> caps string, shared by all
+ * instances and dropped when the registry changes */
+static GMutex filter_cache_lock;
+static GHashTable *filter_cache;
+static guint32 filter_cache_cookie;
+
 enum
 {
   PROP_0,
   PROP_SOURCE,
   PROP_URI,
+  PROP_CONNECTIONS,
+  PROP_SEGMENT_SIZE,
+  PROP_CONNECTION_STATS,
   PROP_LAST
 };
 
@@ -87,6 +100,50 @@ gst_http_ext_bin_class_init (GstHttpExtBinClass * klass)
       g_param_spec_string ("uri", "URI",
           "URI to be set source element",
           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:connections
+   *
+   * Number of parallel connections the resource is downloaded over. With
+   * more than one, it is fetched in segments of segment-size bytes with
+   * range requests, reassembled in order before the filter element. Every
+   * segment is a new request on a new connection, so segments should be
+   * large enough to cover the connection setup. With one, a plain
+   * souphttpsrc is used. Read when going to PAUSED.
+   */
+  g_object_class_install_property (gobject_class, PROP_CONNECTIONS,
+      g_param_spec_uint ("connections", "Connections",
+          "Number of parallel connections (1 = a single request)", 1, 16,
+          DEFAULT_PROP_CONNECTIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:segment-size
+   *
+   * Bytes requested at once by a connection when there are several. Read
+   * when going to PAUSED.
+   */
+  g_object_class_install_property (gobject_class, PROP_SEGMENT_SIZE,
+      g_param_spec_uint ("segment-size", "Segment size",
+          "Bytes requested at once by each of the parallel connections",
+          4096, G_MAXINT, DEFAULT_PROP_SEGMENT_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpExtBin:connection-stats
+   *
+   * A structure named "connection-stats" with the number of "connections"
+   * and for every connection N the "bytes-N" and "segments-N" it
+   * downloaded, the "requests-N" it made and "retries-N" among them, and
+   * for its last request the throughput "bitrate-N" in bits per second and
+   * the "latency-N" to the first byte in nanoseconds. %NULL unless
+   * downloading over several connections.
+   */
+  g_object_class_install_property (gobject_class, PROP_CONNECTION_STATS,
+      g_param_spec_boxed ("connection-stats", "Connection statistics",
+          "Throughput of every parallel connection",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_http_ext_bin_change_state);
 
@@ -114,6 +171,8 @@ gst_http_ext_bin_init (GstHttpExtBin * bin)
 
   /* init member variable */
   bin->uri = g_strdup (DEFAULT_PROP_URI);
+  bin->connections = DEFAULT_PROP_CONNECTIONS;
+  bin->segment_size = DEFAULT_PROP_SEGMENT_SIZE;
 
   GST_OBJECT_FLAG_SET (bin, GST_ELEMENT_FLAG_SOURCE);
 }
@@ -136,6 +195,16 @@ gst_http_ext_bin_set_property (GObject * object, guint prop_id,
       GST_OBJECT_UNLOCK (bin);
     }
       break;
+    case PROP_CONNECTIONS:
+      GST_OBJECT_LOCK (bin);
+      bin->connections = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_SEGMENT_SIZE:
+      GST_OBJECT_LOCK (bin);
+      bin->segment_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -157,6 +226,33 @@ gst_http_ext_bin_get_property (GObject * object, guint prop_id,
     case PROP_URI:
       g_value_set_string (value, bin->uri);
       break;
+    case PROP_CONNECTIONS:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->connections);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_SEGMENT_SIZE:
+      GST_OBJECT_LOCK (bin);
+      g_value_set_uint (value, bin->segment_size);
+      GST_OBJECT_UNLOCK (bin);
+      break;
+    case PROP_CONNECTION_STATS:
+    {
+      GstElement *source = NULL;
+
+      GST_OBJECT_LOCK (bin);
+      if (bin->source_elem && GST_IS_HTTP_SEG_SRC (bin->source_elem))
+        source = gst_object_ref (bin->source_elem);
+      GST_OBJECT_UNLOCK (bin);
+
+      if (source) {
+        g_object_get_property (G_OBJECT (source), "stats", value);
+        gst_object_unref (source);
+      } else {
+        g_value_set_boxed (value, NULL);
+      }
+    }
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -175,10 +271,6 @@ gst_http_ext_bin_finalize (GObject * self)
     gst_caps_unref (bin->caps);
   bin->caps = NULL;
 
-  if (bin->list)
-    gst_plugin_feature_list_free (bin->list);
-  bin->list = NULL;
-
   G_OBJECT_CLASS (parent_class)->finalize (self);
 }
 
@@ -209,7 +301,7 @@ _http_ext_bin_compare_factories_func (gconstpointer p1, gconstpointer p2)
 static GList *
 gst_http_ext_bin_update_factories_list (GstHttpExtBin * bin)
 {
-  GList *factories;
+  GList *factories, *list;
 
   /* list up elements with given caps */
   factories =
@@ -221,20 +313,108 @@ gst_http_ext_bin_update_factories_list (GstHttpExtBin * bin)
     return NULL;
   }
 
-  if (bin->list)
-    gst_plugin_feature_list_free (bin->list);
-  bin->list =
+  list =
       gst_element_factory_list_filter (factories, bin->caps, GST_PAD_SINK,
       gst_caps_is_fixed (bin->caps));
   gst_plugin_feature_list_free (factories);
 
-  if (!bin->list) {
+  if (!list) {
     GST_WARNING_OBJECT (bin->caps,
         "Couldn't list up any of element which handles caps");
     return NULL;
   }
 
-  return g_list_sort (bin->list, _http_ext_bin_compare_factories_func);
+  return g_list_sort (list, _http_ext_bin_compare_factories_func);
+}
+
+/* scans the registry for the best filter whose sink template has bin->caps
+ * as a subset, returns a ref */
+static GstElementFactory *
+find_filter_factory (GstHttpExtBin * bin)
+{
+  GList *list, *tmp;
+  GstElementFactory *factory = NULL;
+  gboolean skip = FALSE;
+
+  /* list up elements with given caps */
+  list = gst_http_ext_bin_update_factories_list (bin);
+
+  for (tmp = list; tmp; tmp = tmp->next) {
+    const GList *templs;
+    GstElementFactory *fac = GST_ELEMENT_FACTORY_CAST (tmp->data);
+    templs = gst_element_factory_get_static_pad_templates (fac);
+
+    while (templs) {
+      GstStaticPadTemplate *templ = (GstStaticPadTemplate *) templs->data;
+
+      if (templ->direction == GST_PAD_SINK) {
+        GstCaps *templcaps = gst_static_caps_get (&templ->static_caps);
+        if (!gst_caps_is_any (templcaps)
+            && gst_caps_is_subset (bin->caps, templcaps)) {
+          GST_INFO_OBJECT (bin,
+              "caps %" GST_PTR_FORMAT " subset of %" GST_PTR_FORMAT, bin->caps,
+              templcaps);
+          factory = gst_object_ref (fac);
+          gst_caps_unref (templcaps);
+          skip = TRUE;
+          break;
+        }
+        gst_caps_unref (templcaps);
+      }
+      templs = g_list_next (templs);
+    }
+    if (skip)
+      break;
+  }
+
+  if (list)
+    gst_plugin_feature_list_free (list);
+
+  return factory;
+}
+
+/* the filter factory for @caps_str, from the cache while the registry
+ * did not change, returns a ref */
+static GstElementFactory *
+get_filter_factory (GstHttpExtBin * bin, const gchar * caps_str)
+{
+  GstElementFactory *factory;
+  guint32 cookie;
+
+  cookie = gst_registry_get_feature_list_cookie (gst_registry_get ());
+
+  g_mutex_lock (&filter_cache_lock);
+  if (!filter_cache)
+    filter_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        gst_object_unref);
+  if (cookie != filter_cache_cookie) {
+    GST_DEBUG_OBJECT (bin, "registry changed, dropping the filter cache");
+    g_hash_table_remove_all (filter_cache);
+    filter_cache_cookie = cookie;
+  }
+
+  factory = g_hash_table_lookup (filter_cache, caps_str);
+  if (factory) {
+    GST_DEBUG_OBJECT (bin, "cached filter %s for %s",
+        GST_OBJECT_NAME (factory), caps_str);
+    factory = gst_object_ref (factory);
+  }
+  g_mutex_unlock (&filter_cache_lock);
+
+  if (factory)
+    return factory;
+
+  /* scanned without the lock, another instance may store the same */
+  factory = find_filter_factory (bin);
+  if (factory) {
+    g_mutex_lock (&filter_cache_lock);
+    if (cookie == filter_cache_cookie)
+      g_hash_table_replace (filter_cache, g_strdup (caps_str),
+          gst_object_ref (factory));
+    g_mutex_unlock (&filter_cache_lock);
+  }
+
+  return factory;
 }
 
 static gboolean
@@ -310,10 +490,6 @@ remove_source (GstHttpExtBin * bin)
     gst_caps_unref (bin->caps);
   bin->caps = NULL;
 
-  if (bin->list)
-    gst_plugin_feature_list_free (bin->list);
-  bin->list = NULL;
-
   /* Don't loose the SOURCE flag */
   GST_OBJECT_FLAG_SET (bin, GST_ELEMENT_FLAG_SOURCE);
 }
@@ -326,10 +502,9 @@ setup_source (GstHttpExtBin * bin)
   gchar **protocols = NULL;
   gchar *real_protocol;
   gchar *new_uri;
-  GList *tmp;
   GstElementFactory *factory = NULL;
-  gboolean skip = FALSE;
   gchar *caps_str;
+  guint connections, segment_size;
 
   GST_DEBUG_OBJECT (bin, "setup source");
 
@@ -353,36 +528,7 @@ setup_source (GstHttpExtBin * bin)
 
   GST_INFO_OBJECT (bin->caps, "created caps");
 
-  /* list up elements with given caps */
-  bin->list = gst_http_ext_bin_update_factories_list (bin);
-
-  for (tmp = bin->list; tmp; tmp = tmp->next) {
-    const GList *templs;
-    GstElementFactory *fac = GST_ELEMENT_FACTORY_CAST (tmp->data);
-    templs = gst_element_factory_get_static_pad_templates (fac);
-
-    while (templs) {
-      GstStaticPadTemplate *templ = (GstStaticPadTemplate *) templs->data;
-
-      if (templ->direction == GST_PAD_SINK) {
-        GstCaps *templcaps = gst_static_caps_get (&templ->static_caps);
-        if (!gst_caps_is_any (templcaps)
-            && gst_caps_is_subset (bin->caps, templcaps)) {
-          GST_INFO_OBJECT (bin,
-              "caps %" GST_PTR_FORMAT " subset of %" GST_PTR_FORMAT, bin->caps,
-              templcaps);
-          factory = fac;
-          gst_caps_unref (templcaps);
-          skip = TRUE;
-          break;
-        }
-        gst_caps_unref (templcaps);
-      }
-      templs = g_list_next (templs);
-    }
-    if (skip)
-      break;
-  }
+  factory = get_filter_factory (bin, caps_str);
 
   if (!factory) {
     ret = FALSE;
@@ -392,9 +538,20 @@ setup_source (GstHttpExtBin * bin)
   g_free (caps_str);
   g_strfreev (protocols);
 
-  /* generate souphttpsrc element */
-  if (!(bin->source_elem = gst_element_factory_make ("souphttpsrc", NULL))) {
+  GST_OBJECT_LOCK (bin);
+  connections = bin->connections;
+  segment_size = bin->segment_size;
+  GST_OBJECT_UNLOCK (bin);
+
+  /* generate souphttpsrc element, or the segmented source using several */
+  if (connections > 1) {
+    GST_INFO_OBJECT (bin, "downloading over %u connections", connections);
+    bin->source_elem = g_object_new (GST_TYPE_HTTP_SEG_SRC, "connections",
+        connections, "segment-size", segment_size, NULL);
+  } else if (!(bin->source_elem =
+          gst_element_factory_make ("souphttpsrc", NULL))) {
     GST_WARNING_OBJECT (bin, "Could not create a souphttpsrc element ");
+    gst_object_unref (factory);
     return FALSE;
   }
 
@@ -408,6 +565,7 @@ setup_source (GstHttpExtBin * bin)
   if (!ret) {
     GST_WARNING_OBJECT (bin, "Failed to set uri:%s to souphttpsrc element",
         new_uri);
+    gst_object_unref (factory);
     return FALSE;
   }
 
@@ -415,16 +573,20 @@ setup_source (GstHttpExtBin * bin)
 
   if (!(gst_bin_add (GST_BIN_CAST (bin), bin->source_elem))) {
     GST_WARNING_OBJECT (bin, "Couldn't add souphttp element to bin");
+    gst_object_unref (factory);
     return FALSE;
   }
 
   /* generate filter element */
   GST_INFO_OBJECT (bin, "filtered factory:%s", GST_OBJECT_NAME (factory));
-  if ((bin->filter_elem = gst_element_factory_create (factory, NULL)) == NULL) {
+  bin->filter_elem = gst_element_factory_create (factory, NULL);
+  if (bin->filter_elem == NULL) {
     GST_WARNING_OBJECT (bin, "Could not create an element from %s",
         gst_plugin_feature_get_name (GST_PLUGIN_FEATURE (factory)));
+    gst_object_unref (factory);
     return FALSE;
   }
+  gst_object_unref (factory);
 
   /* connent filter element */
   ret = connect_filter_element (bin);
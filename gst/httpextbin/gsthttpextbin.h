@@ -44,7 +44,8 @@ struct _GstHttpExtBin
   gchar *uri;
   GstCaps *caps;
 
-  GList *list;                  /* list we can use for selecting elements */
+  guint connections;
+  guint segment_size;
 };
 
 struct _GstHttpExtBinClass
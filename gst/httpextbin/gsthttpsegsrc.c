@@ -0,0 +1,1001 @@
+/* GStreamer httpextbin element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Source of httpextbin downloading the resource over several connections
+ * at once, for servers limiting the rate of each connection.
+ *
+ * The resource is cut into segments of segment-size bytes. Every connection
+ * is a souphttpsrc ! fakesink pipeline of its own, driven by a worker
+ * thread which takes the next segment nobody requested yet and fetches it
+ * with a Range header. Segments are kept by index until all the ones before
+ * them were pushed, so the filter element downstream gets the bytes in
+ * order. Workers stay at most WINDOW_PER_CONN segments per connection ahead
+ * of the one being pushed, which bounds the memory used.
+ *
+ * The length of the resource is not needed: the first segment coming back
+ * short, or empty because the server answered 416, is the last one. Any
+ * other failure is retried from the last byte received. A server ignoring
+ * Range answers with the whole resource, noticed when a segment gets more
+ * than it asked for: the first segment then carries on to the end on its
+ * own and the others are dropped.
+ *
+ * The 1.0 souphttpsrc can only be given a bounded range through its
+ * extra-headers, read when it starts, so every segment goes through
+ * READY -> PLAYING -> READY and opens a new connection: each request pays
+ * the TCP (and TLS) handshake and slow start again. Segments should be
+ * large enough for that to be small against their transfer, the stats
+ * report the time to the first byte of every request to tell.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gsthttpsegsrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (http_seg_src_debug);
+#define GST_CAT_DEFAULT http_seg_src_debug
+
+#define parent_class gst_http_seg_src_parent_class
+
+#define DEFAULT_PROP_LOCATION NULL
+#define DEFAULT_PROP_CONNECTIONS 4
+#define DEFAULT_PROP_SEGMENT_SIZE (1024 * 1024)
+#define MAX_CONNECTIONS 16
+#define MIN_SEGMENT_SIZE 4096
+
+/* segments per connection requested ahead of the one being pushed */
+#define WINDOW_PER_CONN 2
+/* times a segment failing half way is resumed */
+#define MAX_RETRIES 3
+
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_CONNECTIONS,
+  PROP_SEGMENT_SIZE,
+  PROP_STATS,
+  PROP_LAST
+};
+
+typedef enum
+{
+  REQUEST_RUNNING,
+  REQUEST_DONE,
+  REQUEST_FAILED,
+  REQUEST_PAST_END,             /* the server answered 416 */
+  REQUEST_STALE                 /* seeked, stopped or dropped meanwhile */
+} RequestResult;
+
+typedef struct
+{
+  GQueue buffers;
+  guint64 queued;               /* bytes in buffers */
+  guint64 received;
+  gboolean done;
+} Segment;
+
+typedef struct
+{
+  GstHttpSegSrc *src;
+  guint id;
+  GThread *thread;
+  GstElement *pipeline;
+  GstElement *httpsrc;
+
+  /* the segment being fetched, with the lock */
+  guint index;
+  guint generation;
+  Segment *segment;
+  guint64 expected;             /* G_MAXUINT64 when up to the end */
+  RequestResult result;
+
+  /* stats, with the lock */
+  guint64 bytes;
+  guint segments;
+  guint retries;
+  guint requests;
+  gint64 started;               /* monotonic time of the last request */
+  gint64 first_byte;            /* and of its first byte, 0 before */
+  guint64 request_bytes;
+  guint64 bitrate;              /* of the last request with data */
+  gint64 latency;               /* to its first byte, in microseconds */
+} SegConn;
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static void gst_http_seg_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_http_seg_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_http_seg_src_finalize (GObject * object);
+static gboolean gst_http_seg_src_start (GstBaseSrc * bsrc);
+static gboolean gst_http_seg_src_stop (GstBaseSrc * bsrc);
+static gboolean gst_http_seg_src_is_seekable (GstBaseSrc * bsrc);
+static gboolean gst_http_seg_src_do_seek (GstBaseSrc * bsrc,
+    GstSegment * segment);
+static gboolean gst_http_seg_src_unlock (GstBaseSrc * bsrc);
+static gboolean gst_http_seg_src_unlock_stop (GstBaseSrc * bsrc);
+static GstFlowReturn gst_http_seg_src_create (GstBaseSrc * bsrc,
+    guint64 offset, guint length, GstBuffer ** outbuf);
+static void gst_http_seg_src_uri_handler_init (gpointer g_iface,
+    gpointer iface_data);
+
+G_DEFINE_TYPE_WITH_CODE (GstHttpSegSrc, gst_http_seg_src, GST_TYPE_BASE_SRC,
+    G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER,
+        gst_http_seg_src_uri_handler_init));
+
+static void
+gst_http_seg_src_class_init (GstHttpSegSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+  GstBaseSrcClass *gstbasesrc_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gstelement_class = GST_ELEMENT_CLASS (klass);
+  gstbasesrc_class = GST_BASE_SRC_CLASS (klass);
+
+  gobject_class->set_property = gst_http_seg_src_set_property;
+  gobject_class->get_property = gst_http_seg_src_get_property;
+  gobject_class->finalize = gst_http_seg_src_finalize;
+
+  gst_element_class_add_pad_template (gstelement_class,
+      gst_static_pad_template_get (&src_template));
+
+  g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "Location",
+          "URI of the resource to download", DEFAULT_PROP_LOCATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CONNECTIONS,
+      g_param_spec_uint ("connections", "Connections",
+          "Number of parallel connections", 1, MAX_CONNECTIONS,
+          DEFAULT_PROP_CONNECTIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SEGMENT_SIZE,
+      g_param_spec_uint ("segment-size", "Segment size",
+          "Bytes requested at once by a connection", MIN_SEGMENT_SIZE,
+          G_MAXINT, DEFAULT_PROP_SEGMENT_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstHttpSegSrc:stats
+   *
+   * A structure named "connection-stats" with the number of "connections"
+   * and for every connection N the "bytes-N" and "segments-N" it
+   * downloaded, the "requests-N" it made and "retries-N" among them, and
+   * for its last request which brought data the throughput "bitrate-N" in
+   * bits per second, setup included, and the "latency-N" to its first byte
+   * in nanoseconds. Kept after the download until the next one starts.
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Throughput of every connection", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gstbasesrc_class->start = GST_DEBUG_FUNCPTR (gst_http_seg_src_start);
+  gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_http_seg_src_stop);
+  gstbasesrc_class->is_seekable =
+      GST_DEBUG_FUNCPTR (gst_http_seg_src_is_seekable);
+  gstbasesrc_class->do_seek = GST_DEBUG_FUNCPTR (gst_http_seg_src_do_seek);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_http_seg_src_unlock);
+  gstbasesrc_class->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_http_seg_src_unlock_stop);
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_http_seg_src_create);
+
+  gst_element_class_set_static_metadata (gstelement_class,
+      "Segmented Http Source", "Source/Network",
+      "Downloads over parallel HTTP range requests",
+      "HoonHee Lee <hoonhee.lee@lge.com>");
+
+  GST_DEBUG_CATEGORY_INIT (http_seg_src_debug, "httpsegsrc", 0,
+      "Segmented Http Source");
+}
+
+static Segment *
+segment_new (void)
+{
+  Segment *segment = g_slice_new0 (Segment);
+
+  g_queue_init (&segment->buffers);
+
+  return segment;
+}
+
+static void
+segment_free (Segment * segment)
+{
+  g_queue_foreach (&segment->buffers, (GFunc) gst_buffer_unref, NULL);
+  g_queue_clear (&segment->buffers);
+  g_slice_free (Segment, segment);
+}
+
+static void
+gst_http_seg_src_init (GstHttpSegSrc * src)
+{
+  g_mutex_init (&src->lock);
+  g_cond_init (&src->cond);
+  src->segments = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) segment_free);
+
+  src->location = g_strdup (DEFAULT_PROP_LOCATION);
+  src->connections = DEFAULT_PROP_CONNECTIONS;
+  src->segment_size = DEFAULT_PROP_SEGMENT_SIZE;
+
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_BYTES);
+}
+
+static GstStructure *
+gst_http_seg_src_get_stats (GstHttpSegSrc * src)
+{
+  GstStructure *stats;
+  guint i, n;
+
+  g_mutex_lock (&src->lock);
+  n = src->conns ? src->conns->len : 0;
+  stats = gst_structure_new ("connection-stats",
+      "connections", G_TYPE_UINT, n, NULL);
+
+  for (i = 0; i < n; i++) {
+    SegConn *conn = g_ptr_array_index (src->conns, i);
+    gchar *bytes, *segments, *requests, *retries, *rate, *latency;
+
+    bytes = g_strdup_printf ("bytes-%u", i);
+    segments = g_strdup_printf ("segments-%u", i);
+    requests = g_strdup_printf ("requests-%u", i);
+    retries = g_strdup_printf ("retries-%u", i);
+    rate = g_strdup_printf ("bitrate-%u", i);
+    latency = g_strdup_printf ("latency-%u", i);
+    gst_structure_set (stats, bytes, G_TYPE_UINT64, conn->bytes,
+        segments, G_TYPE_UINT, conn->segments,
+        requests, G_TYPE_UINT, conn->requests,
+        retries, G_TYPE_UINT, conn->retries,
+        rate, G_TYPE_UINT64, conn->bitrate,
+        latency, G_TYPE_UINT64, conn->latency * GST_USECOND, NULL);
+    g_free (bytes);
+    g_free (segments);
+    g_free (requests);
+    g_free (retries);
+    g_free (rate);
+    g_free (latency);
+  }
+  g_mutex_unlock (&src->lock);
+
+  return stats;
+}
+
+static void
+gst_http_seg_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      GST_OBJECT_LOCK (src);
+      g_free (src->location);
+      src->location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_CONNECTIONS:
+      GST_OBJECT_LOCK (src);
+      src->connections = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_SEGMENT_SIZE:
+      GST_OBJECT_LOCK (src);
+      src->segment_size = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_http_seg_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      GST_OBJECT_LOCK (src);
+      g_value_set_string (value, src->location);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_CONNECTIONS:
+      GST_OBJECT_LOCK (src);
+      g_value_set_uint (value, src->connections);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_SEGMENT_SIZE:
+      GST_OBJECT_LOCK (src);
+      g_value_set_uint (value, src->segment_size);
+      GST_OBJECT_UNLOCK (src);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_http_seg_src_get_stats (src));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+seg_conn_free (SegConn * conn)
+{
+  if (conn->pipeline) {
+    gst_element_set_state (conn->pipeline, GST_STATE_NULL);
+    gst_object_unref (conn->pipeline);
+  }
+  g_slice_free (SegConn, conn);
+}
+
+static void
+gst_http_seg_src_finalize (GObject * object)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (object);
+
+  if (src->conns)
+    g_ptr_array_unref (src->conns);
+  g_hash_table_destroy (src->segments);
+  g_free (src->location);
+  g_free (src->error);
+  g_mutex_clear (&src->lock);
+  g_cond_clear (&src->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* with the lock, the segment of @conn is still wanted */
+static gboolean
+is_current (GstHttpSegSrc * src, SegConn * conn)
+{
+  return src->running && conn->generation == src->generation &&
+      g_hash_table_lookup (src->segments,
+      GUINT_TO_POINTER (conn->index)) == conn->segment;
+}
+
+static gboolean
+remove_all_but_first (gpointer key, gpointer value, gpointer user_data)
+{
+  return GPOINTER_TO_UINT (key) != 0;
+}
+
+/* with the lock, a segment got more than it asked for */
+static void
+server_ignores_ranges (GstHttpSegSrc * src)
+{
+  guint i;
+
+  src->no_ranges = TRUE;
+  g_cond_broadcast (&src->cond);
+
+  if (src->base != 0) {
+    g_free (src->error);
+    src->error = g_strdup ("Server does not support range requests");
+    return;
+  }
+
+  GST_WARNING_OBJECT (src, "server ignores Range, downloading over one "
+      "connection");
+
+  /* the answer to the first segment is the whole resource */
+  g_hash_table_foreach_remove (src->segments, remove_all_but_first, NULL);
+  for (i = 0; i < src->conns->len; i++) {
+    SegConn *conn = g_ptr_array_index (src->conns, i);
+
+    if (conn->index == 0 && conn->generation == src->generation)
+      conn->expected = G_MAXUINT64;
+  }
+}
+
+/* streaming thread of a connection */
+static void
+seg_conn_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    SegConn * conn)
+{
+  GstHttpSegSrc *src = conn->src;
+  Segment *segment;
+  gsize size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&src->lock);
+  if (conn->result != REQUEST_RUNNING)
+    goto done;
+
+  segment = conn->segment;
+  if (is_current (src, conn) && !src->no_ranges
+      && segment->received + size > conn->expected)
+    server_ignores_ranges (src);
+
+  if (src->error || !is_current (src, conn)) {
+    conn->result = REQUEST_STALE;
+    g_cond_broadcast (&src->cond);
+    goto done;
+  }
+
+  g_queue_push_tail (&segment->buffers, gst_buffer_ref (buffer));
+  segment->queued += size;
+  segment->received += size;
+  conn->bytes += size;
+  if (conn->request_bytes == 0)
+    conn->first_byte = g_get_monotonic_time ();
+  conn->request_bytes += size;
+  g_cond_broadcast (&src->cond);
+
+  /* the whole resource in one segment only waits for the consumer */
+  while (conn->expected == G_MAXUINT64 && segment->queued > src->size
+      && conn->result == REQUEST_RUNNING && is_current (src, conn))
+    g_cond_wait (&src->cond, &src->lock);
+
+done:
+  g_mutex_unlock (&src->lock);
+}
+
+/* any thread */
+static GstBusSyncReply
+seg_conn_bus_sync (GstBus * bus, GstMessage * message, SegConn * conn)
+{
+  GstHttpSegSrc *src = conn->src;
+  RequestResult result;
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_EOS:
+      result = REQUEST_DONE;
+      break;
+    case GST_MESSAGE_ERROR:
+    {
+      GError *err = NULL;
+      gchar *debug = NULL;
+
+      /* souphttpsrc puts the status code in the debug string */
+      gst_message_parse_error (message, &err, &debug);
+      if (debug && strstr (debug, "(416)")) {
+        GST_DEBUG_OBJECT (src, "connection %u: past the end", conn->id);
+        result = REQUEST_PAST_END;
+      } else {
+        GST_WARNING_OBJECT (src, "connection %u: %s (%s)", conn->id,
+            err->message, GST_STR_NULL (debug));
+        result = REQUEST_FAILED;
+      }
+      g_error_free (err);
+      g_free (debug);
+      break;
+    }
+    default:
+      return GST_BUS_DROP;
+  }
+
+  g_mutex_lock (&src->lock);
+  if (conn->result == REQUEST_RUNNING) {
+    conn->result = result;
+    g_cond_broadcast (&src->cond);
+  }
+  g_mutex_unlock (&src->lock);
+
+  return GST_BUS_DROP;
+}
+
+static SegConn *
+seg_conn_new (GstHttpSegSrc * src, guint id, const gchar * location)
+{
+  SegConn *conn;
+  GstElement *httpsrc, *sink;
+  GstBus *bus;
+
+  if (!(httpsrc = gst_element_factory_make ("souphttpsrc", NULL)))
+    return NULL;
+  if (!(sink = gst_element_factory_make ("fakesink", NULL))) {
+    gst_object_unref (httpsrc);
+    return NULL;
+  }
+
+  conn = g_slice_new0 (SegConn);
+  conn->src = src;
+  conn->id = id;
+  conn->result = REQUEST_STALE;
+  conn->pipeline = gst_pipeline_new (NULL);
+  conn->httpsrc = httpsrc;
+
+  g_object_set (httpsrc, "location", location, NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (seg_conn_handoff), conn);
+
+  gst_bin_add_many (GST_BIN_CAST (conn->pipeline), httpsrc, sink, NULL);
+  gst_element_link (httpsrc, sink);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE_CAST (conn->pipeline));
+  gst_bus_set_sync_handler (bus, (GstBusSyncHandler) seg_conn_bus_sync, conn,
+      NULL);
+  gst_object_unref (bus);
+
+  return conn;
+}
+
+/* with the lock, released meanwhile, fetches bytes @from to @to of the
+ * segment of @conn */
+static RequestResult
+seg_conn_request (SegConn * conn, guint64 from, guint64 to)
+{
+  GstHttpSegSrc *src = conn->src;
+  GstStructure *headers;
+  GstStateChangeReturn ret;
+  RequestResult result;
+  gchar *range;
+
+  range = g_strdup_printf ("bytes=%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+      from, to);
+  GST_LOG_OBJECT (src, "connection %u: segment %u, %s", conn->id, conn->index,
+      range);
+  headers = gst_structure_new ("extra-headers", "Range", G_TYPE_STRING, range,
+      NULL);
+  g_object_set (conn->httpsrc, "extra-headers", headers, NULL);
+  gst_structure_free (headers);
+  g_free (range);
+
+  conn->result = REQUEST_RUNNING;
+  conn->requests++;
+  conn->started = g_get_monotonic_time ();
+  conn->first_byte = 0;
+  conn->request_bytes = 0;
+  g_mutex_unlock (&src->lock);
+
+  ret = gst_element_set_state (conn->pipeline, GST_STATE_PLAYING);
+
+  g_mutex_lock (&src->lock);
+  if (ret == GST_STATE_CHANGE_FAILURE && conn->result == REQUEST_RUNNING)
+    conn->result = REQUEST_FAILED;
+  /* stop() and seeks only wake us up, the request is aborted here */
+  while (conn->result == REQUEST_RUNNING && is_current (src, conn))
+    g_cond_wait (&src->cond, &src->lock);
+
+  result = is_current (src, conn) ? conn->result : REQUEST_STALE;
+  conn->result = REQUEST_STALE;
+  if (conn->request_bytes > 0) {
+    conn->bitrate = gst_util_uint64_scale (conn->request_bytes,
+        8 * G_USEC_PER_SEC, MAX (g_get_monotonic_time () - conn->started, 1));
+    conn->latency = conn->first_byte - conn->started;
+  }
+  g_mutex_unlock (&src->lock);
+
+  gst_element_set_state (conn->pipeline, GST_STATE_READY);
+
+  g_mutex_lock (&src->lock);
+  /* a seek or the no-range fallback may have freed the segment meanwhile */
+  if (!is_current (src, conn))
+    result = REQUEST_STALE;
+
+  return result;
+}
+
+/* with the lock */
+static void
+seg_conn_fetch (SegConn * conn)
+{
+  GstHttpSegSrc *src = conn->src;
+  Segment *segment = conn->segment;
+  guint64 start, end;
+  guint attempts = 0;
+
+  start = src->base + (guint64) conn->index * src->size;
+  end = start + src->size - 1;
+
+  while (TRUE) {
+    RequestResult result;
+
+    result = seg_conn_request (conn, start + segment->received, end);
+    if (result == REQUEST_STALE)
+      return;
+    if (result == REQUEST_DONE)
+      break;
+    /* starts past the end, the segment is empty */
+    if (result == REQUEST_PAST_END && segment->received == 0)
+      break;
+
+    /* past the end found meanwhile, never pushed anyway */
+    if (src->ended && conn->index > src->last)
+      break;
+    if (conn->expected == G_MAXUINT64 || attempts == MAX_RETRIES)
+      goto failed;
+
+    attempts++;
+    conn->retries++;
+    GST_DEBUG_OBJECT (src, "connection %u: resuming segment %u at %"
+        G_GUINT64_FORMAT, conn->id, conn->index, segment->received);
+  }
+
+  segment->done = TRUE;
+  conn->segments++;
+  if (segment->received < conn->expected) {
+    GST_DEBUG_OBJECT (src, "segment %u is the last one, %" G_GUINT64_FORMAT
+        " bytes", conn->index, segment->received);
+    src->ended = TRUE;
+    src->last = MIN (src->last, conn->index);
+  }
+  g_cond_broadcast (&src->cond);
+  return;
+
+failed:
+  {
+    if (!src->error)
+      src->error = g_strdup_printf ("Could not download bytes %"
+          G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT, start, end);
+    g_cond_broadcast (&src->cond);
+  }
+}
+
+static gpointer
+seg_conn_thread (SegConn * conn)
+{
+  GstHttpSegSrc *src = conn->src;
+
+  g_mutex_lock (&src->lock);
+  while (src->running) {
+    Segment *segment;
+
+    if (src->no_ranges || src->error || (src->ended && src->next > src->last)
+        || src->next >= src->out + WINDOW_PER_CONN * src->conns->len) {
+      g_cond_wait (&src->cond, &src->lock);
+      continue;
+    }
+
+    segment = segment_new ();
+    conn->index = src->next++;
+    conn->generation = src->generation;
+    conn->segment = segment;
+    conn->expected = src->size;
+    g_hash_table_insert (src->segments, GUINT_TO_POINTER (conn->index),
+        segment);
+
+    seg_conn_fetch (conn);
+  }
+  g_mutex_unlock (&src->lock);
+
+  return NULL;
+}
+
+static gboolean
+gst_http_seg_src_start (GstBaseSrc * bsrc)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+  GPtrArray *conns, *old;
+  gchar *location;
+  guint connections, size, i;
+
+  GST_OBJECT_LOCK (src);
+  location = g_strdup (src->location);
+  connections = src->connections;
+  size = src->segment_size;
+  GST_OBJECT_UNLOCK (src);
+
+  if (!location)
+    goto no_location;
+
+  conns = g_ptr_array_new_with_free_func ((GDestroyNotify) seg_conn_free);
+  for (i = 0; i < connections; i++) {
+    SegConn *conn = seg_conn_new (src, i, location);
+
+    if (!conn)
+      goto no_souphttpsrc;
+    g_ptr_array_add (conns, conn);
+  }
+  g_free (location);
+
+  GST_DEBUG_OBJECT (src, "%u connections, segments of %u bytes", connections,
+      size);
+
+  g_mutex_lock (&src->lock);
+  old = src->conns;
+  src->conns = conns;
+  src->running = TRUE;
+  src->flushing = FALSE;
+  src->generation++;
+  src->size = size;
+  src->base = 0;
+  src->next = 0;
+  src->out = 0;
+  src->out_offset = 0;
+  g_hash_table_remove_all (src->segments);
+  src->ended = FALSE;
+  src->last = G_MAXUINT;
+  src->no_ranges = FALSE;
+  g_free (src->error);
+  src->error = NULL;
+  g_mutex_unlock (&src->lock);
+
+  if (old)
+    g_ptr_array_unref (old);
+
+  for (i = 0; i < conns->len; i++) {
+    SegConn *conn = g_ptr_array_index (conns, i);
+
+    conn->thread = g_thread_new ("httpsegsrc",
+        (GThreadFunc) seg_conn_thread, conn);
+  }
+
+  return TRUE;
+
+  /* ERRORS */
+no_location:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL),
+        ("No location set"));
+    return FALSE;
+  }
+no_souphttpsrc:
+  {
+    GST_ELEMENT_ERROR (src, CORE, MISSING_PLUGIN, (NULL),
+        ("Could not create a souphttpsrc element"));
+    g_ptr_array_unref (conns);
+    g_free (location);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_http_seg_src_stop (GstBaseSrc * bsrc)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+  GPtrArray *conns;
+  guint i;
+
+  g_mutex_lock (&src->lock);
+  src->running = FALSE;
+  g_cond_broadcast (&src->cond);
+  conns = src->conns ? g_ptr_array_ref (src->conns) : NULL;
+  g_mutex_unlock (&src->lock);
+
+  if (!conns)
+    return TRUE;
+
+  /* the workers abort their requests, the stats stay */
+  for (i = 0; i < conns->len; i++) {
+    SegConn *conn = g_ptr_array_index (conns, i);
+
+    if (conn->thread)
+      g_thread_join (conn->thread);
+    conn->thread = NULL;
+    if (conn->pipeline) {
+      gst_element_set_state (conn->pipeline, GST_STATE_NULL);
+      gst_object_unref (conn->pipeline);
+    }
+    conn->pipeline = NULL;
+    conn->httpsrc = NULL;
+  }
+  g_ptr_array_unref (conns);
+
+  g_mutex_lock (&src->lock);
+  g_hash_table_remove_all (src->segments);
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_seg_src_is_seekable (GstBaseSrc * bsrc)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+  gboolean seekable;
+
+  g_mutex_lock (&src->lock);
+  seekable = !src->no_ranges;
+  g_mutex_unlock (&src->lock);
+
+  return seekable;
+}
+
+static gboolean
+gst_http_seg_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  if (segment->start == src->out_offset)
+    goto done;
+  if (src->no_ranges)
+    goto not_seekable;
+
+  GST_DEBUG_OBJECT (src, "restarting the download at %" G_GUINT64_FORMAT,
+      segment->start);
+
+  /* requests in flight see the new generation and give up */
+  src->generation++;
+  g_hash_table_remove_all (src->segments);
+  src->base = segment->start;
+  src->out_offset = segment->start;
+  src->next = 0;
+  src->out = 0;
+  src->ended = FALSE;
+  src->last = G_MAXUINT;
+  g_cond_broadcast (&src->cond);
+
+done:
+  g_mutex_unlock (&src->lock);
+  return TRUE;
+
+not_seekable:
+  {
+    g_mutex_unlock (&src->lock);
+    GST_DEBUG_OBJECT (src, "server does not support range requests");
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_http_seg_src_unlock (GstBaseSrc * bsrc)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = TRUE;
+  g_cond_broadcast (&src->cond);
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_http_seg_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+
+  g_mutex_lock (&src->lock);
+  src->flushing = FALSE;
+  g_mutex_unlock (&src->lock);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_http_seg_src_create (GstBaseSrc * bsrc, guint64 offset, guint length,
+    GstBuffer ** outbuf)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (bsrc);
+  GstBuffer *buffer = NULL;
+  gchar *error;
+
+  g_mutex_lock (&src->lock);
+  while (TRUE) {
+    Segment *segment;
+
+    if (src->flushing)
+      goto flushing;
+    if (src->error)
+      goto download_failed;
+
+    segment = g_hash_table_lookup (src->segments, GUINT_TO_POINTER (src->out));
+    if (segment && !g_queue_is_empty (&segment->buffers)) {
+      buffer = g_queue_pop_head (&segment->buffers);
+      segment->queued -= gst_buffer_get_size (buffer);
+      g_cond_broadcast (&src->cond);
+      break;
+    }
+
+    if (segment && segment->done) {
+      if (src->ended && src->out >= src->last)
+        goto eos;
+      /* on to the next one, a worker can take another segment */
+      g_hash_table_remove (src->segments, GUINT_TO_POINTER (src->out));
+      src->out++;
+      g_cond_broadcast (&src->cond);
+      continue;
+    }
+    if (!segment && src->ended && src->out > src->last)
+      goto eos;
+
+    g_cond_wait (&src->cond, &src->lock);
+  }
+  offset = src->out_offset;
+  src->out_offset += gst_buffer_get_size (buffer);
+  g_mutex_unlock (&src->lock);
+
+  buffer = gst_buffer_make_writable (buffer);
+  GST_BUFFER_OFFSET (buffer) = offset;
+  GST_BUFFER_OFFSET_END (buffer) = offset + gst_buffer_get_size (buffer);
+  GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_DISCONT);
+  *outbuf = buffer;
+
+  return GST_FLOW_OK;
+
+flushing:
+  {
+    g_mutex_unlock (&src->lock);
+    return GST_FLOW_FLUSHING;
+  }
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "end of the resource at %" G_GUINT64_FORMAT,
+        src->out_offset);
+    g_mutex_unlock (&src->lock);
+    return GST_FLOW_EOS;
+  }
+download_failed:
+  {
+    error = g_strdup (src->error);
+    g_mutex_unlock (&src->lock);
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), ("%s", error));
+    g_free (error);
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstURIType
+gst_http_seg_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_http_seg_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { "http", "https", NULL };
+
+  return protocols;
+}
+
+static gchar *
+gst_http_seg_src_uri_get_uri (GstURIHandler * handler)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (handler);
+  gchar *uri;
+
+  GST_OBJECT_LOCK (src);
+  uri = g_strdup (src->location);
+  GST_OBJECT_UNLOCK (src);
+
+  return uri;
+}
+
+static gboolean
+gst_http_seg_src_uri_set_uri (GstURIHandler * handler, const gchar * uri,
+    GError ** error)
+{
+  GstHttpSegSrc *src = GST_HTTP_SEG_SRC (handler);
+
+  GST_OBJECT_LOCK (src);
+  g_free (src->location);
+  src->location = g_strdup (uri);
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+static void
+gst_http_seg_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_http_seg_src_uri_get_type;
+  iface->get_protocols = gst_http_seg_src_uri_get_protocols;
+  iface->get_uri = gst_http_seg_src_uri_get_uri;
+  iface->set_uri = gst_http_seg_src_uri_set_uri;
+}
@@ -0,0 +1,71 @@
+/* GStreamer httpextbin element
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_HTTP_SEG_SRC_H__
+#define __GST_HTTP_SEG_SRC_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesrc.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_HTTP_SEG_SRC (gst_http_seg_src_get_type())
+#define GST_HTTP_SEG_SRC(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_HTTP_SEG_SRC,GstHttpSegSrc))
+#define GST_HTTP_SEG_SRC_CLASS(obj) (G_TYPE_CHECK_CLASS_CAST((obj),GST_TYPE_HTTP_SEG_SRC,GstHttpSegSrcClass))
+#define GST_IS_HTTP_SEG_SRC(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_HTTP_SEG_SRC))
+#define GST_IS_HTTP_SEG_SRC_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((obj),GST_TYPE_HTTP_SEG_SRC))
+typedef struct _GstHttpSegSrc GstHttpSegSrc;
+typedef struct _GstHttpSegSrcClass GstHttpSegSrcClass;
+
+struct _GstHttpSegSrc
+{
+  GstBaseSrc parent;
+
+  /* properties, with the object lock */
+  gchar *location;
+  guint connections;
+  guint segment_size;
+
+  /* the download, with the lock */
+  GMutex lock;
+  GCond cond;
+  GPtrArray *conns;
+  gboolean running;
+  gboolean flushing;
+  guint generation;             /* bumped by every seek */
+  guint size;                   /* segment size of this download */
+  guint64 base;                 /* offset of segment 0 */
+  guint next;                   /* next segment to request */
+  guint out;                    /* segment being pushed */
+  guint64 out_offset;
+  GHashTable *segments;
+  gboolean ended;
+  guint last;                   /* last segment with data, once ended */
+  gboolean no_ranges;           /* the server ignores Range */
+  gchar *error;
+};
+
+struct _GstHttpSegSrcClass
+{
+  GstBaseSrcClass parent_class;
+};
+
+GType gst_http_seg_src_get_type (void);
+
+G_END_DECLS
+#endif /* __GST_HTTP_SEG_SRC_H__ */
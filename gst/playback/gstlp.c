@@ -29,6 +29,7 @@
 #include "gstlpbin.h"
 #include "gstlpsink.h"
 #include "gstlpsrcbin.h"
+#include "gstlpsubsrc.h"
 #include "gstlptsinkbin.h"
 
 static gboolean
@@ -46,6 +47,10 @@ plugin_init (GstPlugin * plugin)
           GST_TYPE_LP_TSINK_BIN))
     return FALSE;
 
+  if (!gst_element_register (plugin, "lpsubsrc", GST_RANK_NONE,
+          GST_TYPE_LP_SUB_SRC))
+    return FALSE;
+
   return TRUE;
 }
 
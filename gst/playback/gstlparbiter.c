@@ -0,0 +1,382 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Process-wide bookkeeping of the decoder channels used by lpsink
+ * instances. Every channel has at most one owner. A request that finds no
+ * free channel preempts the lowest priority owner below its own priority,
+ * if any, and waits in a queue ordered by priority and arrival until a
+ * channel is released, the timeout expires or its owner is set flushing.
+ *
+ * The number of channels per type defaults to 2 and can be changed with
+ * gst_lp_arbiter_set_capacity() or the GST_LP_VDEC_CHANNELS and
+ * GST_LP_ADEC_CHANNELS environment variables.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "gstlparbiter.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_lp_arbiter_debug);
+#define GST_CAT_DEFAULT gst_lp_arbiter_debug
+
+#define MAX_CHANNELS 8
+#define DEFAULT_VDEC_CHANNELS 2
+#define DEFAULT_ADEC_CHANNELS 2
+
+typedef struct
+{
+  gpointer owner;               /* NULL while the channel is free */
+  gint priority;
+  GstLpArbiterPreemptFunc preempt;
+  gboolean preempted;           /* the owner was asked to give it up */
+} Channel;
+
+typedef struct
+{
+  GstLpResourceType type;
+  gint channel;
+  gboolean exact;
+  gint priority;
+  guint64 seqnum;
+} Waiter;
+
+static GMutex arbiter_lock;
+static GCond arbiter_cond;
+static Channel channels[GST_LP_RESOURCE_LAST][MAX_CHANNELS];
+static guint capacity[GST_LP_RESOURCE_LAST];
+static GList *waiters;          /* highest priority first, then by arrival */
+static GList *flushing;         /* owners whose requests fail right away */
+static guint64 next_seqnum;
+
+static const gchar *resource_names[GST_LP_RESOURCE_LAST] = { "vdec", "adec" };
+
+static guint
+capacity_from_env (const gchar * name, guint def)
+{
+  const gchar *env = g_getenv (name);
+
+  if (env && *env)
+    return CLAMP (atoi (env), 0, MAX_CHANNELS);
+
+  return def;
+}
+
+static void
+gst_lp_arbiter_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    GST_DEBUG_CATEGORY_INIT (gst_lp_arbiter_debug, "lparbiter", 0,
+        "Lightweight Playback decoder resource arbiter");
+
+    capacity[GST_LP_RESOURCE_VDEC] =
+        capacity_from_env ("GST_LP_VDEC_CHANNELS", DEFAULT_VDEC_CHANNELS);
+    capacity[GST_LP_RESOURCE_ADEC] =
+        capacity_from_env ("GST_LP_ADEC_CHANNELS", DEFAULT_ADEC_CHANNELS);
+
+    g_once_init_leave (&initialized, 1);
+  }
+}
+
+const gchar *
+gst_lp_resource_type_get_name (GstLpResourceType type)
+{
+  g_return_val_if_fail (type < GST_LP_RESOURCE_LAST, NULL);
+
+  return resource_names[type];
+}
+
+void
+gst_lp_arbiter_set_capacity (GstLpResourceType type, guint n_channels)
+{
+  g_return_if_fail (type < GST_LP_RESOURCE_LAST);
+
+  gst_lp_arbiter_init ();
+
+  g_mutex_lock (&arbiter_lock);
+  capacity[type] = MIN (n_channels, MAX_CHANNELS);
+  GST_INFO ("%s capacity set to %u", resource_names[type], capacity[type]);
+  /* waiters may fit now */
+  g_cond_broadcast (&arbiter_cond);
+  g_mutex_unlock (&arbiter_lock);
+}
+
+guint
+gst_lp_arbiter_get_capacity (GstLpResourceType type)
+{
+  guint res;
+
+  g_return_val_if_fail (type < GST_LP_RESOURCE_LAST, 0);
+
+  gst_lp_arbiter_init ();
+
+  g_mutex_lock (&arbiter_lock);
+  res = capacity[type];
+  g_mutex_unlock (&arbiter_lock);
+
+  return res;
+}
+
+/* Call with the arbiter lock */
+static gint
+find_free_channel (GstLpResourceType type, gint channel, gboolean exact)
+{
+  gint i;
+
+  if (channel >= 0 && channel < (gint) capacity[type]
+      && !channels[type][channel].owner)
+    return channel;
+
+  if (exact)
+    return -1;
+
+  for (i = 0; i < (gint) capacity[type]; i++) {
+    if (!channels[type][i].owner)
+      return i;
+  }
+
+  return -1;
+}
+
+/* Call with the arbiter lock. A waiter only gets a channel when no waiter
+ * ahead of it in the queue could take a free one */
+static gint
+find_channel_for_waiter (Waiter * waiter)
+{
+  GList *walk;
+  gint ch;
+
+  if ((ch = find_free_channel (waiter->type, waiter->channel,
+              waiter->exact)) < 0)
+    return -1;
+
+  for (walk = waiters; walk && walk->data != waiter; walk = walk->next) {
+    Waiter *other = walk->data;
+
+    if (other->type == waiter->type
+        && find_free_channel (other->type, other->channel, other->exact) >= 0)
+      return -1;
+  }
+
+  return ch;
+}
+
+/* Call with the arbiter lock */
+static gint
+find_victim (Waiter * waiter)
+{
+  gint i, victim = -1;
+
+  for (i = 0; i < (gint) capacity[waiter->type]; i++) {
+    Channel *c = &channels[waiter->type][i];
+
+    if (waiter->exact && i != waiter->channel)
+      continue;
+    if (!c->owner || c->preempted || !c->preempt
+        || c->priority >= waiter->priority)
+      continue;
+
+    if (victim < 0 || c->priority < channels[waiter->type][victim].priority)
+      victim = i;
+  }
+
+  return victim;
+}
+
+static gint
+compare_waiters (Waiter * a, Waiter * b)
+{
+  if (a->priority > b->priority)
+    return -1;
+  if (a->priority < b->priority)
+    return 1;
+
+  return a->seqnum < b->seqnum ? -1 : 1;
+}
+
+/**
+ * gst_lp_arbiter_acquire:
+ * @type: the kind of decoder channel
+ * @channel: the channel wanted, or -1 for any
+ * @exact: whether only @channel will do
+ * @priority: priority of the request, higher wins
+ * @owner: the object that will own the channel
+ * @preempt: called when a higher priority request wants the channel back,
+ *   or %NULL if it can't be preempted
+ * @timeout: how long to wait for a channel, %GST_CLOCK_TIME_NONE to wait
+ *   forever
+ * @waited: (out) (allow-none): how long the request waited
+ *
+ * Returns: the granted channel, or -1 if none became available in time or
+ * @owner is flushing.
+ */
+gint
+gst_lp_arbiter_acquire (GstLpResourceType type, gint channel, gboolean exact,
+    gint priority, gpointer owner, GstLpArbiterPreemptFunc preempt,
+    GstClockTime timeout, GstClockTime * waited)
+{
+  Waiter waiter;
+  gint64 start, deadline = -1;
+  gint ch = -1;
+
+  g_return_val_if_fail (type < GST_LP_RESOURCE_LAST, -1);
+  g_return_val_if_fail (owner != NULL, -1);
+
+  gst_lp_arbiter_init ();
+
+  start = g_get_monotonic_time ();
+  if (GST_CLOCK_TIME_IS_VALID (timeout))
+    deadline = start + GST_TIME_AS_USECONDS (timeout);
+
+  waiter.type = type;
+  waiter.channel = channel;
+  waiter.exact = exact && channel >= 0;
+  waiter.priority = priority;
+
+  g_mutex_lock (&arbiter_lock);
+  waiter.seqnum = next_seqnum++;
+  waiters = g_list_insert_sorted (waiters, &waiter,
+      (GCompareFunc) compare_waiters);
+
+  while (!g_list_find (flushing, owner)
+      && (ch = find_channel_for_waiter (&waiter)) < 0) {
+    gint victim = find_victim (&waiter);
+
+    if (victim >= 0) {
+      Channel *c = &channels[type][victim];
+      GstLpArbiterPreemptFunc func = c->preempt;
+      gpointer victim_owner = c->owner;
+
+      GST_INFO ("%p (priority %d) preempts %p (priority %d) on %s%d", owner,
+          priority, victim_owner, c->priority, resource_names[type], victim);
+      c->preempted = TRUE;
+
+      g_mutex_unlock (&arbiter_lock);
+      func (victim_owner, type, victim);
+      g_mutex_lock (&arbiter_lock);
+      continue;
+    }
+
+    if (deadline < 0) {
+      g_cond_wait (&arbiter_cond, &arbiter_lock);
+    } else if (g_get_monotonic_time () >= deadline
+        || !g_cond_wait_until (&arbiter_cond, &arbiter_lock, deadline)) {
+      if (!g_list_find (flushing, owner))
+        ch = find_channel_for_waiter (&waiter);
+      break;
+    }
+  }
+
+  waiters = g_list_remove (waiters, &waiter);
+
+  if (ch >= 0) {
+    channels[type][ch].owner = owner;
+    channels[type][ch].priority = priority;
+    channels[type][ch].preempt = preempt;
+    channels[type][ch].preempted = FALSE;
+  } else {
+    /* whoever queued behind us may be able to go now */
+    g_cond_broadcast (&arbiter_cond);
+  }
+  g_mutex_unlock (&arbiter_lock);
+
+  if (waited)
+    *waited = (g_get_monotonic_time () - start) * GST_USECOND;
+
+  if (ch >= 0)
+    GST_INFO ("granted %s%d to %p (priority %d) after %" G_GINT64_FORMAT
+        " us", resource_names[type], ch, owner, priority,
+        g_get_monotonic_time () - start);
+  else
+    GST_WARNING ("no %s channel for %p (priority %d)", resource_names[type],
+        owner, priority);
+
+  return ch;
+}
+
+/**
+ * gst_lp_arbiter_set_flushing:
+ * @owner: the object requesting channels
+ * @flush: whether its requests should fail
+ *
+ * While @owner is flushing, its pending and later gst_lp_arbiter_acquire()
+ * calls return -1 without waiting, so that it can shut down.
+ */
+void
+gst_lp_arbiter_set_flushing (gpointer owner, gboolean flush)
+{
+  g_return_if_fail (owner != NULL);
+
+  gst_lp_arbiter_init ();
+
+  g_mutex_lock (&arbiter_lock);
+  flushing = g_list_remove (flushing, owner);
+  if (flush) {
+    GST_DEBUG ("%p is flushing", owner);
+    flushing = g_list_prepend (flushing, owner);
+    g_cond_broadcast (&arbiter_cond);
+  }
+  g_mutex_unlock (&arbiter_lock);
+}
+
+void
+gst_lp_arbiter_release (GstLpResourceType type, gint channel, gpointer owner)
+{
+  g_return_if_fail (type < GST_LP_RESOURCE_LAST);
+  g_return_if_fail (channel >= 0 && channel < MAX_CHANNELS);
+
+  gst_lp_arbiter_init ();
+
+  g_mutex_lock (&arbiter_lock);
+  if (channels[type][channel].owner == owner) {
+    GST_INFO ("%p released %s%d", owner, resource_names[type], channel);
+    memset (&channels[type][channel], 0, sizeof (Channel));
+    g_cond_broadcast (&arbiter_cond);
+  }
+  g_mutex_unlock (&arbiter_lock);
+}
+
+void
+gst_lp_arbiter_release_all (gpointer owner)
+{
+  gint type, i;
+
+  gst_lp_arbiter_init ();
+
+  g_mutex_lock (&arbiter_lock);
+  for (type = 0; type < GST_LP_RESOURCE_LAST; type++) {
+    for (i = 0; i < MAX_CHANNELS; i++) {
+      if (channels[type][i].owner != owner)
+        continue;
+
+      GST_INFO ("%p released %s%d", owner, resource_names[type], i);
+      memset (&channels[type][i], 0, sizeof (Channel));
+    }
+  }
+  flushing = g_list_remove (flushing, owner);
+  g_cond_broadcast (&arbiter_cond);
+  g_mutex_unlock (&arbiter_lock);
+}
@@ -0,0 +1,56 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_LP_ARBITER_H__
+#define __GST_LP_ARBITER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+  GST_LP_RESOURCE_VDEC = 0,
+  GST_LP_RESOURCE_ADEC,
+  GST_LP_RESOURCE_LAST
+} GstLpResourceType;
+
+/* Called without the arbiter lock when a higher priority request wants
+ * @channel of @owner. The owner is expected to stop and release it */
+typedef void (*GstLpArbiterPreemptFunc) (gpointer owner,
+    GstLpResourceType type, gint channel);
+
+const gchar *gst_lp_resource_type_get_name (GstLpResourceType type);
+
+void gst_lp_arbiter_set_capacity (GstLpResourceType type, guint channels);
+guint gst_lp_arbiter_get_capacity (GstLpResourceType type);
+
+gint gst_lp_arbiter_acquire (GstLpResourceType type, gint channel,
+    gboolean exact, gint priority, gpointer owner,
+    GstLpArbiterPreemptFunc preempt, GstClockTime timeout,
+    GstClockTime * waited);
+void gst_lp_arbiter_set_flushing (gpointer owner, gboolean flush);
+void gst_lp_arbiter_release (GstLpResourceType type, gint channel,
+    gpointer owner);
+void gst_lp_arbiter_release_all (gpointer owner);
+
+G_END_DECLS
+#endif // __GST_LP_ARBITER_H__
@@ -43,6 +43,7 @@ enum
 {
   PROP_0,
   PROP_URI,
+  PROP_SUBURI,
   PROP_SOURCE,
   PROP_N_VIDEO,
   PROP_CURRENT_VIDEO,
@@ -57,6 +58,12 @@ enum
   PROP_SMART_PROPERTIES,
   PROP_BUFFER_SIZE,
   PROP_BUFFER_DURATION,
+  PROP_SEEK_COALESCING,
+  PROP_SINGLE_PHASE,
+  PROP_VIDEO_SINK_DESC,
+  PROP_AUDIO_SINK_DESC,
+  PROP_TEXT_PULL_MODE,
+  PROP_TEXT_MAX_CUES,
   PROP_LAST
 };
 
@@ -78,12 +85,17 @@ enum
   SIGNAL_GET_TEXT_PAD,
   SIGNAL_STREAMS_READY,
   SIGNAL_STREAM_UNLOCK,
+  SIGNAL_PULL_TEXT_CUES,
   LAST_SIGNAL
 };
 
 #define DEFAULT_USE_BUFFERING FALSE
 #define DEFAULT_BUFFER_DURATION   -1
 #define DEFAULT_BUFFER_SIZE       -1
+#define DEFAULT_SEEK_COALESCING   FALSE
+#define DEFAULT_SINGLE_PHASE      FALSE
+#define DEFAULT_TEXT_PULL_MODE    FALSE
+#define DEFAULT_TEXT_MAX_CUES     64
 
 #define DEFAULT_USE_STREAM_LOCK FALSE
 
@@ -155,6 +167,8 @@ static void gst_lp_bin_deactive (GstLpBin * lpbin);
 static GstBuffer *gst_lp_bin_retrieve_thumbnail (GstLpBin * lpbin, gint width,
     gint height, gchar * format);
 static gboolean gst_lp_bin_stream_unlock (GstLpBin * lpbin);
+static GPtrArray *gst_lp_bin_pull_text_cues (GstLpBin * lpbin, gint stream,
+    guint64 start, guint64 stop);
 static void gst_lp_bin_element_added_cb (GstBin * lpbin, GstElement * element,
     gpointer user_data);
 
@@ -226,6 +240,19 @@ gst_lp_bin_class_init (GstLpBinClass * klass)
       g_param_spec_string ("uri", "URI", "URI of the media to play",
           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstLpBin:suburi:
+   *
+   * Local SubRip or SubStation Alpha file shown along with #GstLpBin:uri,
+   * as a file:// URI or a path. It is memory-mapped and indexed once when
+   * lpbin goes to PAUSED and its cues are added to the text streams as
+   * the last one. Ignored in thumbnail mode.
+   */
+  g_object_class_install_property (gobject_klass, PROP_SUBURI,
+      g_param_spec_string ("suburi", "Subtitle URI",
+          "URI of an external subtitle file", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_klass, PROP_SOURCE,
       g_param_spec_object ("source", "Source", "Source element",
           GST_TYPE_ELEMENT, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
@@ -334,6 +361,80 @@ gst_lp_bin_class_init (GstLpBinClass * klass)
           -1, G_MAXINT64, DEFAULT_BUFFER_DURATION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstLpBin:seek-coalescing:
+   *
+   * When a flushing seek is sent while another one is still executing, only
+   * execute the latest one. Meant for scrubbing. Seeks then return %TRUE
+   * before they ran; see #GstLpSink:seek-coalescing for the
+   * "lpsink-seek-done" message reporting the result and latency of every
+   * executed seek.
+   */
+  g_object_class_install_property (gobject_klass, PROP_SEEK_COALESCING,
+      g_param_spec_boolean ("seek-coalescing", "Seek coalescing",
+          "Only execute the latest of flushing seeks sent in quick succession",
+          DEFAULT_SEEK_COALESCING, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpBin:single-phase:
+   *
+   * Negotiate the streams with lpsink in one phase: lpsink lets the data
+   * through its sink pads right away and builds its chains as soon as all
+   * the streams fcbin exposed reached it, instead of waiting for the
+   * "unblock-sinkpads" and "pad-blocked" round trips through lpbin. Has no
+   * effect when the source asks for the stream lock. See
+   * #GstLpSink:single-phase for the "lpsink-configured" message reporting
+   * how long that took.
+   */
+  g_object_class_install_property (gobject_klass, PROP_SINGLE_PHASE,
+      g_param_spec_boolean ("single-phase", "Single phase",
+          "Build the sink chains in one phase once all streams arrived",
+          DEFAULT_SINGLE_PHASE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpBin:video-sink-desc:
+   *
+   * Factory name or launch snippet of the sink lpsink uses instead of
+   * vdecsink, see #GstLpSink:video-sink-desc.
+   */
+  g_object_class_install_property (gobject_klass, PROP_VIDEO_SINK_DESC,
+      g_param_spec_string ("video-sink-desc", "Video sink description",
+          "Factory name or launch snippet of the video sink (NULL = vdecsink)",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpBin:audio-sink-desc:
+   *
+   * Factory name or launch snippet of the sink lpsink uses instead of
+   * adecsink, see #GstLpSink:audio-sink-desc.
+   */
+  g_object_class_install_property (gobject_klass, PROP_AUDIO_SINK_DESC,
+      g_param_spec_string ("audio-sink-desc", "Audio sink description",
+          "Factory name or launch snippet of the audio sink (NULL = adecsink)",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpBin:text-pull-mode:
+   *
+   * Keep the subtitle cues for #GstLpBin::pull-text-cues instead of posting
+   * each of them, see #GstLpSink:text-pull-mode.
+   */
+  g_object_class_install_property (gobject_klass, PROP_TEXT_PULL_MODE,
+      g_param_spec_boolean ("text-pull-mode", "Text pull mode",
+          "Keep subtitle cues for pull-text-cues instead of posting them",
+          DEFAULT_TEXT_PULL_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpBin:text-max-cues:
+   *
+   * Number of cues kept per text stream in #GstLpBin:text-pull-mode.
+   */
+  g_object_class_install_property (gobject_klass, PROP_TEXT_MAX_CUES,
+      g_param_spec_uint ("text-max-cues", "Text max cues",
+          "Number of cues kept per text stream in text pull mode",
+          1, G_MAXUINT, DEFAULT_TEXT_MAX_CUES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_lp_bin_signals[SIGNAL_ABOUT_TO_FINISH] =
       g_signal_new ("about-to-finish", G_TYPE_FROM_CLASS (klass),
       G_SIGNAL_RUN_LAST,
@@ -542,6 +643,26 @@ gst_lp_bin_class_init (GstLpBinClass * klass)
       G_STRUCT_OFFSET (GstLpBinClass, stream_unlock), NULL, NULL,
       g_cclosure_marshal_generic, G_TYPE_BOOLEAN, 0);
 
+  /**
+   * GstLpBin::pull-text-cues
+   * @lpbin: a #GstLpBin
+   * @stream: a text stream number
+   * @start: start of the window, in stream time
+   * @stop: end of the window, in stream time, or -1 for no end
+   *
+   * Action signal to take the subtitle cues of @stream overlapping the
+   * window in #GstLpBin:text-pull-mode, see #GstLpSink::pull-text-cues.
+   *
+   * Returns: a #GPtrArray of #GstSample, or NULL when the stream number
+   * does not exist.
+   */
+  gst_lp_bin_signals[SIGNAL_PULL_TEXT_CUES] =
+      g_signal_new ("pull-text-cues", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstLpBinClass, pull_text_cues), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_PTR_ARRAY, 3, G_TYPE_INT,
+      G_TYPE_UINT64, G_TYPE_UINT64);
+
   gstelement_klass->change_state = GST_DEBUG_FUNCPTR (gst_lp_bin_change_state);
   gstelement_klass->query = GST_DEBUG_FUNCPTR (gst_lp_bin_query);
 
@@ -559,6 +680,7 @@ gst_lp_bin_class_init (GstLpBinClass * klass)
   klass->get_text_pad = GST_DEBUG_FUNCPTR (gst_lp_bin_get_text_pad);
 
   klass->stream_unlock = GST_DEBUG_FUNCPTR (gst_lp_bin_stream_unlock);
+  klass->pull_text_cues = GST_DEBUG_FUNCPTR (gst_lp_bin_pull_text_cues);
 }
 
 static void
@@ -584,7 +706,10 @@ gst_lp_bin_init (GstLpBin * lpbin)
   lpbin->uridecodebin = NULL;
   lpbin->fcbin = NULL;
   lpbin->lpsink = NULL;
+  lpbin->subsrc = NULL;
+  lpbin->subsrc_linked = FALSE;
   lpbin->source = NULL;
+  lpbin->suburi = NULL;
 
   lpbin->naudio = 0;
   lpbin->nvideo = 0;
@@ -603,6 +728,12 @@ gst_lp_bin_init (GstLpBin * lpbin)
 
   lpbin->buffer_duration = DEFAULT_BUFFER_DURATION;
   lpbin->buffer_size = DEFAULT_BUFFER_SIZE;
+  lpbin->seek_coalescing = DEFAULT_SEEK_COALESCING;
+  lpbin->single_phase = DEFAULT_SINGLE_PHASE;
+  lpbin->video_sink_desc = NULL;
+  lpbin->audio_sink_desc = NULL;
+  lpbin->text_pull_mode = DEFAULT_TEXT_PULL_MODE;
+  lpbin->text_max_cues = DEFAULT_TEXT_MAX_CUES;
 
   lpbin->audio_only = TRUE;
 
@@ -661,6 +792,10 @@ gst_lp_bin_finalize (GObject * obj)
     g_free (lpbin->elements_str);
   }
 
+  g_free (lpbin->suburi);
+  g_free (lpbin->video_sink_desc);
+  g_free (lpbin->audio_sink_desc);
+
   if (lpbin->stream_id_blocked) {
     g_hash_table_remove_all (lpbin->stream_id_blocked);
     g_hash_table_destroy (lpbin->stream_id_blocked);
@@ -715,6 +850,29 @@ gst_lp_bin_handle_message (GstBin * bin, GstMessage * msg)
     GST_BIN_CLASS (parent_class)->handle_message (bin, msg);
 }
 
+static GPtrArray *
+gst_lp_bin_pull_text_cues (GstLpBin * lpbin, gint stream, guint64 start,
+    guint64 stop)
+{
+  GstElement *lpsink = NULL;
+  GPtrArray *res = NULL;
+
+  GST_LP_BIN_LOCK (lpbin);
+  if (lpbin->lpsink)
+    lpsink = gst_object_ref (lpbin->lpsink);
+  GST_LP_BIN_UNLOCK (lpbin);
+
+  if (!lpsink) {
+    GST_DEBUG_OBJECT (lpbin, "no lpsink");
+    return NULL;
+  }
+
+  g_signal_emit_by_name (lpsink, "pull-text-cues", stream, start, stop, &res);
+  gst_object_unref (lpsink);
+
+  return res;
+}
+
 static GstBuffer *
 gst_lp_bin_retrieve_thumbnail (GstLpBin * lpbin, gint width, gint height,
     gchar * format)
@@ -747,6 +905,15 @@ gst_lp_bin_retrieve_thumbnail (GstLpBin * lpbin, gint width, gint height,
   return result;
 }
 
+/* the stream lock relies on lpsink blocking its sink pads */
+static void
+gst_lp_bin_update_single_phase (GstLpBin * lpbin)
+{
+  if (lpbin->lpsink)
+    g_object_set (lpbin->lpsink, "single-phase", lpbin->single_phase
+        && !lpbin->use_stream_lock, NULL);
+}
+
 static gboolean
 gst_lp_bin_stream_unlock (GstLpBin * lpbin)
 {
@@ -787,6 +954,12 @@ gst_lp_bin_set_property (GObject * object, guint prop_id,
     case PROP_URI:
       lpbin->uri = g_strdup (g_value_get_string (value));
       break;
+    case PROP_SUBURI:
+      GST_LP_BIN_LOCK (lpbin);
+      g_free (lpbin->suburi);
+      lpbin->suburi = g_value_dup_string (value);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
     case PROP_CURRENT_VIDEO:
       g_object_set (lpbin->fcbin, "current-video", g_value_get_int (value),
           NULL);
@@ -838,6 +1011,54 @@ gst_lp_bin_set_property (GObject * object, guint prop_id,
     case PROP_BUFFER_DURATION:
       lpbin->buffer_duration = g_value_get_int64 (value);
       break;
+    case PROP_SEEK_COALESCING:
+      GST_LP_BIN_LOCK (lpbin);
+      lpbin->seek_coalescing = g_value_get_boolean (value);
+      if (lpbin->lpsink)
+        g_object_set (lpbin->lpsink, "seek-coalescing", lpbin->seek_coalescing,
+            NULL);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_SINGLE_PHASE:
+      GST_LP_BIN_LOCK (lpbin);
+      lpbin->single_phase = g_value_get_boolean (value);
+      gst_lp_bin_update_single_phase (lpbin);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_VIDEO_SINK_DESC:
+      GST_LP_BIN_LOCK (lpbin);
+      g_free (lpbin->video_sink_desc);
+      lpbin->video_sink_desc = g_value_dup_string (value);
+      if (lpbin->lpsink)
+        g_object_set (lpbin->lpsink, "video-sink-desc",
+            lpbin->video_sink_desc, NULL);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_AUDIO_SINK_DESC:
+      GST_LP_BIN_LOCK (lpbin);
+      g_free (lpbin->audio_sink_desc);
+      lpbin->audio_sink_desc = g_value_dup_string (value);
+      if (lpbin->lpsink)
+        g_object_set (lpbin->lpsink, "audio-sink-desc",
+            lpbin->audio_sink_desc, NULL);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_TEXT_PULL_MODE:
+      GST_LP_BIN_LOCK (lpbin);
+      lpbin->text_pull_mode = g_value_get_boolean (value);
+      if (lpbin->lpsink)
+        g_object_set (lpbin->lpsink, "text-pull-mode", lpbin->text_pull_mode,
+            NULL);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_TEXT_MAX_CUES:
+      GST_LP_BIN_LOCK (lpbin);
+      lpbin->text_max_cues = g_value_get_uint (value);
+      if (lpbin->lpsink)
+        g_object_set (lpbin->lpsink, "text-max-cues", lpbin->text_max_cues,
+            NULL);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
   }
@@ -855,6 +1076,11 @@ gst_lp_bin_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_string (value, lpbin->uri);
       GST_LP_BIN_UNLOCK (lpbin);
       break;
+    case PROP_SUBURI:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_string (value, lpbin->suburi);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
     case PROP_SOURCE:
     {
       GST_OBJECT_LOCK (lpbin);
@@ -953,12 +1179,56 @@ gst_lp_bin_get_property (GObject * object, guint prop_id, GValue * value,
       g_value_set_int64 (value, lpbin->buffer_duration);
       GST_OBJECT_UNLOCK (lpbin);
       break;
+    case PROP_SEEK_COALESCING:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_boolean (value, lpbin->seek_coalescing);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_SINGLE_PHASE:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_boolean (value, lpbin->single_phase);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_VIDEO_SINK_DESC:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_string (value, lpbin->video_sink_desc);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_AUDIO_SINK_DESC:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_string (value, lpbin->audio_sink_desc);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_TEXT_PULL_MODE:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_boolean (value, lpbin->text_pull_mode);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
+    case PROP_TEXT_MAX_CUES:
+      GST_LP_BIN_LOCK (lpbin);
+      g_value_set_uint (value, lpbin->text_max_cues);
+      GST_LP_BIN_UNLOCK (lpbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static gboolean
+gst_lp_bin_is_thumbnail_mode (GstLpBin * lpbin)
+{
+  gboolean thumbnail_mode = FALSE;
+
+  GST_OBJECT_LOCK (lpbin);
+  if (lpbin->smart_prop)
+    gst_structure_get_boolean (lpbin->smart_prop, "thumbnail-mode",
+        &thumbnail_mode);
+  GST_OBJECT_UNLOCK (lpbin);
+
+  return thumbnail_mode;
+}
+
 static void
 pad_added_cb (GstElement * decodebin, GstPad * pad, GstLpBin * lpbin)
 {
@@ -973,6 +1243,18 @@ pad_added_cb (GstElement * decodebin, GstPad * pad, GstLpBin * lpbin)
   s = gst_caps_get_structure (caps, 0);
   name = gst_structure_get_name (s);
 
+  /* a thumbnail only needs video, leave everything else unlinked so it is
+   * dropped right behind the demuxer. no_more_pads_cb() fails when that
+   * leaves nothing */
+  if (gst_lp_bin_is_thumbnail_mode (lpbin)
+      && !g_str_has_prefix (name, "video/")
+      && !g_str_has_prefix (name, "image/")) {
+    GST_INFO_OBJECT (lpbin, "thumbnail mode, ignoring %s pad %s:%s", name,
+        GST_DEBUG_PAD_NAME (pad));
+    gst_caps_unref (caps);
+    return;
+  }
+
   tmpl = gst_pad_template_new (name, GST_PAD_SINK, GST_PAD_REQUEST, caps);
 
   GST_DEBUG_OBJECT (pad, "pad with caps %" GST_PTR_FORMAT " added", caps);
@@ -982,7 +1264,7 @@ pad_added_cb (GstElement * decodebin, GstPad * pad, GstLpBin * lpbin)
 
   fcbin_srcpad = g_object_get_data (G_OBJECT (fcbin_sinkpad), "fcbin.srcpad");
 
-  if (g_str_has_prefix (name, "video/")) {
+  if (g_str_has_prefix (name, "video/") || g_str_has_prefix (name, "image/")) {
     lpbin->audio_only = FALSE;
   }
 
@@ -998,11 +1280,41 @@ pad_removed_cb (GstElement * decodebin, GstPad * pad, GstLpBin * lpbin)
   // TODO
 }
 
+static void
+gst_lp_bin_link_subsrc (GstLpBin * lpbin)
+{
+  GstPad *srcpad;
+
+  /* no-more-pads comes again for every new group of streams */
+  GST_LP_BIN_LOCK (lpbin);
+  if (lpbin->subsrc_linked) {
+    GST_LP_BIN_UNLOCK (lpbin);
+    return;
+  }
+  lpbin->subsrc_linked = TRUE;
+  GST_LP_BIN_UNLOCK (lpbin);
+
+  srcpad = gst_element_get_static_pad (lpbin->subsrc, "src");
+  pad_added_cb (lpbin->subsrc, srcpad, lpbin);
+  gst_object_unref (srcpad);
+
+  /* linked now, it can start pushing */
+  gst_element_set_locked_state (lpbin->subsrc, FALSE);
+  gst_element_sync_state_with_parent (lpbin->subsrc);
+}
+
 static void
 no_more_pads_cb (GstElement * decodebin, GstLpBin * lpbin)
 {
+  gboolean thumbnail_mode = gst_lp_bin_is_thumbnail_mode (lpbin);
+
   GST_INFO_OBJECT (lpbin, "no more pads callback");
 
+  /* pad_added_cb() left the other streams unlinked, nothing would ever
+   * preroll */
+  if (thumbnail_mode && lpbin->audio_only)
+    goto no_video;
+
   if (lpbin->audio_only) {
     if (g_object_class_find_property (G_OBJECT_GET_CLASS (lpbin->lpsink),
             "audio-only"))
@@ -1010,10 +1322,24 @@ no_more_pads_cb (GstElement * decodebin, GstLpBin * lpbin)
     GST_INFO_OBJECT (lpbin, "audio-only set as TRUE");
   }
 
+  /* the external subtitles go in as one more text stream, before fcbin
+   * counts its streams. A thumbnail has no use for them */
+  if (lpbin->subsrc && !thumbnail_mode)
+    gst_lp_bin_link_subsrc (lpbin);
+
   if (lpbin->fcbin) {
     gboolean ret = FALSE;
     g_signal_emit_by_name (lpbin->fcbin, "unblock-sinkpads", &ret, NULL);
   }
+  return;
+
+no_video:
+  {
+    GST_ELEMENT_ERROR (lpbin, STREAM, WRONG_TYPE,
+        ("No video stream to take a thumbnail from."),
+        ("thumbnail mode, but %s has no video stream", lpbin->uri));
+    return;
+  }
 }
 
 static void
@@ -1145,6 +1471,14 @@ no_more_pads_cb_from_fcbin (GstElement * fcbin, GstLpBin * lpbin)
   if (lpbin->use_stream_lock)
     goto emit_streams_ready;
 
+  /* lpsink did not block its sink pads, it only needs to know how many
+   * streams to wait for */
+  if (lpbin->single_phase) {
+    gst_lp_sink_set_expected_streams (GST_LP_SINK (lpbin->lpsink),
+        n_video + n_audio + n_text);
+    goto done;
+  }
+
   g_signal_emit_by_name (lpbin->lpsink, "unblock-sinkpads", &ret, NULL);
   GST_DEBUG_OBJECT (lpbin, "received unblock-sinkpads result=%d", ret);
 
@@ -1280,6 +1614,8 @@ notify_source_cb (GstElement * decodebin, GParamSpec * pspec, GstLpBin * lpbin)
   }
 
   gst_query_unref (query);
+
+  gst_lp_bin_update_single_phase (lpbin);
 }
 
 static void
@@ -1303,6 +1639,54 @@ unknown_type_cb (GstElement * decodebin, GstPad * pad, GstCaps * caps,
   // TODO
 }
 
+/* fcbin only hands out pads from PAUSED on, so lpsubsrc is kept in its
+ * state until it gets linked in no_more_pads_cb() */
+static void
+gst_lp_bin_setup_subsrc (GstLpBin * lpbin)
+{
+  gchar *location = NULL;
+
+  GST_LP_BIN_LOCK (lpbin);
+  if (lpbin->suburi == NULL) {
+    GST_LP_BIN_UNLOCK (lpbin);
+    return;
+  }
+
+  if (gst_uri_has_protocol (lpbin->suburi, "file"))
+    location = g_filename_from_uri (lpbin->suburi, NULL, NULL);
+  else if (!gst_uri_is_valid (lpbin->suburi))
+    location = g_strdup (lpbin->suburi);
+
+  if (location == NULL)
+    GST_WARNING_OBJECT (lpbin, "only local subtitle files are supported, "
+        "ignoring %s", lpbin->suburi);
+  GST_LP_BIN_UNLOCK (lpbin);
+
+  if (location == NULL)
+    return;
+
+  if (gst_lp_bin_is_thumbnail_mode (lpbin)) {
+    GST_INFO_OBJECT (lpbin, "thumbnail mode, ignoring subtitle file %s",
+        location);
+    goto done;
+  }
+
+  lpbin->subsrc = gst_element_factory_make ("lpsubsrc", NULL);
+  if (lpbin->subsrc == NULL) {
+    GST_WARNING_OBJECT (lpbin, "no lpsubsrc, ignoring subtitle file %s",
+        location);
+    goto done;
+  }
+
+  g_object_set (lpbin->subsrc, "location", location, NULL);
+  gst_element_set_locked_state (lpbin->subsrc, TRUE);
+  gst_bin_add (GST_BIN_CAST (lpbin), lpbin->subsrc);
+  lpbin->subsrc_linked = FALSE;
+
+done:
+  g_free (location);
+}
+
 static gboolean
 gst_lp_bin_setup_element (GstLpBin * lpbin)
 {
@@ -1378,7 +1762,15 @@ gst_lp_bin_setup_element (GstLpBin * lpbin)
   g_signal_connect (lpbin->fcbin, "element-configured",
       G_CALLBACK (element_configured_cb), lpbin);
 
+  gst_lp_bin_setup_subsrc (lpbin);
+
   lpbin->lpsink = gst_element_factory_make ("lpsink", NULL);
+  g_object_set (lpbin->lpsink, "seek-coalescing", lpbin->seek_coalescing,
+      "video-sink-desc", lpbin->video_sink_desc,
+      "audio-sink-desc", lpbin->audio_sink_desc,
+      "text-pull-mode", lpbin->text_pull_mode,
+      "text-max-cues", lpbin->text_max_cues, NULL);
+  gst_lp_bin_update_single_phase (lpbin);
   lpbin->pad_blocked_id =
       g_signal_connect (lpbin->lpsink, "pad-blocked",
       G_CALLBACK (pad_blocked_cb), lpbin);
@@ -1469,6 +1861,13 @@ gst_lp_bin_deactive (GstLpBin * lpbin)
   REMOVE_SIGNAL (lpbin->uridecodebin, lpbin->fcbin_pad_added_id);
   REMOVE_SIGNAL (lpbin->uridecodebin, lpbin->fcbin_no_more_pads_id);
 
+  if (lpbin->subsrc) {
+    gst_element_set_state (lpbin->subsrc, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN_CAST (lpbin), lpbin->subsrc);
+    lpbin->subsrc = NULL;
+    lpbin->subsrc_linked = FALSE;
+  }
+
   if (lpbin->fcbin) {
     gst_element_set_state (GST_ELEMENT_CAST (lpbin->fcbin), GST_STATE_NULL);
     gst_bin_remove (GST_BIN_CAST (lpbin), lpbin->fcbin);
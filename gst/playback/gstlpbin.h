@@ -55,6 +55,8 @@ struct _GstLpBin
   GstElement *uridecodebin;
   GstElement *fcbin;
   GstElement *lpsink;
+  GstElement *subsrc;           /* lpsubsrc for suburi, or NULL */
+  gboolean subsrc_linked;       /* with the lock */
   /* the last activated source */
   GstElement *source;
   GstFlowReturn ret;
@@ -64,6 +66,7 @@ struct _GstLpBin
 
 
   gchar *uri;
+  gchar *suburi;                /* external subtitle file */
   gulong pad_added_id;
   gulong pad_removed_id;
   gulong no_more_pads_id;
@@ -117,6 +120,13 @@ struct _GstLpBin
 
   GHashTable *stream_id_blocked;
   gboolean all_pads_blocked;
+
+  gboolean seek_coalescing;     /* passed on to lpsink */
+  gboolean single_phase;        /* unless the source uses the stream lock */
+  gchar *video_sink_desc;       /* passed on to lpsink */
+  gchar *audio_sink_desc;
+  gboolean text_pull_mode;      /* passed on to lpsink */
+  guint text_max_cues;
 };
 
 struct _GstLpBinClass
@@ -155,6 +165,10 @@ struct _GstLpBinClass
   GstPad *(*get_text_pad) (GstLpBin * lpbin, gint stream);
 
   gboolean (*stream_unlock) (GstLpBin * lpbin);
+
+  /* take the subtitle cues of a text stream in text pull mode */
+  GPtrArray *(*pull_text_cues) (GstLpBin * lpbin, gint stream, guint64 start,
+      guint64 stop);
 };
 
 enum
@@ -0,0 +1,428 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Watches the video and audio queue in front of the sinks and keeps the
+ * running-time lead of audio over video within a target.
+ *
+ * When upstream pushes both streams from one thread, a queue that fills up
+ * because its stream is ahead blocks that thread, and the other queue
+ * starves. So when a queue overruns while its stream leads the other one by
+ * more than the target, its limits are doubled, up to MAX_SCALE times the
+ * limits it was configured with. They are put back once the lead at the
+ * input is within half the target again.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstlpdrift.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_lp_drift_debug);
+#define GST_CAT_DEFAULT gst_lp_drift_debug
+
+#define MAX_SCALE 8
+
+enum
+{
+  DRIFT_VIDEO = 0,
+  DRIFT_AUDIO,
+  DRIFT_LAST
+};
+
+typedef struct
+{
+  GstLpDriftMonitor *monitor;
+  const gchar *name;
+
+  GstElement *queue;
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  gulong sink_probe_id;
+  gulong src_probe_id;
+  gulong overrun_id;
+
+  GstSegment in_segment;
+  GstSegment out_segment;
+  GstClockTime in_time;         /* running time of the last buffer in */
+  GstClockTime out_time;        /* running time of the last buffer out */
+
+  /* limits the queue was configured with */
+  guint base_buffers;
+  guint base_bytes;
+  guint64 base_time;
+  guint scale;
+
+  guint overruns;
+} DriftQueue;
+
+struct _GstLpDriftMonitor
+{
+  GMutex lock;
+  GstElement *owner;            /* posts the messages, not reffed */
+  GstClockTime target;
+
+  DriftQueue queues[DRIFT_LAST];
+
+  gint64 max_lead;
+  gint64 min_lead;
+  guint grown;
+  guint restored;
+};
+
+/* Call with the monitor lock. Returns the running-time lead of audio over
+ * video, or FALSE if one of them has not been seen yet */
+static gboolean
+get_lead (GstLpDriftMonitor * monitor, gboolean input, gint64 * lead)
+{
+  GstClockTime video, audio;
+
+  if (input) {
+    video = monitor->queues[DRIFT_VIDEO].in_time;
+    audio = monitor->queues[DRIFT_AUDIO].in_time;
+  } else {
+    video = monitor->queues[DRIFT_VIDEO].out_time;
+    audio = monitor->queues[DRIFT_AUDIO].out_time;
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (video) || !GST_CLOCK_TIME_IS_VALID (audio))
+    return FALSE;
+
+  *lead = GST_CLOCK_DIFF (video, audio);
+  return TRUE;
+}
+
+/* Call with the monitor lock, so that a grow and a restore can't reach the
+ * queue in the other order. The queue never calls us with its own lock */
+static void
+set_limits (DriftQueue * dq, guint scale)
+{
+  guint64 bytes = (guint64) dq->base_bytes * scale;
+
+  g_object_set (dq->queue,
+      "max-size-buffers", dq->base_buffers * scale,
+      "max-size-bytes", (guint) MIN (bytes, G_MAXUINT),
+      "max-size-time", dq->base_time * scale, NULL);
+}
+
+static void
+post_adjusted (GstLpDriftMonitor * monitor, DriftQueue * dq, guint scale,
+    gint64 lead)
+{
+  if (!monitor->owner)
+    return;
+
+  gst_element_post_message (monitor->owner,
+      gst_message_new_element (GST_OBJECT_CAST (monitor->owner),
+          gst_structure_new ("lpsink-drift",
+              "queue", G_TYPE_STRING, dq->name,
+              "scale", G_TYPE_UINT, scale,
+              "audio-lead", G_TYPE_INT64, lead, NULL)));
+}
+
+/* Called from the streaming thread feeding the queue, without the queue
+ * lock */
+static void
+overrun_cb (GstElement * queue, DriftQueue * dq)
+{
+  GstLpDriftMonitor *monitor = dq->monitor;
+  gint64 lead = 0, ahead = 0;
+  guint scale = 0;
+
+  g_mutex_lock (&monitor->lock);
+  dq->overruns++;
+
+  if (get_lead (monitor, TRUE, &lead)) {
+    ahead = dq == &monitor->queues[DRIFT_AUDIO] ? lead : -lead;
+
+    if (ahead > (gint64) monitor->target && dq->scale < MAX_SCALE) {
+      dq->scale *= 2;
+      scale = dq->scale;
+      monitor->grown++;
+      GST_INFO_OBJECT (queue, "%s leads by %" G_GINT64_FORMAT
+          " ns, growing limits to %ux", dq->name, ahead, scale);
+      set_limits (dq, scale);
+    }
+  }
+  g_mutex_unlock (&monitor->lock);
+
+  if (scale)
+    post_adjusted (monitor, dq, scale, lead);
+}
+
+static GstClockTime
+buffer_running_time (GstSegment * segment, GstBuffer * buf)
+{
+  GstClockTime ts = GST_BUFFER_PTS (buf);
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    ts = GST_BUFFER_DTS (buf);
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts) || segment->format != GST_FORMAT_TIME)
+    return GST_CLOCK_TIME_NONE;
+
+  return gst_segment_to_running_time (segment, GST_FORMAT_TIME, ts);
+}
+
+static GstPadProbeReturn
+queue_probe_cb (GstPad * pad, GstPadProbeInfo * info, DriftQueue * dq)
+{
+  GstLpDriftMonitor *monitor = dq->monitor;
+  gboolean input = pad == dq->sinkpad;
+  GstSegment *segment = input ? &dq->in_segment : &dq->out_segment;
+  GstClockTime *time = input ? &dq->in_time : &dq->out_time;
+  gint64 lead = 0;
+  gboolean restore = FALSE;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER) {
+    GstClockTime rt;
+
+    rt = buffer_running_time (segment, GST_PAD_PROBE_INFO_BUFFER (info));
+    if (!GST_CLOCK_TIME_IS_VALID (rt))
+      return GST_PAD_PROBE_OK;
+
+    g_mutex_lock (&monitor->lock);
+    *time = rt;
+
+    if (get_lead (monitor, input, &lead)) {
+      monitor->max_lead = MAX (monitor->max_lead, lead);
+      monitor->min_lead = MIN (monitor->min_lead, lead);
+    }
+
+    /* the stream fell back in line, give back what it was granted */
+    if (!input && dq->scale > 1 && get_lead (monitor, TRUE, &lead)
+        && ABS (lead) <= (gint64) monitor->target / 2) {
+      dq->scale = 1;
+      monitor->restored++;
+      restore = TRUE;
+      GST_INFO_OBJECT (dq->queue, "audio lead back to %" G_GINT64_FORMAT
+          " ns, restoring limits", lead);
+      set_limits (dq, 1);
+    }
+    g_mutex_unlock (&monitor->lock);
+
+    if (restore)
+      post_adjusted (monitor, dq, 1, lead);
+  } else if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_BOTH) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_SEGMENT:
+        g_mutex_lock (&monitor->lock);
+        gst_event_copy_segment (event, segment);
+        g_mutex_unlock (&monitor->lock);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        g_mutex_lock (&monitor->lock);
+        gst_segment_init (segment, GST_FORMAT_UNDEFINED);
+        *time = GST_CLOCK_TIME_NONE;
+        g_mutex_unlock (&monitor->lock);
+        break;
+      default:
+        break;
+    }
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+drift_queue_init (GstLpDriftMonitor * monitor, DriftQueue * dq,
+    const gchar * name, GstElement * queue)
+{
+  GstPadProbeType mask = GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM | GST_PAD_PROBE_TYPE_EVENT_FLUSH;
+
+  dq->monitor = monitor;
+  dq->name = name;
+  dq->queue = gst_object_ref (queue);
+  dq->sinkpad = gst_element_get_static_pad (queue, "sink");
+  dq->srcpad = gst_element_get_static_pad (queue, "src");
+  gst_segment_init (&dq->in_segment, GST_FORMAT_UNDEFINED);
+  gst_segment_init (&dq->out_segment, GST_FORMAT_UNDEFINED);
+  dq->in_time = GST_CLOCK_TIME_NONE;
+  dq->out_time = GST_CLOCK_TIME_NONE;
+  dq->scale = 1;
+
+  g_object_get (queue, "max-size-buffers", &dq->base_buffers,
+      "max-size-bytes", &dq->base_bytes, "max-size-time", &dq->base_time,
+      NULL);
+
+  dq->sink_probe_id = gst_pad_add_probe (dq->sinkpad, mask,
+      (GstPadProbeCallback) queue_probe_cb, dq, NULL);
+  dq->src_probe_id = gst_pad_add_probe (dq->srcpad, mask,
+      (GstPadProbeCallback) queue_probe_cb, dq, NULL);
+  dq->overrun_id = g_signal_connect (queue, "overrun",
+      G_CALLBACK (overrun_cb), dq);
+}
+
+static void
+drift_queue_clear (DriftQueue * dq)
+{
+  g_signal_handler_disconnect (dq->queue, dq->overrun_id);
+  gst_pad_remove_probe (dq->sinkpad, dq->sink_probe_id);
+  gst_pad_remove_probe (dq->srcpad, dq->src_probe_id);
+
+  if (dq->scale > 1)
+    set_limits (dq, 1);
+
+  gst_object_unref (dq->sinkpad);
+  gst_object_unref (dq->srcpad);
+  gst_object_unref (dq->queue);
+}
+
+/**
+ * gst_lp_drift_monitor_new:
+ * @owner: (allow-none): element posting the "lpsink-drift" messages
+ * @video_queue: the queue in front of the video sink
+ * @audio_queue: the queue in front of the audio sink
+ * @target: the largest lead of one stream over the other, in nanoseconds,
+ *   before the queue of the leading stream is allowed to grow
+ *
+ * Returns: a new monitor, free it with gst_lp_drift_monitor_free() before
+ * the queues are destroyed.
+ */
+GstLpDriftMonitor *
+gst_lp_drift_monitor_new (GstElement * owner, GstElement * video_queue,
+    GstElement * audio_queue, GstClockTime target)
+{
+  static gsize initialized = 0;
+  GstLpDriftMonitor *monitor;
+
+  g_return_val_if_fail (GST_IS_ELEMENT (video_queue), NULL);
+  g_return_val_if_fail (GST_IS_ELEMENT (audio_queue), NULL);
+
+  if (g_once_init_enter (&initialized)) {
+    GST_DEBUG_CATEGORY_INIT (gst_lp_drift_debug, "lpdrift", 0,
+        "Lightweight Playback A/V drift monitor");
+    g_once_init_leave (&initialized, 1);
+  }
+
+  monitor = g_slice_new0 (GstLpDriftMonitor);
+  g_mutex_init (&monitor->lock);
+  monitor->owner = owner;
+  monitor->target = target;
+  monitor->max_lead = G_MININT64;
+  monitor->min_lead = G_MAXINT64;
+
+  drift_queue_init (monitor, &monitor->queues[DRIFT_VIDEO], "video",
+      video_queue);
+  drift_queue_init (monitor, &monitor->queues[DRIFT_AUDIO], "audio",
+      audio_queue);
+
+  GST_INFO ("monitoring %" GST_PTR_FORMAT " and %" GST_PTR_FORMAT
+      ", target %" GST_TIME_FORMAT, video_queue, audio_queue,
+      GST_TIME_ARGS (target));
+
+  return monitor;
+}
+
+void
+gst_lp_drift_monitor_free (GstLpDriftMonitor * monitor)
+{
+  g_return_if_fail (monitor != NULL);
+
+  drift_queue_clear (&monitor->queues[DRIFT_VIDEO]);
+  drift_queue_clear (&monitor->queues[DRIFT_AUDIO]);
+  g_mutex_clear (&monitor->lock);
+
+  g_slice_free (GstLpDriftMonitor, monitor);
+}
+
+static void
+add_queue_stats (GstStructure * s, DriftQueue * dq, guint scale,
+    guint overruns)
+{
+  guint level_buffers, level_bytes, max_buffers, max_bytes;
+  guint64 level_time, max_time;
+  gchar *field;
+
+  g_object_get (dq->queue,
+      "current-level-buffers", &level_buffers,
+      "current-level-bytes", &level_bytes,
+      "current-level-time", &level_time,
+      "max-size-buffers", &max_buffers,
+      "max-size-bytes", &max_bytes, "max-size-time", &max_time, NULL);
+
+#define SET_FIELD(suffix, type, value) G_STMT_START { \
+  field = g_strdup_printf ("%s-" suffix, dq->name); \
+  gst_structure_set (s, field, type, value, NULL); \
+  g_free (field); \
+} G_STMT_END
+
+  SET_FIELD ("level-buffers", G_TYPE_UINT, level_buffers);
+  SET_FIELD ("level-bytes", G_TYPE_UINT, level_bytes);
+  SET_FIELD ("level-time", G_TYPE_UINT64, level_time);
+  SET_FIELD ("max-buffers", G_TYPE_UINT, max_buffers);
+  SET_FIELD ("max-bytes", G_TYPE_UINT, max_bytes);
+  SET_FIELD ("max-time", G_TYPE_UINT64, max_time);
+  SET_FIELD ("scale", G_TYPE_UINT, scale);
+  SET_FIELD ("overruns", G_TYPE_UINT, overruns);
+
+#undef SET_FIELD
+}
+
+/**
+ * gst_lp_drift_monitor_get_stats:
+ * @monitor: a #GstLpDriftMonitor
+ *
+ * Returns: (transfer full): a structure named "drift-stats" with the
+ * current running-time lead of audio over video at the input and output
+ * of the queues ("input-lead", "output-lead", 0 until both streams were
+ * seen), the extremes seen so far ("max-lead", "min-lead"), how often the
+ * limits were grown and restored, and the level, limits, scale and overrun
+ * count of the "video-" and "audio-" queue.
+ */
+GstStructure *
+gst_lp_drift_monitor_get_stats (GstLpDriftMonitor * monitor)
+{
+  GstStructure *s;
+  gint64 input_lead = 0, output_lead = 0;
+  guint scale[DRIFT_LAST], overruns[DRIFT_LAST];
+  gint i;
+
+  g_return_val_if_fail (monitor != NULL, NULL);
+
+  g_mutex_lock (&monitor->lock);
+  get_lead (monitor, TRUE, &input_lead);
+  get_lead (monitor, FALSE, &output_lead);
+  for (i = 0; i < DRIFT_LAST; i++) {
+    scale[i] = monitor->queues[i].scale;
+    overruns[i] = monitor->queues[i].overruns;
+  }
+  s = gst_structure_new ("drift-stats",
+      "target", G_TYPE_UINT64, monitor->target,
+      "input-lead", G_TYPE_INT64, input_lead,
+      "output-lead", G_TYPE_INT64, output_lead,
+      "max-lead", G_TYPE_INT64,
+      monitor->max_lead == G_MININT64 ? (gint64) 0 : monitor->max_lead,
+      "min-lead", G_TYPE_INT64,
+      monitor->min_lead == G_MAXINT64 ? (gint64) 0 : monitor->min_lead,
+      "grown", G_TYPE_UINT, monitor->grown,
+      "restored", G_TYPE_UINT, monitor->restored, NULL);
+  g_mutex_unlock (&monitor->lock);
+
+  /* the queues take their own lock for the levels */
+  for (i = 0; i < DRIFT_LAST; i++)
+    add_queue_stats (s, &monitor->queues[i], scale[i], overruns[i]);
+
+  return s;
+}
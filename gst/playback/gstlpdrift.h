@@ -0,0 +1,38 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_LP_DRIFT_H__
+#define __GST_LP_DRIFT_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstLpDriftMonitor GstLpDriftMonitor;
+
+GstLpDriftMonitor *gst_lp_drift_monitor_new (GstElement * owner,
+    GstElement * video_queue, GstElement * audio_queue, GstClockTime target);
+void gst_lp_drift_monitor_free (GstLpDriftMonitor * monitor);
+
+GstStructure *gst_lp_drift_monitor_get_stats (GstLpDriftMonitor * monitor);
+
+G_END_DECLS
+#endif // __GST_LP_DRIFT_H__
@@ -27,6 +27,8 @@
 
 #include <string.h>
 #include "gstlpsink.h"
+#include "gstlparbiter.h"
+#include "gstlptsinkbin.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_lp_sink_debug);
 #define GST_CAT_DEFAULT gst_lp_sink_debug
@@ -51,6 +53,7 @@ enum
 {
   SIGNAL_PAD_BLOCKED,
   SIGNAL_UNBLOCK_SINKPADS,
+  SIGNAL_PULL_TEXT_CUES,
   LAST_SIGNAL
 };
 
@@ -61,12 +64,41 @@ enum
   PROP_VIDEO_SINK,
   PROP_AUDIO_SINK,
   PROP_AUDIO_ONLY,
+  PROP_RECYCLE_STREAMS,
+  PROP_STREAM_IDLE_TIMEOUT,
+  PROP_REUSE_SINKS,
+  PROP_SEEK_COALESCING,
+  PROP_RESOURCE_ARBITRATION,
+  PROP_RESOURCE_PRIORITY,
+  PROP_RESOURCE_TIMEOUT,
+  PROP_DRIFT_MONITOR,
+  PROP_DRIFT_TARGET,
+  PROP_DRIFT_STATS,
+  PROP_SINGLE_PHASE,
+  PROP_VIDEO_SINK_DESC,
+  PROP_AUDIO_SINK_DESC,
+  PROP_TEXT_PULL_MODE,
+  PROP_TEXT_MAX_CUES,
   PROP_LAST
 };
 
 static guint gst_lp_sink_signals[LAST_SIGNAL] = { 0 };
 
 #define DEFAULT_THUMBNAIL_MODE FALSE
+#define DEFAULT_RECYCLE_STREAMS FALSE
+#define DEFAULT_STREAM_IDLE_TIMEOUT 0
+#define DEFAULT_REUSE_SINKS FALSE
+#define DEFAULT_SEEK_COALESCING FALSE
+#define DEFAULT_RESOURCE_ARBITRATION FALSE
+#define DEFAULT_RESOURCE_PRIORITY 0
+#define DEFAULT_RESOURCE_TIMEOUT (3 * GST_SECOND)
+#define DEFAULT_DRIFT_MONITOR FALSE
+#define DEFAULT_DRIFT_TARGET (500 * GST_MSECOND)
+#define DEFAULT_SINGLE_PHASE FALSE
+#define DEFAULT_TEXT_PULL_MODE FALSE
+#define DEFAULT_TEXT_MAX_CUES 64
+
+#define POOL_KEY "lpsink.pool-key"
 
 #define PENDING_FLAG_SET(lpsink, flagtype) \
   ((lpsink->pending_blocked_pads) |= ( 1 << flagtype))
@@ -105,15 +137,21 @@ void gst_lp_sink_set_sink (GstLpSink * lpsink, GstLpSinkType type,
     GstElement * sink);
 GstElement *gst_lp_sink_get_sink (GstLpSink * lpsink, GstLpSinkType type);
 static void gst_lp_sink_do_reconfigure (GstLpSink * lpsink);
+static void gst_lp_sink_get_smart_properties (GstLpSink * lpsink);
 static gboolean add_chain (GstSinkChain * chain, gboolean add);
 static gboolean activate_chain (GstSinkChain * chain, gboolean activate);
 static void video_set_blocked (GstLpSink * lpsink, gboolean blocked);
 static void audio_set_blocked (GstLpSink * lpsink, gboolean blocked);
 static void text_set_blocked (GstLpSink * lpsink, gboolean blocked);
 static gboolean gst_lp_sink_unblock_sinkpads (GstLpSink * lpsink);
+static GPtrArray *gst_lp_sink_pull_text_cues (GstLpSink * lpsink, gint stream,
+    guint64 start, guint64 stop);
 static GstSinkChain *gen_av_chain (GstLpSink * lpsink, GstSinkChain * vchain,
     GstSinkChain * achain, GstPad * video_sink_sinkpad,
     GstPad * audio_sink_sinkpad);
+static void gst_lp_sink_flush_sink_pool (GstLpSink * lpsink,
+    const gchar * prefix);
+static void gst_lp_sink_stop_seek_thread (GstLpSink * lpsink);
 
 static void
 _do_init (GType type)
@@ -171,6 +209,229 @@ gst_lp_sink_class_init (GstLpSinkClass * klass)
           "Audio only stream", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstLpSink:recycle-streams:
+   *
+   * When a new stream-id shows up, reuse the queue and sink chain of a stream
+   * that has finished or has been idle for #GstLpSink:stream-idle-timeout,
+   * as long as the chain accepts the new caps. Must be set before the sink
+   * pads are requested.
+   */
+  g_object_class_install_property (gobject_klass, PROP_RECYCLE_STREAMS,
+      g_param_spec_boolean ("recycle-streams", "Recycle streams",
+          "Reuse chains of finished or idle streams for new stream-ids",
+          DEFAULT_RECYCLE_STREAMS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:stream-idle-timeout:
+   *
+   * Time in nanoseconds a stream has to be inactive before its chain can be
+   * reused. 0 means only chains of streams that have seen EOS are reused.
+   */
+  g_object_class_install_property (gobject_klass, PROP_STREAM_IDLE_TIMEOUT,
+      g_param_spec_uint64 ("stream-idle-timeout", "Stream idle timeout",
+          "Inactive time before a chain can be reused (0 = only after EOS)",
+          0, G_MAXUINT64, DEFAULT_STREAM_IDLE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:reuse-sinks:
+   *
+   * Keep the vdecsink and adecsink elements open in %GST_STATE_READY when
+   * going to %GST_STATE_NULL, and hand them to the next session that asks
+   * for the same resource instead of opening the device again. Sinks that
+   * are not claimed by the next reconfiguration are closed then. Setting it
+   * to %FALSE closes all kept sinks.
+   */
+  g_object_class_install_property (gobject_klass, PROP_REUSE_SINKS,
+      g_param_spec_boolean ("reuse-sinks", "Reuse sinks",
+          "Keep opened sinks for the next session using the same resource",
+          DEFAULT_REUSE_SINKS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:seek-coalescing:
+   *
+   * Run flushing seeks from a separate thread. A seek sent while another
+   * one is being executed replaces whatever seek is still waiting, so only
+   * the latest target of a scrubbing burst is executed.
+   *
+   * gst_element_send_event() then returns %TRUE as soon as the seek is
+   * queued, before it has run, and also for a seek that gets replaced.
+   * Whether a seek worked is only known from its "lpsink-seek-done"
+   * message.
+   *
+   * Every executed seek posts an element message named "lpsink-seek-done"
+   * with the fields "seqnum" (guint), "latency" (guint64, nanoseconds from
+   * the request until the seek returned), "coalesced" (guint, number of
+   * seeks it replaced) and "success" (gboolean).
+   */
+  g_object_class_install_property (gobject_klass, PROP_SEEK_COALESCING,
+      g_param_spec_boolean ("seek-coalescing", "Seek coalescing",
+          "Only execute the latest of flushing seeks sent in quick succession",
+          DEFAULT_SEEK_COALESCING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:resource-arbitration:
+   *
+   * Acquire the vdec channels and adec indexes from the arbiter shared by
+   * all lpsink instances of the process before building the chains, instead
+   * of using the channel given by the smart properties unconditionally. A
+   * requested channel that is taken is replaced by a free one, unless the
+   * smart properties require that exact channel.
+   *
+   * Every decision posts an element message named "lpsink-resource" with
+   * the fields "type" (string, "vdec" or "adec"), "channel" (gint, -1 when
+   * nothing was granted), "priority" (gint) and "waited" (guint64,
+   * nanoseconds). The channels are given back on READY_TO_NULL.
+   */
+  g_object_class_install_property (gobject_klass, PROP_RESOURCE_ARBITRATION,
+      g_param_spec_boolean ("resource-arbitration", "Resource arbitration",
+          "Acquire decoder channels through the process-wide arbiter",
+          DEFAULT_RESOURCE_ARBITRATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:resource-priority:
+   *
+   * Priority of this player for #GstLpSink:resource-arbitration. A request
+   * that finds all channels taken preempts the lowest priority owner below
+   * it, which gets a RESOURCE BUSY error and is expected to stop.
+   */
+  g_object_class_install_property (gobject_klass, PROP_RESOURCE_PRIORITY,
+      g_param_spec_int ("resource-priority", "Resource priority",
+          "Priority when acquiring decoder channels, higher wins",
+          G_MININT, G_MAXINT, DEFAULT_RESOURCE_PRIORITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:resource-timeout:
+   *
+   * How long to wait in nanoseconds for a decoder channel to be released
+   * before failing with a RESOURCE BUSY error. %GST_CLOCK_TIME_NONE waits
+   * forever. Going to READY ends the wait.
+   */
+  g_object_class_install_property (gobject_klass, PROP_RESOURCE_TIMEOUT,
+      g_param_spec_uint64 ("resource-timeout", "Resource timeout",
+          "Time to wait for a decoder channel (-1 = forever)",
+          0, G_MAXUINT64, DEFAULT_RESOURCE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:drift-monitor:
+   *
+   * Watch the running-time lead of audio over video at the queues in front
+   * of the sinks, the AV chain or the first video and audio chain. When a
+   * queue overruns while its stream leads the other one by more than
+   * #GstLpSink:drift-target, its limits are doubled, up to 8 times the
+   * initial ones, so that an upstream thread feeding both streams can reach
+   * the stream that starves. The limits are put back when the lead is
+   * within half the target again.
+   *
+   * Every adjustment posts an element message named "lpsink-drift" with the
+   * fields "queue" (string, "video" or "audio"), "scale" (guint) and
+   * "audio-lead" (gint64, nanoseconds). Must be set before the chains are
+   * built.
+   */
+  g_object_class_install_property (gobject_klass, PROP_DRIFT_MONITOR,
+      g_param_spec_boolean ("drift-monitor", "Drift monitor",
+          "Resize the sink queues to keep audio and video within drift-target",
+          DEFAULT_DRIFT_MONITOR, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:drift-target:
+   *
+   * Lead in nanoseconds one stream may have over the other at the sink
+   * queues before #GstLpSink:drift-monitor grows the queue of the leading
+   * stream.
+   */
+  g_object_class_install_property (gobject_klass, PROP_DRIFT_TARGET,
+      g_param_spec_uint64 ("drift-target", "Drift target",
+          "Allowed running-time lead between audio and video (in ns)",
+          0, G_MAXUINT64, DEFAULT_DRIFT_TARGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:drift-stats:
+   *
+   * A structure named "drift-stats" with the current and extreme leads of
+   * audio over video, the number of adjustments, and the level, limits and
+   * overruns of both queues. %NULL while #GstLpSink:drift-monitor is not
+   * active.
+   */
+  g_object_class_install_property (gobject_klass, PROP_DRIFT_STATS,
+      g_param_spec_boxed ("drift-stats", "Drift statistics",
+          "A/V lead and queue fill of the sink queues",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:single-phase:
+   *
+   * Don't block the sink pads until the "unblock-sinkpads" action, and
+   * don't report blocked streams with #GstLpSink::pad-blocked. Instead the
+   * chains are built as soon as every stream blocked at its queue, once the
+   * parent announced how many there are with
+   * gst_lp_sink_set_expected_streams().
+   *
+   * In both modes an element message named "lpsink-configured" is posted
+   * when the chains are built, with the fields "elapsed" (guint64,
+   * nanoseconds since READY_TO_PAUSED) and "single-phase" (gboolean). Must
+   * be set before the sink pads are requested.
+   */
+  g_object_class_install_property (gobject_klass, PROP_SINGLE_PHASE,
+      g_param_spec_boolean ("single-phase", "Single phase",
+          "Build the chains once all expected streams are blocked, "
+          "without the sink pad block and pad-blocked round trip",
+          DEFAULT_SINGLE_PHASE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:video-sink-desc:
+   *
+   * Sink used for the video chains instead of vdecsink. Either a factory
+   * name with optional properties, like "fakesink sync=true", or a launch
+   * snippet such as "queue ! appsink name=v" whose unlinked sink pad is
+   * ghosted. Such sinks have a single sink pad, so there is no AV chain;
+   * the vdecsink properties are only set when the sink has them. Takes
+   * effect for the chains built after it is set.
+   */
+  g_object_class_install_property (gobject_klass, PROP_VIDEO_SINK_DESC,
+      g_param_spec_string ("video-sink-desc", "Video sink description",
+          "Factory name or launch snippet of the video sink (NULL = vdecsink)",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:audio-sink-desc:
+   *
+   * Sink used for the audio chains instead of adecsink, in the same form as
+   * #GstLpSink:video-sink-desc. Thumbnail mode still uses a fakesink.
+   */
+  g_object_class_install_property (gobject_klass, PROP_AUDIO_SINK_DESC,
+      g_param_spec_string ("audio-sink-desc", "Audio sink description",
+          "Factory name or launch snippet of the audio sink (NULL = adecsink)",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:text-pull-mode:
+   *
+   * Sets #GstLpTSinkBin:pull-mode on the text sink bin, so that subtitle
+   * cues are fetched with #GstLpSink::pull-text-cues.
+   */
+  g_object_class_install_property (gobject_klass, PROP_TEXT_PULL_MODE,
+      g_param_spec_boolean ("text-pull-mode", "Text pull mode",
+          "Keep subtitle cues for pull-text-cues instead of posting them",
+          DEFAULT_TEXT_PULL_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSink:text-max-cues:
+   *
+   * Sets #GstLpTSinkBin:max-cues on the text sink bin.
+   */
+  g_object_class_install_property (gobject_klass, PROP_TEXT_MAX_CUES,
+      g_param_spec_uint ("text-max-cues", "Text max cues",
+          "Number of cues kept per text stream in text pull mode",
+          1, G_MAXUINT, DEFAULT_TEXT_MAX_CUES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstLpSink::pad-blocked
    * @lpsink: a #GstLpSink
@@ -191,6 +452,25 @@ gst_lp_sink_class_init (GstLpSinkClass * klass)
       G_STRUCT_OFFSET (GstLpSinkClass, unblock_sinkpads), NULL, NULL,
       g_cclosure_marshal_generic, G_TYPE_BOOLEAN, 0);
 
+  /**
+   * GstLpSink::pull-text-cues:
+   * @lpsink: a #GstLpSink
+   * @stream: the text stream, counted from 0
+   * @start: start of the window, in stream time
+   * @stop: end of the window, in stream time, or -1 for no end
+   *
+   * Action signal for #GstLpTSinkBin::pull-cues on the text sink bin.
+   *
+   * Returns: (transfer full): a #GPtrArray of #GstSample, or %NULL if there
+   * is no such stream.
+   */
+  gst_lp_sink_signals[SIGNAL_PULL_TEXT_CUES] =
+      g_signal_new ("pull-text-cues", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstLpSinkClass, pull_text_cues), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_PTR_ARRAY, 3, G_TYPE_INT,
+      G_TYPE_UINT64, G_TYPE_UINT64);
+
   gst_element_class_add_pad_template (gstelement_klass,
       gst_static_pad_template_get (&audiotemplate));
   gst_element_class_add_pad_template (gstelement_klass,
@@ -212,10 +492,19 @@ gst_lp_sink_class_init (GstLpSinkClass * klass)
       GST_DEBUG_FUNCPTR (gst_lp_sink_release_request_pad);
 
   klass->unblock_sinkpads = GST_DEBUG_FUNCPTR (gst_lp_sink_unblock_sinkpads);
+  klass->pull_text_cues = GST_DEBUG_FUNCPTR (gst_lp_sink_pull_text_cues);
 
   gstbin_klass->handle_message = GST_DEBUG_FUNCPTR (gst_lp_sink_handle_message);
 }
 
+static void
+close_pooled_sink (GstElement * sink)
+{
+  gst_element_set_locked_state (sink, FALSE);
+  gst_element_set_state (sink, GST_STATE_NULL);
+  gst_object_unref (sink);
+}
+
 static void
 gst_lp_sink_init (GstLpSink * lpsink)
 {
@@ -258,6 +547,42 @@ gst_lp_sink_init (GstLpSink * lpsink)
   lpsink->nb_audio = 0;
 
   lpsink->query_smart_prop = FALSE;
+
+  lpsink->recycle_streams = DEFAULT_RECYCLE_STREAMS;
+  lpsink->stream_idle_timeout = DEFAULT_STREAM_IDLE_TIMEOUT;
+
+  lpsink->reuse_sinks = DEFAULT_REUSE_SINKS;
+  lpsink->sink_pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) close_pooled_sink);
+
+  lpsink->seek_coalescing = DEFAULT_SEEK_COALESCING;
+  g_mutex_init (&lpsink->seek_lock);
+  g_cond_init (&lpsink->seek_cond);
+  lpsink->seek_thread = NULL;
+  lpsink->seek_thread_running = FALSE;
+  lpsink->pending_seek = NULL;
+  lpsink->pending_seek_time = 0;
+  lpsink->pending_seek_coalesced = 0;
+
+  lpsink->resource_arbitration = DEFAULT_RESOURCE_ARBITRATION;
+  lpsink->resource_priority = DEFAULT_RESOURCE_PRIORITY;
+  lpsink->resource_timeout = DEFAULT_RESOURCE_TIMEOUT;
+  lpsink->resource_requests = NULL;
+  lpsink->configuring = FALSE;
+
+  lpsink->drift_monitor_enabled = DEFAULT_DRIFT_MONITOR;
+  lpsink->drift_target = DEFAULT_DRIFT_TARGET;
+  lpsink->drift_monitor = NULL;
+
+  lpsink->single_phase = DEFAULT_SINGLE_PHASE;
+  lpsink->expected_streams = -1;
+  lpsink->configure_start = 0;
+
+  lpsink->video_sink_desc = NULL;
+  lpsink->audio_sink_desc = NULL;
+
+  lpsink->text_pull_mode = DEFAULT_TEXT_PULL_MODE;
+  lpsink->text_max_cues = DEFAULT_TEXT_MAX_CUES;
 }
 
 static void
@@ -313,8 +638,18 @@ gst_lp_sink_finalize (GObject * obj)
 
   lpsink = GST_LP_SINK (obj);
 
+  g_hash_table_unref (lpsink->sink_pool);
+  gst_lp_arbiter_release_all (lpsink);
+
+  gst_lp_sink_stop_seek_thread (lpsink);
+  g_mutex_clear (&lpsink->seek_lock);
+  g_cond_clear (&lpsink->seek_cond);
+
   g_rec_mutex_clear (&lpsink->lock);
 
+  g_free (lpsink->video_sink_desc);
+  g_free (lpsink->audio_sink_desc);
+
   if (lpsink->audio_sink) {
     g_object_unref (lpsink->audio_sink);
     lpsink->audio_sink = NULL;
@@ -408,41 +743,361 @@ try_element (GstLpSink * lpsink, GstElement * element, gboolean unref)
   return element;
 }
 
-static GstSinkChain *
-gen_audio_chain (GstLpSink * lpsink, GstSinkChain * chain)
+static gboolean
+pool_key_has_prefix (gchar * key, GstElement * sink, const gchar * prefix)
 {
-  gchar *bin_name = NULL;
-  GstBin *bin = NULL;
-  GstPad *queue_sinkpad = NULL;
-  GstElement *sink_element = NULL;
-  const gchar *elem_name = NULL;
+  return prefix == NULL || g_str_has_prefix (key, prefix);
+}
 
-  chain->lpsink = lpsink;
+/* Close kept sinks whose key starts with @prefix, or all of them */
+static void
+gst_lp_sink_flush_sink_pool (GstLpSink * lpsink, const gchar * prefix)
+{
+  GST_LP_SINK_LOCK (lpsink);
+  g_hash_table_foreach_remove (lpsink->sink_pool,
+      (GHRFunc) pool_key_has_prefix, (gpointer) prefix);
+  GST_LP_SINK_UNLOCK (lpsink);
+}
 
-  if (lpsink->thumbnail_mode)
-    elem_name = "fakesink";
+/* Take the sink kept open for @key. The returned reference is floating
+ * again, so it is handled like a sink fresh from the factory */
+static GstElement *
+gst_lp_sink_take_pooled_sink (GstLpSink * lpsink, const gchar * key)
+{
+  gpointer orig_key = NULL;
+  GstElement *sink = NULL;
+
+  GST_LP_SINK_LOCK (lpsink);
+  if (g_hash_table_lookup_extended (lpsink->sink_pool, key, &orig_key,
+          (gpointer *) & sink)) {
+    g_hash_table_steal (lpsink->sink_pool, key);
+    g_free (orig_key);
+  }
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  if (!sink)
+    return NULL;
+
+  GST_INFO_OBJECT (lpsink, "reusing open sink %" GST_PTR_FORMAT " for %s",
+      sink, key);
+  gst_element_set_locked_state (sink, FALSE);
+  g_object_force_floating (G_OBJECT (sink));
+
+  return sink;
+}
+
+/* Take @chain's sink out of its bin, and keep it open if it can be reused.
+ * The sink was locked in READY before the bin went to NULL */
+static void
+gst_lp_sink_release_chain_sink (GstLpSink * lpsink, GstSinkChain * chain)
+{
+  GstElement *sink = gst_object_ref (chain->sink);
+  const gchar *key = g_object_get_data (G_OBJECT (sink), POOL_KEY);
+
+  gst_bin_remove (chain->bin, sink);
+  chain->sink = NULL;
+
+  GST_LP_SINK_LOCK (lpsink);
+  /* with arbitration the channel is given back, so the device must close */
+  if (lpsink->reuse_sinks && !lpsink->resource_arbitration && key
+      && GST_STATE (sink) == GST_STATE_READY
+      && !g_hash_table_contains (lpsink->sink_pool, key)) {
+    GST_INFO_OBJECT (lpsink, "keeping %" GST_PTR_FORMAT " open as %s", sink,
+        key);
+    g_hash_table_insert (lpsink->sink_pool, g_strdup (key), sink);
+    sink = NULL;
+  }
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  if (sink)
+    close_pooled_sink (sink);
+}
+
+/* Unlink @chain's queue from its sink. A pad the sink handed out on request
+ * is given back, or a kept sink would come back with it still there */
+static void
+gst_lp_sink_unlink_chain_sink (GstSinkChain * chain)
+{
+  GstPad *srcpad, *sinkpad;
+
+  srcpad = gst_element_get_static_pad (chain->queue, "src");
+  sinkpad = gst_pad_get_peer (srcpad);
+  gst_object_unref (srcpad);
+
+  gst_element_unlink (chain->queue, chain->sink);
+
+  if (!sinkpad)
+    return;
+
+  if (gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (chain->sink),
+          "sink_%d"))
+    gst_element_release_request_pad (chain->sink, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+/* Keep the sinks that can be reused in READY while the chains go to NULL */
+static void
+gst_lp_sink_lock_reusable_sinks (GstLpSink * lpsink, GList * chains)
+{
+  GList *walk;
+
+  if (!lpsink->reuse_sinks)
+    return;
+
+  for (walk = chains; walk; walk = g_list_next (walk)) {
+    GstSinkChain *chain = (GstSinkChain *) walk->data;
+
+    if (chain->sink && g_object_get_data (G_OBJECT (chain->sink), POOL_KEY))
+      gst_element_set_locked_state (chain->sink, TRUE);
+  }
+}
+
+static void
+resource_preempted_cb (gpointer owner, GstLpResourceType type, gint channel)
+{
+  GstLpSink *lpsink = GST_LP_SINK (owner);
+
+  GST_ELEMENT_ERROR (lpsink, RESOURCE, BUSY,
+      ("%s channel %d is needed by a higher priority player",
+          gst_lp_resource_type_get_name (type), channel), (NULL));
+}
+
+/* Call without the lock, the wait can last resource-timeout. Returns the
+ * granted channel, or -1 after posting an error or when shutting down */
+static gint
+gst_lp_sink_acquire_resource (GstLpSink * lpsink, GstLpResourceType type,
+    gint channel, gboolean exact)
+{
+  GstClockTime waited = 0;
+  gint granted;
+  gboolean shutdown;
+
+  granted = gst_lp_arbiter_acquire (type, channel, exact,
+      lpsink->resource_priority, lpsink, resource_preempted_cb,
+      lpsink->resource_timeout, &waited);
+
+  GST_OBJECT_LOCK (lpsink);
+  shutdown = GST_STATE_TARGET (lpsink) < GST_STATE_PAUSED;
+  GST_OBJECT_UNLOCK (lpsink);
+
+  if (shutdown) {
+    GST_DEBUG_OBJECT (lpsink, "shut down while waiting for %s",
+        gst_lp_resource_type_get_name (type));
+    if (granted >= 0)
+      gst_lp_arbiter_release (type, granted, lpsink);
+    return -1;
+  }
+
+  GST_INFO_OBJECT (lpsink, "%s channel %d%s requested, got %d after %"
+      GST_TIME_FORMAT, gst_lp_resource_type_get_name (type), channel,
+      exact ? " (exact)" : "", granted, GST_TIME_ARGS (waited));
+
+  gst_element_post_message (GST_ELEMENT_CAST (lpsink),
+      gst_message_new_element (GST_OBJECT_CAST (lpsink),
+          gst_structure_new ("lpsink-resource",
+              "type", G_TYPE_STRING, gst_lp_resource_type_get_name (type),
+              "channel", G_TYPE_INT, granted,
+              "priority", G_TYPE_INT, lpsink->resource_priority,
+              "waited", G_TYPE_UINT64, waited, NULL)));
+
+  if (granted < 0)
+    GST_ELEMENT_ERROR (lpsink, RESOURCE, BUSY,
+        ("no %s channel available", gst_lp_resource_type_get_name (type)),
+        ("requested channel %d, waited %" GST_TIME_FORMAT, channel,
+            GST_TIME_ARGS (waited)));
+
+  return granted;
+}
+
+typedef struct
+{
+  GstLpResourceType type;
+  gint channel;
+  gboolean exact;
+  gint paired;                  /* another exact channel the chain needs */
+  gint granted;
+  gint paired_granted;
+  gboolean taken;               /* by a chain */
+} ResourceRequest;
+
+static gint
+gst_lp_sink_get_vdec_channel (GstLpSink * lpsink, guint nb_bin)
+{
+  guint vdec_ch = 0;
+
+  if ((lpsink->video_resource & 0x0F) == GST_VDEC_CH0_REQUIRED
+      || (lpsink->video_resource & 0x0F) == GST_VDEC_CH0_CH1_REQUIRED) {
+    vdec_ch = 0;
+  } else if ((lpsink->video_resource & 0x0F) == GST_VDEC_CH1_REQUIRED) {
+    vdec_ch = 1;
+  }
+
+  if (lpsink->nb_video > 1) {
+    vdec_ch = nb_bin;
+  }
+
+  return vdec_ch;
+}
+
+static void
+add_resource_request (GArray * requests, GstLpResourceType type,
+    gint channel, gboolean exact, gint paired)
+{
+  ResourceRequest req = { type, channel, exact, paired, -1, -1, FALSE };
+
+  g_array_append_val (requests, req);
+}
+
+/* Call with the lock. Lists the channels gen_video_chain() and
+ * gen_audio_chain() will need, in the order do_reconfigure() builds the
+ * chains */
+static GArray *
+gst_lp_sink_plan_resources (GstLpSink * lpsink)
+{
+  GArray *requests;
+  GList *item;
+  guint nb_bin = lpsink->nb_video_bin;
+
+  requests = g_array_new (FALSE, FALSE, sizeof (ResourceRequest));
+  if (!lpsink->resource_arbitration)
+    return requests;
+
+  for (item = lpsink->video_chains; item; item = item->next) {
+    GstSinkChain *chain = (GstSinkChain *) item->data;
+    guint required = lpsink->video_resource & 0x0F;
+    gboolean single = lpsink->nb_video <= 1;
+
+    if (chain->sink)
+      continue;
+
+    /* channels named by the smart properties are required as they are */
+    add_resource_request (requests, GST_LP_RESOURCE_VDEC,
+        gst_lp_sink_get_vdec_channel (lpsink, nb_bin++),
+        single && required != 0,
+        single && required == GST_VDEC_CH0_CH1_REQUIRED ? 1 : -1);
+
+    if (chain->type == GST_LP_SINK_TYPE_AV)
+      break;
+  }
+
+  /* the mixer is shared, only decoder indexes are arbitrated */
+  if (!lpsink->thumbnail_mode && !(lpsink->audio_resource & (1 << 31))) {
+    for (item = lpsink->audio_chains; item; item = item->next)
+      add_resource_request (requests, GST_LP_RESOURCE_ADEC,
+          lpsink->audio_resource, FALSE, -1);
+  }
+
+  return requests;
+}
+
+/* Call without the lock */
+static void
+gst_lp_sink_acquire_resources (GstLpSink * lpsink, GArray * requests)
+{
+  guint i;
+
+  for (i = 0; i < requests->len; i++) {
+    ResourceRequest *req = &g_array_index (requests, ResourceRequest, i);
+
+    req->granted = gst_lp_sink_acquire_resource (lpsink, req->type,
+        req->channel, req->exact);
+    if (req->granted < 0 || req->paired < 0)
+      continue;
+
+    req->paired_granted = gst_lp_sink_acquire_resource (lpsink, req->type,
+        req->paired, TRUE);
+    if (req->paired_granted < 0) {
+      gst_lp_arbiter_release (req->type, req->granted, lpsink);
+      req->granted = -1;
+    }
+  }
+}
+
+/* Gives back what no chain took */
+static void
+gst_lp_sink_release_resources (GstLpSink * lpsink, GArray * requests)
+{
+  guint i;
+
+  for (i = 0; i < requests->len; i++) {
+    ResourceRequest *req = &g_array_index (requests, ResourceRequest, i);
+
+    if (req->taken)
+      continue;
+    if (req->granted >= 0)
+      gst_lp_arbiter_release (req->type, req->granted, lpsink);
+    if (req->paired_granted >= 0)
+      gst_lp_arbiter_release (req->type, req->paired_granted, lpsink);
+  }
+}
+
+/* Call with the lock. The next channel granted for a chain of @type, or -1
+ * when it could not be acquired */
+static gint
+gst_lp_sink_take_resource (GstLpSink * lpsink, GstLpResourceType type)
+{
+  guint i;
+
+  for (i = 0; lpsink->resource_requests
+      && i < lpsink->resource_requests->len; i++) {
+    ResourceRequest *req =
+        &g_array_index (lpsink->resource_requests, ResourceRequest, i);
+
+    if (req->type != type || req->taken)
+      continue;
+
+    req->taken = TRUE;
+    return req->granted;
+  }
+
+  GST_WARNING_OBJECT (lpsink, "no %s channel was acquired for this chain",
+      gst_lp_resource_type_get_name (type));
+
+  return -1;
+}
+
+/* @desc is a factory name with optional properties, or a launch snippet
+ * that gets wrapped in a bin ghosting its unlinked sink pad */
+static GstElement *
+make_sink_from_desc (GstLpSink * lpsink, const gchar * desc)
+{
+  GstElement *sink;
+  GError *err = NULL;
+
+  if (strchr (desc, '!'))
+    sink = gst_parse_bin_from_description (desc, TRUE, &err);
   else
-    elem_name = "adecsink";
+    sink = gst_parse_launch (desc, &err);
 
-  sink_element = gst_element_factory_make (elem_name, NULL);
-  if (sink_element == NULL) {
-    gchar *msg =
-        g_strdup_printf ("missing element '%s' - check your environment",
-        elem_name);
-    GST_ELEMENT_ERROR (lpsink, CORE, MISSING_PLUGIN, (msg),
-        ("gen_audio_chain fail"));
-    g_free (msg);
+  if (err) {
+    GST_ELEMENT_ERROR (lpsink, CORE, MISSING_PLUGIN,
+        ("could not create sink from '%s'", desc), ("%s", err->message));
+    g_clear_error (&err);
+    if (sink)
+      gst_object_unref (sink);
     return NULL;
   }
 
-  g_object_set (sink_element, "mixer",
-      (lpsink->audio_resource & (1 << 31)), NULL);
+  GST_INFO_OBJECT (lpsink, "created %" GST_PTR_FORMAT " from '%s'", sink,
+      desc);
+
+  return sink;
+}
+
+static void
+configure_audio_sink (GstLpSink * lpsink, GstElement * sink_element,
+    guint audio_resource)
+{
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink_element),
+          "index")) {
+    g_object_set (sink_element, "mixer", (audio_resource & (1 << 31)), NULL);
 
-  g_object_set (sink_element, "index",
-      (lpsink->audio_resource & ~(1 << 31)), NULL);
-  GST_DEBUG_OBJECT (sink_element, "Request to acquire [%s:%x]",
-      (lpsink->audio_resource & (1 << 31)) ? "MIXER" : "ADEC",
-      (lpsink->audio_resource & ~(1 << 31)));
+    g_object_set (sink_element, "index", (audio_resource & ~(1 << 31)),
+        NULL);
+    GST_DEBUG_OBJECT (sink_element, "Request to acquire [%s:%x]",
+        (audio_resource & (1 << 31)) ? "MIXER" : "ADEC",
+        (audio_resource & ~(1 << 31)));
+  }
 
   if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink_element),
           "audio-only")) {
@@ -454,8 +1109,87 @@ gen_audio_chain (GstLpSink * lpsink, GstSinkChain * chain)
 
     g_free (elem_name);
   }
+}
+
+static GstSinkChain *
+gen_audio_chain (GstLpSink * lpsink, GstSinkChain * chain)
+{
+  gchar *bin_name = NULL;
+  GstBin *bin = NULL;
+  GstPad *queue_sinkpad = NULL;
+  GstElement *sink_element = NULL;
+  const gchar *elem_name = NULL;
+  gchar *pool_key = NULL;
+  gchar *desc = NULL;
+  guint audio_resource = lpsink->audio_resource;
+
+  chain->lpsink = lpsink;
+
+  /* the mixer is shared, only decoder indexes are arbitrated */
+  if (lpsink->resource_arbitration && !lpsink->thumbnail_mode
+      && !(audio_resource & (1 << 31))) {
+    gint index = gst_lp_sink_take_resource (lpsink, GST_LP_RESOURCE_ADEC);
+
+    if (index < 0)
+      return NULL;
+    audio_resource = index;
+  }
 
-  chain->sink = try_element (lpsink, sink_element, TRUE);
+  if (!lpsink->thumbnail_mode) {
+    GST_LP_SINK_LOCK (lpsink);
+    desc = g_strdup (lpsink->audio_sink_desc);
+    GST_LP_SINK_UNLOCK (lpsink);
+  }
+
+  if (lpsink->thumbnail_mode) {
+    elem_name = "fakesink";
+  } else if (desc) {
+    /* custom sinks are not kept open */
+    sink_element = make_sink_from_desc (lpsink, desc);
+    g_free (desc);
+    if (sink_element) {
+      configure_audio_sink (lpsink, sink_element, audio_resource);
+      chain->sink = try_element (lpsink, sink_element, TRUE);
+    }
+    if (!chain->sink)
+      return NULL;
+  } else {
+    elem_name = "adecsink";
+    pool_key = g_strdup_printf ("adecsink:%x:%d", audio_resource,
+        lpsink->audio_only);
+    chain->sink = gst_lp_sink_take_pooled_sink (lpsink, pool_key);
+  }
+
+  if (!chain->sink) {
+    /* a sink kept open with other settings may still hold the device */
+    if (pool_key) {
+      gchar *prefix = g_strdup_printf ("adecsink:%x:", audio_resource);
+      gst_lp_sink_flush_sink_pool (lpsink, prefix);
+      g_free (prefix);
+    }
+
+    sink_element = gst_element_factory_make (elem_name, NULL);
+    if (sink_element == NULL) {
+      gchar *msg =
+          g_strdup_printf ("missing element '%s' - check your environment",
+          elem_name);
+      GST_ELEMENT_ERROR (lpsink, CORE, MISSING_PLUGIN, (msg),
+          ("gen_audio_chain fail"));
+      g_free (msg);
+      g_free (pool_key);
+      return NULL;
+    }
+
+    configure_audio_sink (lpsink, sink_element, audio_resource);
+    chain->sink = try_element (lpsink, sink_element, TRUE);
+
+    if (chain->sink && pool_key) {
+      g_object_set_data_full (G_OBJECT (chain->sink), POOL_KEY, pool_key,
+          g_free);
+      pool_key = NULL;
+    }
+  }
+  g_free (pool_key);
 
   //FIXME
   if (chain->sink)
@@ -493,21 +1227,13 @@ gen_audio_chain (GstLpSink * lpsink, GstSinkChain * chain)
   return chain;
 }
 
-static GstSinkChain *
-gen_video_chain (GstLpSink * lpsink, GstSinkChain * vchain)
+static GstElement *
+make_video_sink (GstLpSink * lpsink, guint vdec_ch, const gchar * desc)
 {
-  gchar *bin_name = NULL;
-  GstBin *bin = NULL;
-  GstPad *queue_sinkpad = NULL;
   GstElement *sink_element = NULL;
-  GstPadTemplate *tmpl;
-  GstPad *queue_srcpad = NULL;
-  GstPad *video_sink_sinkpad = NULL;
-  GstPad *audio_sink_sinkpad = NULL;
-  GList *item = NULL;
-  guint vdec_ch = 0;
 
-  vchain->lpsink = lpsink;
+  if (desc)
+    return try_element (lpsink, make_sink_from_desc (lpsink, desc), TRUE);
 
   sink_element = gst_element_factory_make ("vdecsink", NULL);
   if (sink_element == NULL) {
@@ -535,28 +1261,105 @@ gen_video_chain (GstLpSink * lpsink, GstSinkChain * vchain)
         NULL);
   }
 
-  if ((lpsink->video_resource & 0x0F) == GST_VDEC_CH0_REQUIRED
-      || (lpsink->video_resource & 0x0F) == GST_VDEC_CH0_CH1_REQUIRED) {
-    vdec_ch = 0;
-  } else if ((lpsink->video_resource & 0x0F) == GST_VDEC_CH1_REQUIRED) {
-    vdec_ch = 1;
+  GST_INFO_OBJECT (sink_element, "vdec_ch = %d", vdec_ch);
+  g_object_set (sink_element, "vdec-ch", vdec_ch, NULL);
+
+  return try_element (lpsink, sink_element, TRUE);
+}
+
+/* vdecsink hands out a pad per stream, other sinks have a single one */
+static GstPad *
+get_video_sink_pad (GstElement * sink, GstCaps * caps)
+{
+  GstPadTemplate *tmpl;
+
+  tmpl = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (sink),
+      "sink_%d");
+  if (tmpl)
+    return gst_element_request_pad (sink, tmpl, NULL, caps);
+
+  return gst_element_get_static_pad (sink, "sink");
+}
+
+static GstSinkChain *
+gen_video_chain (GstLpSink * lpsink, GstSinkChain * vchain)
+{
+  gchar *bin_name = NULL;
+  GstBin *bin = NULL;
+  GstPad *queue_sinkpad = NULL;
+  GstPadTemplate *tmpl;
+  GstPad *queue_srcpad = NULL;
+  GstPad *video_sink_sinkpad = NULL;
+  GstPad *audio_sink_sinkpad = NULL;
+  GList *item = NULL;
+  guint vdec_ch = 0;
+  gchar *pool_key = NULL;
+  gchar *prefix = NULL;
+  gchar *desc;
+
+  vchain->lpsink = lpsink;
+
+  vdec_ch = gst_lp_sink_get_vdec_channel (lpsink, lpsink->nb_video_bin);
+
+  if (lpsink->resource_arbitration) {
+    gint granted = gst_lp_sink_take_resource (lpsink, GST_LP_RESOURCE_VDEC);
+
+    if (granted < 0)
+      return NULL;
+    vdec_ch = granted;
   }
 
-  if (lpsink->nb_video > 1) {
-    vdec_ch = lpsink->nb_video_bin;
+  GST_LP_SINK_LOCK (lpsink);
+  desc = g_strdup (lpsink->video_sink_desc);
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  if (desc) {
+    /* custom sinks are not kept open */
+    vchain->sink = make_video_sink (lpsink, vdec_ch, desc);
+    g_free (desc);
+    if (!vchain->sink)
+      return NULL;
+    video_sink_sinkpad = get_video_sink_pad (vchain->sink, vchain->caps);
+    goto have_sink;
+  }
+
+  prefix = g_strdup_printf ("vdecsink:%u:", vdec_ch);
+  pool_key = g_strdup_printf ("%s%d:%d", prefix, lpsink->thumbnail_mode,
+      lpsink->interleaving_type);
+
+  vchain->sink = gst_lp_sink_take_pooled_sink (lpsink, pool_key);
+  if (vchain->sink) {
+    video_sink_sinkpad = get_video_sink_pad (vchain->sink, vchain->caps);
+
+    /* the kept sink can't take these caps, open the device again */
+    if (!video_sink_sinkpad) {
+      GST_INFO_OBJECT (lpsink, "kept sink refused %" GST_PTR_FORMAT,
+          vchain->caps);
+      gst_object_ref_sink (vchain->sink);
+      close_pooled_sink (vchain->sink);
+      vchain->sink = NULL;
+    }
   }
 
-  GST_INFO_OBJECT (sink_element, "vdec_ch = %d", vdec_ch);
-  g_object_set (sink_element, "vdec-ch", vdec_ch, NULL);
+  if (!vchain->sink) {
+    /* a sink kept open with other settings may still hold the channel */
+    gst_lp_sink_flush_sink_pool (lpsink, prefix);
 
-  vchain->sink = try_element (lpsink, sink_element, TRUE);
+    if (!(vchain->sink = make_video_sink (lpsink, vdec_ch, NULL))) {
+      g_free (pool_key);
+      g_free (prefix);
+      return NULL;
+    }
+    g_object_set_data_full (G_OBJECT (vchain->sink), POOL_KEY, pool_key,
+        g_free);
+    pool_key = NULL;
 
-  tmpl =
-      gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (vchain->sink),
-      "sink_%d");
-  video_sink_sinkpad =
-      gst_element_request_pad (vchain->sink, tmpl, NULL, vchain->caps);
+    video_sink_sinkpad = get_video_sink_pad (vchain->sink, vchain->caps);
+  }
+  g_free (pool_key);
+  g_free (prefix);
 
+have_sink:
   if (!video_sink_sinkpad) {
     lpsink->unsupported_pipeline = TRUE;
     gst_element_set_state (vchain->sink, GST_STATE_NULL);
@@ -565,7 +1368,11 @@ gen_video_chain (GstLpSink * lpsink, GstSinkChain * vchain)
   }
 
   /* configure av sink chain if audio_sinkpad is exist */
-  if (lpsink->audio_chains && (item = g_list_first (lpsink->audio_chains))) {
+  tmpl =
+      gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS
+      (vchain->sink), "sink_%d");
+  if (tmpl && lpsink->audio_chains
+      && (item = g_list_first (lpsink->audio_chains))) {
     GstSinkChain *achain = NULL;
 
     achain = (GstSinkChain *) item->data;
@@ -837,7 +1644,8 @@ pad_added_cb (GstElement * element, GstPad * pad, GstLpSink * lpsink)
   chain = g_slice_alloc0 (sizeof (GstSinkChain));
   block_id = &chain->block_id;
   chain->peer_srcpad_queue = gst_object_ref (queue_srcpad);
-  chain->caps = caps;
+  /* caps belong to the query, which is freed below */
+  chain->caps = caps ? gst_caps_ref (caps) : NULL;
 
   if (element == lpsink->video_streamid_demux) {
     chain->type = GST_LP_SINK_TYPE_VIDEO;
@@ -868,17 +1676,80 @@ pad_added_cb (GstElement * element, GstPad * pad, GstLpSink * lpsink)
   gst_object_unref (ghost_sinkpad);
 }
 
+/* A demux srcpad of a finished or idle stream was handed over to a new
+ * stream-id, and the chain behind it already accepted the new caps */
+static void
+pad_recycled_cb (GstElement * element, GstPad * pad, const gchar * stream_id,
+    GstCaps * caps, GstLpSink * lpsink)
+{
+  GstPad *queue_sinkpad = NULL;
+  GstPad *queue_srcpad = NULL;
+  GstElement *queue = NULL;
+  GstSinkChain *chain = NULL;
+
+  if (!(queue_sinkpad = gst_pad_get_peer (pad)))
+    return;
+
+  queue = gst_pad_get_parent_element (queue_sinkpad);
+  queue_srcpad = gst_element_get_static_pad (queue, "src");
+  chain = g_object_get_data (G_OBJECT (queue_srcpad), "lpsink.chain");
+
+  GST_INFO_OBJECT (lpsink, "reusing chain %p for stream-id %s", chain,
+      stream_id);
+
+  GST_LP_SINK_LOCK (lpsink);
+  if (chain)
+    gst_caps_replace (&chain->caps, caps);
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  gst_object_unref (queue_srcpad);
+  gst_object_unref (queue);
+  gst_object_unref (queue_sinkpad);
+}
+
+/* Call without the lock. The decoder channels are all acquired before the
+ * chains are walked, so that waiting for them neither keeps the
+ * application out of lpsink nor lets a shutdown free the chains under
+ * do_reconfigure */
 void
 gst_lp_sink_set_all_pads_blocked (GstLpSink * lpsink)
 {
+  GArray *requests;
+  gboolean shutdown;
+
   GST_DEBUG_OBJECT (lpsink, "all pads are blocked!");
 
   GST_LP_SINK_LOCK (lpsink);
-  gst_lp_sink_do_reconfigure (lpsink);
+  if (lpsink->configuring) {
+    GST_DEBUG_OBJECT (lpsink, "already building the chains");
+    GST_LP_SINK_UNLOCK (lpsink);
+    return;
+  }
+  lpsink->configuring = TRUE;
+  gst_lp_sink_get_smart_properties (lpsink);
+  requests = gst_lp_sink_plan_resources (lpsink);
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  gst_lp_sink_acquire_resources (lpsink, requests);
+
+  GST_LP_SINK_LOCK (lpsink);
+  GST_OBJECT_LOCK (lpsink);
+  shutdown = GST_STATE_TARGET (lpsink) < GST_STATE_PAUSED;
+  GST_OBJECT_UNLOCK (lpsink);
+
+  if (shutdown) {
+    GST_DEBUG_OBJECT (lpsink, "shut down while acquiring the channels");
+    gst_lp_sink_release_resources (lpsink, requests);
+    g_array_free (requests, TRUE);
+  } else {
+    lpsink->resource_requests = requests;
+    gst_lp_sink_do_reconfigure (lpsink);
 
-  video_set_blocked (lpsink, FALSE);
-  audio_set_blocked (lpsink, FALSE);
-  text_set_blocked (lpsink, FALSE);
+    video_set_blocked (lpsink, FALSE);
+    audio_set_blocked (lpsink, FALSE);
+    text_set_blocked (lpsink, FALSE);
+  }
+  lpsink->configuring = FALSE;
   GST_LP_SINK_UNLOCK (lpsink);
 }
 
@@ -899,14 +1770,52 @@ gst_lp_sink_get_smart_properties (GstLpSink * lpsink)
 }
 
 
+/* Call with the lpsink lock, after the chains are built */
+static void
+gst_lp_sink_start_drift_monitor (GstLpSink * lpsink)
+{
+  GstElement *video_queue = NULL, *audio_queue = NULL;
+  GList *walk;
+
+  if (!lpsink->drift_monitor_enabled || lpsink->drift_monitor)
+    return;
+
+  for (walk = lpsink->video_chains; walk && !video_queue; walk = walk->next) {
+    GstSinkChain *chain = (GstSinkChain *) walk->data;
+
+    if (!chain->sink)
+      continue;
+
+    if (chain->type == GST_LP_SINK_TYPE_AV) {
+      video_queue = GST_AV_SINK_CHAIN (chain)->video_queue;
+      audio_queue = GST_AV_SINK_CHAIN (chain)->audio_queue;
+    } else {
+      video_queue = chain->queue;
+    }
+  }
+
+  for (walk = lpsink->audio_chains; walk && !audio_queue; walk = walk->next) {
+    GstSinkChain *chain = (GstSinkChain *) walk->data;
+
+    if (chain->sink)
+      audio_queue = chain->queue;
+  }
+
+  if (!video_queue || !audio_queue) {
+    GST_DEBUG_OBJECT (lpsink, "no audio and video queue pair to monitor");
+    return;
+  }
+
+  lpsink->drift_monitor = gst_lp_drift_monitor_new (GST_ELEMENT_CAST (lpsink),
+      video_queue, audio_queue, lpsink->drift_target);
+}
+
 static void
 gst_lp_sink_do_reconfigure (GstLpSink * lpsink)
 {
   GList *item = NULL;
   GstSinkChain *chain = NULL;
 
-  gst_lp_sink_get_smart_properties (lpsink);
-
   GST_LP_SINK_LOCK (lpsink);
 
   for (item = g_list_first (lpsink->video_chains); item; item = item->next) {
@@ -971,7 +1880,31 @@ gst_lp_sink_do_reconfigure (GstLpSink * lpsink)
     GST_DEBUG_OBJECT (lpsink, "text chain added");
   }
 
+  gst_lp_sink_start_drift_monitor (lpsink);
+
+  if (lpsink->configure_start) {
+    guint64 elapsed =
+        (g_get_monotonic_time () - lpsink->configure_start) * GST_USECOND;
+
+    GST_INFO_OBJECT (lpsink, "chains built %" GST_TIME_FORMAT
+        " after READY_TO_PAUSED", GST_TIME_ARGS (elapsed));
+    gst_element_post_message (GST_ELEMENT_CAST (lpsink),
+        gst_message_new_element (GST_OBJECT_CAST (lpsink),
+            gst_structure_new ("lpsink-configured",
+                "elapsed", G_TYPE_UINT64, elapsed,
+                "single-phase", G_TYPE_BOOLEAN, lpsink->single_phase, NULL)));
+    lpsink->configure_start = 0;
+  }
+
 finish_reconfiguration:
+  /* kept sinks nobody asked for would only hold their device */
+  gst_lp_sink_flush_sink_pool (lpsink, NULL);
+
+  if (lpsink->resource_requests) {
+    gst_lp_sink_release_resources (lpsink, lpsink->resource_requests);
+    g_array_free (lpsink->resource_requests, TRUE);
+    lpsink->resource_requests = NULL;
+  }
 
   do_async_done (lpsink);
   GST_LP_SINK_UNLOCK (lpsink);
@@ -997,6 +1930,13 @@ gst_lp_sink_setup_element (GstLpSink * lpsink, GstElement ** streamid_demux,
   g_signal_connect (G_OBJECT (*streamid_demux), "pad-added",
       G_CALLBACK (pad_added_cb), lpsink);
 
+  if (lpsink->recycle_streams) {
+    g_object_set (*streamid_demux, "recycle-pads", TRUE, "idle-timeout",
+        lpsink->stream_idle_timeout, NULL);
+    g_signal_connect (G_OBJECT (*streamid_demux), "pad-recycled",
+        G_CALLBACK (pad_recycled_cb), lpsink);
+  }
+
   gst_element_set_state (*streamid_demux, GST_STATE_PAUSED);
 
   if (*ghost_sinkpad == lpsink->video_pad)
@@ -1115,6 +2055,68 @@ text_set_blocked (GstLpSink * lpsink, gboolean blocked)
   }
 }
 
+/* Call with the lpsink lock. Whether every stream announced by the parent
+ * has a chain blocked on its first event */
+static gboolean
+gst_lp_sink_streams_ready (GstLpSink * lpsink)
+{
+  GList *lists[] = { lpsink->video_chains, lpsink->audio_chains,
+    lpsink->text_chains
+  };
+  GList *walk;
+  guint i;
+  gint n_blocked = 0;
+
+  if (lpsink->expected_streams < 0)
+    return FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (lists); i++) {
+    for (walk = lists[i]; walk; walk = walk->next) {
+      GstSinkChain *chain = (GstSinkChain *) walk->data;
+
+      if (chain->type == GST_LP_SINK_TYPE_AV) {
+        if (!GST_AV_SINK_CHAIN (chain)->video_peer_srcpad_blocked
+            || !GST_AV_SINK_CHAIN (chain)->audio_peer_srcpad_blocked)
+          return FALSE;
+        n_blocked += 2;
+      } else {
+        if (!chain->peer_srcpad_blocked)
+          return FALSE;
+        n_blocked++;
+      }
+    }
+  }
+
+  GST_DEBUG_OBJECT (lpsink, "%d of %d streams blocked", n_blocked,
+      lpsink->expected_streams);
+
+  return n_blocked >= lpsink->expected_streams;
+}
+
+/**
+ * gst_lp_sink_set_expected_streams:
+ * @lpsink: a #GstLpSink
+ * @n_streams: number of streams that will be linked to the sink pads
+ *
+ * In #GstLpSink:single-phase mode, tell how many streams to wait for
+ * before building the chains. Builds them right away if they all arrived
+ * already.
+ */
+void
+gst_lp_sink_set_expected_streams (GstLpSink * lpsink, gint n_streams)
+{
+  gboolean ready;
+
+  GST_LP_SINK_LOCK (lpsink);
+  GST_INFO_OBJECT (lpsink, "expecting %d streams", n_streams);
+  lpsink->expected_streams = n_streams;
+  ready = lpsink->single_phase && gst_lp_sink_streams_ready (lpsink);
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  if (ready)
+    gst_lp_sink_set_all_pads_blocked (lpsink);
+}
+
 static GstPadProbeReturn
 srcpad_blocked_cb (GstPad * blockedpad, GstPadProbeInfo * info,
     gpointer user_data)
@@ -1125,6 +2127,7 @@ srcpad_blocked_cb (GstPad * blockedpad, GstPadProbeInfo * info,
   const gchar *parsed_stream_id = NULL;
   gchar *stream_id = NULL;
   GstEvent *event = GST_PAD_PROBE_INFO_DATA (info);
+  gboolean ready;
 
   GST_LP_SINK_LOCK (lpsink);
 
@@ -1156,12 +2159,17 @@ srcpad_blocked_cb (GstPad * blockedpad, GstPadProbeInfo * info,
   GST_DEBUG_OBJECT (blockedpad, "%s pad(%s) blocked", pad_type,
       GST_PAD_NAME (blockedpad));
 
-  g_signal_emit (G_OBJECT (lpsink),
-      gst_lp_sink_signals[SIGNAL_PAD_BLOCKED], 0, stream_id, TRUE);
-  g_free (stream_id);
-
+  ready = lpsink->single_phase && gst_lp_sink_streams_ready (lpsink);
   GST_LP_SINK_UNLOCK (lpsink);
 
+  /* the chains are built from here, or from the handler, without the lock */
+  if (ready)
+    gst_lp_sink_set_all_pads_blocked (lpsink);
+  else if (!lpsink->single_phase)
+    g_signal_emit (G_OBJECT (lpsink),
+        gst_lp_sink_signals[SIGNAL_PAD_BLOCKED], 0, stream_id, TRUE);
+  g_free (stream_id);
+
   return GST_PAD_PROBE_OK;
 }
 
@@ -1179,6 +2187,30 @@ gst_lp_sink_reconfigure (GstLpSink * lpsink)
   return TRUE;
 }
 
+static GPtrArray *
+gst_lp_sink_pull_text_cues (GstLpSink * lpsink, gint stream, guint64 start,
+    guint64 stop)
+{
+  GstElement *text_sinkbin = NULL;
+  GPtrArray *res;
+
+  GST_LP_SINK_LOCK (lpsink);
+  if (lpsink->text_sinkbin)
+    text_sinkbin = gst_object_ref (lpsink->text_sinkbin);
+  GST_LP_SINK_UNLOCK (lpsink);
+
+  if (!text_sinkbin) {
+    GST_DEBUG_OBJECT (lpsink, "no text stream yet");
+    return NULL;
+  }
+
+  res = gst_lp_tsink_bin_pull_cues (GST_LP_TSINK_BIN (text_sinkbin), stream,
+      start, stop);
+  gst_object_unref (text_sinkbin);
+
+  return res;
+}
+
 static gboolean
 gst_lp_sink_unblock_sinkpads (GstLpSink * lpsink)
 {
@@ -1253,6 +2285,8 @@ gst_lp_sink_request_pad (GstLpSink * lpsink, GstLpSinkType type)
             &lpsink->text_pad, "text_sink");
 
         lpsink->text_sinkbin = gst_element_factory_make ("lptsinkbin", NULL);
+        g_object_set (lpsink->text_sinkbin, "pull-mode", lpsink->text_pull_mode,
+            "max-cues", lpsink->text_max_cues, NULL);
         gst_bin_add (GST_BIN_CAST (lpsink), lpsink->text_sinkbin);
         GST_OBJECT_FLAG_SET (lpsink->text_sinkbin, GST_ELEMENT_FLAG_SINK);
       }
@@ -1269,7 +2303,8 @@ gst_lp_sink_request_pad (GstLpSink * lpsink, GstLpSinkType type)
     gst_pad_set_active (res, TRUE);
     gst_element_add_pad (GST_ELEMENT_CAST (lpsink), res);
 
-    if (block_id && *block_id == 0) {
+    /* in single-phase mode the streams only block at their queues */
+    if (block_id && *block_id == 0 && !lpsink->single_phase) {
       GstPad *blockpad =
           GST_PAD_CAST (gst_proxy_pad_get_internal (GST_PROXY_PAD (res)));
 
@@ -1412,6 +2447,82 @@ gst_lp_sink_set_property (GObject * object, guint prop_id,
     case PROP_AUDIO_ONLY:
       lpsink->audio_only = g_value_get_boolean (value);
       break;
+    case PROP_RECYCLE_STREAMS:
+      lpsink->recycle_streams = g_value_get_boolean (value);
+      break;
+    case PROP_STREAM_IDLE_TIMEOUT:
+      lpsink->stream_idle_timeout = g_value_get_uint64 (value);
+      break;
+    case PROP_SEEK_COALESCING:
+      g_mutex_lock (&lpsink->seek_lock);
+      lpsink->seek_coalescing = g_value_get_boolean (value);
+      g_mutex_unlock (&lpsink->seek_lock);
+      break;
+    case PROP_RESOURCE_ARBITRATION:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->resource_arbitration = g_value_get_boolean (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_RESOURCE_PRIORITY:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->resource_priority = g_value_get_int (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_RESOURCE_TIMEOUT:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->resource_timeout = g_value_get_uint64 (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_DRIFT_MONITOR:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->drift_monitor_enabled = g_value_get_boolean (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_DRIFT_TARGET:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->drift_target = g_value_get_uint64 (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_SINGLE_PHASE:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->single_phase = g_value_get_boolean (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_VIDEO_SINK_DESC:
+      GST_LP_SINK_LOCK (lpsink);
+      g_free (lpsink->video_sink_desc);
+      lpsink->video_sink_desc = g_value_dup_string (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_AUDIO_SINK_DESC:
+      GST_LP_SINK_LOCK (lpsink);
+      g_free (lpsink->audio_sink_desc);
+      lpsink->audio_sink_desc = g_value_dup_string (value);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_TEXT_PULL_MODE:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->text_pull_mode = g_value_get_boolean (value);
+      if (lpsink->text_sinkbin)
+        g_object_set (lpsink->text_sinkbin, "pull-mode", lpsink->text_pull_mode,
+            NULL);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_TEXT_MAX_CUES:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->text_max_cues = g_value_get_uint (value);
+      if (lpsink->text_sinkbin)
+        g_object_set (lpsink->text_sinkbin, "max-cues", lpsink->text_max_cues,
+            NULL);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_REUSE_SINKS:
+      GST_LP_SINK_LOCK (lpsink);
+      lpsink->reuse_sinks = g_value_get_boolean (value);
+      if (!lpsink->reuse_sinks)
+        gst_lp_sink_flush_sink_pool (lpsink, NULL);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
@@ -1435,12 +2546,216 @@ gst_lp_sink_get_property (GObject * object, guint prop_id,
     case PROP_AUDIO_ONLY:
       g_value_set_boolean (value, lpsink->audio_only);
       break;
+    case PROP_RECYCLE_STREAMS:
+      g_value_set_boolean (value, lpsink->recycle_streams);
+      break;
+    case PROP_STREAM_IDLE_TIMEOUT:
+      g_value_set_uint64 (value, lpsink->stream_idle_timeout);
+      break;
+    case PROP_REUSE_SINKS:
+      g_value_set_boolean (value, lpsink->reuse_sinks);
+      break;
+    case PROP_SEEK_COALESCING:
+      g_mutex_lock (&lpsink->seek_lock);
+      g_value_set_boolean (value, lpsink->seek_coalescing);
+      g_mutex_unlock (&lpsink->seek_lock);
+      break;
+    case PROP_RESOURCE_ARBITRATION:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_boolean (value, lpsink->resource_arbitration);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_RESOURCE_PRIORITY:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_int (value, lpsink->resource_priority);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_RESOURCE_TIMEOUT:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_uint64 (value, lpsink->resource_timeout);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_DRIFT_MONITOR:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_boolean (value, lpsink->drift_monitor_enabled);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_DRIFT_TARGET:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_uint64 (value, lpsink->drift_target);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_SINGLE_PHASE:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_boolean (value, lpsink->single_phase);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_VIDEO_SINK_DESC:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_string (value, lpsink->video_sink_desc);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_AUDIO_SINK_DESC:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_string (value, lpsink->audio_sink_desc);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_TEXT_PULL_MODE:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_boolean (value, lpsink->text_pull_mode);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_TEXT_MAX_CUES:
+      GST_LP_SINK_LOCK (lpsink);
+      g_value_set_uint (value, lpsink->text_max_cues);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
+    case PROP_DRIFT_STATS:
+      GST_LP_SINK_LOCK (lpsink);
+      if (lpsink->drift_monitor)
+        g_value_take_boxed (value,
+            gst_lp_drift_monitor_get_stats (lpsink->drift_monitor));
+      else
+        g_value_set_boxed (value, NULL);
+      GST_LP_SINK_UNLOCK (lpsink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
   }
 }
 
+/* Takes ownership of @event */
+static gboolean
+gst_lp_sink_do_seek (GstLpSink * lpsink, GstEvent * event)
+{
+  gboolean res;
+  gdouble rate;
+
+  gst_event_parse_seek (event, &rate, NULL, NULL, NULL, NULL, NULL, NULL);
+
+  res = gst_lp_sink_send_event_to_sink (lpsink, event);
+  if (res) {
+    /* the seek thread writes it while the app queries the position */
+    GST_OBJECT_LOCK (lpsink);
+    if (lpsink->rate != rate) {
+      lpsink->rate = rate;
+      GST_INFO_OBJECT (lpsink, "GST_EVENT_SEEK, set playrate %lf", rate);
+    }
+    GST_OBJECT_UNLOCK (lpsink);
+  }
+
+  return res;
+}
+
+static gpointer
+gst_lp_sink_seek_func (GstLpSink * lpsink)
+{
+  g_mutex_lock (&lpsink->seek_lock);
+  while (lpsink->seek_thread_running) {
+    GstEvent *event;
+    gint64 requested;
+    guint coalesced, seqnum;
+    gboolean res;
+
+    if (!lpsink->pending_seek) {
+      g_cond_wait (&lpsink->seek_cond, &lpsink->seek_lock);
+      continue;
+    }
+
+    event = lpsink->pending_seek;
+    requested = lpsink->pending_seek_time;
+    coalesced = lpsink->pending_seek_coalesced;
+    lpsink->pending_seek = NULL;
+    lpsink->pending_seek_coalesced = 0;
+    g_mutex_unlock (&lpsink->seek_lock);
+
+    seqnum = gst_event_get_seqnum (event);
+    res = gst_lp_sink_do_seek (lpsink, event);
+
+    gst_element_post_message (GST_ELEMENT_CAST (lpsink),
+        gst_message_new_element (GST_OBJECT_CAST (lpsink),
+            gst_structure_new ("lpsink-seek-done",
+                "seqnum", G_TYPE_UINT, seqnum,
+                "latency", G_TYPE_UINT64,
+                (guint64) (g_get_monotonic_time () - requested) * GST_USECOND,
+                "coalesced", G_TYPE_UINT, coalesced,
+                "success", G_TYPE_BOOLEAN, res, NULL)));
+
+    GST_DEBUG_OBJECT (lpsink, "seek %u done (%d), replaced %u seeks", seqnum,
+        res, coalesced);
+
+    g_mutex_lock (&lpsink->seek_lock);
+  }
+  g_mutex_unlock (&lpsink->seek_lock);
+
+  return NULL;
+}
+
+/* Hand a flushing seek over to the seek thread, replacing the one that is
+ * still waiting there. Takes ownership of @event when returning TRUE */
+static gboolean
+gst_lp_sink_queue_seek (GstLpSink * lpsink, GstEvent * event)
+{
+  GstSeekFlags flags;
+  GstEvent *old = NULL;
+
+  gst_event_parse_seek (event, NULL, NULL, &flags, NULL, NULL, NULL, NULL);
+  if (!(flags & GST_SEEK_FLAG_FLUSH))
+    return FALSE;
+
+  g_mutex_lock (&lpsink->seek_lock);
+  if (!lpsink->seek_coalescing) {
+    g_mutex_unlock (&lpsink->seek_lock);
+    return FALSE;
+  }
+
+  if (!lpsink->seek_thread) {
+    lpsink->seek_thread_running = TRUE;
+    lpsink->seek_thread =
+        g_thread_new ("lpsink-seek", (GThreadFunc) gst_lp_sink_seek_func,
+        lpsink);
+  }
+
+  if ((old = lpsink->pending_seek)) {
+    GST_DEBUG_OBJECT (lpsink, "seek %u replaces pending seek %u",
+        gst_event_get_seqnum (event), gst_event_get_seqnum (old));
+    lpsink->pending_seek_coalesced++;
+  }
+  lpsink->pending_seek = event;
+  lpsink->pending_seek_time = g_get_monotonic_time ();
+  g_cond_signal (&lpsink->seek_cond);
+  g_mutex_unlock (&lpsink->seek_lock);
+
+  if (old)
+    gst_event_unref (old);
+
+  return TRUE;
+}
+
+/* Drop the pending seek and wait for the one in progress */
+static void
+gst_lp_sink_stop_seek_thread (GstLpSink * lpsink)
+{
+  GThread *thread;
+  GstEvent *pending;
+
+  g_mutex_lock (&lpsink->seek_lock);
+  thread = lpsink->seek_thread;
+  pending = lpsink->pending_seek;
+  lpsink->seek_thread = NULL;
+  lpsink->seek_thread_running = FALSE;
+  lpsink->pending_seek = NULL;
+  lpsink->pending_seek_coalesced = 0;
+  g_cond_signal (&lpsink->seek_cond);
+  g_mutex_unlock (&lpsink->seek_lock);
+
+  if (pending)
+    gst_event_unref (pending);
+  if (thread)
+    g_thread_join (thread);
+}
+
 /* We only want to send the event to a single sink (overriding GstBin's
  * behaviour), but we want to keep GstPipeline's behaviour - wrapping seek
  * events appropriately. So, this is a messy duplication of code. */
@@ -1453,17 +2768,12 @@ gst_lp_sink_send_event (GstElement * element, GstEvent * event)
 
   switch (event_type) {
     case GST_EVENT_SEEK:
-      GST_DEBUG_OBJECT (element, "Sending event to a sink");
-      gdouble rate;
-      res = gst_lp_sink_send_event_to_sink (lpsink, event);
-      if (res) {
-        gst_event_parse_seek (event, &rate, NULL, NULL, NULL, NULL, NULL, NULL);
-        if (lpsink->rate != rate) {
-          lpsink->rate = rate;
-          GST_INFO_OBJECT (lpsink,
-              "GST_EVENT_SEEK, set playrate %lf" G_GUINT64_FORMAT, rate);
-        }
+      if (gst_lp_sink_queue_seek (lpsink, event)) {
+        res = TRUE;
+        break;
       }
+      GST_DEBUG_OBJECT (element, "Sending event to a sink");
+      res = gst_lp_sink_do_seek (lpsink, event);
       break;
     default:
       res = GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
@@ -1504,9 +2814,16 @@ gst_lp_sink_query (GstElement * element, GstQuery * query)
 {
   GstLpSink *lpsink = GST_LP_SINK (element);
   gboolean ret;
+  gdouble rate;
+
+  GST_OBJECT_LOCK (lpsink);
+  rate = lpsink->rate;
+  GST_OBJECT_UNLOCK (lpsink);
 
   if (GST_QUERY_TYPE (query) == GST_QUERY_POSITION && lpsink->video_sink
-      && ABS ((gint64) lpsink->rate) >= 4) {
+      && ABS ((gint64) rate) >= 4
+      && g_object_class_find_property (G_OBJECT_GET_CLASS (lpsink->video_sink),
+          "current-pts")) {
     GST_INFO_OBJECT (lpsink,
         "GST_QUERY_POSITION, trying to get current pts from vdecsink");
     guint64 current_pts = 0;
@@ -1582,7 +2899,9 @@ gst_lp_sink_change_state (GstElement * element, GstStateChange transition)
 
   switch (transition) {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_lp_arbiter_set_flushing (lpsink, FALSE);
       lpsink->need_async_start = TRUE;
+      lpsink->configure_start = g_get_monotonic_time ();
       /* we want to go async to PAUSED until we managed to configure and add the
        * sinks */
       do_async_start (lpsink);
@@ -1593,12 +2912,24 @@ gst_lp_sink_change_state (GstElement * element, GstStateChange transition)
          ret = GST_STATE_CHANGE_FAILURE; */
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* a streaming thread waiting for a channel must return before its
+       * pad can be deactivated */
+      gst_lp_arbiter_set_flushing (lpsink, TRUE);
+      gst_lp_sink_stop_seek_thread (lpsink);
+
       GST_LP_SINK_LOCK (lpsink);
       video_set_blocked (lpsink, FALSE);
       audio_set_blocked (lpsink, FALSE);
       text_set_blocked (lpsink, FALSE);
       GST_LP_SINK_UNLOCK (lpsink);
       break;
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      GST_LP_SINK_LOCK (lpsink);
+      gst_lp_sink_lock_reusable_sinks (lpsink, lpsink->video_chains);
+      gst_lp_sink_lock_reusable_sinks (lpsink, lpsink->audio_chains);
+      GST_LP_SINK_UNLOCK (lpsink);
+      ret = GST_STATE_CHANGE_SUCCESS;
+      break;
     default:
       /* all other state changes return SUCCESS by default, this value can be
        * overridden by the result of the children */
@@ -1635,9 +2966,17 @@ gst_lp_sink_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PAUSED_TO_READY:{
       /* FIXME Release audio device when we implement that */
       lpsink->need_async_start = TRUE;
+      lpsink->expected_streams = -1;
       break;
     }
     case GST_STATE_CHANGE_READY_TO_NULL:
+      GST_LP_SINK_LOCK (lpsink);
+      if (lpsink->drift_monitor) {
+        gst_lp_drift_monitor_free (lpsink->drift_monitor);
+        lpsink->drift_monitor = NULL;
+      }
+      GST_LP_SINK_UNLOCK (lpsink);
+
       gst_lp_sink_release_pad (lpsink, lpsink->audio_pad);
       gst_lp_sink_release_pad (lpsink, lpsink->video_pad);
       gst_lp_sink_release_pad (lpsink, lpsink->text_pad);
@@ -1674,18 +3013,12 @@ gst_lp_sink_change_state (GstElement * element, GstStateChange transition)
           } else {
             gst_ghost_pad_set_target (GST_GHOST_PAD_CAST (chain->bin_ghostpad),
                 NULL);
-            gst_element_unlink (chain->queue, chain->sink);
+            gst_lp_sink_unlink_chain_sink (chain);
           }
           activate_chain (chain, FALSE);
           add_chain (chain, FALSE);
 
-          gst_bin_remove (chain->bin, chain->sink);
-
-          if (chain->sink != NULL) {
-            gst_element_set_state (chain->sink, GST_STATE_NULL);
-            gst_bin_remove (chain->bin, chain->sink);
-            chain->sink = NULL;
-          }
+          gst_lp_sink_release_chain_sink (lpsink, chain);
 
           free_chain ((GstSinkChain *) chain);
 
@@ -1712,13 +3045,7 @@ gst_lp_sink_change_state (GstElement * element, GstStateChange transition)
           activate_chain (chain, FALSE);
           add_chain (chain, FALSE);
 
-          gst_bin_remove (chain->bin, chain->sink);
-
-          if (chain->sink != NULL) {
-            gst_element_set_state (chain->sink, GST_STATE_NULL);
-            gst_bin_remove (chain->bin, chain->sink);
-            chain->sink = NULL;
-          }
+          gst_lp_sink_release_chain_sink (lpsink, chain);
 
           free_chain ((GstSinkChain *) chain);
 
@@ -1726,6 +3053,17 @@ gst_lp_sink_change_state (GstElement * element, GstStateChange transition)
         }
       }
 
+      /* the next session builds its chains, and takes the kept sinks, the
+       * same way as the first one */
+      g_list_free (lpsink->video_chains);
+      lpsink->video_chains = NULL;
+      g_list_free (lpsink->audio_chains);
+      lpsink->audio_chains = NULL;
+      lpsink->nb_video = lpsink->nb_audio = 0;
+      lpsink->nb_video_bin = lpsink->nb_audio_bin = 0;
+
+      gst_lp_arbiter_release_all (lpsink);
+
       if (lpsink->text_chains) {
         GList *walk = lpsink->text_chains;
 
@@ -24,6 +24,7 @@
 #define __GST_LP_SINK_H__
 
 #include <gst/gst.h>
+#include "gstlpdrift.h"
 
 G_BEGIN_DECLS
 #define GST_TYPE_LP_SINK (gst_lp_sink_get_type())
@@ -101,6 +102,49 @@ struct _GstLpSink
   guint nb_audio;
 
   gboolean query_smart_prop;
+
+  /* let the streamid demuxers hand chains of finished streams over */
+  gboolean recycle_streams;
+  guint64 stream_idle_timeout;
+
+  /* sinks kept open in READY across sessions, by factory and resource */
+  gboolean reuse_sinks;
+  GHashTable *sink_pool;
+
+  /* flushing seeks run from seek_thread, only the latest pending one */
+  gboolean seek_coalescing;
+  GMutex seek_lock;
+  GCond seek_cond;
+  GThread *seek_thread;
+  gboolean seek_thread_running;
+  GstEvent *pending_seek;
+  gint64 pending_seek_time;     /* monotonic time the seek was requested */
+  guint pending_seek_coalesced; /* seeks replaced by the pending one */
+
+  /* decoder channels come from the process-wide arbiter */
+  gboolean resource_arbitration;
+  gint resource_priority;
+  guint64 resource_timeout;
+  GArray *resource_requests;    /* granted for the chains being built */
+
+  /* watches the lead of audio over video at the sink queues */
+  gboolean drift_monitor_enabled;
+  guint64 drift_target;
+  GstLpDriftMonitor *drift_monitor;
+
+  /* sink factory names or launch snippets replacing vdecsink/adecsink */
+  gchar *video_sink_desc;
+  gchar *audio_sink_desc;
+
+  /* chains are built as soon as expected_streams streams are blocked */
+  gboolean single_phase;
+  gint expected_streams;        /* -1 until the parent tells */
+  gint64 configure_start;       /* monotonic time of READY_TO_PAUSED */
+  gboolean configuring;         /* a thread is building the chains */
+
+  /* passed on to the text sink bin */
+  gboolean text_pull_mode;
+  guint text_max_cues;
 };
 
 struct _GstLpSinkClass
@@ -108,6 +152,8 @@ struct _GstLpSinkClass
   GstBinClass parent_class;
   void (*pad_blocked) (GstLpSink * lpsink, gchar * steram_id, gboolean blocked);
   gboolean *(*unblock_sinkpads) (GstLpSink * lpsink);
+  GPtrArray *(*pull_text_cues) (GstLpSink * lpsink, gint stream,
+      guint64 start, guint64 stop);
 };
 
 typedef enum
@@ -176,6 +222,7 @@ void gst_lp_sink_set_interleaving_type (GstLpSink * lpsink,
 
 gboolean gst_lp_sink_reconfigure (GstLpSink * lpsink);
 void gst_lp_sink_set_all_pads_blocked (GstLpSink * lpsink);
+void gst_lp_sink_set_expected_streams (GstLpSink * lpsink, gint n_streams);
 void gst_lp_sink_release_pad (GstLpSink * lpsink, GstPad * pad);
 
 G_END_DECLS
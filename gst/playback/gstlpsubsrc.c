@@ -0,0 +1,801 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-lpsubsrc
+ *
+ * Reads an external SubRip (.srt) or SubStation Alpha (.ass, .ssa) subtitle
+ * file and pushes one text/x-raw buffer per cue.
+ *
+ * The file is memory-mapped and scanned once when the element starts. The
+ * scan only records the timing of every cue and where its text lies in the
+ * file, so a seek is a binary search over that table and the text of a cue
+ * is never copied unless ASS override tags have to be stripped from it.
+ *
+ * Nothing downstream paces a file source, so with #GstLpSubSrc:sync the
+ * cues are pushed against the clock: the first one after a start or a
+ * seek goes out right away for the preroll, every later one waits until
+ * the running time is #GstLpSubSrc:lead before its start.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "gstlpsubsrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_lp_sub_src_debug);
+#define GST_CAT_DEFAULT gst_lp_sub_src_debug
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("text/x-raw, format = (string) utf8"));
+
+#define DEFAULT_SYNC TRUE
+#define DEFAULT_LEAD GST_SECOND
+
+/* props */
+enum
+{
+  PROP_0,
+  PROP_LOCATION,
+  PROP_SYNC,
+  PROP_LEAD,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GstClockTime start;
+  GstClockTime stop;
+  guint32 offset;               /* text of the cue in the mapped file */
+  guint32 size;
+} GstLpSubCue;
+
+static void gst_lp_sub_src_finalize (GObject * object);
+static void gst_lp_sub_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * spec);
+static void gst_lp_sub_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * spec);
+
+static gboolean gst_lp_sub_src_start (GstBaseSrc * bsrc);
+static gboolean gst_lp_sub_src_stop (GstBaseSrc * bsrc);
+static gboolean gst_lp_sub_src_is_seekable (GstBaseSrc * bsrc);
+static gboolean gst_lp_sub_src_do_seek (GstBaseSrc * bsrc,
+    GstSegment * segment);
+static gboolean gst_lp_sub_src_query (GstBaseSrc * bsrc, GstQuery * query);
+static gboolean gst_lp_sub_src_unlock (GstBaseSrc * bsrc);
+static gboolean gst_lp_sub_src_unlock_stop (GstBaseSrc * bsrc);
+static GstStateChangeReturn gst_lp_sub_src_change_state (GstElement *
+    element, GstStateChange transition);
+static GstFlowReturn gst_lp_sub_src_create (GstBaseSrc * bsrc,
+    guint64 offset, guint size, GstBuffer ** buf);
+
+G_DEFINE_TYPE (GstLpSubSrc, gst_lp_sub_src, GST_TYPE_BASE_SRC);
+
+#define parent_class gst_lp_sub_src_parent_class
+
+static void
+gst_lp_sub_src_class_init (GstLpSubSrcClass * klass)
+{
+  GObjectClass *gobject_klass;
+  GstElementClass *gstelement_klass;
+  GstBaseSrcClass *gstbasesrc_klass;
+
+  gobject_klass = (GObjectClass *) klass;
+  gstelement_klass = (GstElementClass *) klass;
+  gstbasesrc_klass = (GstBaseSrcClass *) klass;
+
+  gobject_klass->finalize = gst_lp_sub_src_finalize;
+  gobject_klass->set_property = gst_lp_sub_src_set_property;
+  gobject_klass->get_property = gst_lp_sub_src_get_property;
+
+  /**
+   * GstLpSubSrc:location:
+   *
+   * Path of the subtitle file. The format is guessed from the content.
+   */
+  g_object_class_install_property (gobject_klass, PROP_LOCATION,
+      g_param_spec_string ("location", "Location",
+          "Path of the subtitle file", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSubSrc:sync:
+   *
+   * Push every cue but the first one only when the running time gets to
+   * #GstLpSubSrc:lead before its start, instead of as fast as downstream
+   * takes them.
+   */
+  g_object_class_install_property (gobject_klass, PROP_SYNC,
+      g_param_spec_boolean ("sync", "Sync",
+          "Push the cues against the clock", DEFAULT_SYNC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpSubSrc:lead:
+   *
+   * How long in nanoseconds before its start a cue is pushed with
+   * #GstLpSubSrc:sync.
+   */
+  g_object_class_install_property (gobject_klass, PROP_LEAD,
+      g_param_spec_uint64 ("lead", "Lead",
+          "How early cues are pushed with sync (in ns)", 0, G_MAXUINT64,
+          DEFAULT_LEAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_klass,
+      gst_static_pad_template_get (&src_template));
+
+  gst_element_class_set_static_metadata (gstelement_klass,
+      "Lightweight Subtitle Source", "Source/Subtitle",
+      "Read cues from an indexed external subtitle file",
+      "Jeongseok Kim <jeongseok.kim@lge.com>");
+
+  gstelement_klass->change_state =
+      GST_DEBUG_FUNCPTR (gst_lp_sub_src_change_state);
+
+  gstbasesrc_klass->start = GST_DEBUG_FUNCPTR (gst_lp_sub_src_start);
+  gstbasesrc_klass->stop = GST_DEBUG_FUNCPTR (gst_lp_sub_src_stop);
+  gstbasesrc_klass->is_seekable =
+      GST_DEBUG_FUNCPTR (gst_lp_sub_src_is_seekable);
+  gstbasesrc_klass->do_seek = GST_DEBUG_FUNCPTR (gst_lp_sub_src_do_seek);
+  gstbasesrc_klass->query = GST_DEBUG_FUNCPTR (gst_lp_sub_src_query);
+  gstbasesrc_klass->unlock = GST_DEBUG_FUNCPTR (gst_lp_sub_src_unlock);
+  gstbasesrc_klass->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_lp_sub_src_unlock_stop);
+  gstbasesrc_klass->create = GST_DEBUG_FUNCPTR (gst_lp_sub_src_create);
+}
+
+static void
+gst_lp_sub_src_init (GstLpSubSrc * self)
+{
+  GST_DEBUG_CATEGORY_INIT (gst_lp_sub_src_debug, "lpsubsrc", 0,
+      "Lightweight Subtitle Source");
+
+  self->location = NULL;
+  self->file = NULL;
+  self->format = GST_LP_SUB_FORMAT_UNKNOWN;
+  self->cues = NULL;
+  self->max_stop = NULL;
+  self->cur = 0;
+  self->duration = GST_CLOCK_TIME_NONE;
+
+  self->sync = DEFAULT_SYNC;
+  self->lead = DEFAULT_LEAD;
+  g_cond_init (&self->cond);
+  self->clock_id = NULL;
+  self->playing = FALSE;
+  self->flushing = FALSE;
+  self->preroll = TRUE;
+
+  gst_base_src_set_format (GST_BASE_SRC (self), GST_FORMAT_TIME);
+}
+
+static void
+gst_lp_sub_src_finalize (GObject * object)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (object);
+
+  g_free (self->location);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_lp_sub_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      GST_OBJECT_LOCK (self);
+      g_free (self->location);
+      self->location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SYNC:
+      GST_OBJECT_LOCK (self);
+      self->sync = g_value_get_boolean (value);
+      g_cond_broadcast (&self->cond);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_LEAD:
+      GST_OBJECT_LOCK (self);
+      self->lead = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_lp_sub_src_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (object);
+
+  switch (prop_id) {
+    case PROP_LOCATION:
+      GST_OBJECT_LOCK (self);
+      g_value_set_string (value, self->location);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_SYNC:
+      GST_OBJECT_LOCK (self);
+      g_value_set_boolean (value, self->sync);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_LEAD:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->lead);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* returns the end of the line starting at @p without its line break, and
+ * the start of the following line in @next */
+static const gchar *
+line_end (const gchar * p, const gchar * end, const gchar ** next)
+{
+  const gchar *eol = memchr (p, '\n', end - p);
+
+  if (eol == NULL) {
+    eol = *next = end;
+  } else {
+    *next = eol + 1;
+  }
+
+  if (eol > p && eol[-1] == '\r')
+    eol--;
+
+  return eol;
+}
+
+static gboolean
+parse_srt_times (const gchar * line, gsize len, GstClockTime * start,
+    GstClockTime * stop)
+{
+  gchar buf[64];
+  guint h1, m1, s1, ms1, h2, m2, s2, ms2;
+
+  len = MIN (len, sizeof (buf) - 1);
+  memcpy (buf, line, len);
+  buf[len] = '\0';
+
+  if (sscanf (buf, "%u:%u:%u%*1[,.]%u --> %u:%u:%u%*1[,.]%u",
+          &h1, &m1, &s1, &ms1, &h2, &m2, &s2, &ms2) != 8)
+    return FALSE;
+
+  *start = ((h1 * 60 + m1) * 60 + s1) * GST_SECOND + ms1 * GST_MSECOND;
+  *stop = ((h2 * 60 + m2) * 60 + s2) * GST_SECOND + ms2 * GST_MSECOND;
+
+  return TRUE;
+}
+
+static gboolean
+parse_ass_time (const gchar * field, gsize len, GstClockTime * time)
+{
+  gchar buf[32];
+  guint h, m, s, cs;
+
+  len = MIN (len, sizeof (buf) - 1);
+  memcpy (buf, field, len);
+  buf[len] = '\0';
+
+  if (sscanf (buf, "%u:%u:%u.%u", &h, &m, &s, &cs) != 4)
+    return FALSE;
+
+  *time = ((h * 60 + m) * 60 + s) * GST_SECOND + cs * 10 * GST_MSECOND;
+
+  return TRUE;
+}
+
+static void
+add_cue (GstLpSubSrc * self, const gchar * base, GstClockTime start,
+    GstClockTime stop, const gchar * text, const gchar * text_end)
+{
+  GstLpSubCue cue;
+
+  if (text_end <= text || stop < start)
+    return;
+
+  cue.start = start;
+  cue.stop = stop;
+  cue.offset = text - base;
+  cue.size = text_end - text;
+  g_array_append_val (self->cues, cue);
+}
+
+/* index  \n  start --> stop  \n  text lines  \n  blank line */
+static void
+index_srt (GstLpSubSrc * self, const gchar * base, const gchar * p,
+    const gchar * end)
+{
+  const gchar *eol, *next, *text, *text_end;
+  GstClockTime start, stop;
+
+  while (p < end) {
+    eol = line_end (p, end, &next);
+
+    if (!g_strstr_len (p, eol - p, "-->")
+        || !parse_srt_times (p, eol - p, &start, &stop)) {
+      p = next;
+      continue;
+    }
+
+    /* the text runs up to the next blank line */
+    text = text_end = p = next;
+    while (p < end) {
+      eol = line_end (p, end, &next);
+      if (eol == p)
+        break;
+      text_end = eol;
+      p = next;
+    }
+
+    add_cue (self, base, start, stop, text, text_end);
+  }
+}
+
+/* Dialogue: Layer,Start,End,Style,Name,MarginL,MarginR,MarginV,Effect,Text */
+static void
+index_ass (GstLpSubSrc * self, const gchar * base, const gchar * p,
+    const gchar * end)
+{
+  const gchar *eol, *next, *q;
+  const gchar *field[10];
+  GstClockTime start, stop;
+  gint n;
+
+  for (; p < end; p = next) {
+    eol = line_end (p, end, &next);
+
+    if (eol - p < 9 || strncmp (p, "Dialogue:", 9) != 0)
+      continue;
+
+    n = 0;
+    field[0] = p + 9;
+    for (q = field[0]; q < eol && n < 9; q++) {
+      if (*q == ',')
+        field[++n] = q + 1;
+    }
+    if (n < 9)
+      continue;
+
+    if (!parse_ass_time (field[1], field[2] - field[1] - 1, &start)
+        || !parse_ass_time (field[2], field[3] - field[2] - 1, &stop))
+      continue;
+
+    add_cue (self, base, start, stop, field[9], eol);
+  }
+}
+
+static gint
+compare_cues (gconstpointer a, gconstpointer b)
+{
+  const GstLpSubCue *ca = a, *cb = b;
+
+  if (ca->start != cb->start)
+    return ca->start < cb->start ? -1 : 1;
+  if (ca->stop != cb->stop)
+    return ca->stop < cb->stop ? -1 : 1;
+
+  return 0;
+}
+
+static gboolean
+gst_lp_sub_src_start (GstBaseSrc * bsrc)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+  GError *err = NULL;
+  const gchar *base, *data, *end;
+  gchar *location;
+  gsize size;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  location = g_strdup (self->location);
+  GST_OBJECT_UNLOCK (self);
+
+  if (location == NULL)
+    goto no_location;
+
+  self->file = g_mapped_file_new (location, FALSE, &err);
+  if (self->file == NULL)
+    goto open_failed;
+
+  size = g_mapped_file_get_length (self->file);
+  if (size > G_MAXUINT32)
+    goto too_big;
+
+  self->cues = g_array_new (FALSE, FALSE, sizeof (GstLpSubCue));
+  self->format = GST_LP_SUB_FORMAT_UNKNOWN;
+
+  /* an empty file maps to NULL */
+  base = data = g_mapped_file_get_contents (self->file);
+  if (data) {
+    end = data + size;
+    if (size >= 3 && memcmp (data, "\xef\xbb\xbf", 3) == 0)
+      data += 3;
+
+    if (g_strstr_len (data, MIN (end - data, 4096), "[Script Info]")) {
+      self->format = GST_LP_SUB_FORMAT_ASS;
+      index_ass (self, base, data, end);
+    } else {
+      self->format = GST_LP_SUB_FORMAT_SRT;
+      index_srt (self, base, data, end);
+    }
+  }
+
+  /* SRT is usually in order already, ASS events need not be */
+  g_array_sort (self->cues, compare_cues);
+
+  /* a long cue can still be on screen after later ones ended, so seeking
+   * looks at the latest stop so far rather than at the previous cue */
+  self->duration = 0;
+  self->max_stop = g_new (GstClockTime, MAX (self->cues->len, 1));
+  for (i = 0; i < self->cues->len; i++) {
+    self->duration = MAX (self->duration,
+        g_array_index (self->cues, GstLpSubCue, i).stop);
+    self->max_stop[i] = self->duration;
+  }
+  self->cur = 0;
+  self->preroll = TRUE;
+
+  GST_INFO_OBJECT (self, "indexed %u %s cues of %s, duration %"
+      GST_TIME_FORMAT, self->cues->len,
+      self->format == GST_LP_SUB_FORMAT_ASS ? "ass" : "srt", location,
+      GST_TIME_ARGS (self->duration));
+
+  g_free (location);
+
+  return TRUE;
+
+no_location:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, NOT_FOUND, (NULL),
+        ("No subtitle file given"));
+    return FALSE;
+  }
+open_failed:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_READ, (NULL),
+        ("Could not map %s: %s", location, err->message));
+    g_clear_error (&err);
+    g_free (location);
+    return FALSE;
+  }
+too_big:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, READ, (NULL),
+        ("%s is too big for a subtitle file", location));
+    g_mapped_file_unref (self->file);
+    self->file = NULL;
+    g_free (location);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_lp_sub_src_stop (GstBaseSrc * bsrc)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+
+  if (self->cues) {
+    g_array_free (self->cues, TRUE);
+    self->cues = NULL;
+  }
+  g_free (self->max_stop);
+  self->max_stop = NULL;
+
+  /* buffers still out keep their own reference on the mapping */
+  if (self->file) {
+    g_mapped_file_unref (self->file);
+    self->file = NULL;
+  }
+
+  self->cur = 0;
+  self->duration = GST_CLOCK_TIME_NONE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_lp_sub_src_is_seekable (GstBaseSrc * bsrc)
+{
+  return TRUE;
+}
+
+static gboolean
+gst_lp_sub_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+  GstClockTime target = segment->start;
+  guint lo = 0, hi, mid;
+
+  segment->time = segment->start;
+  segment->position = segment->start;
+
+  if (self->cues == NULL)
+    return TRUE;
+
+  hi = self->cues->len;
+
+  /* first cue from which on one may still be on screen at the target,
+   * create skips the ones in between that already ended */
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    if (self->max_stop[mid] <= target)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  GST_DEBUG_OBJECT (self, "seek to %" GST_TIME_FORMAT ", cue %u of %u",
+      GST_TIME_ARGS (target), lo, self->cues->len);
+
+  self->cur = lo;
+  self->preroll = TRUE;
+
+  return TRUE;
+}
+
+static gboolean
+gst_lp_sub_src_unlock (GstBaseSrc * bsrc)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+
+  GST_OBJECT_LOCK (self);
+  self->flushing = TRUE;
+  if (self->clock_id)
+    gst_clock_id_unschedule (self->clock_id);
+  g_cond_broadcast (&self->cond);
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static gboolean
+gst_lp_sub_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+
+  GST_OBJECT_LOCK (self);
+  self->flushing = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  return TRUE;
+}
+
+static GstStateChangeReturn
+gst_lp_sub_src_change_state (GstElement * element, GstStateChange transition)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (element);
+
+  /* a wait started in PLAYING is done again against the next base time */
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
+      GST_OBJECT_LOCK (self);
+      self->playing = TRUE;
+      g_cond_broadcast (&self->cond);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+      GST_OBJECT_LOCK (self);
+      self->playing = FALSE;
+      if (self->clock_id)
+        gst_clock_id_unschedule (self->clock_id);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      break;
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+}
+
+/* waits until the running time is the lead before @timestamp, in PLAYING
+ * only */
+static GstFlowReturn
+gst_lp_sub_src_wait (GstLpSubSrc * self, GstClockTime timestamp)
+{
+  GstSegment *segment = &GST_BASE_SRC_CAST (self)->segment;
+  GstClockTime running_time;
+  GstClockReturn cret;
+  GstClockID id;
+  GstClock *clock;
+
+  running_time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+      timestamp);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return GST_FLOW_OK;
+
+  GST_OBJECT_LOCK (self);
+  running_time = running_time > self->lead ? running_time - self->lead : 0;
+
+  while (self->sync && !self->flushing) {
+    if (!self->playing) {
+      g_cond_wait (&self->cond, GST_OBJECT_GET_LOCK (self));
+      continue;
+    }
+
+    if ((clock = GST_ELEMENT_CLOCK (self)) == NULL)
+      break;
+
+    id = gst_clock_new_single_shot_id (clock,
+        running_time + GST_ELEMENT_CAST (self)->base_time);
+    self->clock_id = id;
+    GST_OBJECT_UNLOCK (self);
+
+    GST_LOG_OBJECT (self, "waiting for running time %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (running_time));
+    cret = gst_clock_id_wait (id, NULL);
+
+    GST_OBJECT_LOCK (self);
+    self->clock_id = NULL;
+    gst_clock_id_unref (id);
+
+    /* paused or flushing, look again */
+    if (cret != GST_CLOCK_UNSCHEDULED)
+      break;
+  }
+
+  if (self->flushing) {
+    GST_OBJECT_UNLOCK (self);
+    return GST_FLOW_FLUSHING;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_lp_sub_src_query (GstBaseSrc * bsrc, GstQuery * query)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_DURATION) {
+    GstFormat format;
+    GstClockTime duration = self->duration;
+
+    gst_query_parse_duration (query, &format, NULL);
+    if (format == GST_FORMAT_TIME && GST_CLOCK_TIME_IS_VALID (duration)) {
+      gst_query_set_duration (query, format, duration);
+      return TRUE;
+    }
+  }
+
+  return GST_BASE_SRC_CLASS (parent_class)->query (bsrc, query);
+}
+
+/* drops {\override} blocks and turns \N, \n and \h into plain text */
+static GstBuffer *
+ass_cue_text (const gchar * text, gsize size)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gsize i, n = 0;
+  gint depth = 0;
+
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+
+  for (i = 0; i < size; i++) {
+    if (text[i] == '{') {
+      depth++;
+    } else if (text[i] == '}' && depth > 0) {
+      depth--;
+    } else if (depth > 0) {
+      continue;
+    } else if (text[i] == '\\' && i + 1 < size
+        && (text[i + 1] == 'N' || text[i + 1] == 'n')) {
+      map.data[n++] = '\n';
+      i++;
+    } else if (text[i] == '\\' && i + 1 < size && text[i + 1] == 'h') {
+      map.data[n++] = ' ';
+      i++;
+    } else {
+      map.data[n++] = text[i];
+    }
+  }
+
+  gst_buffer_unmap (buf, &map);
+  gst_buffer_set_size (buf, n);
+
+  return buf;
+}
+
+static GstFlowReturn
+gst_lp_sub_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
+    GstBuffer ** buf)
+{
+  GstLpSubSrc *self = GST_LP_SUB_SRC (bsrc);
+  GstSegment *segment = &bsrc->segment;
+  GstLpSubCue *cue;
+  const gchar *text;
+  GstBuffer *outbuf;
+
+  if (self->cues == NULL)
+    goto eos;
+
+  /* cues that ended before the segment, left over from a seek */
+  while (self->cur < self->cues->len) {
+    cue = &g_array_index (self->cues, GstLpSubCue, self->cur);
+    if (cue->start >= segment->start || cue->stop > segment->start)
+      break;
+    self->cur++;
+  }
+
+  if (self->cur >= self->cues->len)
+    goto eos;
+
+  cue = &g_array_index (self->cues, GstLpSubCue, self->cur);
+  if (GST_CLOCK_TIME_IS_VALID (segment->stop) && cue->start >= segment->stop)
+    goto eos;
+
+  if (self->preroll) {
+    self->preroll = FALSE;
+  } else {
+    GstFlowReturn ret = gst_lp_sub_src_wait (self, MAX (cue->start,
+            segment->start));
+
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  text = g_mapped_file_get_contents (self->file) + cue->offset;
+
+  if (self->format == GST_LP_SUB_FORMAT_ASS
+      && (memchr (text, '{', cue->size) || memchr (text, '\\', cue->size))) {
+    outbuf = ass_cue_text (text, cue->size);
+  } else {
+    outbuf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+        (gpointer) text, cue->size, 0, cue->size,
+        g_mapped_file_ref (self->file), (GDestroyNotify) g_mapped_file_unref);
+  }
+
+  GST_BUFFER_PTS (outbuf) = cue->start;
+  GST_BUFFER_DURATION (outbuf) = cue->stop - cue->start;
+
+  GST_LOG_OBJECT (self, "cue %u %" GST_TIME_FORMAT " - %" GST_TIME_FORMAT,
+      self->cur, GST_TIME_ARGS (cue->start), GST_TIME_ARGS (cue->stop));
+
+  self->cur++;
+  *buf = outbuf;
+
+  return GST_FLOW_OK;
+
+eos:
+  {
+    GST_DEBUG_OBJECT (self, "no more cues");
+    return GST_FLOW_EOS;
+  }
+}
@@ -0,0 +1,76 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2013-2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_LP_SUB_SRC_H__
+#define __GST_LP_SUB_SRC_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesrc.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_LP_SUB_SRC (gst_lp_sub_src_get_type())
+#define GST_LP_SUB_SRC(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_LP_SUB_SRC,GstLpSubSrc))
+#define GST_LP_SUB_SRC_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_LP_SUB_SRC,GstLpSubSrcClass))
+#define GST_IS_LP_SUB_SRC(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_LP_SUB_SRC))
+#define GST_IS_LP_SUB_SRC_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_LP_SUB_SRC))
+#define GST_LP_SUB_SRC_CAST(obj) ((GstLpSubSrc*)(obj))
+typedef struct _GstLpSubSrc GstLpSubSrc;
+typedef struct _GstLpSubSrcClass GstLpSubSrcClass;
+
+typedef enum
+{
+  GST_LP_SUB_FORMAT_UNKNOWN,
+  GST_LP_SUB_FORMAT_SRT,
+  GST_LP_SUB_FORMAT_ASS
+} GstLpSubFormat;
+
+struct _GstLpSubSrc
+{
+  GstBaseSrc parent;
+
+  gchar *location;
+
+  GMappedFile *file;
+  GstLpSubFormat format;
+  GArray *cues;                 /* GstLpSubCue sorted by start */
+  GstClockTime *max_stop;       /* latest stop of the cues up to each one */
+  guint cur;                    /* next cue to push */
+  GstClockTime duration;        /* end of the last cue */
+
+  /* pacing, with the object lock */
+  gboolean sync;
+  GstClockTime lead;
+  GCond cond;                   /* signalled when going to PLAYING */
+  GstClockID clock_id;
+  gboolean playing;
+  gboolean flushing;
+  gboolean preroll;             /* next cue goes out without waiting */
+};
+
+struct _GstLpSubSrcClass
+{
+  GstBaseSrcClass parent_class;
+};
+
+GType gst_lp_sub_src_get_type (void);
+
+G_END_DECLS
+#endif // __GST_LP_SUB_SRC_H__
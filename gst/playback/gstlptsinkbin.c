@@ -35,14 +35,34 @@ GST_STATIC_PAD_TEMPLATE ("text_sink%d",
     GST_PAD_REQUEST,
     GST_STATIC_CAPS_ANY);
 
+/* signals */
+enum
+{
+  SIGNAL_PULL_CUES,
+  LAST_SIGNAL
+};
+
 /* props */
 enum
 {
   PROP_0,
+  PROP_PULL_MODE,
+  PROP_MAX_CUES,
   PROP_LAST
 };
 
+static guint gst_lp_tsink_bin_signals[LAST_SIGNAL] = { 0 };
+
 #define DEFAULT_THUMBNAIL_MODE FALSE
+#define DEFAULT_PULL_MODE FALSE
+#define DEFAULT_MAX_CUES 64
+
+typedef struct
+{
+  GstSample *sample;
+  GstClockTime start;           /* stream time, NONE if unknown */
+  GstClockTime stop;
+} GstTextCue;
 
 static void gst_lp_tsink_bin_finalize (GObject * object);
 static void gst_lp_tsink_bin_set_property (GObject * object, guint prop_id,
@@ -57,8 +77,13 @@ static void gst_lp_tsink_bin_release_request_pad (GstElement * element,
 
 static gboolean activate_chain (GstElement * sink, GstTextGroup * tgoup,
     gboolean activate);
-static GstFlowReturn gst_lp_tsink_bin_new_sample (GstElement * sink);
+static GstFlowReturn gst_lp_tsink_bin_new_sample (GstElement * sink,
+    GstTextGroup * tgroup);
 static gboolean gst_lp_tsink_bin_query (GstElement * element, GstQuery * query);
+static gboolean gst_lp_tsink_bin_send_event (GstElement * element,
+    GstEvent * event);
+static GstStateChangeReturn gst_lp_tsink_bin_change_state (GstElement *
+    element, GstStateChange transition);
 
 G_DEFINE_TYPE (GstLpTSinkBin, gst_lp_tsink_bin, GST_TYPE_BIN);
 
@@ -77,6 +102,61 @@ gst_lp_tsink_bin_class_init (GstLpTSinkBinClass * klass)
   gobject_klass->set_property = gst_lp_tsink_bin_set_property;
   gobject_klass->get_property = gst_lp_tsink_bin_get_property;
 
+  /**
+   * GstLpTSinkBin:pull-mode:
+   *
+   * Keep the subtitle samples in a ring of #GstLpTSinkBin:max-cues cues
+   * per text stream, to be fetched with #GstLpTSinkBin::pull-cues, instead
+   * of posting every sample as a "subtitle_data" application message.
+   *
+   * When a stream gets its first cue since the last pull, an application
+   * message named "subtitle_cues" is posted with the fields "stream" (gint)
+   * and "dropped" (guint, cues lost so far). Nothing more is posted for
+   * that stream until it is pulled. Cues a pull leaves in the ring are not
+   * announced again, pull them when their window comes.
+   *
+   * The rings are emptied on flush, seek and PAUSED to READY.
+   */
+  g_object_class_install_property (gobject_klass, PROP_PULL_MODE,
+      g_param_spec_boolean ("pull-mode", "Pull mode",
+          "Keep subtitle cues for pull-cues instead of posting each of them",
+          DEFAULT_PULL_MODE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpTSinkBin:max-cues:
+   *
+   * Number of cues kept per text stream in #GstLpTSinkBin:pull-mode. When
+   * the ring is full, the oldest cue is dropped.
+   */
+  g_object_class_install_property (gobject_klass, PROP_MAX_CUES,
+      g_param_spec_uint ("max-cues", "Max cues",
+          "Number of cues kept per text stream in pull mode",
+          1, G_MAXUINT, DEFAULT_MAX_CUES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstLpTSinkBin::pull-cues:
+   * @lptsinkbin: a #GstLpTSinkBin
+   * @stream: the text stream, counted from 0 in pad request order
+   * @start: start of the window, in stream time
+   * @stop: end of the window, in stream time, or -1 for no end
+   *
+   * Take the cues of @stream overlapping [@start, @stop) out of the ring.
+   * Cues that ended before @start are discarded. The samples are not
+   * copied.
+   *
+   * Returns: (transfer full): a #GPtrArray of #GstSample, oldest first,
+   * or %NULL if there is no such stream. Unref it after use.
+   */
+  gst_lp_tsink_bin_signals[SIGNAL_PULL_CUES] =
+      g_signal_new ("pull-cues", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstLpTSinkBinClass, pull_cues), NULL, NULL,
+      g_cclosure_marshal_generic, G_TYPE_PTR_ARRAY, 3, G_TYPE_INT,
+      G_TYPE_UINT64, G_TYPE_UINT64);
+
+  klass->pull_cues = gst_lp_tsink_bin_pull_cues;
+
   gst_element_class_add_pad_template (gstelement_klass,
       gst_static_pad_template_get (&text_template));
 
@@ -90,6 +170,10 @@ gst_lp_tsink_bin_class_init (GstLpTSinkBinClass * klass)
   gstelement_klass->release_pad =
       GST_DEBUG_FUNCPTR (gst_lp_tsink_bin_release_request_pad);
   gstelement_klass->query = GST_DEBUG_FUNCPTR (gst_lp_tsink_bin_query);
+  gstelement_klass->send_event =
+      GST_DEBUG_FUNCPTR (gst_lp_tsink_bin_send_event);
+  gstelement_klass->change_state =
+      GST_DEBUG_FUNCPTR (gst_lp_tsink_bin_change_state);
 }
 
 static void
@@ -100,6 +184,65 @@ gst_lp_tsink_bin_init (GstLpTSinkBin * lptsinkbin)
   g_rec_mutex_init (&lptsinkbin->lock);
 
   lptsinkbin->sink_list = g_list_alloc ();
+
+  lptsinkbin->pull_mode = DEFAULT_PULL_MODE;
+  lptsinkbin->max_cues = DEFAULT_MAX_CUES;
+}
+
+static void
+free_cue (GstTextCue * cue)
+{
+  gst_sample_unref (cue->sample);
+  g_slice_free (GstTextCue, cue);
+}
+
+/* call with the lock */
+static void
+clear_cues (GstTextGroup * tgroup)
+{
+  if (!tgroup)
+    return;
+
+  g_queue_foreach (&tgroup->cues, (GFunc) free_cue, NULL);
+  g_queue_clear (&tgroup->cues);
+  tgroup->announced = FALSE;
+}
+
+static void
+free_text_group (GstTextGroup * tgroup)
+{
+  if (!tgroup)
+    return;
+
+  clear_cues (tgroup);
+  g_free (tgroup);
+}
+
+static void
+gst_lp_tsink_bin_clear_all_cues (GstLpTSinkBin * lptsinkbin)
+{
+  GST_DEBUG_OBJECT (lptsinkbin, "clearing the cue rings");
+
+  GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+  g_list_foreach (lptsinkbin->sink_list, (GFunc) clear_cues, NULL);
+  GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+}
+
+static GstPadProbeReturn
+appsink_flush_probe_cb (GstPad * pad, GstPadProbeInfo * info,
+    GstTextGroup * tgroup)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    GST_DEBUG_OBJECT (tgroup->bin, "flushed, clearing stream %d",
+        tgroup->index);
+    GST_LP_TSINK_BIN_LOCK (tgroup->bin);
+    clear_cues (tgroup);
+    GST_LP_TSINK_BIN_UNLOCK (tgroup->bin);
+  }
+
+  return GST_PAD_PROBE_OK;
 }
 
 static void
@@ -111,7 +254,7 @@ gst_lp_tsink_bin_finalize (GObject * obj)
 
   g_rec_mutex_clear (&lptsinkbin->lock);
 
-  g_list_free (lptsinkbin->sink_list);
+  g_list_free_full (lptsinkbin->sink_list, (GDestroyNotify) free_text_group);
 
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -125,6 +268,7 @@ gst_lp_tsink_bin_request_new_pad (GstElement * element, GstPadTemplate * templ,
   GstPad *pad;
   GstTextGroup *t_group;
   GstPad *queue_sinkpad;
+  GstPad *appsink_sinkpad;
 
   g_return_val_if_fail (templ != NULL, NULL);
   GST_DEBUG_OBJECT (element, "name: %s", name);
@@ -132,6 +276,8 @@ gst_lp_tsink_bin_request_new_pad (GstElement * element, GstPadTemplate * templ,
   lptsinkbin = GST_LP_TSINK_BIN (element);
 
   t_group = g_malloc0 (sizeof (GstTextGroup));
+  t_group->bin = lptsinkbin;
+  g_queue_init (&t_group->cues);
 
   t_group->queue = gst_element_factory_make ("queue", NULL);
   g_object_set (G_OBJECT (t_group->queue), "silent", TRUE, NULL);
@@ -149,7 +295,7 @@ gst_lp_tsink_bin_request_new_pad (GstElement * element, GstPadTemplate * templ,
   g_object_set (t_group->appsink, "emit-signals", TRUE, "sync", FALSE,
       "ts-offset", 1000 * 1000, NULL);
   g_signal_connect (t_group->appsink, "new-sample",
-      G_CALLBACK (gst_lp_tsink_bin_new_sample), NULL);
+      G_CALLBACK (gst_lp_tsink_bin_new_sample), t_group);
 
   /* disable async enable */
   g_object_set (t_group->appsink, "async", FALSE, NULL);
@@ -161,6 +307,11 @@ gst_lp_tsink_bin_request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   gst_element_link_pads (t_group->queue, "src", t_group->appsink, "sink");
 
+  appsink_sinkpad = gst_element_get_static_pad (t_group->appsink, "sink");
+  gst_pad_add_probe (appsink_sinkpad, GST_PAD_PROBE_TYPE_EVENT_FLUSH,
+      (GstPadProbeCallback) appsink_flush_probe_cb, t_group, NULL);
+  gst_object_unref (appsink_sinkpad);
+
   queue_sinkpad = gst_element_get_static_pad (t_group->queue, "sink");
   pad_name =
       g_strdup_printf ("text_sink%d", g_list_length (lptsinkbin->sink_list));
@@ -171,7 +322,11 @@ gst_lp_tsink_bin_request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   activate_chain (element, t_group, TRUE);
 
+  GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+  /* the list starts with an empty link */
+  t_group->index = g_list_length (lptsinkbin->sink_list) - 1;
   lptsinkbin->sink_list = g_list_append (lptsinkbin->sink_list, t_group);
+  GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
 
   return pad;
 
@@ -192,9 +347,19 @@ static void
 gst_lp_tsink_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * spec)
 {
-  //GstLpTSinkBin *lptsinkbin = GST_LP_TSINK_BIN (object);
+  GstLpTSinkBin *lptsinkbin = GST_LP_TSINK_BIN (object);
 
   switch (prop_id) {
+    case PROP_PULL_MODE:
+      GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+      lptsinkbin->pull_mode = g_value_get_boolean (value);
+      GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+      break;
+    case PROP_MAX_CUES:
+      GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+      lptsinkbin->max_cues = g_value_get_uint (value);
+      GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
@@ -205,8 +370,19 @@ static void
 gst_lp_tsink_bin_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * spec)
 {
-  //GstLpTSinkBin *lptsinkbin = GST_LP_TSINK_BIN (object);
+  GstLpTSinkBin *lptsinkbin = GST_LP_TSINK_BIN (object);
+
   switch (prop_id) {
+    case PROP_PULL_MODE:
+      GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+      g_value_set_boolean (value, lptsinkbin->pull_mode);
+      GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+      break;
+    case PROP_MAX_CUES:
+      GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+      g_value_set_uint (value, lptsinkbin->max_cues);
+      GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, spec);
       break;
@@ -235,11 +411,72 @@ activate_chain (GstElement * sink, GstTextGroup * tgroup, gboolean activate)
   return TRUE;
 }
 
+/* Takes ownership of @sample. Returns whether the app has to be woken up */
+static gboolean
+gst_lp_tsink_bin_queue_cue (GstLpTSinkBin * lptsinkbin, GstTextGroup * tgroup,
+    GstSample * sample)
+{
+  GstTextCue *cue = g_slice_new (GstTextCue);
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  GstSegment *segment = gst_sample_get_segment (sample);
+  gboolean wake_up;
+
+  cue->sample = sample;
+  cue->start = cue->stop = GST_CLOCK_TIME_NONE;
+
+  if (buffer && GST_BUFFER_PTS_IS_VALID (buffer)) {
+    if (segment && segment->format == GST_FORMAT_TIME)
+      cue->start = gst_segment_to_stream_time (segment, GST_FORMAT_TIME,
+          GST_BUFFER_PTS (buffer));
+    else
+      cue->start = GST_BUFFER_PTS (buffer);
+  }
+
+  cue->stop = cue->start;
+  if (GST_CLOCK_TIME_IS_VALID (cue->start)
+      && GST_BUFFER_DURATION_IS_VALID (buffer))
+    cue->stop += GST_BUFFER_DURATION (buffer);
+
+  GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+  wake_up = !tgroup->announced;
+  tgroup->announced = TRUE;
+
+  while (g_queue_get_length (&tgroup->cues) >= lptsinkbin->max_cues) {
+    free_cue (g_queue_pop_head (&tgroup->cues));
+    tgroup->dropped++;
+  }
+  g_queue_push_tail (&tgroup->cues, cue);
+  GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+
+  GST_LOG_OBJECT (lptsinkbin, "stream %d cue %" GST_TIME_FORMAT " - %"
+      GST_TIME_FORMAT, tgroup->index, GST_TIME_ARGS (cue->start),
+      GST_TIME_ARGS (cue->stop));
+
+  return wake_up;
+}
+
+static void
+gst_lp_tsink_bin_post_cues (GstLpTSinkBin * lptsinkbin, GstTextGroup * tgroup)
+{
+  GstStructure *structure;
+
+  GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+  structure = gst_structure_new ("subtitle_cues",
+      "stream", G_TYPE_INT, tgroup->index,
+      "dropped", G_TYPE_UINT, tgroup->dropped, NULL);
+  GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+
+  gst_element_post_message (GST_ELEMENT_CAST (lptsinkbin),
+      gst_message_new_application (GST_OBJECT_CAST (lptsinkbin), structure));
+}
+
 static GstFlowReturn
-gst_lp_tsink_bin_new_sample (GstElement * sink)
+gst_lp_tsink_bin_new_sample (GstElement * sink, GstTextGroup * tgroup)
 {
+  GstLpTSinkBin *lptsinkbin = tgroup->bin;
   GstSample *sample = NULL;
   GstStructure *structure;
+  gboolean pull_mode;
 
   g_signal_emit_by_name (sink, "pull-sample", &sample);
 
@@ -248,6 +485,16 @@ gst_lp_tsink_bin_new_sample (GstElement * sink)
     return GST_FLOW_CUSTOM_ERROR;
   }
 
+  GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+  pull_mode = lptsinkbin->pull_mode;
+  GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+
+  if (pull_mode) {
+    if (gst_lp_tsink_bin_queue_cue (lptsinkbin, tgroup, sample))
+      gst_lp_tsink_bin_post_cues (lptsinkbin, tgroup);
+    return GST_FLOW_OK;
+  }
+
   structure =
       gst_structure_new ("subtitle_data", "sample", GST_TYPE_SAMPLE,
       sample, NULL);
@@ -255,11 +502,86 @@ gst_lp_tsink_bin_new_sample (GstElement * sink)
   gst_element_post_message (sink,
       gst_message_new_application (GST_OBJECT_CAST (sink), structure));
 
-  //gst_sample_unref (sample);
+  gst_sample_unref (sample);
 
   return GST_FLOW_OK;
 }
 
+/**
+ * gst_lp_tsink_bin_pull_cues:
+ * @lptsinkbin: a #GstLpTSinkBin
+ * @stream: the text stream, counted from 0 in pad request order
+ * @start: start of the window, in stream time
+ * @stop: end of the window, in stream time, or %GST_CLOCK_TIME_NONE
+ *
+ * See #GstLpTSinkBin::pull-cues.
+ *
+ * Returns: (transfer full): a #GPtrArray of #GstSample or %NULL.
+ */
+GPtrArray *
+gst_lp_tsink_bin_pull_cues (GstLpTSinkBin * lptsinkbin, gint stream,
+    GstClockTime start, GstClockTime stop)
+{
+  GstTextGroup *tgroup = NULL;
+  GPtrArray *res;
+  GList *walk, *next;
+
+  g_return_val_if_fail (GST_IS_LP_TSINK_BIN (lptsinkbin), NULL);
+
+  GST_LP_TSINK_BIN_LOCK (lptsinkbin);
+  for (walk = lptsinkbin->sink_list; walk; walk = walk->next) {
+    GstTextGroup *group = walk->data;
+
+    if (group && group->index == stream) {
+      tgroup = group;
+      break;
+    }
+  }
+
+  if (!tgroup) {
+    GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+    GST_WARNING_OBJECT (lptsinkbin, "no text stream %d", stream);
+    return NULL;
+  }
+
+  res = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_sample_unref);
+
+  for (walk = tgroup->cues.head; walk; walk = next) {
+    GstTextCue *cue = walk->data;
+    gboolean take = FALSE, drop = FALSE;
+
+    next = walk->next;
+
+    /* untimed cues always go out, cues over before the window are stale */
+    if (!GST_CLOCK_TIME_IS_VALID (cue->start))
+      take = TRUE;
+    else if (GST_CLOCK_TIME_IS_VALID (start) && cue->stop < start)
+      drop = TRUE;
+    else if (!GST_CLOCK_TIME_IS_VALID (stop) || cue->start < stop)
+      take = TRUE;
+
+    if (!take && !drop)
+      continue;
+
+    if (take)
+      g_ptr_array_add (res, gst_sample_ref (cue->sample));
+    else
+      tgroup->dropped++;
+
+    g_queue_delete_link (&tgroup->cues, walk);
+    free_cue (cue);
+  }
+  /* the next queued cue wakes the app up again */
+  tgroup->announced = FALSE;
+  GST_LP_TSINK_BIN_UNLOCK (lptsinkbin);
+
+  GST_DEBUG_OBJECT (lptsinkbin, "pulled %u cues of stream %d for %"
+      GST_TIME_FORMAT " - %" GST_TIME_FORMAT, res->len, stream,
+      GST_TIME_ARGS (start), GST_TIME_ARGS (stop));
+
+  return res;
+}
+
 
 static gboolean
 gst_lp_tsink_bin_query (GstElement * element, GstQuery * query)
@@ -277,3 +599,30 @@ gst_lp_tsink_bin_query (GstElement * element, GstQuery * query)
 
   return ret;
 }
+
+static gboolean
+gst_lp_tsink_bin_send_event (GstElement * element, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK)
+    gst_lp_tsink_bin_clear_all_cues (GST_LP_TSINK_BIN (element));
+
+  return GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
+}
+
+static GstStateChangeReturn
+gst_lp_tsink_bin_change_state (GstElement * element, GstStateChange transition)
+{
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_lp_tsink_bin_clear_all_cues (GST_LP_TSINK_BIN (element));
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
@@ -42,8 +42,14 @@ typedef struct _GstLpTSinkBinClass GstLpTSinkBinClass;
 
 struct _GstTextGroup
 {
+  GstLpTSinkBin *bin;
   GstElement *appsink;
   GstElement *queue;
+
+  gint index;                   /* text stream number, from 0 */
+  GQueue cues;                  /* GstTextCue not pulled yet, oldest first */
+  guint dropped;                /* cues overwritten or stale */
+  gboolean announced;           /* posted, not pulled since */
 };
 
 struct _GstLpTSinkBin
@@ -53,14 +59,23 @@ struct _GstLpTSinkBin
   GRecMutex lock;               /* to protect group switching */
 
   GList *sink_list;
+
+  gboolean pull_mode;
+  guint max_cues;
 };
 
 struct _GstLpTSinkBinClass
 {
   GstBinClass parent_class;
+
+  GPtrArray *(*pull_cues) (GstLpTSinkBin * lptsinkbin, gint stream,
+      guint64 start, guint64 stop);
 };
 
 GType gst_lp_tsink_bin_get_type (void);
 
+GPtrArray *gst_lp_tsink_bin_pull_cues (GstLpTSinkBin * lptsinkbin, gint stream,
+    GstClockTime start, GstClockTime stop);
+
 G_END_DECLS
 #endif // __GST_LP_TSINK_BIN_H__
@@ -0,0 +1,268 @@
+/* GStreamer lpbin preroll benchmark
+ *
+ * Copyright 2014 LG Electronics, Inc.
+ *
+ * preroll.c: measure how long lpbin takes to preroll a uri
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * Brings lpbin from NULL to PAUSED on the given uri a number of times, with
+ * the two-phase stream negotiation and with lpbin's single-phase property,
+ * and reports for both:
+ *
+ *   configured  time from READY_TO_PAUSED of lpsink until its chains were
+ *               built, from the "lpsink-configured" message
+ *   preroll     time from the state change until the pipeline posted
+ *               ASYNC_DONE
+ *
+ * Run it from the build tree so that the lp plugins are found, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst ./preroll -n 20 file:///media/a.ts
+ * --thumbnail sets the thumbnail-mode smart property, so that lpsink uses
+ * fakesinks and the benchmark also runs without the device sinks.
+ * --video-sink and --audio-sink replace vdecsink and adecsink, e.g.
+ *   ./preroll --video-sink="fakesink sync=true" --audio-sink=fakesink URI
+ * Adding $(top_builddir)/tests/plugins/.libs to GST_PLUGIN_PATH provides
+ * emulated vdecsink and adecsink, so lpsink builds its device chains
+ * without any --video-sink or --audio-sink, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst:$(top_builddir)/tests/plugins/.libs \
+ *       ./preroll URI
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/gst.h>
+
+#define DEFAULT_ITERATIONS 10
+#define DEFAULT_TIMEOUT 10
+
+static gchar *video_sink_desc = NULL;
+static gchar *audio_sink_desc = NULL;
+
+typedef struct
+{
+  guint runs;
+  guint configured_runs;        /* runs that reported lpsink-configured */
+  guint failures;
+  GstClockTime configured_sum, configured_min, configured_max;
+  GstClockTime preroll_sum, preroll_min, preroll_max;
+} Stats;
+
+static void
+stats_add (GstClockTime * sum, GstClockTime * min, GstClockTime * max,
+    GstClockTime value)
+{
+  *sum += value;
+  *min = MIN (*min, value);
+  *max = MAX (*max, value);
+}
+
+static gboolean
+preroll_once (const gchar * uri, gboolean single_phase, gboolean thumbnail,
+    gint timeout, Stats * stats)
+{
+  GstElement *lpbin;
+  GstBus *bus;
+  GstMessage *msg;
+  GstClockTime configured = GST_CLOCK_TIME_NONE, preroll = 0;
+  gint64 start, deadline;
+  gboolean done = FALSE, res = FALSE;
+
+  lpbin = gst_element_factory_make ("lpbin", NULL);
+  if (!lpbin) {
+    g_printerr ("lpbin not found, check GST_PLUGIN_PATH\n");
+    return FALSE;
+  }
+
+  g_object_set (lpbin, "uri", uri, "single-phase", single_phase,
+      "video-sink-desc", video_sink_desc, "audio-sink-desc", audio_sink_desc,
+      NULL);
+  if (thumbnail) {
+    GstStructure *s = gst_structure_new ("smart-properties",
+        "thumbnail-mode", G_TYPE_BOOLEAN, TRUE, NULL);
+
+    g_object_set (lpbin, "smart-properties", s, NULL);
+    gst_structure_free (s);
+  }
+
+  bus = gst_element_get_bus (lpbin);
+
+  start = g_get_monotonic_time ();
+  deadline = start + timeout * G_USEC_PER_SEC;
+  if (gst_element_set_state (lpbin, GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_FAILURE)
+    goto done;
+
+  while (!done) {
+    gint64 now = g_get_monotonic_time ();
+
+    if (now >= deadline) {
+      g_printerr ("timed out\n");
+      break;
+    }
+
+    msg = gst_bus_timed_pop_filtered (bus, (deadline - now) * GST_USECOND,
+        GST_MESSAGE_ELEMENT | GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+    if (!msg)
+      continue;
+
+    switch (GST_MESSAGE_TYPE (msg)) {
+      case GST_MESSAGE_ELEMENT:
+        if (gst_message_has_name (msg, "lpsink-configured"))
+          gst_structure_get_uint64 (gst_message_get_structure (msg),
+              "elapsed", &configured);
+        break;
+      case GST_MESSAGE_ASYNC_DONE:
+        if (GST_MESSAGE_SRC (msg) == GST_OBJECT_CAST (lpbin)) {
+          preroll = (g_get_monotonic_time () - start) * GST_USECOND;
+          done = res = TRUE;
+        }
+        break;
+      case GST_MESSAGE_ERROR:{
+        GError *err = NULL;
+
+        gst_message_parse_error (msg, &err, NULL);
+        g_printerr ("error from %s: %s\n", GST_OBJECT_NAME (msg->src),
+            err->message);
+        g_clear_error (&err);
+        done = TRUE;
+        break;
+      }
+      default:
+        break;
+    }
+    gst_message_unref (msg);
+  }
+
+done:
+  gst_element_set_state (lpbin, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (lpbin);
+
+  if (!res) {
+    stats->failures++;
+    return FALSE;
+  }
+
+  stats->runs++;
+  stats_add (&stats->preroll_sum, &stats->preroll_min, &stats->preroll_max,
+      preroll);
+  if (GST_CLOCK_TIME_IS_VALID (configured)) {
+    stats->configured_runs++;
+    stats_add (&stats->configured_sum, &stats->configured_min,
+        &stats->configured_max, configured);
+  }
+
+  return TRUE;
+}
+
+static void
+print_line (const gchar * name, guint runs, GstClockTime sum,
+    GstClockTime min, GstClockTime max)
+{
+  if (!runs) {
+    g_print ("  %-11s n/a\n", name);
+    return;
+  }
+
+  g_print ("  %-11s mean %8.2f ms  min %8.2f ms  max %8.2f ms\n", name,
+      (gdouble) sum / runs / GST_MSECOND, (gdouble) min / GST_MSECOND,
+      (gdouble) max / GST_MSECOND);
+}
+
+static void
+print_stats (const gchar * mode, Stats * stats)
+{
+  g_print ("%s: %u runs, %u failed\n", mode, stats->runs, stats->failures);
+  print_line ("configured", stats->configured_runs, stats->configured_sum,
+      stats->configured_min, stats->configured_max);
+  print_line ("preroll", stats->runs, stats->preroll_sum, stats->preroll_min,
+      stats->preroll_max);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  gint iterations = DEFAULT_ITERATIONS;
+  gint timeout = DEFAULT_TIMEOUT;
+  gboolean thumbnail = FALSE;
+  gchar *mode = NULL;
+  gint phase, i;
+
+  GOptionEntry options[] = {
+    {"iterations", 'n', 0, G_OPTION_ARG_INT, &iterations,
+        "Number of prerolls per mode", "N"},
+    {"mode", 'm', 0, G_OPTION_ARG_STRING, &mode,
+        "Only run two-phase or single-phase", "MODE"},
+    {"timeout", 't', 0, G_OPTION_ARG_INT, &timeout,
+        "Seconds to wait for one preroll", "SECONDS"},
+    {"thumbnail", 0, 0, G_OPTION_ARG_NONE, &thumbnail,
+        "Preroll in thumbnail mode", NULL},
+    {"video-sink", 0, 0, G_OPTION_ARG_STRING, &video_sink_desc,
+        "Video sink instead of vdecsink", "DESCRIPTION"},
+    {"audio-sink", 0, 0, G_OPTION_ARG_STRING, &audio_sink_desc,
+        "Audio sink instead of adecsink", "DESCRIPTION"},
+    {NULL}
+  };
+
+  ctx = g_option_context_new ("URI - lpbin time-to-preroll benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (argc != 2 || iterations < 1 || timeout < 1) {
+    g_printerr ("usage: %s [OPTION...] URI, see --help\n", argv[0]);
+    return -1;
+  }
+
+  g_print ("uri: %s, iterations: %d\n", argv[1], iterations);
+
+  for (phase = 0; phase < 2; phase++) {
+    const gchar *name = phase ? "single-phase" : "two-phase";
+    Stats stats = { 0, }, warmup = { 0, };
+
+    if (mode && strcmp (mode, name) != 0)
+      continue;
+
+    stats.configured_min = stats.preroll_min = GST_CLOCK_TIME_NONE;
+    warmup.configured_min = warmup.preroll_min = GST_CLOCK_TIME_NONE;
+
+    /* the first run pays for loading the plugins and the file cache */
+    preroll_once (argv[1], phase, thumbnail, timeout, &warmup);
+
+    for (i = 0; i < iterations; i++)
+      preroll_once (argv[1], phase, thumbnail, timeout, &stats);
+
+    print_stats (name, &stats);
+  }
+
+  g_free (mode);
+  g_free (video_sink_desc);
+  g_free (audio_sink_desc);
+
+  return 0;
+}
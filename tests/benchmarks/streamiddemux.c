@@ -0,0 +1,342 @@
+/* GStreamer streamiddemux benchmark
+ *
+ * Copyright 2014 LG Electronics, Inc.
+ *  @author: HoonHee Lee <hoonhee.lee@lge.com>
+ *
+ * streamiddemux.c: measure the per-buffer routing cost of streamiddemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+/*
+ * Pushes buffers of several streams through streamiddemux into sink pads
+ * that drop them, and reports buffers/sec and ns/buffer. Streams are
+ * interleaved in one of these patterns:
+ *
+ *   round-robin  switch to the next stream after every buffer
+ *   bursty       switch to the next stream after --burst buffers
+ *   dominant     one stream carries --dominant-percent of the buffers,
+ *                the rest is spread over the others at random
+ *
+ * A switch costs a stream-start and a segment event, as it does upstream.
+ * Each pattern is run twice: alone, and while another thread keeps reading
+ * the active-pad property. That thread takes the object lock of the
+ * demuxer with a trylock first and counts how often it was already held,
+ * which is reported as lock contention.
+ *
+ * Run it from the build tree so that the lpcompat plugin is found, e.g.
+ *   GST_PLUGIN_PATH=$(top_builddir)/gst ./streamiddemux -n 1000000 -s 4
+ * and compare the output between revisions.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <gst/gst.h>
+
+#define DEFAULT_NUM_BUFFERS 1000000
+#define DEFAULT_NUM_STREAMS 4
+#define DEFAULT_BUFFER_SIZE 188
+#define DEFAULT_BURST 32
+#define DEFAULT_DOMINANT_PERCENT 90
+#define DEFAULT_SEED 0x5eed
+
+typedef enum
+{
+  PATTERN_ROUND_ROBIN,
+  PATTERN_BURSTY,
+  PATTERN_DOMINANT,
+  PATTERN_LAST
+} Pattern;
+
+static const gchar *pattern_names[PATTERN_LAST] = {
+  "round-robin", "bursty", "dominant"
+};
+
+typedef struct _Bench Bench;
+
+struct _Bench
+{
+  GstElement *demux;
+  GstPad *srcpad;               /* feeds the demuxer */
+  GPtrArray *sinkpads;          /* receive from the demuxer, one per stream */
+
+  gint num_streams;
+  gint burst;
+  gint dominant_percent;
+
+  gint current;                 /* stream the last buffer went to */
+  guint switches;
+
+  volatile gint running;
+  guint lock_attempts;
+  guint lock_contended;
+};
+
+typedef struct
+{
+  guint num_buffers;
+  guint switches;
+  gint64 elapsed;               /* in microseconds */
+  guint lock_attempts;
+  guint lock_contended;
+} Result;
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, Bench * bench)
+{
+  GstPad *sinkpad;
+  gchar *name;
+
+  name = g_strdup_printf ("sink_%u", bench->sinkpads->len);
+  sinkpad = gst_pad_new (name, GST_PAD_SINK);
+  g_free (name);
+
+  gst_pad_set_chain_function (sinkpad, sink_chain);
+  gst_pad_set_active (sinkpad, TRUE);
+  gst_pad_link (pad, sinkpad);
+
+  g_ptr_array_add (bench->sinkpads, sinkpad);
+}
+
+static gpointer
+contend_func (Bench * bench)
+{
+  GstPad *active = NULL;
+
+  while (g_atomic_int_get (&bench->running)) {
+    bench->lock_attempts++;
+    if (GST_OBJECT_TRYLOCK (bench->demux)) {
+      GST_OBJECT_UNLOCK (bench->demux);
+    } else {
+      bench->lock_contended++;
+    }
+
+    g_object_get (bench->demux, "active-pad", &active, NULL);
+    if (active)
+      gst_object_unref (active);
+  }
+
+  return NULL;
+}
+
+static void
+switch_stream (Bench * bench, gint stream)
+{
+  GstSegment segment;
+  gchar *stream_id;
+
+  stream_id = g_strdup_printf ("bench-%d", stream);
+  gst_pad_push_event (bench->srcpad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (bench->srcpad, gst_event_new_segment (&segment));
+
+  bench->current = stream;
+  bench->switches++;
+}
+
+static gint
+next_stream (Bench * bench, Pattern pattern, guint i, GRand * rand)
+{
+  switch (pattern) {
+    case PATTERN_ROUND_ROBIN:
+      return i % bench->num_streams;
+    case PATTERN_BURSTY:
+      return (i / bench->burst) % bench->num_streams;
+    case PATTERN_DOMINANT:
+      if (bench->num_streams == 1
+          || g_rand_int_range (rand, 0, 100) < bench->dominant_percent)
+        return 0;
+      return g_rand_int_range (rand, 1, bench->num_streams);
+    default:
+      g_assert_not_reached ();
+  }
+
+  return 0;
+}
+
+static void
+run (Bench * bench, Pattern pattern, GstBuffer * buf, guint num_buffers,
+    gboolean contended, Result * result)
+{
+  GThread *thread = NULL;
+  GRand *rand;
+  gint64 start, end;
+  guint i;
+
+  /* same sequence of streams for every run of a pattern */
+  rand = g_rand_new_with_seed (DEFAULT_SEED);
+  bench->switches = 0;
+  bench->lock_attempts = 0;
+  bench->lock_contended = 0;
+
+  if (contended) {
+    g_atomic_int_set (&bench->running, 1);
+    thread = g_thread_new ("contend", (GThreadFunc) contend_func, bench);
+  }
+
+  start = g_get_monotonic_time ();
+  for (i = 0; i < num_buffers; i++) {
+    gint stream = next_stream (bench, pattern, i, rand);
+
+    if (stream != bench->current)
+      switch_stream (bench, stream);
+    gst_pad_push (bench->srcpad, gst_buffer_ref (buf));
+  }
+  end = g_get_monotonic_time ();
+
+  if (thread) {
+    g_atomic_int_set (&bench->running, 0);
+    g_thread_join (thread);
+  }
+
+  g_rand_free (rand);
+
+  result->num_buffers = num_buffers;
+  result->switches = bench->switches;
+  result->elapsed = MAX (end - start, 1);
+  result->lock_attempts = bench->lock_attempts;
+  result->lock_contended = bench->lock_contended;
+}
+
+static void
+print_result (const gchar * name, Result * result, gboolean contended)
+{
+  gdouble secs = (gdouble) result->elapsed / G_USEC_PER_SEC;
+
+  g_print ("  %-12s %12.0f buffers/sec %8.1f ns/buffer %9u switches",
+      name, result->num_buffers / secs,
+      (gdouble) result->elapsed * 1000 / result->num_buffers,
+      result->switches);
+  if (contended)
+    g_print ("  lock contended %u/%u", result->lock_contended,
+        result->lock_attempts);
+  g_print ("\n");
+}
+
+int
+main (int argc, char *argv[])
+{
+  Bench bench = { NULL, };
+  GOptionContext *ctx;
+  GError *err = NULL;
+  GstPad *demux_sinkpad;
+  GstBuffer *buf;
+  Result result;
+  gint num_buffers = DEFAULT_NUM_BUFFERS;
+  gint num_streams = DEFAULT_NUM_STREAMS;
+  gint buffer_size = DEFAULT_BUFFER_SIZE;
+  gint burst = DEFAULT_BURST;
+  gint dominant_percent = DEFAULT_DOMINANT_PERCENT;
+  gchar *pattern_name = NULL;
+  gint pattern, stream;
+
+  GOptionEntry options[] = {
+    {"buffers", 'n', 0, G_OPTION_ARG_INT, &num_buffers,
+        "Number of buffers per run", "N"},
+    {"streams", 's', 0, G_OPTION_ARG_INT, &num_streams,
+        "Number of interleaved streams", "N"},
+    {"size", 'b', 0, G_OPTION_ARG_INT, &buffer_size,
+        "Size of each buffer in bytes", "BYTES"},
+    {"pattern", 'p', 0, G_OPTION_ARG_STRING, &pattern_name,
+        "Only run round-robin, bursty or dominant", "PATTERN"},
+    {"burst", 0, 0, G_OPTION_ARG_INT, &burst,
+        "Buffers per stream before switching in the bursty pattern", "N"},
+    {"dominant-percent", 0, 0, G_OPTION_ARG_INT, &dominant_percent,
+        "Share of the first stream in the dominant pattern", "PERCENT"},
+    {NULL}
+  };
+
+  ctx = g_option_context_new ("- streamiddemux throughput benchmark");
+  g_option_context_add_main_entries (ctx, options, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
+    g_printerr ("Error initializing: %s\n", err->message);
+    g_clear_error (&err);
+    g_option_context_free (ctx);
+    return -1;
+  }
+  g_option_context_free (ctx);
+
+  if (num_buffers < 1 || num_streams < 1 || buffer_size < 0 || burst < 1
+      || dominant_percent < 0 || dominant_percent > 100) {
+    g_printerr ("invalid arguments, see --help\n");
+    return -1;
+  }
+
+  bench.num_streams = num_streams;
+  bench.burst = burst;
+  bench.dominant_percent = dominant_percent;
+  bench.sinkpads = g_ptr_array_new_with_free_func (gst_object_unref);
+
+  bench.demux = gst_element_factory_make ("streamiddemux", NULL);
+  if (!bench.demux) {
+    g_printerr ("streamiddemux not found, check GST_PLUGIN_PATH\n");
+    return -1;
+  }
+
+  bench.srcpad = gst_pad_new ("src", GST_PAD_SRC);
+
+  g_signal_connect (bench.demux, "pad-added", G_CALLBACK (pad_added_cb),
+      &bench);
+
+  demux_sinkpad = gst_element_get_static_pad (bench.demux, "sink");
+  gst_pad_link (bench.srcpad, demux_sinkpad);
+  gst_object_unref (demux_sinkpad);
+
+  gst_pad_set_active (bench.srcpad, TRUE);
+  gst_element_set_state (bench.demux, GST_STATE_PLAYING);
+
+  /* create all srcpads up front, so that only routing is measured */
+  for (stream = 0; stream < num_streams; stream++)
+    switch_stream (&bench, stream);
+
+  buf = gst_buffer_new_allocate (NULL, buffer_size, NULL);
+
+  g_print ("buffers: %d, streams: %d, size: %d\n", num_buffers, num_streams,
+      buffer_size);
+
+  for (pattern = 0; pattern < PATTERN_LAST; pattern++) {
+    if (pattern_name && strcmp (pattern_name, pattern_names[pattern]) != 0)
+      continue;
+
+    g_print ("%s:\n", pattern_names[pattern]);
+    run (&bench, pattern, buf, num_buffers, FALSE, &result);
+    print_result ("uncontended", &result, FALSE);
+    run (&bench, pattern, buf, num_buffers, TRUE, &result);
+    print_result ("contended", &result, TRUE);
+  }
+
+  gst_buffer_unref (buf);
+  g_free (pattern_name);
+
+  gst_element_set_state (bench.demux, GST_STATE_NULL);
+  gst_object_unref (bench.demux);
+  gst_object_unref (bench.srcpad);
+  g_ptr_array_unref (bench.sinkpads);
+
+  return 0;
+}
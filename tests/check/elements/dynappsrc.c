@@ -22,9 +22,15 @@
 # include <config.h>
 #endif
 
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 
+#include "gstdynshm.h"
+
 #define NUM_REPEAT 5
 #define NUM_APPSRC 10
 
@@ -207,6 +213,7 @@ GST_START_TEST (test_appsrc_create_when_paused)
   GstElement *appsrc1 = NULL;
   GstElement *appsrc2 = NULL;
   gint n_source = 0;
+  gboolean removed = FALSE;
 
   dynappsrc =
       gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
@@ -229,19 +236,30 @@ GST_START_TEST (test_appsrc_create_when_paused)
   fail_unless (ret == GST_STATE_CHANGE_SUCCESS,
       "fail to state change to PAUSED");
 
-  /* Try to generate a appsrc element when state is paused.
-   * If it is genetated, it is not make sence.
-   * Because, in this time, configuratoin of all appsrc elements in dynappsrc bin is already done.
-   * Thus, you should call "new-appsrc" singal action before paused state.
-   */
+  /* a track showing up while running gets its own srcpad */
   g_signal_emit_by_name (dynappsrc, "new-appsrc", "wonchul", &appsrc2);
-  fail_unless (!appsrc2,
-      "appsrc element is generated even though when state is paused");
+  fail_unless (appsrc2 != NULL,
+      "appsrc element is not generated when state is paused");
+  gst_object_ref (appsrc2);
+  fail_unless (GST_OBJECT_PARENT (appsrc2) == GST_OBJECT (dynappsrc));
+  fail_unless_equals_int (GST_STATE (appsrc2), GST_STATE_PAUSED);
+
+  g_object_get (dynappsrc, "n-source", &n_source, NULL);
+  fail_unless (n_source == 2, "the number of source element is not matched");
+
+  fail_unless (n_added == 2, "srcpad of dynappsrc does not added");
 
+  /* and goes away again, the first keeps running */
+  g_signal_emit_by_name (dynappsrc, "remove-appsrc", appsrc2, &removed);
+  fail_unless (removed);
+  fail_unless (GST_OBJECT_PARENT (appsrc2) == NULL);
   g_object_get (dynappsrc, "n-source", &n_source, NULL);
   fail_unless (n_source == 1, "the number of source element is not matched");
+  fail_unless_equals_int (GST_STATE (appsrc1), GST_STATE_PAUSED);
 
-  fail_unless (n_added == 1, "srcpad of dynappsrc does not added");
+  g_signal_emit_by_name (dynappsrc, "remove-appsrc", appsrc2, &removed);
+  fail_if (removed);
+  gst_object_unref (appsrc2);
 
   /* user should do unref appsrc elements before destroy pipeline */
   gst_object_unref (appsrc1);
@@ -540,6 +558,672 @@ GST_START_TEST (test_appsrc_eos)
 
 GST_END_TEST;
 
+GST_START_TEST (test_appsrc_buffer_pool)
+{
+  GstElement *dynappsrc;
+  GstElement *appsrc = NULL;
+  GstBufferPool *pool = NULL, *pool2 = NULL;
+  GstBufferPoolAcquireParams params = { 0, };
+  GstBuffer *buf1, *buf2, *buf3;
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc);
+  fail_unless (appsrc != NULL);
+
+  g_signal_emit_by_name (dynappsrc, "get-buffer-pool", 1, 1024, 2, &pool);
+  fail_unless (pool == NULL, "got a pool for a missing stream");
+
+  g_signal_emit_by_name (dynappsrc, "get-buffer-pool", 0, 1024, 2, &pool);
+  fail_unless (pool != NULL);
+  fail_unless (gst_buffer_pool_is_active (pool));
+
+  /* the same pool for the same configuration only */
+  g_signal_emit_by_name (dynappsrc, "get-buffer-pool", 0, 1024, 2, &pool2);
+  fail_unless (pool2 == pool);
+  gst_object_unref (pool2);
+  pool2 = NULL;
+  g_signal_emit_by_name (dynappsrc, "get-buffer-pool", 0, 2048, 2, &pool2);
+  fail_unless (pool2 == NULL);
+
+  /* at most max-buffers are in flight and they are recycled */
+  params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+  fail_unless_equals_int (gst_buffer_pool_acquire_buffer (pool, &buf1,
+          &params), GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_pool_acquire_buffer (pool, &buf2,
+          &params), GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buf1), 1024);
+  fail_if (gst_buffer_pool_acquire_buffer (pool, &buf3, &params) ==
+      GST_FLOW_OK);
+  gst_buffer_unref (buf1);
+  fail_unless_equals_int (gst_buffer_pool_acquire_buffer (pool, &buf3,
+          &params), GST_FLOW_OK);
+  fail_unless (buf3 == buf1);
+  gst_buffer_unref (buf3);
+  gst_buffer_unref (buf2);
+
+  /* released on the way back to READY */
+  fail_unless_equals_int (gst_element_set_state (dynappsrc, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_element_set_state (dynappsrc, GST_STATE_NULL);
+  fail_if (gst_buffer_pool_is_active (pool));
+
+  gst_object_unref (pool);
+  gst_object_unref (dynappsrc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_appsrc_byte_budget)
+{
+  GstElement *dynappsrc;
+  GstElement *appsrc1 = NULL, *appsrc2 = NULL;
+  GstStructure *stats = NULL;
+  guint64 max_bytes1 = 0, max_bytes2 = 0, max_bytes = 0;
+  guint n_streams = 0;
+  gboolean removed = FALSE;
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+  g_object_set (dynappsrc, "max-bytes", (guint64) 1000, NULL);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc1);
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc2);
+  fail_unless (appsrc1 && appsrc2);
+  gst_object_ref (appsrc1);
+  gst_object_ref (appsrc2);
+
+  g_object_get (dynappsrc, "budget-stats", &stats, NULL);
+  fail_unless (stats == NULL, "budget before PAUSED");
+
+  fail_unless_equals_int (gst_element_set_state (dynappsrc, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* nothing consumed yet, so the budget is split evenly */
+  g_object_get (appsrc1, "max-bytes", &max_bytes1, NULL);
+  g_object_get (appsrc2, "max-bytes", &max_bytes2, NULL);
+  fail_unless_equals_uint64 (max_bytes1, 500);
+  fail_unless_equals_uint64 (max_bytes2, 500);
+
+  g_object_get (dynappsrc, "budget-stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "n-streams", &n_streams));
+  fail_unless_equals_int (n_streams, 2);
+  fail_unless (gst_structure_get_uint64 (stats, "max-bytes-1", &max_bytes));
+  fail_unless_equals_uint64 (max_bytes, 500);
+  gst_structure_free (stats);
+
+  /* a removed stream leaves its share to the others */
+  g_signal_emit_by_name (dynappsrc, "remove-appsrc", appsrc2, &removed);
+  fail_unless (removed);
+  g_object_get (appsrc1, "max-bytes", &max_bytes1, NULL);
+  fail_unless_equals_uint64 (max_bytes1, 1000);
+
+  gst_element_set_state (dynappsrc, GST_STATE_NULL);
+  gst_object_unref (appsrc1);
+  gst_object_unref (appsrc2);
+  gst_object_unref (dynappsrc);
+}
+
+GST_END_TEST;
+
+static gboolean
+batch_seek_data_cb (GstElement * dynappsrc, GstFormat format,
+    guint64 position, gint * n_seeks)
+{
+  GstIterator *it;
+  GValue data = { 0, };
+  gboolean flushing = FALSE;
+
+  fail_unless_equals_int (format, GST_FORMAT_TIME);
+  fail_unless_equals_uint64 (position, 2 * GST_SECOND);
+
+  /* called from the seek of the first appsrc, after it started flushing */
+  it = gst_bin_iterate_sources (GST_BIN (dynappsrc));
+  while (gst_iterator_next (it, &data) == GST_ITERATOR_OK) {
+    GstPad *pad =
+        gst_element_get_static_pad (g_value_get_object (&data), "src");
+
+    flushing |= GST_PAD_IS_FLUSHING (pad);
+    gst_object_unref (pad);
+    g_value_reset (&data);
+  }
+  g_value_unset (&data);
+  gst_iterator_free (it);
+  fail_unless (flushing);
+
+  *n_seeks = *n_seeks + 1;
+
+  return TRUE;
+}
+
+GST_START_TEST (test_appsrc_batched_seek)
+{
+  GstElement *dynappsrc;
+  GstElement *appsrc1 = NULL, *appsrc2 = NULL;
+  GstPad *srcpad1, *srcpad2;
+  GstEvent *seek;
+  gint n_seeks = 0;
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+  g_signal_connect (dynappsrc, "seek-data", G_CALLBACK (batch_seek_data_cb),
+      &n_seeks);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc1);
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc2);
+  fail_unless (appsrc1 && appsrc2);
+  gst_object_ref (appsrc1);
+  gst_object_ref (appsrc2);
+  /* seekable in time, without seek-data handlers of their own */
+  gst_util_set_object_arg (G_OBJECT (appsrc1), "stream-type", "seekable");
+  gst_util_set_object_arg (G_OBJECT (appsrc2), "stream-type", "seekable");
+  g_object_set (appsrc1, "format", GST_FORMAT_TIME, NULL);
+  g_object_set (appsrc2, "format", GST_FORMAT_TIME, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (dynappsrc, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+
+  srcpad1 = gst_element_get_static_pad (dynappsrc, "src_0");
+  srcpad2 = gst_element_get_static_pad (dynappsrc, "src_1");
+  fail_unless (srcpad1 && srcpad2);
+
+  /* the seek comes up every stream, the application sees it once */
+  seek = gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+      GST_SEEK_TYPE_SET, 2 * GST_SECOND, GST_SEEK_TYPE_NONE, -1);
+  fail_unless (gst_pad_send_event (srcpad1, gst_event_ref (seek)));
+  fail_unless (gst_pad_send_event (srcpad2, seek));
+  fail_unless_equals_int (n_seeks, 1);
+
+  gst_object_unref (srcpad1);
+  gst_object_unref (srcpad2);
+
+  gst_element_set_state (dynappsrc, GST_STATE_NULL);
+  gst_object_unref (appsrc1);
+  gst_object_unref (appsrc2);
+  gst_object_unref (dynappsrc);
+}
+
+GST_END_TEST;
+
+static void
+interleave_handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    gint * count)
+{
+  g_atomic_int_inc (count);
+}
+
+static void
+interleave_pad_added_cb (GstElement * dynappsrc, GstPad * pad,
+    GstElement * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+  gint *count;
+
+  count = g_object_get_data (G_OBJECT (pipeline), GST_PAD_NAME (pad));
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (interleave_handoff_cb),
+      count);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (pad, sinkpad)));
+  gst_object_unref (sinkpad);
+}
+
+static void
+push_timed (GstElement * appsrc, GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, 16, NULL);
+  GstFlowReturn ret;
+
+  GST_BUFFER_PTS (buf) = pts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+  g_signal_emit_by_name (appsrc, "push-buffer", buf, &ret);
+  gst_buffer_unref (buf);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+}
+
+/* waits up to a second for @count to reach @expected */
+static gint
+wait_count (gint * count, gint expected)
+{
+  gint i;
+
+  for (i = 0; i < 100 && g_atomic_int_get (count) < expected; i++)
+    g_usleep (10 * 1000);
+  /* and a bit longer to catch buffers that should not have passed */
+  g_usleep (50 * 1000);
+
+  return g_atomic_int_get (count);
+}
+
+GST_START_TEST (test_appsrc_interleave)
+{
+  GstElement *pipeline, *dynappsrc;
+  GstElement *appsrc1 = NULL, *appsrc2 = NULL;
+  GstCaps *caps;
+  gint count1 = 0, count2 = 0;
+  GstClockTime t;
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set_data (G_OBJECT (pipeline), "src_0", &count1);
+  g_object_set_data (G_OBJECT (pipeline), "src_1", &count2);
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+  g_object_set (dynappsrc, "interleave-window", (guint64) GST_SECOND, NULL);
+  g_signal_connect (dynappsrc, "pad-added",
+      G_CALLBACK (interleave_pad_added_cb), pipeline);
+  gst_bin_add (GST_BIN (pipeline), dynappsrc);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc1);
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc2);
+  fail_unless (appsrc1 && appsrc2);
+  gst_object_ref (appsrc1);
+  gst_object_ref (appsrc2);
+
+  caps = gst_caps_new_empty_simple ("video/x-test");
+  g_object_set (appsrc1, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  g_object_set (appsrc2, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  /* stream 0 runs up to 3s while stream 1 is at 0s, only what is within a
+   * second of it gets through */
+  push_timed (appsrc2, 0);
+  fail_unless_equals_int (wait_count (&count2, 1), 1);
+  for (t = 0; t <= 3 * GST_SECOND; t += GST_SECOND)
+    push_timed (appsrc1, t);
+  fail_unless_equals_int (wait_count (&count1, 2), 2);
+
+  /* stream 1 catching up releases it */
+  push_timed (appsrc2, 2 * GST_SECOND);
+  fail_unless_equals_int (wait_count (&count1, 4), 4);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (appsrc1);
+  gst_object_unref (appsrc2);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static void
+preroll_pad_added_cb (GstElement * dynappsrc, GstPad * pad,
+    GstElement * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (pad, sinkpad)));
+  gst_object_unref (sinkpad);
+}
+
+GST_START_TEST (test_appsrc_interleave_preroll)
+{
+  GstElement *pipeline, *dynappsrc;
+  GstElement *appsrc1 = NULL, *appsrc2 = NULL;
+  GstCaps *caps;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+  g_object_set (dynappsrc, "interleave-window", (guint64) GST_SECOND, NULL);
+  g_signal_connect (dynappsrc, "pad-added",
+      G_CALLBACK (preroll_pad_added_cb), pipeline);
+  gst_bin_add (GST_BIN (pipeline), dynappsrc);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc1);
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc2);
+  fail_unless (appsrc1 && appsrc2);
+  gst_object_ref (appsrc1);
+  gst_object_ref (appsrc2);
+
+  caps = gst_caps_new_empty_simple ("video/x-test");
+  g_object_set (appsrc1, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  g_object_set (appsrc2, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_ASYNC);
+
+  /* stream 0 starts 3s ahead, holding it would keep its sink from
+   * prerolling while the other sink waits in preroll */
+  push_timed (appsrc2, 0);
+  push_timed (appsrc1, 3 * GST_SECOND);
+
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          5 * GST_SECOND), GST_STATE_CHANGE_SUCCESS);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (appsrc1);
+  gst_object_unref (appsrc2);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  gint count;
+  GstClockTime pts;
+  gboolean discont;
+  gboolean backwards;
+} LiveOut;
+
+static void
+live_handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    LiveOut * out)
+{
+  if (out->count > 0 && GST_BUFFER_PTS (buf) < out->pts)
+    out->backwards = TRUE;
+  out->pts = GST_BUFFER_PTS (buf);
+  out->discont = GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT);
+  g_atomic_int_inc (&out->count);
+}
+
+static void
+live_pad_added_cb (GstElement * dynappsrc, GstPad * pad, GstElement * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, "signal-handoffs", TRUE,
+      NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (live_handoff_cb),
+      g_object_get_data (G_OBJECT (pipeline), "out"));
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (pad, sinkpad)));
+  gst_object_unref (sinkpad);
+}
+
+GST_START_TEST (test_appsrc_live)
+{
+  GstElement *pipeline, *dynappsrc, *appsrc = NULL;
+  GstStructure *stats = NULL;
+  GstCaps *caps;
+  LiveOut out = { 0, };
+  gboolean is_live;
+  guint resyncs;
+  gint64 min_latency;
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set_data (G_OBJECT (pipeline), "out", &out);
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+  g_object_set (dynappsrc, "live", TRUE, "latency",
+      (guint64) (100 * GST_MSECOND), NULL);
+  g_signal_connect (dynappsrc, "pad-added", G_CALLBACK (live_pad_added_cb),
+      pipeline);
+  gst_bin_add (GST_BIN (pipeline), dynappsrc);
+
+  g_object_get (dynappsrc, "live-stats", &stats, NULL);
+  fail_unless (stats == NULL);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc);
+  fail_unless (appsrc != NULL);
+  gst_object_ref (appsrc);
+  caps = gst_caps_new_empty_simple ("video/x-test");
+  g_object_set (appsrc, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_FAILURE);
+
+  g_object_get (appsrc, "is-live", &is_live, "min-latency", &min_latency,
+      NULL);
+  fail_unless (is_live);
+  fail_unless_equals_uint64 (min_latency, 100 * GST_MSECOND);
+
+  /* the sender clock is far from the pipeline running time */
+  push_timed (appsrc, 100 * GST_SECOND);
+  fail_unless_equals_int (wait_count (&out.count, 1), 1);
+  fail_unless (out.pts < 10 * GST_SECOND);
+
+  /* a sender jumping ahead by more than the latency is mapped again */
+  push_timed (appsrc, 200 * GST_SECOND);
+  fail_unless_equals_int (wait_count (&out.count, 2), 2);
+  fail_unless (out.pts < 10 * GST_SECOND);
+  fail_unless (out.discont);
+
+  g_object_get (dynappsrc, "live-stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "resyncs", &resyncs));
+  fail_unless_equals_int (resyncs, 1);
+  fail_unless (gst_structure_has_field (stats, "skew"));
+  gst_structure_free (stats);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (appsrc);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+/* the sender clock runs 1% slow, starting at 50s */
+#define SENDER_RATE 0.99
+#define SENDER_BASE (50 * GST_SECOND)
+
+GST_START_TEST (test_appsrc_live_drift)
+{
+  GstElement *pipeline, *dynappsrc, *appsrc = NULL;
+  GstStructure *stats = NULL;
+  GstClock *clock;
+  GstClockTime base_time, now, send = 0;
+  GstCaps *caps;
+  LiveOut out = { 0, };
+  guint resyncs, late;
+  gint64 skew;
+  gdouble drift, expected_drift;
+  gint pushed = 0;
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set_data (G_OBJECT (pipeline), "out", &out);
+
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_unless (dynappsrc != NULL);
+  g_object_set (dynappsrc, "live", TRUE, "latency",
+      (guint64) (100 * GST_MSECOND), NULL);
+  g_signal_connect (dynappsrc, "pad-added", G_CALLBACK (live_pad_added_cb),
+      pipeline);
+  gst_bin_add (GST_BIN (pipeline), dynappsrc);
+
+  g_signal_emit_by_name (dynappsrc, "new-appsrc", NULL, &appsrc);
+  fail_unless (appsrc != NULL);
+  gst_object_ref (appsrc);
+  caps = gst_caps_new_empty_simple ("video/x-test");
+  g_object_set (appsrc, "format", GST_FORMAT_TIME, "caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_FAILURE);
+
+  clock = gst_element_get_clock (pipeline);
+  fail_unless (clock != NULL);
+  base_time = gst_element_get_base_time (pipeline);
+
+  /* two and a half windows of the sender clock, sent as it ticks */
+  do {
+    now = gst_clock_get_time (clock) - base_time;
+    send = SENDER_BASE + (GstClockTime) (now * SENDER_RATE);
+    push_timed (appsrc, send);
+    pushed++;
+    g_usleep (20 * 1000);
+  } while (send < SENDER_BASE + 5 * GST_SECOND);
+  fail_unless_equals_int (wait_count (&out.count, pushed), pushed);
+
+  g_object_get (dynappsrc, "live-stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "resyncs", &resyncs));
+  fail_unless (gst_structure_get_uint (stats, "late", &late));
+  fail_unless (gst_structure_get_int64 (stats, "skew", &skew));
+  fail_unless (gst_structure_get_double (stats, "drift", &drift));
+  gst_structure_free (stats);
+
+  /* the pipeline gains 1% of the running time on the sender */
+  expected_drift = (1.0 / SENDER_RATE - 1.0) * 1e6;
+  GST_INFO ("drift %lf ppm, expected %lf, skew %" G_GINT64_FORMAT, drift,
+      expected_drift, skew);
+  fail_unless (ABS (drift - expected_drift) < expected_drift / 20);
+  fail_unless (ABS (skew - (gint64) ((send - SENDER_BASE) * expected_drift /
+              1e6)) < 5 * GST_MSECOND);
+
+  /* followed all along, without starting over or going back */
+  fail_unless_equals_int (resyncs, 0);
+  fail_unless_equals_int (late, 0);
+  fail_if (out.backwards);
+  fail_if (out.discont);
+
+  /* and the last buffer left at about the time it was pushed */
+  fail_unless (ABS ((gint64) out.pts - (gint64) now) < 5 * GST_MSECOND);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (clock);
+  gst_object_unref (appsrc);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static void
+fill_slot (guint8 * base, guint lane, guint i, GstClockTime pts)
+{
+  GstDynShmSlot *slot;
+  guint index = lane * 4 + i;
+
+  slot = (GstDynShmSlot *) (base + GST_DYN_SHM_SLOTS_OFFSET) + index;
+  memset (base + GST_DYN_SHM_DATA_OFFSET (2, 4) + index * 1024, lane, 100);
+  slot->size = 100;
+  slot->flags = 0;
+  slot->pts = pts;
+  slot->dts = GST_CLOCK_TIME_NONE;
+  slot->duration = GST_SECOND;
+  g_atomic_int_set (&slot->state, GST_DYN_SHM_SLOT_FILLED);
+}
+
+GST_START_TEST (test_appsrc_shm)
+{
+  GstElement *pipeline, *dynappsrc;
+  GstDynShmHeader *header;
+  GstDynShmSlot *slots;
+  GstMessage *msg;
+  GstBus *bus;
+  gint count1 = 0, count2 = 0;
+  gchar *path, *uri;
+  guint8 *base;
+  gsize size;
+  gint fd, i;
+
+  fd = g_file_open_tmp ("dynappsrc-shm-XXXXXX", &path, NULL);
+  fail_unless (fd >= 0);
+  unlink (path);
+  g_free (path);
+
+  /* 2 lanes of 4 slots of 1024 bytes */
+  size = GST_DYN_SHM_SIZE (2, 4, 1024);
+  fail_unless (ftruncate (fd, size) == 0);
+  base = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  fail_unless (base != MAP_FAILED);
+
+  header = (GstDynShmHeader *) base;
+  header->magic = GST_DYN_SHM_MAGIC;
+  header->version = GST_DYN_SHM_VERSION;
+  header->n_lanes = 2;
+  header->n_slots = 4;
+  header->slot_size = 1024;
+  g_strlcpy (header->lanes[0].caps, "video/x-test", GST_DYN_SHM_CAPS_LEN);
+  g_strlcpy (header->lanes[1].caps, "audio/x-test", GST_DYN_SHM_CAPS_LEN);
+
+  fill_slot (base, 0, 0, 0);
+  fill_slot (base, 0, 1, GST_SECOND);
+  fill_slot (base, 1, 0, 0);
+  g_atomic_int_set (&header->lanes[0].flags, GST_DYN_SHM_LANE_EOS);
+  g_atomic_int_set (&header->lanes[1].flags, GST_DYN_SHM_LANE_EOS);
+
+  /* no descriptor, no dynappsrc */
+  dynappsrc =
+      gst_element_make_from_uri (GST_URI_SRC, "dynappsrc://", "source", NULL);
+  fail_if (gst_uri_handler_set_uri (GST_URI_HANDLER (dynappsrc),
+          "dynappsrc://shm?fd=a", NULL));
+  fail_if (gst_uri_handler_set_uri (GST_URI_HANDLER (dynappsrc),
+          "dynappsrc://shm?notify=3", NULL));
+  gst_object_unref (dynappsrc);
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set_data (G_OBJECT (pipeline), "src_0", &count1);
+  g_object_set_data (G_OBJECT (pipeline), "src_1", &count2);
+
+  uri = g_strdup_printf ("dynappsrc://shm?fd=%d", fd);
+  dynappsrc = gst_element_make_from_uri (GST_URI_SRC, uri, "source", NULL);
+  g_free (uri);
+  fail_unless (dynappsrc != NULL);
+  g_signal_connect (dynappsrc, "pad-added",
+      G_CALLBACK (interleave_pad_added_cb), pipeline);
+  gst_bin_add (GST_BIN (pipeline), dynappsrc);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  /* every lane is a stream, ending with the lane */
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless_equals_int (g_atomic_int_get (&count1), 2);
+  fail_unless_equals_int (g_atomic_int_get (&count2), 1);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  /* all slots went back to the producer */
+  slots = (GstDynShmSlot *) (base + GST_DYN_SHM_SLOTS_OFFSET);
+  for (i = 0; i < 8; i++)
+    fail_unless_equals_int (g_atomic_int_get (&slots[i].state),
+        GST_DYN_SHM_SLOT_FREE);
+  fail_unless_equals_int (g_atomic_int_get (&header->lanes[0].tail), 2);
+  fail_unless_equals_int (g_atomic_int_get (&header->lanes[1].tail), 1);
+
+  munmap (base, size);
+  close (fd);
+}
+
+GST_END_TEST;
+
 static Suite *
 dynappsrc_suite (void)
 {
@@ -554,6 +1238,14 @@ dynappsrc_suite (void)
   tcase_add_test (tc_chain, test_repeat_state_change);
   tcase_add_test (tc_chain, test_appsrc_upstream_event);
   tcase_add_test (tc_chain, test_appsrc_eos);
+  tcase_add_test (tc_chain, test_appsrc_buffer_pool);
+  tcase_add_test (tc_chain, test_appsrc_byte_budget);
+  tcase_add_test (tc_chain, test_appsrc_batched_seek);
+  tcase_add_test (tc_chain, test_appsrc_interleave);
+  tcase_add_test (tc_chain, test_appsrc_interleave_preroll);
+  tcase_add_test (tc_chain, test_appsrc_live);
+  tcase_add_test (tc_chain, test_appsrc_live_drift);
+  tcase_add_test (tc_chain, test_appsrc_shm);
 
   return s;
 }
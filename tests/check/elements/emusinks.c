@@ -0,0 +1,178 @@
+/* GStreamer unit tests for the emulated device sinks
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+static GstPad *
+request_pad (GstElement * sink, const gchar * caps_str)
+{
+  GstPadTemplate *templ;
+  GstCaps *caps;
+  GstPad *pad;
+
+  templ = gst_element_class_get_pad_template (GST_ELEMENT_GET_CLASS (sink),
+      "sink_%d");
+  fail_unless (templ != NULL);
+
+  caps = gst_caps_from_string (caps_str);
+  pad = gst_element_request_pad (sink, templ, NULL, caps);
+  gst_caps_unref (caps);
+
+  return pad;
+}
+
+GST_START_TEST (test_vdecsink_pads)
+{
+  GstElement *sink;
+  GstPad *pad;
+
+  sink = gst_element_factory_make ("vdecsink", NULL);
+  fail_unless (sink != NULL);
+
+  pad = request_pad (sink, "video/x-h264");
+  fail_unless (pad != NULL);
+  gst_element_release_request_pad (sink, pad);
+  gst_object_unref (pad);
+
+  /* audio only when asked to, so that lpsink keeps separate chains */
+  fail_unless (request_pad (sink, "audio/mpeg") == NULL);
+  g_object_set (sink, "accept-audio", TRUE, NULL);
+  pad = request_pad (sink, "audio/mpeg");
+  fail_unless (pad != NULL);
+  gst_element_release_request_pad (sink, pad);
+  gst_object_unref (pad);
+
+  gst_util_set_object_arg (G_OBJECT (sink), "reject-caps", "video/x-h265");
+  fail_unless (request_pad (sink, "video/x-h265") == NULL);
+  fail_unless (request_pad (sink, "text/x-raw") == NULL);
+
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_channels)
+{
+  GstElement *vdec1, *vdec2, *adec1, *adec2;
+
+  vdec1 = gst_element_factory_make ("vdecsink", NULL);
+  vdec2 = gst_element_factory_make ("vdecsink", NULL);
+  fail_unless (vdec1 != NULL && vdec2 != NULL);
+
+  /* a channel can only be opened once */
+  fail_unless_equals_int (gst_element_set_state (vdec1, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (vdec2, GST_STATE_READY),
+      GST_STATE_CHANGE_FAILURE);
+  g_object_set (vdec2, "vdec-ch", 1, NULL);
+  fail_unless_equals_int (gst_element_set_state (vdec2, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_element_set_state (vdec2, GST_STATE_NULL);
+
+  /* and beyond max-channels there is none */
+  g_object_set (vdec2, "vdec-ch", 2, NULL);
+  fail_unless_equals_int (gst_element_set_state (vdec2, GST_STATE_READY),
+      GST_STATE_CHANGE_FAILURE);
+  g_object_set (vdec2, "max-channels", 3, NULL);
+  fail_unless_equals_int (gst_element_set_state (vdec2, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_element_set_state (vdec2, GST_STATE_NULL);
+
+  g_object_set (vdec2, "vdec-ch", 1, "fail-open", TRUE, NULL);
+  fail_unless_equals_int (gst_element_set_state (vdec2, GST_STATE_READY),
+      GST_STATE_CHANGE_FAILURE);
+
+  /* the mixer is shared */
+  adec1 = gst_element_factory_make ("adecsink", NULL);
+  adec2 = gst_element_factory_make ("adecsink", NULL);
+  fail_unless (adec1 != NULL && adec2 != NULL);
+  fail_unless_equals_int (gst_element_set_state (adec1, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (adec2, GST_STATE_READY),
+      GST_STATE_CHANGE_FAILURE);
+  g_object_set (adec2, "mixer", TRUE, NULL);
+  fail_unless_equals_int (gst_element_set_state (adec2, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+
+  gst_element_set_state (adec2, GST_STATE_NULL);
+  gst_element_set_state (adec1, GST_STATE_NULL);
+  gst_element_set_state (vdec2, GST_STATE_NULL);
+  gst_element_set_state (vdec1, GST_STATE_NULL);
+  gst_object_unref (adec2);
+  gst_object_unref (adec1);
+  gst_object_unref (vdec2);
+  gst_object_unref (vdec1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_error_after)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+
+  pipeline = gst_parse_launch ("videotestsrc num-buffers=10 ! "
+      "adecsink error-after=3 decode-latency=1000000 sync=false", NULL);
+  fail_unless (pipeline != NULL);
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_ERROR);
+  gst_message_parse_error (msg, &err, NULL);
+  fail_unless (g_error_matches (err, GST_STREAM_ERROR,
+          GST_STREAM_ERROR_DECODE));
+  g_error_free (err);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static Suite *
+emusinks_suite (void)
+{
+  Suite *s = suite_create ("emusinks");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("emusinks");
+  tcase_add_test (tc_chain, test_vdecsink_pads);
+  tcase_add_test (tc_chain, test_channels);
+  tcase_add_test (tc_chain, test_error_after);
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (emusinks);
@@ -25,6 +25,11 @@
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 static GType gst_http_filter_get_type (void);
 
@@ -51,6 +56,23 @@ static GstStaticPadTemplate filter_src_templ = GST_STATIC_PAD_TEMPLATE ("src",
 
 G_DEFINE_TYPE (GstHttpFilter, gst_http_filter, GST_TYPE_ELEMENT);
 
+/* the same filter under other factories, to tell a cached choice from a
+ * fresh registry scan */
+static GType gst_http_filter2_get_type (void);
+typedef GstHttpFilter GstHttpFilter2;
+typedef GstHttpFilterClass GstHttpFilter2Class;
+G_DEFINE_TYPE (GstHttpFilter2, gst_http_filter2, gst_http_filter_get_type ());
+
+static void
+gst_http_filter2_class_init (GstHttpFilter2Class * klass)
+{
+}
+
+static void
+gst_http_filter2_init (GstHttpFilter2 * filter)
+{
+}
+
 static void
 gst_http_filter_finalize (GObject * object)
 {
@@ -75,11 +97,20 @@ gst_http_filter_class_init (GstHttpFilterClass * klass)
       "Hoonhee Lee <hoonhee.lee@lge.com>");
 }
 
+static GstFlowReturn
+gst_http_filter_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstHttpFilter *filter = (GstHttpFilter *) parent;
+
+  return gst_pad_push (filter->srcpad, buffer);
+}
+
 static void
 gst_http_filter_init (GstHttpFilter * filter)
 {
   filter->sinkpad =
       gst_pad_new_from_static_template (&filter_sink_templ, "sink");
+  gst_pad_set_chain_function (filter->sinkpad, gst_http_filter_chain);
   gst_element_add_pad (GST_ELEMENT (filter), filter->sinkpad);
 
   filter->srcpad = gst_pad_new_from_static_template (&filter_src_templ, "src");
@@ -270,6 +301,458 @@ GST_START_TEST (test_repeat_state_change)
 
 GST_END_TEST;
 
+/* the filter element of @httpextbin comes from @factory_name */
+static gboolean
+has_filter_from (GstElement * httpextbin, const gchar * factory_name)
+{
+  GstIterator *it;
+  GValue item = { 0, };
+  gboolean found = FALSE;
+
+  it = gst_bin_iterate_elements (GST_BIN (httpextbin));
+  while (gst_iterator_next (it, &item) == GST_ITERATOR_OK) {
+    GstElementFactory *factory =
+        gst_element_get_factory (g_value_get_object (&item));
+
+    if (factory && !strcmp (GST_OBJECT_NAME (factory), factory_name))
+      found = TRUE;
+    g_value_reset (&item);
+  }
+  g_value_unset (&item);
+  gst_iterator_free (it);
+
+  return found;
+}
+
+GST_START_TEST (test_filter_cache)
+{
+  GstElement *httpextbin, *other;
+  GstPluginFeature *filter2;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+  fail_unless (gst_element_register (NULL, "httpfilter2",
+          GST_RANK_PRIMARY, gst_http_filter2_get_type ()));
+
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  other = gst_element_factory_make ("httpextbin", NULL);
+  g_object_set (httpextbin, "uri", "http+justin://", NULL);
+  g_object_set (other, "uri", "http+justin://", NULL);
+
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (has_filter_from (httpextbin, "httpfilter"));
+
+  /* a new rank leaves the registry cookie alone, so only a fresh scan
+   * would see httpfilter2 ranked above httpfilter */
+  filter2 = gst_registry_lookup_feature (gst_registry_get (), "httpfilter2");
+  fail_unless (filter2 != NULL);
+  gst_plugin_feature_set_rank (filter2, GST_RANK_PRIMARY + 200);
+  gst_object_unref (filter2);
+
+  /* the second start and the second instance use the cached factory */
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (has_filter_from (httpextbin, "httpfilter"));
+  fail_unless_equals_int (gst_element_set_state (other, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (has_filter_from (other, "httpfilter"));
+
+  /* any feature added to the registry drops the cache */
+  fail_unless (gst_element_register (NULL, "httpfilter3",
+          GST_RANK_NONE, gst_http_filter2_get_type ()));
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (httpextbin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (has_filter_from (httpextbin, "httpfilter2"));
+
+  gst_element_set_state (httpextbin, GST_STATE_NULL);
+  gst_element_set_state (other, GST_STATE_NULL);
+  gst_object_unref (httpextbin);
+  gst_object_unref (other);
+}
+
+GST_END_TEST;
+
+/* a local HTTP server answering range requests on a generated resource,
+ * one thread per connection */
+typedef struct
+{
+  gint fd;
+  guint16 port;
+  GThread *thread;
+  gboolean ranges;              /* FALSE to ignore Range */
+  guint8 *data;
+  gsize size;
+  gint64 fail_at;               /* answer 503 once to a range starting here */
+  gint64 cut_at;                /* close once a range spanning this here */
+  gint failed;
+  gint cut;
+  gint ranged;                  /* requests answered with 206 */
+  gint clients;                 /* connections being served */
+} HttpServer;
+
+typedef struct
+{
+  HttpServer *server;
+  gint fd;
+} HttpClient;
+
+static void
+http_server_write (gint fd, const guint8 * data, gsize size)
+{
+  while (size > 0) {
+    ssize_t ret = send (fd, data, size, MSG_NOSIGNAL);
+
+    if (ret <= 0)
+      return;
+    data += ret;
+    size -= ret;
+  }
+}
+
+static gpointer
+http_client_thread (HttpClient * client)
+{
+  HttpServer *server = client->server;
+  gchar request[4096], *header, *range;
+  gsize len = 0;
+  guint64 first = 0, last = server->size - 1;
+  gboolean partial = FALSE;
+  gchar *reply;
+  gsize body;
+
+  /* the headers, souphttpsrc sends no body */
+  while (len < sizeof (request) - 1) {
+    ssize_t ret = read (client->fd, request + len, sizeof (request) - 1 - len);
+
+    if (ret <= 0)
+      goto done;
+    len += ret;
+    request[len] = '\0';
+    if (strstr (request, "\r\n\r\n"))
+      break;
+  }
+
+  header = g_ascii_strdown (request, -1);
+  range = strstr (header, "\r\nrange: bytes=");
+  if (server->ranges && range && strstr (range + 2, "\r\nrange:")) {
+    /* souphttpsrc reconnecting on its own adds its Range to ours */
+    g_free (header);
+    reply = g_strdup ("HTTP/1.1 400 Bad Request\r\n"
+        "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    http_server_write (client->fd, (guint8 *) reply, strlen (reply));
+    g_free (reply);
+    goto done;
+  }
+  if (server->ranges && range) {
+    gchar *end;
+
+    first = g_ascii_strtoull (range + 15, &end, 10);
+    if (*end == '-' && g_ascii_isdigit (end[1]))
+      last = MIN (g_ascii_strtoull (end + 1, NULL, 10), server->size - 1);
+    partial = TRUE;
+  }
+  g_free (header);
+
+  if (partial && first == server->fail_at
+      && g_atomic_int_compare_and_exchange (&server->failed, 0, 1)) {
+    reply = g_strdup ("HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Length: 0\r\nConnection: close\r\n\r\n");
+    http_server_write (client->fd, (guint8 *) reply, strlen (reply));
+  } else if (partial && first >= server->size) {
+    reply = g_strdup_printf ("HTTP/1.1 416 Requested Range Not Satisfiable\r\n"
+        "Content-Range: bytes */%" G_GSIZE_FORMAT "\r\n"
+        "Content-Length: 0\r\nConnection: close\r\n\r\n", server->size);
+    http_server_write (client->fd, (guint8 *) reply, strlen (reply));
+  } else if (partial) {
+    g_atomic_int_inc (&server->ranged);
+    reply = g_strdup_printf ("HTTP/1.1 206 Partial Content\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Range: bytes %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT "/%"
+        G_GSIZE_FORMAT "\r\nContent-Length: %" G_GUINT64_FORMAT "\r\n"
+        "Accept-Ranges: bytes\r\nConnection: close\r\n\r\n", first, last,
+        server->size, last - first + 1);
+    http_server_write (client->fd, (guint8 *) reply, strlen (reply));
+    body = last - first + 1;
+    if (server->cut_at > first && server->cut_at <= last
+        && g_atomic_int_compare_and_exchange (&server->cut, 0, 1))
+      body = server->cut_at - first;
+    http_server_write (client->fd, server->data + first, body);
+  } else {
+    reply = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: %" G_GSIZE_FORMAT "\r\nConnection: close\r\n\r\n",
+        server->size);
+    http_server_write (client->fd, (guint8 *) reply, strlen (reply));
+    http_server_write (client->fd, server->data, server->size);
+  }
+  g_free (reply);
+
+done:
+  close (client->fd);
+  g_atomic_int_add (&server->clients, -1);
+  g_free (client);
+  return NULL;
+}
+
+static gpointer
+http_server_thread (HttpServer * server)
+{
+  gint fd;
+
+  while ((fd = accept (server->fd, NULL, NULL)) >= 0) {
+    HttpClient *client = g_new0 (HttpClient, 1);
+
+    client->server = server;
+    client->fd = fd;
+    g_atomic_int_inc (&server->clients);
+    g_thread_unref (g_thread_new ("httpclient",
+            (GThreadFunc) http_client_thread, client));
+  }
+
+  return NULL;
+}
+
+static HttpServer *
+http_server_new (gsize size, gboolean ranges)
+{
+  HttpServer *server = g_new0 (HttpServer, 1);
+  struct sockaddr_in addr;
+  socklen_t addrlen = sizeof (addr);
+  gsize i;
+
+  server->ranges = ranges;
+  server->size = size;
+  server->fail_at = -1;
+  server->cut_at = -1;
+  server->data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    server->data[i] = (i * 7 + i / 251) & 0xff;
+
+  server->fd = socket (AF_INET, SOCK_STREAM, 0);
+  fail_unless (server->fd >= 0);
+  memset (&addr, 0, sizeof (addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+  fail_unless (bind (server->fd, (struct sockaddr *) &addr,
+          sizeof (addr)) == 0);
+  fail_unless (listen (server->fd, 16) == 0);
+  fail_unless (getsockname (server->fd, (struct sockaddr *) &addr,
+          &addrlen) == 0);
+  server->port = ntohs (addr.sin_port);
+
+  server->thread = g_thread_new ("httpserver",
+      (GThreadFunc) http_server_thread, server);
+
+  return server;
+}
+
+static void
+http_server_free (HttpServer * server)
+{
+  /* makes accept() fail */
+  shutdown (server->fd, SHUT_RDWR);
+  g_thread_join (server->thread);
+  close (server->fd);
+  while (g_atomic_int_get (&server->clients) > 0)
+    g_usleep (1000);
+  g_free (server->data);
+  g_free (server);
+}
+
+static void
+collect_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GByteArray * received)
+{
+  GstMapInfo map;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  g_byte_array_append (received, map.data, map.size);
+  gst_buffer_unmap (buffer, &map);
+}
+
+/* plays http+justin:// from @server through @connections from @seek on,
+ * returns what reached the sink and the connection stats at the end */
+static GByteArray *
+download_segmented (HttpServer * server, guint connections, gint64 seek,
+    GstStructure ** stats)
+{
+  GstElement *pipeline, *httpextbin, *sink;
+  GByteArray *received;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *uri;
+
+  fail_unless (gst_element_register (NULL, "httpfilter",
+          GST_RANK_PRIMARY + 100, gst_http_filter_get_type ()));
+
+  pipeline = gst_pipeline_new (NULL);
+  httpextbin = gst_element_factory_make ("httpextbin", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (httpextbin != NULL && sink != NULL);
+
+  uri = g_strdup_printf ("http+justin://127.0.0.1:%u/resource", server->port);
+  g_object_set (httpextbin, "uri", uri, "connections", connections,
+      "segment-size", 65536, NULL);
+  g_free (uri);
+
+  received = g_byte_array_new ();
+  g_object_set (sink, "signal-handoffs", TRUE, "sync", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (collect_handoff_cb),
+      received);
+
+  gst_bin_add_many (GST_BIN (pipeline), httpextbin, sink, NULL);
+  fail_unless (gst_element_link (httpextbin, sink));
+
+  if (seek > 0) {
+    fail_if (gst_element_set_state (pipeline, GST_STATE_PAUSED) ==
+        GST_STATE_CHANGE_FAILURE);
+    fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL, -1),
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_BYTES,
+            GST_SEEK_FLAG_FLUSH, seek));
+    fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL, -1),
+        GST_STATE_CHANGE_SUCCESS);
+    /* in PAUSED the preroll buffer is not rendered */
+    fail_unless_equals_int (received->len, 0);
+  }
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 10 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL, "no EOS");
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  g_object_get (httpextbin, "connection-stats", stats, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return received;
+}
+
+GST_START_TEST (test_segmented_download)
+{
+  HttpServer *server;
+  GByteArray *received;
+  GstStructure *stats;
+  guint64 bytes, total = 0;
+  guint n, i;
+
+  /* four full segments and a short one */
+  server = http_server_new (300000, TRUE);
+  received = download_segmented (server, 3, 0, &stats);
+
+  fail_unless_equals_int (received->len, 300000);
+  fail_unless (memcmp (received->data, server->data, server->size) == 0);
+  fail_unless (g_atomic_int_get (&server->ranged) >= 5);
+
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get_uint (stats, "connections", &n));
+  fail_unless_equals_int (n, 3);
+  for (i = 0; i < n; i++) {
+    gchar *field = g_strdup_printf ("bytes-%u", i);
+
+    fail_unless (gst_structure_get_uint64 (stats, field, &bytes));
+    total += bytes;
+    g_free (field);
+  }
+  fail_unless_equals_uint64 (total, 300000);
+  gst_structure_free (stats);
+
+  g_byte_array_unref (received);
+  http_server_free (server);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_segmented_no_ranges)
+{
+  HttpServer *server;
+  GByteArray *received;
+  GstStructure *stats;
+
+  /* the whole resource comes over the first connection */
+  server = http_server_new (200000, FALSE);
+  received = download_segmented (server, 3, 0, &stats);
+
+  fail_unless_equals_int (received->len, 200000);
+  fail_unless (memcmp (received->data, server->data, server->size) == 0);
+  fail_unless_equals_int (g_atomic_int_get (&server->ranged), 0);
+  gst_structure_free (stats);
+
+  g_byte_array_unref (received);
+  http_server_free (server);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_segmented_retry)
+{
+  HttpServer *server;
+  GByteArray *received;
+  GstStructure *stats;
+  guint retries, total = 0;
+  guint n, i;
+
+  /* the second segment fails before its first byte, the third half way */
+  server = http_server_new (300000, TRUE);
+  server->fail_at = 65536;
+  server->cut_at = 2 * 65536 + 30000;
+  received = download_segmented (server, 3, 0, &stats);
+
+  fail_unless_equals_int (g_atomic_int_get (&server->failed), 1);
+  fail_unless_equals_int (g_atomic_int_get (&server->cut), 1);
+  fail_unless_equals_int (received->len, 300000);
+  fail_unless (memcmp (received->data, server->data, server->size) == 0);
+
+  fail_unless (gst_structure_get_uint (stats, "connections", &n));
+  for (i = 0; i < n; i++) {
+    gchar *field = g_strdup_printf ("retries-%u", i);
+
+    fail_unless (gst_structure_get_uint (stats, field, &retries));
+    total += retries;
+    g_free (field);
+  }
+  fail_unless_equals_int (total, 2);
+  gst_structure_free (stats);
+
+  g_byte_array_unref (received);
+  http_server_free (server);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_segmented_seek)
+{
+  HttpServer *server;
+  GByteArray *received;
+  GstStructure *stats;
+
+  /* restarts the segments from the middle of the second one */
+  server = http_server_new (300000, TRUE);
+  received = download_segmented (server, 3, 100000, &stats);
+
+  fail_unless_equals_int (received->len, 300000 - 100000);
+  fail_unless (memcmp (received->data, server->data + 100000,
+          received->len) == 0);
+  gst_structure_free (stats);
+
+  g_byte_array_unref (received);
+  http_server_free (server);
+}
+
+GST_END_TEST;
+
 static Suite *
 httpextbin_suite (void)
 {
@@ -282,6 +765,11 @@ httpextbin_suite (void)
   tcase_add_test (tc_chain, test_missing_plugin);
   tcase_add_test (tc_chain, test_set_state_paused);
   tcase_add_test (tc_chain, test_repeat_state_change);
+  tcase_add_test (tc_chain, test_filter_cache);
+  tcase_add_test (tc_chain, test_segmented_download);
+  tcase_add_test (tc_chain, test_segmented_no_ranges);
+  tcase_add_test (tc_chain, test_segmented_retry);
+  tcase_add_test (tc_chain, test_segmented_seek);
 
   suite_add_tcase (s, tc_chain);
 
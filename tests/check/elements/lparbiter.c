@@ -0,0 +1,194 @@
+/* GStreamer unit tests for the lpsink decoder resource arbiter
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstlparbiter.h"
+
+typedef struct
+{
+  gint priority;
+  GstClockTime timeout;
+  gint channel;                 /* granted */
+  GstClockTime waited;
+} Request;
+
+static GMutex order_lock;
+static GPtrArray *order;        /* requests in the order they were served */
+
+static gpointer
+acquire_thread (Request * req)
+{
+  req->channel = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE,
+      req->priority, req, NULL, req->timeout, &req->waited);
+
+  if (req->channel >= 0) {
+    g_mutex_lock (&order_lock);
+    g_ptr_array_add (order, req);
+    g_mutex_unlock (&order_lock);
+    gst_lp_arbiter_release (GST_LP_RESOURCE_VDEC, req->channel, req);
+  }
+
+  return NULL;
+}
+
+static void
+setup (void)
+{
+  gst_lp_arbiter_set_capacity (GST_LP_RESOURCE_VDEC, 1);
+  order = g_ptr_array_new ();
+}
+
+static void
+teardown (void)
+{
+  g_ptr_array_unref (order);
+  order = NULL;
+}
+
+GST_START_TEST (test_priority_order)
+{
+  Request low = { G_MININT, GST_CLOCK_TIME_NONE, -1, 0 };
+  Request high = { G_MAXINT, GST_CLOCK_TIME_NONE, -1, 0 };
+  GThread *low_thread, *high_thread;
+  gint holder;
+
+  holder = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE, 0,
+      &holder, NULL, 0, NULL);
+  fail_unless_equals_int (holder, 0);
+
+  /* the low priority request queues first, the extreme priorities must not
+   * overflow the queue ordering */
+  low_thread = g_thread_new ("low", (GThreadFunc) acquire_thread, &low);
+  g_usleep (100 * 1000);
+  high_thread = g_thread_new ("high", (GThreadFunc) acquire_thread, &high);
+  g_usleep (100 * 1000);
+
+  gst_lp_arbiter_release (GST_LP_RESOURCE_VDEC, holder, &holder);
+
+  g_thread_join (high_thread);
+  g_thread_join (low_thread);
+
+  fail_unless_equals_int (order->len, 2);
+  fail_unless (g_ptr_array_index (order, 0) == &high);
+  fail_unless (g_ptr_array_index (order, 1) == &low);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_timeout)
+{
+  Request req = { 0, 100 * GST_MSECOND, -1, 0 };
+  gint holder;
+
+  holder = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE, 0,
+      &holder, NULL, 0, NULL);
+  fail_unless_equals_int (holder, 0);
+
+  /* a higher priority does not help without a preempt function */
+  req.priority = 10;
+  acquire_thread (&req);
+
+  fail_unless_equals_int (req.channel, -1);
+  fail_unless (req.waited >= 100 * GST_MSECOND);
+  fail_unless_equals_int (order->len, 0);
+
+  gst_lp_arbiter_release_all (&holder);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_release_wakeup)
+{
+  Request req = { 0, 5 * GST_SECOND, -1, 0 };
+  GThread *thread;
+  gint holder;
+
+  holder = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE, 0,
+      &holder, NULL, 0, NULL);
+  fail_unless_equals_int (holder, 0);
+
+  thread = g_thread_new ("waiter", (GThreadFunc) acquire_thread, &req);
+  g_usleep (100 * 1000);
+  gst_lp_arbiter_release (GST_LP_RESOURCE_VDEC, holder, &holder);
+  g_thread_join (thread);
+
+  fail_unless_equals_int (req.channel, 0);
+  fail_unless (req.waited >= 100 * GST_MSECOND);
+  fail_unless (req.waited < 5 * GST_SECOND);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_flushing)
+{
+  Request req = { 0, GST_CLOCK_TIME_NONE, -1, 0 };
+  GThread *thread;
+  gint holder;
+
+  holder = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE, 0,
+      &holder, NULL, 0, NULL);
+  fail_unless_equals_int (holder, 0);
+
+  /* a wait without timeout ends when its owner is set flushing */
+  thread = g_thread_new ("waiter", (GThreadFunc) acquire_thread, &req);
+  g_usleep (100 * 1000);
+  gst_lp_arbiter_set_flushing (&req, TRUE);
+  g_thread_join (thread);
+
+  fail_unless_equals_int (req.channel, -1);
+  fail_unless_equals_int (order->len, 0);
+
+  /* and later requests fail right away, even with a free channel */
+  gst_lp_arbiter_release (GST_LP_RESOURCE_VDEC, holder, &holder);
+  acquire_thread (&req);
+  fail_unless_equals_int (req.channel, -1);
+
+  gst_lp_arbiter_set_flushing (&req, FALSE);
+  acquire_thread (&req);
+  fail_unless_equals_int (req.channel, 0);
+  fail_unless_equals_int (order->len, 1);
+}
+
+GST_END_TEST;
+
+static Suite *
+lparbiter_suite (void)
+{
+  Suite *s = suite_create ("lparbiter");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("lparbiter");
+  tcase_add_checked_fixture (tc_chain, setup, teardown);
+  tcase_add_test (tc_chain, test_priority_order);
+  tcase_add_test (tc_chain, test_timeout);
+  tcase_add_test (tc_chain, test_release_wakeup);
+  tcase_add_test (tc_chain, test_flushing);
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (lparbiter);
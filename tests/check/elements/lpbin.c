@@ -26,8 +26,10 @@
 #include <gst/check/gstcheck.h>
 #include <gst/base/gstpushsrc.h>
 #include <unistd.h>
+#include <glib/gstdio.h>
 
 static GType gst_red_video_src_get_type (void);
+static GType gst_fd_test_src_get_type (void);
 
 GST_START_TEST (test_uri)
 {
@@ -55,6 +57,107 @@ GST_START_TEST (test_uri)
 
 GST_END_TEST;
 
+static const gchar srt_data[] =
+    "1\n00:00:01,000 --> 00:00:02,000\none\n\n"
+    "2\n00:00:04,000 --> 00:00:05,000\ntwo\n\n"
+    "3\n00:00:07,000 --> 00:00:08,000\nthree\n\n";
+
+GST_START_TEST (test_suburi_paced)
+{
+  GstElement *lpbin;
+  GstBus *bus;
+  GstMessage *msg;
+  GstStateChangeReturn ret;
+  gchar *path = NULL, *uri;
+  gint fd, cues = 0;
+  gint64 end;
+
+  fail_unless (gst_element_register (NULL, "fdtestsrc", GST_RANK_PRIMARY,
+          gst_fd_test_src_get_type ()));
+
+  fd = g_file_open_tmp ("lpbin-XXXXXX.srt", &path, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (g_file_set_contents (path, srt_data, -1, NULL));
+  uri = g_filename_to_uri (path, NULL, NULL);
+
+  lpbin = gst_element_factory_make ("lpbin", "lpbin");
+  fail_unless (lpbin != NULL, "Failed to create lpbin element");
+  g_object_set (lpbin, "uri", "fdvideo://", "suburi", uri,
+      "video-sink-desc", "fakesink sync=true", NULL);
+
+  ret = gst_element_set_state (lpbin, GST_STATE_PLAYING);
+  fail_if (ret == GST_STATE_CHANGE_FAILURE);
+  ret = gst_element_get_state (lpbin, NULL, NULL, 5 * GST_SECOND);
+  fail_unless_equals_int (ret, GST_STATE_CHANGE_SUCCESS);
+
+  /* the cue at 4s is held back by the 1s lead until 3s, so only the
+   * first one may be out after a second and a half of playback */
+  bus = gst_element_get_bus (lpbin);
+  end = g_get_monotonic_time () + 1500 * G_TIME_SPAN_MILLISECOND;
+  while (g_get_monotonic_time () < end) {
+    msg = gst_bus_timed_pop (bus, 50 * GST_MSECOND);
+    if (msg == NULL)
+      continue;
+    fail_if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR);
+    if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_APPLICATION &&
+        gst_message_has_name (msg, "subtitle_data"))
+      cues++;
+    gst_message_unref (msg);
+  }
+  fail_unless_equals_int (cues, 1);
+
+  gst_object_unref (bus);
+  gst_element_set_state (lpbin, GST_STATE_NULL);
+  gst_object_unref (lpbin);
+  g_unlink (path);
+  g_free (path);
+  g_free (uri);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_thumbnail_audio_only)
+{
+  GstElement *lpbin;
+  GstStructure *smart_prop;
+  GstBus *bus;
+  GstMessage *msg;
+  GError *err = NULL;
+
+  fail_unless (gst_element_register (NULL, "fdtestsrc", GST_RANK_PRIMARY,
+          gst_fd_test_src_get_type ()));
+
+  lpbin = gst_element_factory_make ("lpbin", "lpbin");
+  fail_unless (lpbin != NULL, "Failed to create lpbin element");
+
+  smart_prop = gst_structure_new ("smart-properties", "thumbnail-mode",
+      G_TYPE_BOOLEAN, TRUE, NULL);
+  g_object_set (lpbin, "uri", "fdaudio://", "smart-properties", smart_prop,
+      NULL);
+  gst_structure_free (smart_prop);
+
+  gst_element_set_state (lpbin, GST_STATE_PAUSED);
+
+  /* the audio stream is left unlinked, lpbin must not wait for video */
+  bus = gst_element_get_bus (lpbin);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_ERROR | GST_MESSAGE_ASYNC_DONE);
+  fail_unless (msg != NULL, "no error about the missing video stream");
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_ERROR);
+  gst_message_parse_error (msg, &err, NULL);
+  fail_unless (g_error_matches (err, GST_STREAM_ERROR,
+          GST_STREAM_ERROR_WRONG_TYPE));
+  g_error_free (err);
+  gst_message_unref (msg);
+
+  gst_object_unref (bus);
+  gst_element_set_state (lpbin, GST_STATE_NULL);
+  gst_object_unref (lpbin);
+}
+
+GST_END_TEST;
+
 /*** redvideo:// source ***/
 
 static GstURIType
@@ -165,6 +268,155 @@ gst_red_video_src_init (GstRedVideoSrc * src)
 {
 }
 
+/*** fdvideo:// and fdaudio:// source ***/
+
+static GstURIType
+gst_fd_test_src_uri_get_type (GType type)
+{
+  return GST_URI_SRC;
+}
+
+static const gchar *const *
+gst_fd_test_src_uri_get_protocols (GType type)
+{
+  static const gchar *protocols[] = { "fdvideo", "fdaudio", NULL };
+
+  return protocols;
+}
+
+/* already decoded frames, which lpbin links without a decoder */
+typedef struct
+{
+  GstPushSrc parent;
+  gboolean audio;
+  GstClockTime next;
+} GstFdTestSrc;
+typedef GstPushSrcClass GstFdTestSrcClass;
+
+static gchar *
+gst_fd_test_src_uri_get_uri (GstURIHandler * handler)
+{
+  return g_strdup (((GstFdTestSrc *) handler)->audio ? "fdaudio://" :
+      "fdvideo://");
+}
+
+static gboolean
+gst_fd_test_src_uri_set_uri (GstURIHandler * handler, const gchar * uri,
+    GError ** error)
+{
+  if (uri == NULL)
+    return FALSE;
+
+  if (g_str_has_prefix (uri, "fdaudio:"))
+    ((GstFdTestSrc *) handler)->audio = TRUE;
+  else if (!g_str_has_prefix (uri, "fdvideo:"))
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gst_fd_test_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_fd_test_src_uri_get_type;
+  iface->get_protocols = gst_fd_test_src_uri_get_protocols;
+  iface->get_uri = gst_fd_test_src_uri_get_uri;
+  iface->set_uri = gst_fd_test_src_uri_set_uri;
+}
+
+static void
+gst_fd_test_src_init_type (GType type)
+{
+  static const GInterfaceInfo uri_hdlr_info = {
+    gst_fd_test_src_uri_handler_init, NULL, NULL
+  };
+
+  g_type_add_interface_static (type, GST_TYPE_URI_HANDLER, &uri_hdlr_info);
+}
+
+G_DEFINE_TYPE_WITH_CODE (GstFdTestSrc, gst_fd_test_src,
+    GST_TYPE_PUSH_SRC, gst_fd_test_src_init_type (g_define_type_id));
+
+/* lpbin hands its smart-properties to every source */
+static void
+gst_fd_test_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+}
+
+static void
+gst_fd_test_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static gboolean
+gst_fd_test_src_start (GstBaseSrc * src)
+{
+  ((GstFdTestSrc *) src)->next = 0;
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_fd_test_src_create (GstPushSrc * src, GstBuffer ** p_buf)
+{
+  GstFdTestSrc *self = (GstFdTestSrc *) src;
+  GstBuffer *buf;
+
+  buf = gst_buffer_new_and_alloc (4);
+  GST_BUFFER_PTS (buf) = self->next;
+  GST_BUFFER_DURATION (buf) = 40 * GST_MSECOND;
+  self->next += 40 * GST_MSECOND;
+
+  *p_buf = buf;
+  return GST_FLOW_OK;
+}
+
+static GstCaps *
+gst_fd_test_src_get_caps (GstBaseSrc * src, GstCaps * filter)
+{
+  return gst_caps_new_empty_simple (((GstFdTestSrc *) src)->audio ?
+      "audio/x-fd" : "video/x-fd");
+}
+
+static void
+gst_fd_test_src_class_init (GstFdTestSrcClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstPushSrcClass *pushsrc_class = GST_PUSH_SRC_CLASS (klass);
+  GstBaseSrcClass *basesrc_class = GST_BASE_SRC_CLASS (klass);
+  static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
+      GST_PAD_SRC, GST_PAD_ALWAYS,
+      GST_STATIC_CAPS ("video/x-fd; audio/x-fd")
+      );
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_templ));
+  gst_element_class_set_metadata (element_class,
+      "Fd Test Src", "Source/Video", "yep", "me");
+
+  gobject_class->set_property = gst_fd_test_src_set_property;
+  gobject_class->get_property = gst_fd_test_src_get_property;
+  g_object_class_install_property (gobject_class, 1,
+      g_param_spec_boxed ("smart-properties", "Smart Properties",
+          "Ignored", GST_TYPE_STRUCTURE,
+          G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
+
+  pushsrc_class->create = gst_fd_test_src_create;
+  basesrc_class->start = gst_fd_test_src_start;
+  basesrc_class->get_caps = gst_fd_test_src_get_caps;
+}
+
+static void
+gst_fd_test_src_init (GstFdTestSrc * src)
+{
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+}
+
 static Suite *
 lpbin_suite (void)
 {
@@ -174,6 +426,8 @@ lpbin_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_uri);
+  tcase_add_test (tc_chain, test_suburi_paced);
+  tcase_add_test (tc_chain, test_thumbnail_audio_only);
 
   return s;
 }
@@ -0,0 +1,202 @@
+/* GStreamer unit tests for the lpsink A/V drift monitor
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstlpdrift.h"
+
+static GMutex video_lock;
+static GCond video_cond;
+static gboolean video_blocked;
+static gint video_waiting;
+static gint video_received;
+
+/* the video sink holds the first buffer until released */
+static GstFlowReturn
+video_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  g_atomic_int_inc (&video_waiting);
+
+  g_mutex_lock (&video_lock);
+  while (video_blocked)
+    g_cond_wait (&video_cond, &video_lock);
+  g_mutex_unlock (&video_lock);
+
+  gst_buffer_unref (buf);
+  g_atomic_int_inc (&video_received);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+audio_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  gst_buffer_unref (buf);
+
+  return GST_FLOW_OK;
+}
+
+static GstBuffer *
+new_timed_buffer (GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, 16, NULL);
+
+  GST_BUFFER_PTS (buf) = pts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+
+  return buf;
+}
+
+static GstPad *
+setup_queue_pads (GstElement * queue, GstPadChainFunction chain,
+    const gchar * stream_id, GstPad ** mysink)
+{
+  GstPad *mysrc, *pad;
+  GstCaps *caps;
+
+  mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  pad = gst_element_get_static_pad (queue, "sink");
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (mysrc, pad)));
+  gst_object_unref (pad);
+
+  *mysink = gst_pad_new ("mysink", GST_PAD_SINK);
+  gst_pad_set_chain_function (*mysink, chain);
+  pad = gst_element_get_static_pad (queue, "src");
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (pad, *mysink)));
+  gst_object_unref (pad);
+
+  gst_pad_set_active (*mysink, TRUE);
+  gst_pad_set_active (mysrc, TRUE);
+
+  caps = gst_caps_new_empty_simple ("application/x-test");
+  gst_check_setup_events_with_stream_id (mysrc, queue, caps, GST_FORMAT_TIME,
+      stream_id);
+  gst_caps_unref (caps);
+
+  return mysrc;
+}
+
+static guint
+get_stats_uint (GstLpDriftMonitor * monitor, const gchar * field)
+{
+  GstStructure *stats = gst_lp_drift_monitor_get_stats (monitor);
+  guint value = 0;
+
+  fail_unless (gst_structure_get_uint (stats, field, &value));
+  gst_structure_free (stats);
+
+  return value;
+}
+
+GST_START_TEST (test_grow_and_restore)
+{
+  GstElement *bin, *vqueue, *aqueue;
+  GstPad *vsrc, *asrc, *vsink, *asink;
+  GstLpDriftMonitor *monitor;
+  gint i;
+
+  bin = gst_bin_new (NULL);
+  vqueue = gst_element_factory_make ("queue", NULL);
+  aqueue = gst_element_factory_make ("queue", NULL);
+  fail_unless (vqueue && aqueue);
+  g_object_set (vqueue, "max-size-buffers", 2, "max-size-bytes", 0,
+      "max-size-time", (guint64) 0, NULL);
+  gst_bin_add_many (GST_BIN (bin), vqueue, aqueue, NULL);
+
+  vsrc = setup_queue_pads (vqueue, video_chain, "video", &vsink);
+  asrc = setup_queue_pads (aqueue, audio_chain, "audio", &asink);
+
+  monitor = gst_lp_drift_monitor_new (NULL, vqueue, aqueue, GST_SECOND);
+  fail_unless (monitor != NULL);
+
+  video_blocked = TRUE;
+  fail_unless (gst_element_set_state (bin, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* audio stays at 0 while video runs ahead: the first buffer waits in the
+   * sink, the next two fill the queue, the fourth and the sixth overrun
+   * it */
+  fail_unless (gst_pad_push (asrc, new_timed_buffer (0)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (vsrc, new_timed_buffer (0)) == GST_FLOW_OK);
+  for (i = 0; i < 500 && !g_atomic_int_get (&video_waiting); i++)
+    g_usleep (10 * 1000);
+  fail_unless (g_atomic_int_get (&video_waiting));
+
+  for (i = 1; i < 6; i++)
+    fail_unless (gst_pad_push (vsrc,
+            new_timed_buffer (i * GST_SECOND)) == GST_FLOW_OK);
+
+  fail_unless_equals_int (get_stats_uint (monitor, "grown"), 2);
+  fail_unless_equals_int (get_stats_uint (monitor, "video-scale"), 4);
+  fail_unless_equals_int (get_stats_uint (monitor, "video-max-buffers"), 8);
+  fail_unless_equals_int (get_stats_uint (monitor, "audio-scale"), 1);
+
+  /* audio catches up, the next video buffer out gives the room back */
+  fail_unless (gst_pad_push (asrc,
+          new_timed_buffer (5 * GST_SECOND)) == GST_FLOW_OK);
+
+  g_mutex_lock (&video_lock);
+  video_blocked = FALSE;
+  g_cond_broadcast (&video_cond);
+  g_mutex_unlock (&video_lock);
+
+  for (i = 0; i < 500 && g_atomic_int_get (&video_received) < 6; i++)
+    g_usleep (10 * 1000);
+  fail_unless_equals_int (g_atomic_int_get (&video_received), 6);
+
+  fail_unless_equals_int (get_stats_uint (monitor, "restored"), 1);
+  fail_unless_equals_int (get_stats_uint (monitor, "video-scale"), 1);
+  fail_unless_equals_int (get_stats_uint (monitor, "video-max-buffers"), 2);
+
+  gst_lp_drift_monitor_free (monitor);
+  gst_element_set_state (bin, GST_STATE_NULL);
+
+  gst_pad_set_active (vsrc, FALSE);
+  gst_pad_set_active (asrc, FALSE);
+  gst_pad_set_active (vsink, FALSE);
+  gst_pad_set_active (asink, FALSE);
+  gst_object_unref (vsrc);
+  gst_object_unref (asrc);
+  gst_object_unref (vsink);
+  gst_object_unref (asink);
+  gst_object_unref (bin);
+}
+
+GST_END_TEST;
+
+static Suite *
+lpdrift_suite (void)
+{
+  Suite *s = suite_create ("lpdrift");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("lpdrift");
+  tcase_add_test (tc_chain, test_grow_and_restore);
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (lpdrift);
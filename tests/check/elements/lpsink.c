@@ -0,0 +1,347 @@
+/* GStreamer unit tests for lpsink
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstlpsink.h"
+#include "gstlparbiter.h"
+
+static GstPad *mysrc;
+
+/* Link a single video stream to @lpsink in PAUSED */
+static void
+push_video_stream (GstElement * pipeline, GstElement * lpsink)
+{
+  GstPad *sinkpad;
+  GstCaps *caps;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  gst_lp_sink_set_expected_streams (GST_LP_SINK (lpsink), 1);
+
+  sinkpad = gst_element_get_request_pad (lpsink, "video_sink");
+  fail_unless (sinkpad != NULL);
+  mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (mysrc, sinkpad)));
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (mysrc, TRUE);
+
+  caps = gst_caps_new_empty_simple ("video/x-h264");
+  gst_check_setup_events_with_stream_id (mysrc, lpsink, caps, GST_FORMAT_TIME,
+      "video");
+  gst_caps_unref (caps);
+}
+
+/* Start a session with a single video stream through @lpsink, which the
+ * emulated vdecsink takes, and return that sink */
+static GstElement *
+start_video_session (GstElement * pipeline, GstElement * lpsink)
+{
+  GstElement *video_sink = NULL;
+  GstBus *bus;
+  GstMessage *msg;
+  gboolean configured = FALSE;
+
+  push_video_stream (pipeline, lpsink);
+
+  /* the chains are built from the streaming thread of the stream's queue */
+  bus = gst_element_get_bus (pipeline);
+  while (!configured && (msg = gst_bus_timed_pop_filtered (bus,
+              5 * GST_SECOND, GST_MESSAGE_ELEMENT | GST_MESSAGE_ERROR))) {
+    fail_if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR);
+    configured = gst_structure_has_name (gst_message_get_structure (msg),
+        "lpsink-configured");
+    gst_message_unref (msg);
+  }
+  gst_object_unref (bus);
+  fail_unless (configured);
+
+  g_object_get (lpsink, "video-sink", &video_sink, NULL);
+  fail_unless (video_sink != NULL);
+
+  return video_sink;
+}
+
+static void
+stop_video_session (GstElement * pipeline)
+{
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_pad_set_active (mysrc, FALSE);
+  gst_object_unref (mysrc);
+  mysrc = NULL;
+}
+
+GST_START_TEST (test_reuse_pooled_sink)
+{
+  GstElement *pipeline, *lpsink, *first, *second;
+
+  pipeline = gst_pipeline_new (NULL);
+  lpsink = g_object_new (GST_TYPE_LP_SINK, NULL);
+  g_object_set (lpsink, "reuse-sinks", TRUE, "single-phase", TRUE, NULL);
+  gst_bin_add (GST_BIN (pipeline), lpsink);
+
+  first = start_video_session (pipeline, lpsink);
+  fail_unless_equals_string (GST_OBJECT_NAME (gst_element_get_factory
+          (first)), "vdecsink");
+  fail_unless_equals_int (first->numsinkpads, 1);
+  stop_video_session (pipeline);
+
+  /* kept open, without the pad the chain requested */
+  fail_unless_equals_int (GST_STATE (first), GST_STATE_READY);
+  fail_unless_equals_int (first->numsinkpads, 0);
+
+  /* the next session takes it again and requests a single pad */
+  second = start_video_session (pipeline, lpsink);
+  fail_unless (second == first);
+  fail_unless_equals_int (second->numsinkpads, 1);
+  stop_video_session (pipeline);
+
+  gst_object_unref (second);
+  gst_object_unref (first);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_shutdown_while_waiting)
+{
+  GstElement *pipeline, *lpsink, *video_sink = NULL;
+  gint holder, other;
+
+  /* the only channel is taken, lpsink waits for it without a timeout */
+  gst_lp_arbiter_set_capacity (GST_LP_RESOURCE_VDEC, 1);
+  holder = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE, 0,
+      &holder, NULL, 0, NULL);
+  fail_unless_equals_int (holder, 0);
+
+  pipeline = gst_pipeline_new (NULL);
+  lpsink = g_object_new (GST_TYPE_LP_SINK, NULL);
+  g_object_set (lpsink, "resource-arbitration", TRUE, "resource-timeout",
+      GST_CLOCK_TIME_NONE, "single-phase", TRUE, NULL);
+  gst_bin_add (GST_BIN (pipeline), lpsink);
+
+  push_video_stream (pipeline, lpsink);
+  g_usleep (100 * 1000);
+
+  /* going down ends the wait instead of deadlocking on it */
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  g_object_get (lpsink, "video-sink", &video_sink, NULL);
+  fail_unless (video_sink == NULL);
+
+  /* and lpsink did not take the channel on its way out */
+  gst_lp_arbiter_release (GST_LP_RESOURCE_VDEC, holder, &holder);
+  other = gst_lp_arbiter_acquire (GST_LP_RESOURCE_VDEC, -1, FALSE, 0,
+      &other, NULL, 0, NULL);
+  fail_unless_equals_int (other, 0);
+  gst_lp_arbiter_release (GST_LP_RESOURCE_VDEC, other, &other);
+
+  gst_pad_set_active (mysrc, FALSE);
+  gst_object_unref (mysrc);
+  mysrc = NULL;
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_video_sink_desc)
+{
+  GstElement *pipeline, *lpsink, *video_sink, *inner;
+
+  pipeline = gst_pipeline_new (NULL);
+  lpsink = g_object_new (GST_TYPE_LP_SINK, NULL);
+  g_object_set (lpsink, "video-sink-desc", "fakesink name=custom",
+      "reuse-sinks", TRUE, "single-phase", TRUE, NULL);
+  gst_bin_add (GST_BIN (pipeline), lpsink);
+
+  /* a factory name with properties is used as is */
+  video_sink = start_video_session (pipeline, lpsink);
+  fail_unless_equals_string (GST_OBJECT_NAME (gst_element_get_factory
+          (video_sink)), "fakesink");
+  fail_unless_equals_string (GST_OBJECT_NAME (video_sink), "custom");
+  fail_unless (GST_OBJECT_PARENT (video_sink) != NULL);
+  stop_video_session (pipeline);
+
+  /* custom sinks are not kept for the next session */
+  fail_if (GST_OBJECT_PARENT (video_sink) != NULL);
+  gst_object_unref (video_sink);
+
+  /* a launch snippet is wrapped in a bin */
+  g_object_set (lpsink, "video-sink-desc", "queue ! fakesink name=inner",
+      NULL);
+  video_sink = start_video_session (pipeline, lpsink);
+  fail_unless (GST_IS_BIN (video_sink));
+  inner = gst_bin_get_by_name (GST_BIN (video_sink), "inner");
+  fail_unless (inner != NULL);
+  fail_unless_equals_string (GST_OBJECT_NAME (gst_element_get_factory
+          (inner)), "fakesink");
+  gst_object_unref (inner);
+  stop_video_session (pipeline);
+
+  gst_object_unref (video_sink);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static GMutex seek_lock;
+static GCond seek_cond;
+static gboolean seek_blocked;
+static GList *seeks;
+
+/* Upstream end of the seeks. The first one stays here until released */
+static gboolean
+seek_event_cb (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
+    g_mutex_lock (&seek_lock);
+    seeks = g_list_append (seeks,
+        GUINT_TO_POINTER (gst_event_get_seqnum (event)));
+    g_cond_broadcast (&seek_cond);
+    while (seek_blocked)
+      g_cond_wait (&seek_cond, &seek_lock);
+    g_mutex_unlock (&seek_lock);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static GstEvent *
+new_flushing_seek (gint64 position)
+{
+  return gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+      GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, -1);
+}
+
+static GstStructure *
+pop_seek_done (GstBus * bus)
+{
+  GstMessage *msg;
+  GstStructure *s = NULL;
+
+  while (!s && (msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+              GST_MESSAGE_ELEMENT))) {
+    if (gst_structure_has_name (gst_message_get_structure (msg),
+            "lpsink-seek-done"))
+      s = gst_structure_copy (gst_message_get_structure (msg));
+    gst_message_unref (msg);
+  }
+  fail_unless (s != NULL, "no lpsink-seek-done");
+
+  return s;
+}
+
+#define NUM_BURST_SEEKS 5
+
+GST_START_TEST (test_seek_coalescing)
+{
+  GstElement *pipeline, *lpsink, *video_sink;
+  GstEvent *event;
+  GstStructure *s;
+  GstBus *bus;
+  guint seqnum, last_seqnum = 0, coalesced;
+  gboolean success;
+  gint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  lpsink = g_object_new (GST_TYPE_LP_SINK, NULL);
+  g_object_set (lpsink, "video-sink-desc", "fakesink", "seek-coalescing",
+      TRUE, "single-phase", TRUE, NULL);
+  gst_bin_add (GST_BIN (pipeline), lpsink);
+
+  video_sink = start_video_session (pipeline, lpsink);
+  gst_pad_set_event_function (mysrc, seek_event_cb);
+  bus = gst_element_get_bus (pipeline);
+
+  /* the seek thread gets stuck in the first seek */
+  seek_blocked = TRUE;
+  fail_unless (gst_element_send_event (lpsink, new_flushing_seek (0)));
+  g_mutex_lock (&seek_lock);
+  while (seeks == NULL)
+    g_cond_wait (&seek_cond, &seek_lock);
+  g_mutex_unlock (&seek_lock);
+
+  /* a burst queued meanwhile comes down to its last seek */
+  for (i = 1; i <= NUM_BURST_SEEKS; i++) {
+    event = new_flushing_seek (i * GST_SECOND);
+    last_seqnum = gst_event_get_seqnum (event);
+    fail_unless (gst_element_send_event (lpsink, event));
+  }
+
+  g_mutex_lock (&seek_lock);
+  seek_blocked = FALSE;
+  g_cond_broadcast (&seek_cond);
+  g_mutex_unlock (&seek_lock);
+
+  s = pop_seek_done (bus);
+  fail_unless (gst_structure_get_uint (s, "coalesced", &coalesced));
+  fail_unless_equals_int (coalesced, 0);
+  gst_structure_free (s);
+
+  s = pop_seek_done (bus);
+  fail_unless (gst_structure_get_uint (s, "seqnum", &seqnum));
+  fail_unless (gst_structure_get_uint (s, "coalesced", &coalesced));
+  fail_unless (gst_structure_get_boolean (s, "success", &success));
+  fail_unless_equals_int (seqnum, last_seqnum);
+  fail_unless_equals_int (coalesced, NUM_BURST_SEEKS - 1);
+  fail_unless (success);
+  gst_structure_free (s);
+
+  /* nothing else of the burst ran */
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT) == NULL);
+  g_mutex_lock (&seek_lock);
+  fail_unless_equals_int (g_list_length (seeks), 2);
+  fail_unless_equals_int (GPOINTER_TO_UINT (g_list_last (seeks)->data),
+      last_seqnum);
+  g_list_free (seeks);
+  seeks = NULL;
+  g_mutex_unlock (&seek_lock);
+
+  stop_video_session (pipeline);
+  gst_object_unref (bus);
+  gst_object_unref (video_sink);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static Suite *
+lpsink_suite (void)
+{
+  Suite *s = suite_create ("lpsink");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("lpsink");
+  tcase_add_test (tc_chain, test_reuse_pooled_sink);
+  tcase_add_test (tc_chain, test_shutdown_while_waiting);
+  tcase_add_test (tc_chain, test_video_sink_desc);
+  tcase_add_test (tc_chain, test_seek_coalescing);
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (lpsink);
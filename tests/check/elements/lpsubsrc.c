@@ -0,0 +1,294 @@
+/* GStreamer unit tests for lpsubsrc
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+static const gchar srt_data[] =
+    "1\r\n00:00:01,000 --> 00:00:02,000\r\none\r\n\r\n"
+    "2\n00:00:03,000 --> 00:00:04,000\ntwo\nlines\n\n"
+    "3\n00:00:05,000 --> 00:00:06,500\nthree\n";
+
+static const gchar srt_long_data[] =
+    "1\n00:00:01,000 --> 00:00:10,000\nlong\n\n"
+    "2\n00:00:02,000 --> 00:00:03,000\nshort\n\n"
+    "3\n00:00:05,000 --> 00:00:06,000\nthree\n";
+
+static const gchar ass_data[] =
+    "[Script Info]\nScriptType: v4.00+\n\n[Events]\n"
+    "Format: Layer, Start, End, Style, Name, MarginL, MarginR, MarginV, "
+    "Effect, Text\n"
+    "Dialogue: 0,0:00:03.00,0:00:04.00,Default,,0,0,0,,{\\i1}two{\\i0}\\Nlines\n"
+    "Dialogue: 0,0:00:01.00,0:00:02.00,Default,,0,0,0,,one\n";
+
+static gchar *
+write_file (const gchar * data)
+{
+  gchar *path = NULL;
+  gint fd;
+
+  fd = g_file_open_tmp ("lpsubsrc-XXXXXX", &path, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (g_file_set_contents (path, data, -1, NULL));
+
+  return path;
+}
+
+static void
+handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad, GList ** cues)
+{
+  *cues = g_list_append (*cues, gst_buffer_ref (buf));
+}
+
+/* runs lpsubsrc on @path from @start to EOS and returns the cues */
+static GList *
+run_cues (const gchar * path, GstClockTime start)
+{
+  GstElement *pipeline, *src, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  GList *cues = NULL;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("lpsubsrc", NULL);
+  fail_unless (src != NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  /* the cues are checked, not their pace */
+  g_object_set (src, "location", path, "sync", FALSE, NULL);
+  g_object_set (sink, "signal-handoffs", TRUE, "sync", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff_cb), &cues);
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  if (start) {
+    g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+    cues = NULL;
+    fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH, start));
+    gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return cues;
+}
+
+static void
+check_cue (GList * cues, guint i, GstClockTime pts, GstClockTime duration,
+    const gchar * text)
+{
+  GstBuffer *buf = g_list_nth_data (cues, i);
+  GstMapInfo map;
+
+  fail_unless (buf != NULL);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), pts);
+  fail_unless_equals_uint64 (GST_BUFFER_DURATION (buf), duration);
+
+  gst_buffer_map (buf, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, strlen (text));
+  fail_unless (memcmp (map.data, text, map.size) == 0);
+  gst_buffer_unmap (buf, &map);
+}
+
+GST_START_TEST (test_srt)
+{
+  gchar *path = write_file (srt_data);
+  GList *cues;
+
+  cues = run_cues (path, 0);
+  fail_unless_equals_int (g_list_length (cues), 3);
+  check_cue (cues, 0, 1 * GST_SECOND, GST_SECOND, "one");
+  check_cue (cues, 1, 3 * GST_SECOND, GST_SECOND, "two\nlines");
+  check_cue (cues, 2, 5 * GST_SECOND, 1500 * GST_MSECOND, "three");
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_srt_seek)
+{
+  gchar *path = write_file (srt_data);
+  GList *cues;
+
+  /* the second cue is still on screen at 3.5s */
+  cues = run_cues (path, 3500 * GST_MSECOND);
+  fail_unless_equals_int (g_list_length (cues), 2);
+  check_cue (cues, 0, 3 * GST_SECOND, GST_SECOND, "two\nlines");
+  check_cue (cues, 1, 5 * GST_SECOND, 1500 * GST_MSECOND, "three");
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+
+  cues = run_cues (path, 4500 * GST_MSECOND);
+  fail_unless_equals_int (g_list_length (cues), 1);
+  check_cue (cues, 0, 5 * GST_SECOND, 1500 * GST_MSECOND, "three");
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_srt_seek_long_cue)
+{
+  gchar *path = write_file (srt_long_data);
+  GList *cues;
+
+  /* the first cue is still on screen at 4s, the one after it is not */
+  cues = run_cues (path, 4 * GST_SECOND);
+  fail_unless_equals_int (g_list_length (cues), 2);
+  check_cue (cues, 0, 1 * GST_SECOND, 9 * GST_SECOND, "long");
+  check_cue (cues, 1, 5 * GST_SECOND, GST_SECOND, "three");
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_ass)
+{
+  gchar *path = write_file (ass_data);
+  GList *cues;
+
+  /* events are sorted and the override tags dropped */
+  cues = run_cues (path, 0);
+  fail_unless_equals_int (g_list_length (cues), 2);
+  check_cue (cues, 0, 1 * GST_SECOND, GST_SECOND, "one");
+  check_cue (cues, 1, 3 * GST_SECOND, GST_SECOND, "two\nlines");
+  g_list_free_full (cues, (GDestroyNotify) gst_buffer_unref);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+/* the running time each cue was pushed at */
+static void
+paced_handoff_cb (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    GArray * times)
+{
+  GstClockTime now = 0;
+  GstClock *clock = gst_element_get_clock (sink);
+
+  if (clock) {
+    now = gst_clock_get_time (clock) - gst_element_get_base_time (sink);
+    gst_object_unref (clock);
+  }
+  g_array_append_val (times, now);
+}
+
+GST_START_TEST (test_srt_sync)
+{
+  gchar *path = write_file (srt_data);
+  GstElement *pipeline, *src, *sink;
+  GArray *times;
+  GstBus *bus;
+  GstMessage *msg;
+
+  times = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("lpsubsrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (src, "location", path, "lead", 2500 * GST_MSECOND, NULL);
+  g_object_set (sink, "signal-handoffs", TRUE, "sync", FALSE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (paced_handoff_cb), times);
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  /* only the first cue goes out for the preroll */
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  g_usleep (200 * 1000);
+  fail_unless_equals_int (times->len, 1);
+
+  /* the others 2.5s before they start, 3s and 5s */
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless_equals_int (times->len, 3);
+  fail_unless (g_array_index (times, GstClockTime, 1) >= 500 * GST_MSECOND);
+  fail_unless (g_array_index (times, GstClockTime, 2) >= 2500 * GST_MSECOND);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  g_array_free (times, TRUE);
+
+  g_unlink (path);
+  g_free (path);
+}
+
+GST_END_TEST;
+
+static Suite *
+lpsubsrc_suite (void)
+{
+  Suite *s = suite_create ("lpsubsrc");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("lpsubsrc");
+  tcase_add_test (tc_chain, test_srt);
+  tcase_add_test (tc_chain, test_srt_seek);
+  tcase_add_test (tc_chain, test_srt_seek_long_cue);
+  tcase_add_test (tc_chain, test_ass);
+  tcase_add_test (tc_chain, test_srt_sync);
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (lpsubsrc);
@@ -0,0 +1,255 @@
+/* GStreamer unit tests for lptsinkbin
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+
+static GstBuffer *
+new_cue (GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new_allocate (NULL, 4, NULL);
+
+  GST_BUFFER_PTS (buf) = pts;
+  GST_BUFFER_DURATION (buf) = 500 * GST_MSECOND;
+
+  return buf;
+}
+
+static GstClockTime
+sample_pts (GPtrArray * cues, guint i)
+{
+  GstSample *sample = g_ptr_array_index (cues, i);
+
+  return GST_BUFFER_PTS (gst_sample_get_buffer (sample));
+}
+
+GST_START_TEST (test_pull_cues)
+{
+  GstElement *pipeline, *tsinkbin;
+  GstPad *sinkpad, *mysrc;
+  GstCaps *caps;
+  GstBus *bus;
+  GstMessage *msg;
+  GPtrArray *cues = NULL;
+  guint i, nb_wakeups = 0;
+
+  pipeline = gst_pipeline_new (NULL);
+  tsinkbin = gst_element_factory_make ("lptsinkbin", NULL);
+  fail_unless (tsinkbin != NULL);
+  g_object_set (tsinkbin, "pull-mode", TRUE, "max-cues", 4, NULL);
+  gst_bin_add (GST_BIN (pipeline), tsinkbin);
+
+  sinkpad = gst_element_get_request_pad (tsinkbin, "text_sink%d");
+  fail_unless (sinkpad != NULL);
+
+  mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (mysrc, sinkpad)));
+  gst_pad_set_active (mysrc, TRUE);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  caps = gst_caps_new_simple ("text/x-raw", "format", G_TYPE_STRING, "utf8",
+      NULL);
+  gst_check_setup_events_with_stream_id (mysrc, tsinkbin, caps,
+      GST_FORMAT_TIME, "text0");
+  gst_caps_unref (caps);
+
+  /* six cues at 1s..6s, the ring keeps the last four */
+  for (i = 1; i <= 6; i++)
+    fail_unless (gst_pad_push (mysrc, new_cue (i * GST_SECOND)) ==
+        GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (mysrc, gst_event_new_eos ()));
+
+  bus = gst_element_get_bus (pipeline);
+  while ((msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+              GST_MESSAGE_APPLICATION | GST_MESSAGE_EOS))) {
+    GstMessageType type = GST_MESSAGE_TYPE (msg);
+
+    if (type == GST_MESSAGE_APPLICATION) {
+      fail_unless (gst_message_has_name (msg, "subtitle_cues"));
+      nb_wakeups++;
+    }
+    gst_message_unref (msg);
+
+    if (type == GST_MESSAGE_EOS)
+      break;
+  }
+  fail_unless (msg != NULL, "no EOS");
+
+  /* one wake-up for the whole batch */
+  fail_unless_equals_int (nb_wakeups, 1);
+
+  /* 3s is over before the window, 6s starts after it */
+  g_signal_emit_by_name (tsinkbin, "pull-cues", 0, (guint64) 4 * GST_SECOND,
+      (guint64) 5500 * GST_MSECOND, &cues);
+  fail_unless (cues != NULL);
+  fail_unless_equals_int (cues->len, 2);
+  fail_unless_equals_uint64 (sample_pts (cues, 0), 4 * GST_SECOND);
+  fail_unless_equals_uint64 (sample_pts (cues, 1), 5 * GST_SECOND);
+  g_ptr_array_unref (cues);
+
+  cues = NULL;
+  g_signal_emit_by_name (tsinkbin, "pull-cues", 0, (guint64) 0,
+      GST_CLOCK_TIME_NONE, &cues);
+  fail_unless (cues != NULL);
+  fail_unless_equals_int (cues->len, 1);
+  fail_unless_equals_uint64 (sample_pts (cues, 0), 6 * GST_SECOND);
+  g_ptr_array_unref (cues);
+
+  cues = NULL;
+  g_signal_emit_by_name (tsinkbin, "pull-cues", 1, (guint64) 0,
+      GST_CLOCK_TIME_NONE, &cues);
+  fail_unless (cues == NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_pad_set_active (mysrc, FALSE);
+  gst_object_unref (mysrc);
+  gst_object_unref (sinkpad);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_announce_and_flush)
+{
+  GstElement *pipeline, *tsinkbin;
+  GstPad *sinkpad, *mysrc;
+  GstCaps *caps;
+  GstBus *bus;
+  GstMessage *msg;
+  GPtrArray *cues = NULL;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  tsinkbin = gst_element_factory_make ("lptsinkbin", NULL);
+  fail_unless (tsinkbin != NULL);
+  g_object_set (tsinkbin, "pull-mode", TRUE, NULL);
+  gst_bin_add (GST_BIN (pipeline), tsinkbin);
+
+  sinkpad = gst_element_get_request_pad (tsinkbin, "text_sink%d");
+  fail_unless (sinkpad != NULL);
+
+  mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (mysrc, sinkpad)));
+  gst_pad_set_active (mysrc, TRUE);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  caps = gst_caps_new_simple ("text/x-raw", "format", G_TYPE_STRING, "utf8",
+      NULL);
+  gst_check_setup_events_with_stream_id (mysrc, tsinkbin, caps,
+      GST_FORMAT_TIME, "text0");
+  gst_caps_unref (caps);
+
+  for (i = 1; i <= 3; i++)
+    fail_unless (gst_pad_push (mysrc, new_cue (i * GST_SECOND)) ==
+        GST_FLOW_OK);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_APPLICATION);
+  fail_unless (msg != NULL);
+  fail_unless (gst_message_has_name (msg, "subtitle_cues"));
+  gst_message_unref (msg);
+  /* let the queue in front of the appsink drain */
+  g_usleep (G_USEC_PER_SEC / 10);
+
+  /* the cues at 2s and 3s are left, an app pulling on every message must
+   * not be woken up for them again */
+  g_signal_emit_by_name (tsinkbin, "pull-cues", 0, (guint64) 0,
+      (guint64) 1500 * GST_MSECOND, &cues);
+  fail_unless (cues != NULL);
+  fail_unless_equals_int (cues->len, 1);
+  g_ptr_array_unref (cues);
+
+  msg = gst_bus_timed_pop_filtered (bus, 0, GST_MESSAGE_APPLICATION);
+  fail_unless (msg == NULL);
+
+  /* cues queued after the pull do, once */
+  fail_unless (gst_pad_push (mysrc, new_cue (4 * GST_SECOND)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (mysrc, new_cue (5 * GST_SECOND)) == GST_FLOW_OK);
+
+  msg = gst_bus_timed_pop_filtered (bus, 5 * GST_SECOND,
+      GST_MESSAGE_APPLICATION);
+  fail_unless (msg != NULL);
+  fail_unless (gst_message_has_name (msg, "subtitle_cues"));
+  gst_message_unref (msg);
+  g_usleep (G_USEC_PER_SEC / 10);
+  msg = gst_bus_timed_pop_filtered (bus, 0, GST_MESSAGE_APPLICATION);
+  fail_unless (msg == NULL);
+
+  cues = NULL;
+  g_signal_emit_by_name (tsinkbin, "pull-cues", 0, (guint64) 0,
+      (guint64) 2500 * GST_MSECOND, &cues);
+  fail_unless (cues != NULL);
+  fail_unless_equals_int (cues->len, 1);
+  fail_unless_equals_uint64 (sample_pts (cues, 0), 2 * GST_SECOND);
+  g_ptr_array_unref (cues);
+
+  msg = gst_bus_timed_pop_filtered (bus, 0, GST_MESSAGE_APPLICATION);
+  fail_unless (msg == NULL);
+
+  /* a flush empties the ring */
+  fail_unless (gst_pad_push_event (mysrc, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (mysrc, gst_event_new_flush_stop (TRUE)));
+
+  cues = NULL;
+  g_signal_emit_by_name (tsinkbin, "pull-cues", 0, (guint64) 0,
+      GST_CLOCK_TIME_NONE, &cues);
+  fail_unless (cues != NULL);
+  fail_unless_equals_int (cues->len, 0);
+  g_ptr_array_unref (cues);
+
+  /* an empty ring is not announced */
+  msg = gst_bus_timed_pop_filtered (bus, 0, GST_MESSAGE_APPLICATION);
+  fail_unless (msg == NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_pad_set_active (mysrc, FALSE);
+  gst_object_unref (mysrc);
+  gst_object_unref (sinkpad);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static Suite *
+lptsinkbin_suite (void)
+{
+  Suite *s = suite_create ("lptsinkbin");
+  TCase *tc_chain;
+
+  tc_chain = tcase_create ("lptsinkbin pull mode");
+  tcase_add_test (tc_chain, test_pull_cues);
+  tcase_add_test (tc_chain, test_announce_and_flush);
+  suite_add_tcase (s, tc_chain);
+
+  return s;
+}
+
+GST_CHECK_MAIN (lptsinkbin);
@@ -237,6 +237,341 @@ GST_START_TEST (test_streamiddemux_num_buffers)
 
 GST_END_TEST;
 
+static GstFlowReturn
+chain_list_ok (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint *nb_lists = g_object_get_data (G_OBJECT (pad), "nb-lists");
+
+  fail_unless (gst_buffer_list_length (list) == NUM_BUFFER);
+  (*nb_lists)++;
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_streamiddemux_buffer_list)
+{
+  struct TestData td;
+  GstBufferList *list;
+  guint nb_lists = 0;
+  gint buffer_cnt = 0;
+
+  setup_test_objects (&td);
+
+  GST_DEBUG ("Creating mysink");
+  td.mysink[0] = gst_pad_new ("mysink0", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[0], chain_ok);
+  gst_pad_set_chain_list_function (td.mysink[0], chain_list_ok);
+  g_object_set_data (G_OBJECT (td.mysink[0]), "nb-lists", &nb_lists);
+  gst_pad_set_active (td.mysink[0], TRUE);
+
+  GST_DEBUG ("Creating mysrc");
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  set_active_srcpad (&td);
+
+  GST_DEBUG ("Pushing buffer list");
+  list = gst_buffer_list_new_sized (NUM_BUFFER);
+  for (buffer_cnt = 0; buffer_cnt < NUM_BUFFER; ++buffer_cnt)
+    gst_buffer_list_add (list, gst_buffer_new ());
+  fail_unless (gst_pad_push_list (td.mysrc, list) == GST_FLOW_OK);
+
+  /* the list must not be split into single buffers on the way */
+  fail_unless_equals_int (nb_lists, 1);
+
+  GST_DEBUG ("Releasing mysink and mysrc");
+  gst_pad_set_active (td.mysink[0], FALSE);
+  gst_pad_set_active (td.mysrc, FALSE);
+
+  gst_object_unref (td.mysink[0]);
+  gst_object_unref (td.mysrc);
+
+  GST_DEBUG ("Releasing streamiddemux");
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static GMutex blocked_lock;
+static GCond blocked_cond;
+static gboolean blocked_release;
+static gint nb_received;
+
+static GstFlowReturn
+chain_blocked (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  g_mutex_lock (&blocked_lock);
+  while (!blocked_release)
+    g_cond_wait (&blocked_cond, &blocked_lock);
+  g_mutex_unlock (&blocked_lock);
+
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+chain_count (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  g_atomic_int_inc (&nb_received);
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_streamiddemux_async_push)
+{
+  struct TestData td;
+  gint buffer_cnt = 0;
+  guint level = 0;
+  gint64 end_time;
+
+  blocked_release = FALSE;
+  nb_received = 0;
+
+  td.mycaps = gst_caps_new_empty_simple ("test/test");
+  td.srcpad_cnt = 0;
+
+  td.demux = gst_element_factory_make ("streamiddemux", NULL);
+  fail_unless (td.demux != NULL);
+  g_object_set (td.demux, "async-push", TRUE, "max-size-buffers", NUM_BUFFER,
+      NULL);
+  g_signal_connect (td.demux, "pad-added", G_CALLBACK (src_pad_added_cb), &td);
+  td.demuxsink = gst_element_get_static_pad (td.demux, "sink");
+  fail_unless (gst_element_set_state (td.demux, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  GST_DEBUG ("Creating a blocked mysink and a counting mysink");
+  td.mysink[0] = gst_pad_new ("mysink0", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[0], chain_blocked);
+  gst_pad_set_active (td.mysink[0], TRUE);
+
+  td.mysink[1] = gst_pad_new ("mysink1", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[1], chain_count);
+  gst_pad_set_active (td.mysink[1], TRUE);
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  /* the first buffer blocks the streaming task of src_0 */
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+
+  /* src_1 still gets its data while src_0 is stuck */
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test1");
+  set_active_srcpad (&td);
+  for (buffer_cnt = 0; buffer_cnt < NUM_BUFFER; ++buffer_cnt)
+    fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+
+  end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  while (g_atomic_int_get (&nb_received) < NUM_BUFFER
+      && g_get_monotonic_time () < end_time)
+    g_usleep (1000);
+  fail_unless_equals_int (g_atomic_int_get (&nb_received), NUM_BUFFER);
+
+  /* the second buffer of stream test0 is still waiting in the queue */
+  for (;;) {
+    g_object_get (td.demuxsrc[0], "current-level-buffers", &level, NULL);
+    if (level == 1 || g_get_monotonic_time () >= end_time)
+      break;
+    g_usleep (1000);
+  }
+  fail_unless_equals_int (level, 1);
+
+  g_mutex_lock (&blocked_lock);
+  blocked_release = TRUE;
+  g_cond_broadcast (&blocked_cond);
+  g_mutex_unlock (&blocked_lock);
+
+  GST_DEBUG ("Releasing mysink and mysrc");
+  gst_pad_set_active (td.mysrc, FALSE);
+  fail_unless (gst_element_set_state (td.demux, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_pad_set_active (td.mysink[0], FALSE);
+  gst_pad_set_active (td.mysink[1], FALSE);
+
+  gst_object_unref (td.mysink[0]);
+  gst_object_unref (td.mysink[1]);
+  gst_object_unref (td.mysrc);
+
+  GST_DEBUG ("Releasing streamiddemux");
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static void
+pad_recycled_cb (GstElement * demux, GstPad * pad, const gchar * stream_id,
+    GstCaps * caps, gint * nb_recycled)
+{
+  fail_unless (g_strcmp0 (stream_id, "test1") == 0);
+  (*nb_recycled)++;
+}
+
+GST_START_TEST (test_streamiddemux_recycle_pads)
+{
+  struct TestData td;
+  gint nb_recycled = 0;
+
+  setup_test_objects (&td);
+  g_object_set (td.demux, "recycle-pads", TRUE, NULL);
+  g_signal_connect (td.demux, "pad-recycled", G_CALLBACK (pad_recycled_cb),
+      &nb_recycled);
+
+  GST_DEBUG ("Creating mysink");
+  td.mysink[0] = gst_pad_new ("mysink0", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[0], chain_ok);
+  gst_pad_set_active (td.mysink[0], TRUE);
+
+  GST_DEBUG ("Creating mysrc");
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (td.mysrc, gst_event_new_eos ()));
+
+  /* the finished stream hands its srcpad over to the next one */
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test1");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+
+  fail_unless_equals_int (td.srcpad_cnt, 1);
+  fail_unless (active_srcpad == td.demuxsrc[0]);
+  fail_unless_equals_int (nb_recycled, 1);
+
+  GST_DEBUG ("Releasing mysink and mysrc");
+  gst_pad_set_active (td.mysink[0], FALSE);
+  gst_pad_set_active (td.mysrc, FALSE);
+
+  gst_object_unref (td.mysink[0]);
+  gst_object_unref (td.mysrc);
+
+  GST_DEBUG ("Releasing streamiddemux");
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+static gchar *sink0_stream_id;
+
+static gboolean
+event_record_stream_id (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  const gchar *stream_id = NULL;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START) {
+    gst_event_parse_stream_start (event, &stream_id);
+    g_free (sink0_stream_id);
+    sink0_stream_id = g_strdup (stream_id);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static gboolean
+query_accept_mycaps (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstCaps *caps = NULL;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_ACCEPT_CAPS)
+    return gst_pad_query_default (pad, parent, query);
+
+  gst_query_parse_accept_caps (query, &caps);
+  gst_query_set_accept_caps_result (query,
+      gst_structure_has_name (gst_caps_get_structure (caps, 0), "test/test"));
+
+  return TRUE;
+}
+
+static GstFlowReturn
+chain_drop (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_streamiddemux_recycle_refused)
+{
+  struct TestData td;
+  GstCaps *other_caps;
+  gchar *stream_id;
+  gint nb_recycled = 0;
+
+  setup_test_objects (&td);
+  g_object_set (td.demux, "recycle-pads", TRUE, NULL);
+  g_signal_connect (td.demux, "pad-recycled", G_CALLBACK (pad_recycled_cb),
+      &nb_recycled);
+
+  /* only takes test/test */
+  td.mysink[0] = gst_pad_new ("mysink0", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[0], chain_drop);
+  gst_pad_set_event_function (td.mysink[0], event_record_stream_id);
+  gst_pad_set_query_function (td.mysink[0], query_accept_mycaps);
+  gst_pad_set_active (td.mysink[0], TRUE);
+  td.mysink[1] = gst_pad_new ("mysink1", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[1], chain_drop);
+  gst_pad_set_active (td.mysink[1], TRUE);
+
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_event (td.mysrc, gst_event_new_eos ()));
+  fail_unless_equals_string (sink0_stream_id, "test0");
+
+  /* the finished srcpad is offered to test1, whose caps mysink0 refuses */
+  other_caps = gst_caps_new_empty_simple ("test/other");
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, other_caps,
+      GST_FORMAT_BYTES, "test1");
+  gst_caps_unref (other_caps);
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+
+  fail_unless_equals_int (td.srcpad_cnt, 2);
+  fail_unless (active_srcpad == td.demuxsrc[1]);
+  fail_unless_equals_int (nb_recycled, 0);
+
+  /* the refused stream never reached the old srcpad */
+  fail_unless_equals_string (sink0_stream_id, "test0");
+  stream_id = gst_pad_get_stream_id (td.mysink[1]);
+  fail_unless_equals_string (stream_id, "test1");
+  g_free (stream_id);
+
+  gst_pad_set_active (td.mysink[0], FALSE);
+  gst_pad_set_active (td.mysink[1], FALSE);
+  gst_pad_set_active (td.mysrc, FALSE);
+
+  gst_object_unref (td.mysink[0]);
+  gst_object_unref (td.mysink[1]);
+  gst_object_unref (td.mysrc);
+  g_free (sink0_stream_id);
+  sink0_stream_id = NULL;
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
 static Suite *
 streamiddemux_suite (void)
 {
@@ -246,6 +581,10 @@ streamiddemux_suite (void)
   tc_chain = tcase_create ("streamiddemux simple");
   tcase_add_test (tc_chain, test_streamiddemux_simple);
   tcase_add_test (tc_chain, test_streamiddemux_num_buffers);
+  tcase_add_test (tc_chain, test_streamiddemux_buffer_list);
+  tcase_add_test (tc_chain, test_streamiddemux_async_push);
+  tcase_add_test (tc_chain, test_streamiddemux_recycle_pads);
+  tcase_add_test (tc_chain, test_streamiddemux_recycle_refused);
   suite_add_tcase (s, tc_chain);
 
   return s;
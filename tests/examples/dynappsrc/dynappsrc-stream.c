@@ -27,6 +27,8 @@
 
 #include <gst/gst.h>
 
+#include "gstdynappsrc.h"
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -56,7 +58,9 @@ typedef struct _App App;
 struct _App
 {
   GstElement *lpbin;
+  GstElement *dynappsrc;
   GstElement *appsrc;
+  guint index;                  /* stream index in dynappsrc */
 
   guint sourceid;
 
@@ -80,7 +84,6 @@ App a_app;
 static gboolean
 read_data (App * app)
 {
-  GstBuffer *buffer;
   guint len;
   GstFlowReturn ret;
 
@@ -90,21 +93,17 @@ read_data (App * app)
     return FALSE;
   }
 
-  /* read the next chunk */
-  buffer = gst_buffer_new ();
-
   len = CHUNK_SIZE;
   if (app->offset + len > app->length)
     len = app->length - app->offset;
 
-  gst_buffer_append_memory (buffer,
-      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
-          app->data, app->length, app->offset, len, NULL, NULL));
-
-  GST_DEBUG ("feed buffer %p, offset %" G_GUINT64_FORMAT "-%u", buffer,
-      app->offset, len);
-  g_signal_emit_by_name (app->appsrc, "push-buffer", buffer, &ret);
-  gst_buffer_unref (buffer);
+  /* push the next chunk straight from the mapping, which stays alive until
+   * the pipeline released the chunk */
+  GST_DEBUG ("feed offset %" G_GUINT64_FORMAT "-%u", app->offset, len);
+  ret = gst_dyn_appsrc_push_wrapped (GST_DYN_APPSRC (app->dynappsrc),
+      app->index, app->data, app->length, app->offset, len,
+      GST_CLOCK_TIME_NONE, g_mapped_file_ref (app->file),
+      (GDestroyNotify) g_mapped_file_unref);
   if (ret != GST_FLOW_OK) {
     /* some error, stop sending data */
     return FALSE;
@@ -158,6 +157,9 @@ found_source (GObject * object, GObject * orig, GParamSpec * pspec,
   /* create a appsrc element */
   g_signal_emit_by_name (dynappsrc, "new-appsrc", "video", &video_app->appsrc);
   g_signal_emit_by_name (dynappsrc, "new-appsrc", "audio", &audio_app->appsrc);
+  video_app->dynappsrc = audio_app->dynappsrc = dynappsrc;
+  video_app->index = 0;
+  audio_app->index = 1;
 
   gst_object_ref (video_app->appsrc);
   gst_object_ref (audio_app->appsrc);
@@ -0,0 +1,225 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstemusinks.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_emu_adec_sink_debug);
+#define GST_CAT_DEFAULT gst_emu_adec_sink_debug
+
+/* props */
+enum
+{
+  PROP_0,
+  PROP_MIXER,
+  PROP_INDEX,
+  PROP_AUDIO_ONLY,
+  PROP_MAX_CHANNELS,
+  PROP_FAIL_OPEN,
+  PROP_LAST
+};
+
+#define DEFAULT_MAX_CHANNELS 2
+
+static void gst_emu_adec_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * spec);
+static void gst_emu_adec_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * spec);
+static GstStateChangeReturn gst_emu_adec_sink_change_state (GstElement *
+    element, GstStateChange transition);
+
+G_DEFINE_TYPE (GstEmuADecSink, gst_emu_adec_sink, GST_TYPE_EMU_DECODER);
+
+#define parent_class gst_emu_adec_sink_parent_class
+
+static void
+gst_emu_adec_sink_class_init (GstEmuADecSinkClass * klass)
+{
+  GObjectClass *gobject_klass;
+  GstElementClass *gstelement_klass;
+
+  gobject_klass = (GObjectClass *) klass;
+  gstelement_klass = (GstElementClass *) klass;
+
+  gobject_klass->set_property = gst_emu_adec_sink_set_property;
+  gobject_klass->get_property = gst_emu_adec_sink_get_property;
+
+  g_object_class_install_property (gobject_klass, PROP_MIXER,
+      g_param_spec_boolean ("mixer", "Mixer",
+          "Play through the shared mixer instead of an adec index", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_INDEX,
+      g_param_spec_uint ("index", "Index", "adec index to open",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_AUDIO_ONLY,
+      g_param_spec_boolean ("audio-only", "Audio only",
+          "The stream has no video", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_MAX_CHANNELS,
+      g_param_spec_uint ("max-channels", "Max channels",
+          "Number of adec indexes of the emulated device",
+          0, 32, DEFAULT_MAX_CHANNELS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_FAIL_OPEN,
+      g_param_spec_boolean ("fail-open", "Fail open",
+          "Fail the change to READY as if the device was busy", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_set_static_metadata (gstelement_klass,
+      "Emulated audio decoder sink", "Sink/Audio",
+      "Stands in for adecsink in tests and benchmarks",
+      "Jeongseok Kim <jeongseok.kim@lge.com>");
+
+  gstelement_klass->change_state =
+      GST_DEBUG_FUNCPTR (gst_emu_adec_sink_change_state);
+
+  GST_DEBUG_CATEGORY_INIT (gst_emu_adec_sink_debug, "emuadecsink", 0,
+      "Emulated adecsink");
+}
+
+static void
+gst_emu_adec_sink_init (GstEmuADecSink * self)
+{
+  self->mixer = FALSE;
+  self->index = 0;
+  self->audio_only = FALSE;
+  self->max_channels = DEFAULT_MAX_CHANNELS;
+  self->fail_open = FALSE;
+  self->has_channel = FALSE;
+}
+
+static void
+gst_emu_adec_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstEmuADecSink *self = GST_EMU_ADEC_SINK (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_MIXER:
+      self->mixer = g_value_get_boolean (value);
+      break;
+    case PROP_INDEX:
+      self->index = g_value_get_uint (value);
+      break;
+    case PROP_AUDIO_ONLY:
+      self->audio_only = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_CHANNELS:
+      self->max_channels = g_value_get_uint (value);
+      break;
+    case PROP_FAIL_OPEN:
+      self->fail_open = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_emu_adec_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstEmuADecSink *self = GST_EMU_ADEC_SINK (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_MIXER:
+      g_value_set_boolean (value, self->mixer);
+      break;
+    case PROP_INDEX:
+      g_value_set_uint (value, self->index);
+      break;
+    case PROP_AUDIO_ONLY:
+      g_value_set_boolean (value, self->audio_only);
+      break;
+    case PROP_MAX_CHANNELS:
+      g_value_set_uint (value, self->max_channels);
+      break;
+    case PROP_FAIL_OPEN:
+      g_value_set_boolean (value, self->fail_open);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static GstStateChangeReturn
+gst_emu_adec_sink_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstEmuADecSink *self = GST_EMU_ADEC_SINK (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (self->fail_open)
+        goto open_failed;
+      /* the mixer is shared, only indexes are exclusive */
+      if (!self->mixer) {
+        if (!gst_emu_channel_acquire (GST_EMU_CHANNEL_ADEC, self->index,
+                self->max_channels))
+          goto busy;
+        self->has_channel = TRUE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      if (self->has_channel) {
+        gst_emu_channel_release (GST_EMU_CHANNEL_ADEC, self->index);
+        self->has_channel = FALSE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+
+open_failed:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, (NULL),
+        ("emulated open failure"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+busy:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, BUSY, (NULL),
+        ("adec index %u is not available", self->index));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+}
@@ -0,0 +1,326 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstemusinks.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_emu_decoder_debug);
+#define GST_CAT_DEFAULT gst_emu_decoder_debug
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+/* props */
+enum
+{
+  PROP_0,
+  PROP_DECODE_LATENCY,
+  PROP_ERROR_AFTER,
+  PROP_REJECT_CAPS,
+  PROP_CURRENT_PTS,
+  PROP_LAST
+};
+
+#define DEFAULT_DECODE_LATENCY 0
+#define DEFAULT_ERROR_AFTER -1
+
+static void gst_emu_decoder_finalize (GObject * object);
+static void gst_emu_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * spec);
+static void gst_emu_decoder_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * spec);
+
+static gboolean gst_emu_decoder_start (GstBaseSink * bsink);
+static gboolean gst_emu_decoder_set_caps (GstBaseSink * bsink, GstCaps * caps);
+static GstFlowReturn gst_emu_decoder_prepare (GstBaseSink * bsink,
+    GstBuffer * buffer);
+static GstFlowReturn gst_emu_decoder_show (GstBaseSink * bsink,
+    GstBuffer * buffer);
+static gboolean gst_emu_decoder_unlock (GstBaseSink * bsink);
+static gboolean gst_emu_decoder_unlock_stop (GstBaseSink * bsink);
+
+G_DEFINE_TYPE (GstEmuDecoder, gst_emu_decoder, GST_TYPE_BASE_SINK);
+
+#define parent_class gst_emu_decoder_parent_class
+
+static void
+gst_emu_decoder_class_init (GstEmuDecoderClass * klass)
+{
+  GObjectClass *gobject_klass;
+  GstElementClass *gstelement_klass;
+  GstBaseSinkClass *gstbasesink_klass;
+
+  gobject_klass = (GObjectClass *) klass;
+  gstelement_klass = (GstElementClass *) klass;
+  gstbasesink_klass = (GstBaseSinkClass *) klass;
+
+  gobject_klass->finalize = gst_emu_decoder_finalize;
+  gobject_klass->set_property = gst_emu_decoder_set_property;
+  gobject_klass->get_property = gst_emu_decoder_get_property;
+
+  g_object_class_install_property (gobject_klass, PROP_DECODE_LATENCY,
+      g_param_spec_uint64 ("decode-latency", "Decode latency",
+          "Time in nanoseconds spent decoding each buffer",
+          0, G_MAXUINT64, DEFAULT_DECODE_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_ERROR_AFTER,
+      g_param_spec_int ("error-after", "Error after",
+          "Fail with a decode error after this many buffers (-1 = never)",
+          -1, G_MAXINT, DEFAULT_ERROR_AFTER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_REJECT_CAPS,
+      g_param_spec_boxed ("reject-caps", "Reject caps",
+          "Caps that can't be decoded", GST_TYPE_CAPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_CURRENT_PTS,
+      g_param_spec_uint64 ("current-pts", "Current PTS",
+          "PTS of the last decoded buffer", 0, G_MAXUINT64,
+          GST_CLOCK_TIME_NONE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  gst_element_class_add_pad_template (gstelement_klass,
+      gst_static_pad_template_get (&sink_template));
+
+  gstbasesink_klass->start = GST_DEBUG_FUNCPTR (gst_emu_decoder_start);
+  gstbasesink_klass->set_caps = GST_DEBUG_FUNCPTR (gst_emu_decoder_set_caps);
+  gstbasesink_klass->prepare = GST_DEBUG_FUNCPTR (gst_emu_decoder_prepare);
+  gstbasesink_klass->preroll = GST_DEBUG_FUNCPTR (gst_emu_decoder_show);
+  gstbasesink_klass->render = GST_DEBUG_FUNCPTR (gst_emu_decoder_show);
+  gstbasesink_klass->unlock = GST_DEBUG_FUNCPTR (gst_emu_decoder_unlock);
+  gstbasesink_klass->unlock_stop =
+      GST_DEBUG_FUNCPTR (gst_emu_decoder_unlock_stop);
+
+  GST_DEBUG_CATEGORY_INIT (gst_emu_decoder_debug, "emudecoder", 0,
+      "Emulated decoder sink");
+}
+
+static void
+gst_emu_decoder_init (GstEmuDecoder * self)
+{
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  self->flushing = FALSE;
+
+  self->decode_latency = DEFAULT_DECODE_LATENCY;
+  self->error_after = DEFAULT_ERROR_AFTER;
+  self->reject_caps = NULL;
+
+  self->decoded = 0;
+  self->current_pts = GST_CLOCK_TIME_NONE;
+}
+
+static void
+gst_emu_decoder_finalize (GObject * object)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (object);
+
+  if (self->reject_caps)
+    gst_caps_unref (self->reject_caps);
+
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_emu_decoder_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (object);
+
+  switch (prop_id) {
+    case PROP_DECODE_LATENCY:
+      GST_OBJECT_LOCK (self);
+      self->decode_latency = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_ERROR_AFTER:
+      GST_OBJECT_LOCK (self);
+      self->error_after = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_REJECT_CAPS:
+      GST_OBJECT_LOCK (self);
+      gst_caps_replace (&self->reject_caps,
+          (GstCaps *) gst_value_get_caps (value));
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_emu_decoder_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (object);
+
+  switch (prop_id) {
+    case PROP_DECODE_LATENCY:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->decode_latency);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_ERROR_AFTER:
+      GST_OBJECT_LOCK (self);
+      g_value_set_int (value, self->error_after);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_REJECT_CAPS:
+      GST_OBJECT_LOCK (self);
+      gst_value_set_caps (value, self->reject_caps);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    case PROP_CURRENT_PTS:
+      GST_OBJECT_LOCK (self);
+      g_value_set_uint64 (value, self->current_pts);
+      GST_OBJECT_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static gboolean
+gst_emu_decoder_start (GstBaseSink * bsink)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (bsink);
+
+  GST_OBJECT_LOCK (self);
+  self->decoded = 0;
+  self->current_pts = GST_CLOCK_TIME_NONE;
+  GST_OBJECT_UNLOCK (self);
+
+  /* unlock() of the last PAUSED_TO_READY may have left it set */
+  g_mutex_lock (&self->lock);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_emu_decoder_set_caps (GstBaseSink * bsink, GstCaps * caps)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (bsink);
+  gboolean res = TRUE;
+
+  GST_OBJECT_LOCK (self);
+  if (self->reject_caps && gst_caps_can_intersect (caps, self->reject_caps))
+    res = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!res)
+    GST_WARNING_OBJECT (self, "refusing %" GST_PTR_FORMAT, caps);
+
+  return res;
+}
+
+/* called for every buffer before it is synchronised, preroll included */
+static GstFlowReturn
+gst_emu_decoder_prepare (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (bsink);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint64 latency;
+  gint error_after;
+  gint64 end_time;
+
+  GST_OBJECT_LOCK (self);
+  latency = self->decode_latency;
+  error_after = self->error_after;
+  GST_OBJECT_UNLOCK (self);
+
+  if (error_after >= 0 && self->decoded >= (guint) error_after)
+    goto decode_error;
+
+  if (latency) {
+    end_time = g_get_monotonic_time () + latency / GST_USECOND;
+
+    g_mutex_lock (&self->lock);
+    while (!self->flushing) {
+      if (!g_cond_wait_until (&self->cond, &self->lock, end_time))
+        break;
+    }
+    if (self->flushing)
+      ret = GST_FLOW_FLUSHING;
+    g_mutex_unlock (&self->lock);
+  }
+
+  if (ret == GST_FLOW_OK)
+    self->decoded++;
+
+  return ret;
+
+decode_error:
+  {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, ("emulated decode error"),
+        ("after %u buffers", self->decoded));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_emu_decoder_show (GstBaseSink * bsink, GstBuffer * buffer)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (bsink);
+
+  GST_OBJECT_LOCK (self);
+  self->current_pts = GST_BUFFER_PTS (buffer);
+  GST_OBJECT_UNLOCK (self);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_emu_decoder_unlock (GstBaseSink * bsink)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (bsink);
+
+  g_mutex_lock (&self->lock);
+  self->flushing = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_emu_decoder_unlock_stop (GstBaseSink * bsink)
+{
+  GstEmuDecoder *self = GST_EMU_DECODER (bsink);
+
+  g_mutex_lock (&self->lock);
+  self->flushing = FALSE;
+  g_mutex_unlock (&self->lock);
+
+  return TRUE;
+}
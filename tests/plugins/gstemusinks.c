@@ -0,0 +1,95 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Emulated vdecsink and adecsink, implementing what lpsink expects from the
+ * device sinks so that lpbin can be exercised and benchmarked on any box:
+ *
+ *   vdecsink  "vdec-ch", "thumbnail-mode", "interleaving-type",
+ *             "current-pts", the "convert-frame" action signal and
+ *             "sink_%d" request pads refusing caps it can't decode, audio
+ *             unless "accept-audio" is set, so that lpsink builds an AV
+ *             chain on it
+ *   adecsink  "mixer", "index", "audio-only" and "current-pts"
+ *
+ * Both take "decode-latency" per buffer, "max-channels" decoder channels
+ * per process and fail on purpose with "fail-open" (READY fails as if the
+ * channel was busy), "error-after" (decode error after that many buffers)
+ * and "reject-caps".
+ *
+ * The plugin is not installed, add this directory of the build tree to
+ * GST_PLUGIN_PATH to use it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstemusinks.h"
+
+static GMutex channel_lock;
+static guint32 busy_channels[2];
+
+gboolean
+gst_emu_channel_acquire (GstEmuChannelType type, guint channel,
+    guint max_channels)
+{
+  gboolean res = FALSE;
+
+  if (channel >= MIN (max_channels, 32))
+    return FALSE;
+
+  g_mutex_lock (&channel_lock);
+  if (!(busy_channels[type] & (1u << channel))) {
+    busy_channels[type] |= 1u << channel;
+    res = TRUE;
+  }
+  g_mutex_unlock (&channel_lock);
+
+  return res;
+}
+
+void
+gst_emu_channel_release (GstEmuChannelType type, guint channel)
+{
+  g_mutex_lock (&channel_lock);
+  busy_channels[type] &= ~(1u << channel);
+  g_mutex_unlock (&channel_lock);
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  if (!gst_element_register (plugin, "vdecsink", GST_RANK_NONE,
+          GST_TYPE_EMU_VDEC_SINK))
+    return FALSE;
+
+  if (!gst_element_register (plugin, "adecsink", GST_RANK_NONE,
+          GST_TYPE_EMU_ADEC_SINK))
+    return FALSE;
+
+  return TRUE;
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    emusinks,
+    "Emulated device sinks for testing lpsink",
+    plugin_init, PACKAGE_VERSION, "LGPL", PACKAGE_NAME, PACKAGE_BUGREPORT)
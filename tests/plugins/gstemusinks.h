@@ -0,0 +1,129 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_EMU_SINKS_H__
+#define __GST_EMU_SINKS_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_EMU_DECODER (gst_emu_decoder_get_type())
+#define GST_EMU_DECODER(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_EMU_DECODER,GstEmuDecoder))
+#define GST_IS_EMU_DECODER(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_EMU_DECODER))
+#define GST_TYPE_EMU_ADEC_SINK (gst_emu_adec_sink_get_type())
+#define GST_EMU_ADEC_SINK(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_EMU_ADEC_SINK,GstEmuADecSink))
+#define GST_TYPE_EMU_VDEC_SINK (gst_emu_vdec_sink_get_type())
+#define GST_EMU_VDEC_SINK(obj) (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_EMU_VDEC_SINK,GstEmuVDecSink))
+typedef struct _GstEmuDecoder GstEmuDecoder;
+typedef struct _GstEmuDecoderClass GstEmuDecoderClass;
+typedef struct _GstEmuADecSink GstEmuADecSink;
+typedef struct _GstEmuADecSinkClass GstEmuADecSinkClass;
+typedef struct _GstEmuVDecSink GstEmuVDecSink;
+typedef struct _GstEmuVDecSinkClass GstEmuVDecSinkClass;
+
+typedef enum
+{
+  GST_EMU_CHANNEL_VDEC,
+  GST_EMU_CHANNEL_ADEC
+} GstEmuChannelType;
+
+/* the process-wide table of open decoder channels */
+gboolean gst_emu_channel_acquire (GstEmuChannelType type, guint channel,
+    guint max_channels);
+void gst_emu_channel_release (GstEmuChannelType type, guint channel);
+
+/* a sink taking decode-latency per buffer and failing on request */
+struct _GstEmuDecoder
+{
+  GstBaseSink parent;
+
+  GMutex lock;
+  GCond cond;
+  gboolean flushing;
+
+  guint64 decode_latency;
+  gint error_after;             /* buffers before a decode error, -1 never */
+  GstCaps *reject_caps;
+
+  guint decoded;
+  GstClockTime current_pts;
+};
+
+struct _GstEmuDecoderClass
+{
+  GstBaseSinkClass parent_class;
+};
+
+/* adecsink: one decoder on the adec index, or the shared mixer */
+struct _GstEmuADecSink
+{
+  GstEmuDecoder parent;
+
+  gboolean mixer;
+  guint index;
+  gboolean audio_only;
+
+  guint max_channels;
+  gboolean fail_open;
+  gboolean has_channel;
+};
+
+struct _GstEmuADecSinkClass
+{
+  GstEmuDecoderClass parent_class;
+};
+
+/* vdecsink: a GstEmuDecoder per sink_%d pad, all on channel vdec-ch */
+struct _GstEmuVDecSink
+{
+  GstBin parent;
+
+  guint vdec_ch;
+  gboolean thumbnail_mode;
+  gint interleaving_type;
+
+  guint64 decode_latency;
+  gint error_after;
+  GstCaps *reject_caps;
+  gboolean accept_audio;        /* lets lpsink build an AV chain */
+
+  guint max_channels;
+  gboolean fail_open;
+  gboolean has_channel;
+
+  guint nb_pads;
+  GList *decoders;              /* the GstEmuDecoder of each pad */
+};
+
+struct _GstEmuVDecSinkClass
+{
+  GstBinClass parent_class;
+
+  GstBuffer *(*convert_frame) (GstEmuVDecSink * sink, GstCaps * caps);
+};
+
+GType gst_emu_decoder_get_type (void);
+GType gst_emu_adec_sink_get_type (void);
+GType gst_emu_vdec_sink_get_type (void);
+
+G_END_DECLS
+#endif // __GST_EMU_SINKS_H__
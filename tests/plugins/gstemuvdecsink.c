@@ -0,0 +1,495 @@
+/* GStreamer Lightweight Playback Plugins
+ *
+ * Copyright (C) 2014 LG Electronics, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstemusinks.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_emu_vdec_sink_debug);
+#define GST_CAT_DEFAULT gst_emu_vdec_sink_debug
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%d",
+    GST_PAD_SINK,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS_ANY);
+
+/* signals */
+enum
+{
+  SIGNAL_CONVERT_FRAME,
+  LAST_SIGNAL
+};
+
+/* props */
+enum
+{
+  PROP_0,
+  PROP_VDEC_CH,
+  PROP_THUMBNAIL_MODE,
+  PROP_INTERLEAVING_TYPE,
+  PROP_CURRENT_PTS,
+  PROP_DECODE_LATENCY,
+  PROP_ERROR_AFTER,
+  PROP_REJECT_CAPS,
+  PROP_ACCEPT_AUDIO,
+  PROP_MAX_CHANNELS,
+  PROP_FAIL_OPEN,
+  PROP_LAST
+};
+
+static guint gst_emu_vdec_sink_signals[LAST_SIGNAL] = { 0 };
+
+#define DEFAULT_DECODE_LATENCY 0
+#define DEFAULT_ERROR_AFTER -1
+#define DEFAULT_MAX_CHANNELS 2
+
+static void gst_emu_vdec_sink_finalize (GObject * object);
+static void gst_emu_vdec_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * spec);
+static void gst_emu_vdec_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * spec);
+static GstStateChangeReturn gst_emu_vdec_sink_change_state (GstElement *
+    element, GstStateChange transition);
+static GstPad *gst_emu_vdec_sink_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
+static void gst_emu_vdec_sink_release_pad (GstElement * element, GstPad * pad);
+static GstBuffer *gst_emu_vdec_sink_convert_frame (GstEmuVDecSink * self,
+    GstCaps * caps);
+
+G_DEFINE_TYPE (GstEmuVDecSink, gst_emu_vdec_sink, GST_TYPE_BIN);
+
+#define parent_class gst_emu_vdec_sink_parent_class
+
+static void
+gst_emu_vdec_sink_class_init (GstEmuVDecSinkClass * klass)
+{
+  GObjectClass *gobject_klass;
+  GstElementClass *gstelement_klass;
+
+  gobject_klass = (GObjectClass *) klass;
+  gstelement_klass = (GstElementClass *) klass;
+
+  gobject_klass->finalize = gst_emu_vdec_sink_finalize;
+  gobject_klass->set_property = gst_emu_vdec_sink_set_property;
+  gobject_klass->get_property = gst_emu_vdec_sink_get_property;
+
+  g_object_class_install_property (gobject_klass, PROP_VDEC_CH,
+      g_param_spec_uint ("vdec-ch", "vdec channel", "vdec channel to open",
+          0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_THUMBNAIL_MODE,
+      g_param_spec_boolean ("thumbnail-mode", "Thumbnail mode",
+          "Only decode for thumbnails", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_INTERLEAVING_TYPE,
+      g_param_spec_int ("interleaving-type", "Interleaving type",
+          "Interleaving type of the stream", 0, G_MAXINT, 0,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_CURRENT_PTS,
+      g_param_spec_uint64 ("current-pts", "Current PTS",
+          "PTS of the last decoded video buffer", 0, G_MAXUINT64,
+          GST_CLOCK_TIME_NONE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_DECODE_LATENCY,
+      g_param_spec_uint64 ("decode-latency", "Decode latency",
+          "Time in nanoseconds spent decoding each buffer",
+          0, G_MAXUINT64, DEFAULT_DECODE_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_ERROR_AFTER,
+      g_param_spec_int ("error-after", "Error after",
+          "Fail with a decode error after this many buffers per pad "
+          "(-1 = never)", -1, G_MAXINT, DEFAULT_ERROR_AFTER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_REJECT_CAPS,
+      g_param_spec_boxed ("reject-caps", "Reject caps",
+          "Caps for which no pad is handed out", GST_TYPE_CAPS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_ACCEPT_AUDIO,
+      g_param_spec_boolean ("accept-audio", "Accept audio",
+          "Hand out pads for audio too, so lpsink builds an AV chain", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_MAX_CHANNELS,
+      g_param_spec_uint ("max-channels", "Max channels",
+          "Number of vdec channels of the emulated device",
+          0, 32, DEFAULT_MAX_CHANNELS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_klass, PROP_FAIL_OPEN,
+      g_param_spec_boolean ("fail-open", "Fail open",
+          "Fail the change to READY as if the device was busy", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstEmuVDecSink::convert-frame:
+   * @vdecsink: a #GstEmuVDecSink
+   * @caps: raw video caps with the width and height of the thumbnail
+   *
+   * Returns: a black frame of the requested size with the PTS of the
+   * last decoded frame, or %NULL before the first frame.
+   */
+  gst_emu_vdec_sink_signals[SIGNAL_CONVERT_FRAME] =
+      g_signal_new ("convert-frame", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstEmuVDecSinkClass, convert_frame), NULL, NULL,
+      g_cclosure_marshal_generic, GST_TYPE_BUFFER, 1, GST_TYPE_CAPS);
+
+  gst_element_class_add_pad_template (gstelement_klass,
+      gst_static_pad_template_get (&sink_template));
+
+  gst_element_class_set_static_metadata (gstelement_klass,
+      "Emulated video decoder sink", "Sink/Video",
+      "Stands in for vdecsink in tests and benchmarks",
+      "Jeongseok Kim <jeongseok.kim@lge.com>");
+
+  gstelement_klass->change_state =
+      GST_DEBUG_FUNCPTR (gst_emu_vdec_sink_change_state);
+  gstelement_klass->request_new_pad =
+      GST_DEBUG_FUNCPTR (gst_emu_vdec_sink_request_new_pad);
+  gstelement_klass->release_pad =
+      GST_DEBUG_FUNCPTR (gst_emu_vdec_sink_release_pad);
+
+  klass->convert_frame = GST_DEBUG_FUNCPTR (gst_emu_vdec_sink_convert_frame);
+
+  GST_DEBUG_CATEGORY_INIT (gst_emu_vdec_sink_debug, "emuvdecsink", 0,
+      "Emulated vdecsink");
+}
+
+static void
+gst_emu_vdec_sink_init (GstEmuVDecSink * self)
+{
+  self->vdec_ch = 0;
+  self->thumbnail_mode = FALSE;
+  self->interleaving_type = 0;
+
+  self->decode_latency = DEFAULT_DECODE_LATENCY;
+  self->error_after = DEFAULT_ERROR_AFTER;
+  self->reject_caps = NULL;
+  self->accept_audio = FALSE;
+
+  self->max_channels = DEFAULT_MAX_CHANNELS;
+  self->fail_open = FALSE;
+  self->has_channel = FALSE;
+
+  self->nb_pads = 0;
+  self->decoders = NULL;
+
+  GST_OBJECT_FLAG_SET (self, GST_ELEMENT_FLAG_SINK);
+}
+
+static void
+gst_emu_vdec_sink_finalize (GObject * object)
+{
+  GstEmuVDecSink *self = GST_EMU_VDEC_SINK (object);
+
+  if (self->reject_caps)
+    gst_caps_unref (self->reject_caps);
+
+  g_list_free (self->decoders);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* with the object lock */
+static void
+update_decoders (GstEmuVDecSink * self)
+{
+  GList *walk;
+
+  for (walk = self->decoders; walk; walk = walk->next)
+    g_object_set (walk->data, "decode-latency", self->decode_latency,
+        "error-after", self->error_after, NULL);
+}
+
+static void
+gst_emu_vdec_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstEmuVDecSink *self = GST_EMU_VDEC_SINK (object);
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_VDEC_CH:
+      self->vdec_ch = g_value_get_uint (value);
+      break;
+    case PROP_THUMBNAIL_MODE:
+      self->thumbnail_mode = g_value_get_boolean (value);
+      break;
+    case PROP_INTERLEAVING_TYPE:
+      self->interleaving_type = g_value_get_int (value);
+      break;
+    case PROP_DECODE_LATENCY:
+      self->decode_latency = g_value_get_uint64 (value);
+      update_decoders (self);
+      break;
+    case PROP_ERROR_AFTER:
+      self->error_after = g_value_get_int (value);
+      update_decoders (self);
+      break;
+    case PROP_REJECT_CAPS:
+      gst_caps_replace (&self->reject_caps,
+          (GstCaps *) gst_value_get_caps (value));
+      break;
+    case PROP_ACCEPT_AUDIO:
+      self->accept_audio = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_CHANNELS:
+      self->max_channels = g_value_get_uint (value);
+      break;
+    case PROP_FAIL_OPEN:
+      self->fail_open = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+static void
+gst_emu_vdec_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstEmuVDecSink *self = GST_EMU_VDEC_SINK (object);
+  GstElement *video = NULL;
+
+  GST_OBJECT_LOCK (self);
+  switch (prop_id) {
+    case PROP_VDEC_CH:
+      g_value_set_uint (value, self->vdec_ch);
+      break;
+    case PROP_THUMBNAIL_MODE:
+      g_value_set_boolean (value, self->thumbnail_mode);
+      break;
+    case PROP_INTERLEAVING_TYPE:
+      g_value_set_int (value, self->interleaving_type);
+      break;
+    case PROP_CURRENT_PTS:
+      /* lpsink asks for the video pad first */
+      if (self->decoders)
+        video = gst_object_ref (g_list_last (self->decoders)->data);
+      g_value_set_uint64 (value, GST_CLOCK_TIME_NONE);
+      break;
+    case PROP_DECODE_LATENCY:
+      g_value_set_uint64 (value, self->decode_latency);
+      break;
+    case PROP_ERROR_AFTER:
+      g_value_set_int (value, self->error_after);
+      break;
+    case PROP_REJECT_CAPS:
+      gst_value_set_caps (value, self->reject_caps);
+      break;
+    case PROP_ACCEPT_AUDIO:
+      g_value_set_boolean (value, self->accept_audio);
+      break;
+    case PROP_MAX_CHANNELS:
+      g_value_set_uint (value, self->max_channels);
+      break;
+    case PROP_FAIL_OPEN:
+      g_value_set_boolean (value, self->fail_open);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (self);
+
+  if (video) {
+    g_object_get_property (G_OBJECT (video), "current-pts", value);
+    gst_object_unref (video);
+  }
+}
+
+static gboolean
+accept_caps (GstEmuVDecSink * self, const GstCaps * caps)
+{
+  const gchar *name;
+  gboolean res = TRUE;
+
+  if (caps == NULL || gst_caps_is_empty (caps) || gst_caps_is_any (caps))
+    return TRUE;
+
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+  GST_OBJECT_LOCK (self);
+  if (self->reject_caps && gst_caps_can_intersect (caps, self->reject_caps))
+    res = FALSE;
+  else if (g_str_has_prefix (name, "audio/"))
+    res = self->accept_audio;
+  else if (!g_str_has_prefix (name, "video/")
+      && !g_str_has_prefix (name, "image/"))
+    res = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  return res;
+}
+
+static GstPad *
+gst_emu_vdec_sink_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * name, const GstCaps * caps)
+{
+  GstEmuVDecSink *self = GST_EMU_VDEC_SINK (element);
+  GstElement *decoder;
+  GstPad *target, *pad;
+  gchar *pad_name;
+
+  if (!accept_caps (self, caps)) {
+    GST_INFO_OBJECT (self, "refusing pad for %" GST_PTR_FORMAT, caps);
+    return NULL;
+  }
+
+  decoder = g_object_new (GST_TYPE_EMU_DECODER, NULL);
+
+  GST_OBJECT_LOCK (self);
+  g_object_set (decoder, "decode-latency", self->decode_latency,
+      "error-after", self->error_after, NULL);
+  pad_name = g_strdup_printf ("sink_%u", self->nb_pads++);
+  self->decoders = g_list_prepend (self->decoders, decoder);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_bin_add (GST_BIN_CAST (self), decoder);
+
+  target = gst_element_get_static_pad (decoder, "sink");
+  pad = gst_ghost_pad_new (pad_name, target);
+  g_object_set_data (G_OBJECT (pad), "emu.decoder", decoder);
+  gst_object_unref (target);
+  g_free (pad_name);
+
+  gst_pad_set_active (pad, TRUE);
+  gst_element_add_pad (element, pad);
+  gst_element_sync_state_with_parent (decoder);
+
+  GST_DEBUG_OBJECT (self, "%s:%s for %" GST_PTR_FORMAT,
+      GST_DEBUG_PAD_NAME (pad), caps);
+
+  return pad;
+}
+
+static void
+gst_emu_vdec_sink_release_pad (GstElement * element, GstPad * pad)
+{
+  GstEmuVDecSink *self = GST_EMU_VDEC_SINK (element);
+  GstElement *decoder = g_object_get_data (G_OBJECT (pad), "emu.decoder");
+
+  GST_OBJECT_LOCK (self);
+  self->decoders = g_list_remove (self->decoders, decoder);
+  GST_OBJECT_UNLOCK (self);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+
+  gst_element_set_state (decoder, GST_STATE_NULL);
+  gst_bin_remove (GST_BIN_CAST (self), decoder);
+}
+
+static GstBuffer *
+gst_emu_vdec_sink_convert_frame (GstEmuVDecSink * self, GstCaps * caps)
+{
+  const GstStructure *s;
+  const gchar *format;
+  GstBuffer *buf;
+  guint64 pts;
+  gint width = 0, height = 0;
+  gsize size;
+
+  g_object_get (self, "current-pts", &pts, NULL);
+  if (!GST_CLOCK_TIME_IS_VALID (pts)) {
+    GST_DEBUG_OBJECT (self, "no frame decoded yet");
+    return NULL;
+  }
+
+  s = gst_caps_get_structure (caps, 0);
+  if (!gst_structure_get_int (s, "width", &width)
+      || !gst_structure_get_int (s, "height", &height)
+      || width <= 0 || height <= 0) {
+    GST_WARNING_OBJECT (self, "no size in %" GST_PTR_FORMAT, caps);
+    return NULL;
+  }
+
+  format = gst_structure_get_string (s, "format");
+  if (format && (!strcmp (format, "I420") || !strcmp (format, "YV12")
+          || !strcmp (format, "NV12")))
+    size = width * height * 3 / 2;
+  else
+    size = width * height * 4;
+
+  buf = gst_buffer_new_allocate (NULL, size, NULL);
+  gst_buffer_memset (buf, 0, 0, size);
+  GST_BUFFER_PTS (buf) = pts;
+
+  return buf;
+}
+
+static GstStateChangeReturn
+gst_emu_vdec_sink_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstEmuVDecSink *self = GST_EMU_VDEC_SINK (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      if (self->fail_open)
+        goto open_failed;
+      if (!gst_emu_channel_acquire (GST_EMU_CHANNEL_VDEC, self->vdec_ch,
+              self->max_channels))
+        goto busy;
+      self->has_channel = TRUE;
+      break;
+    default:
+      break;
+  }
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      if (self->has_channel) {
+        gst_emu_channel_release (GST_EMU_CHANNEL_VDEC, self->vdec_ch);
+        self->has_channel = FALSE;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+
+open_failed:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, (NULL),
+        ("emulated open failure"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+busy:
+  {
+    GST_ELEMENT_ERROR (self, RESOURCE, BUSY, (NULL),
+        ("vdec channel %u is not available", self->vdec_ch));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+}